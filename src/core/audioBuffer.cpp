@@ -107,7 +107,7 @@ void AudioBuffer::moveData(AudioBuffer& b)
 /* -------------------------------------------------------------------------- */
 
 
-void AudioBuffer::copyFrame(int frame, float* values)
+void AudioBuffer::copyFrame(int frame, const float* values)
 {
 	assert(m_data != nullptr);
 	memcpy(m_data + (frame * m_channels), values, m_channels * sizeof(float));
@@ -116,7 +116,7 @@ void AudioBuffer::copyFrame(int frame, float* values)
 
 /* -------------------------------------------------------------------------- */
 
-void AudioBuffer::copyData(float* data, int frames, int offset)
+void AudioBuffer::copyData(const float* data, int frames, int offset)
 {
 	assert(m_data != nullptr);
 	assert(frames <= m_size - offset);
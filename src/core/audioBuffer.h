@@ -38,13 +38,13 @@ public:
 	starting from frame 'offset'. It takes for granted that the new data contains 
 	the same number of channels than m_channels. */
 
-	void copyData(float* data, int frames, int offset=0);
+	void copyData(const float* data, int frames, int offset=0);
 
 	/* copyFrame
 	Copies data pointed by 'values' into m_data[frame]. It takes for granted that
 	'values' contains the same number of channels than m_channels. */
 
-	void copyFrame(int frame, float* values);
+	void copyFrame(int frame, const float* values);
 
 	/* setData
 	Borrow 'data' as new m_data. Makes sure not to delete the data 'data' points
@@ -64,7 +64,7 @@ Channel::Channel(ChannelType type, ChannelStatus status, int bufferSize)
 	mute           (false),
 	solo           (false),
 	volume_i       (1.0f),
-	volume_d       (0.0f),
+	volumeEnv      (G_ACTION_VOLUME),
 	hasActions     (false),
 	readActions    (false),
 	midiIn         (true),
@@ -82,6 +82,12 @@ Channel::Channel(ChannelType type, ChannelStatus status, int bufferSize)
 	midiOutLsolo   (0x0)
 {
 	buffer.alloc(bufferSize, G_MAX_IO_CHANS);
+	mixBuffer.alloc(bufferSize, G_MAX_IO_CHANS);
+#ifdef WITH_VST
+	pluginEnvs.reserve(G_MAX_PLUGIN_ENVS);
+	pluginEnvsCount   = 0;
+	pluginEnvsVersion = 0;
+#endif
 }
 
 
@@ -95,7 +101,6 @@ void Channel::copy(const Channel* src, pthread_mutex_t* pluginMutex)
 	key             = src->key;
 	volume          = src->volume;
 	volume_i        = src->volume_i;
-	volume_d        = src->volume_d;
 	pan             = src->pan;
 	mute            = src->mute;
 	solo            = src->solo;
@@ -122,16 +127,30 @@ void Channel::copy(const Channel* src, pthread_mutex_t* pluginMutex)
 			pluginMutex, this);
 #endif
 
-	/* clone actions */
+	/* clone actions. Collect them first: recording while walking the timeline
+	would invalidate it. Plug-in automation moves to the cloned plug-ins. */
 
-	for (unsigned i=0; i<recorder::global.size(); i++) {
-		for (unsigned k=0; k<recorder::global.at(i).size(); k++) {
-			recorder::action* a = recorder::global.at(i).at(k);
-			if (a->chan == src->index) {
-				recorder::rec(index, a->type, a->frame, a->iValue, a->fValue);
-				hasActions = true;
-			}
+	std::vector<recorder::action> actions;
+	recorder::forEachAction([&](const recorder::action* a)
+	{
+		if (a->chan == src->index)
+			actions.push_back(*a);
+	});
+	for (recorder::action& a : actions) {
+#ifdef WITH_VST
+		if (a.type == G_ACTION_PLUGIN) {
+			unsigned i = 0;
+			while (i < src->plugins.size() && 
+			       src->plugins.at(i)->getId() != pluginHost::getParamKeyPlugin(a.iValue))
+				i++;
+			if (i >= plugins.size())
+				continue;
+			a.iValue = pluginHost::makeParamKey(plugins.at(i)->getId(), 
+				pluginHost::getParamKeyParam(a.iValue));
 		}
+#endif
+		recorder::rec(index, a.type, a.frame, a.iValue, a.fValue);
+		hasActions = true;
 	}
 }
 
@@ -268,17 +287,6 @@ float Channel::calcPanning(int ch) const
 /* -------------------------------------------------------------------------- */
 
 
-void Channel::calcVolumeEnvelope()
-{
-	volume_i += volume_d;
-	if (volume_i < 0.0f)
-		volume_i = 0.0f;
-	else
-	if (volume_i > 1.0f)
-		volume_i = 1.0f;	
-}
-
-
 bool Channel::isPreview() const
 {
 	return previewMode != PreviewMode::NONE;
@@ -29,6 +29,7 @@
 #define G_CHANNEL_H
 
 
+#include <atomic>
 #include <vector>
 #include <string>
 #include <pthread.h>
@@ -38,6 +39,7 @@
 #include "midiEvent.h"
 #include "recorder.h"
 #include "audioBuffer.h"
+#include "envelope.h"
 
 #ifdef WITH_VST
 	#include "../deps/juce-config.h"
@@ -61,9 +63,10 @@ public:
 	virtual void copy(const Channel* src, pthread_mutex_t* pluginMutex) = 0;
 
 	/* parseEvents
-	Prepares channel for rendering. This is called on each frame. */
+	Prepares channel for rendering. This is called once per block with the list
+	of events that fall in it, sorted by frame. */
 
-	virtual void parseEvents(giada::m::mixer::FrameEvents fe) = 0;
+	virtual void parseEvents(const std::vector<giada::m::mixer::FrameEvents>& events) = 0;
 
 	/* process
 	Merges working buffers into 'out', plus plugin processing (if any). Warning:
@@ -124,8 +127,12 @@ public:
 	virtual bool hasEditedData()  const { return false; };
 	virtual bool hasData()        const { return false; };
 
-	virtual bool recordStart(bool canQuantize) { return true; };
-	virtual bool recordKill() { return true; };
+	/* recordStart, recordKill
+	Record the related action, if capable of. 'localFrame' is the position of 
+	the event in the current audio block. */
+
+	virtual bool recordStart(bool /*canQuantize*/, int /*localFrame*/) { return true; };
+	virtual bool recordKill(int /*localFrame*/) { return true; };
 	virtual void recordStop() {};
 
 	/* prepareBuffer
@@ -145,9 +152,11 @@ public:
 	virtual void writePatch(int i, bool isProject);
 
 	/* receiveMidi
-	Receives and processes midi messages from external devices. */
+	Receives and processes midi messages from external devices. Audio thread 
+	only: 'localFrame' is the position of the message in the current block. */
 
-	virtual void receiveMidi(const giada::m::MidiEvent& midiEvent) {};
+	virtual void receiveMidi(const giada::m::MidiEvent& /*midiEvent*/, 
+		int /*localFrame*/) {};
 
 	/* calcPanning
 	Given an audio channel (stereo: 0 or 1) computes the current panning value. */
@@ -178,8 +187,6 @@ public:
 
 	void setPan(float v);
 
-	void calcVolumeEnvelope();
-
 #ifdef WITH_VST
 
 	/* getPluginMidiEvents
@@ -203,6 +210,12 @@ public:
 	
 	giada::m::AudioBuffer buffer;
 
+	/* mixBuffer
+	The channel's share of the output, when channels are rendered in parallel. 
+	Mixer sums it into the master bus (see mixer::renderIO()). */
+	
+	giada::m::AudioBuffer mixBuffer;
+
 	giada::ChannelType   type;
 	giada::ChannelStatus status;
 	giada::ChannelStatus recStatus;
@@ -221,13 +234,17 @@ public:
 	bool        mute;     // global mute
 	bool        solo;
 
-	/* volume_*
-	Internal volume variables: volume_i for envelopes, volume_d keeps track of
-	the delta during volume changes (or the line slope between two volume 
-	points). */
+	/* volume_i
+	Internal volume, on top of the global one: set by the velocity and by the 
+	volume envelope, where it stays when the sequencer stops. */
 	
 	float volume_i;
-	float volume_d;
+
+	/* volumeEnv
+	Volume automation recorded with the envelope editor (G_ACTION_VOLUME). Kept
+	in sync with the recorder by mh::updateEnvelopes(). */
+
+	giada::m::Envelope volumeEnv;
 	
   bool hasActions;      // has something recorded
   bool readActions;     // read what's recorded
@@ -259,6 +276,16 @@ public:
 
 #ifdef WITH_VST
   std::vector <Plugin*> plugins;
+
+	/* pluginEnvs, pluginEnvsCount
+	Plug-in parameter automation (G_ACTION_PLUGIN), one envelope for each 
+	parameter. Kept in sync with the recorder by mh::updateEnvelopes(). Room for
+	G_MAX_PLUGIN_ENVS is reserved upfront: envelopes never move, and the audio 
+	thread reads the first 'pluginEnvsCount' while new ones are appended. */
+
+	std::vector<giada::m::Envelope> pluginEnvs;
+	std::atomic<unsigned> pluginEnvsCount;
+	unsigned pluginEnvsVersion;
 #endif
 
 protected:
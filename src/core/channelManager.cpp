@@ -49,13 +49,30 @@ namespace channelManager
 {
 namespace
 {
-void writeActions_(int chanIndex, patch::channel_t& pch)
+/* writeActions_
+Plug-in parameter actions point to their plug-in by position in the stack in 
+patches, by id in memory (see pluginHost::makeParamKey()). Those pointing to a
+plug-in that is gone are dropped. */
+
+void writeActions_(const Channel* ch, patch::channel_t& pch)
 {
 	recorder::forEachAction([&] (const recorder::action* a) {
-		if (a->chan != chanIndex) 
+		if (a->chan != ch->index) 
 			return;
+		uint32_t iValue = a->iValue;
+#ifdef WITH_VST
+		if (a->type == G_ACTION_PLUGIN) {
+			unsigned i = 0;
+			while (i < ch->plugins.size() && 
+			       ch->plugins.at(i)->getId() != pluginHost::getParamKeyPlugin(iValue))
+				i++;
+			if (i == ch->plugins.size())
+				return;
+			iValue = pluginHost::makeParamKey(i + 1, pluginHost::getParamKeyParam(iValue));
+		}
+#endif
 		pch.actions.push_back(patch::action_t { 
-			a->type, a->frame, a->fValue, a->iValue 
+			a->type, a->frame, a->fValue, iValue 
 		});
 	});
 }
@@ -87,10 +104,28 @@ void writePlugins_(const Channel* ch, patch::channel_t& pch)
 /* -------------------------------------------------------------------------- */
 
 
-void readActions_(Channel* ch, const patch::channel_t& pch)
+/* readActions_
+The other way around: 'pluginIds' holds the id of each plug-in in the patch, 0 
+if it couldn't be loaded. */
+
+void readActions_(Channel* ch, const patch::channel_t& pch, 
+	const std::vector<int>& pluginIds)
 {
+#ifndef WITH_VST
+	(void) pluginIds;  // no plug-ins to point to
+#endif
 	for (const patch::action_t& ac : pch.actions) {
-		recorder::rec(ch->index, ac.type, ac.frame, ac.iValue, ac.fValue);
+		uint32_t iValue = ac.iValue;
+#ifdef WITH_VST
+		if (ac.type == G_ACTION_PLUGIN) {
+			unsigned i = pluginHost::getParamKeyPlugin(iValue) - 1;
+			if (i >= pluginIds.size() || pluginIds.at(i) == 0)
+				continue;
+			iValue = pluginHost::makeParamKey(pluginIds.at(i), 
+				pluginHost::getParamKeyParam(iValue));
+		}
+#endif
+		recorder::rec(ch->index, ac.type, ac.frame, iValue, ac.fValue);
 		ch->hasActions = true;
 	}
 }
@@ -99,13 +134,19 @@ void readActions_(Channel* ch, const patch::channel_t& pch)
 /* -------------------------------------------------------------------------- */
 
 
-void readPlugins_(Channel* ch, const patch::channel_t& pch)
+/* readPlugins_
+Returns the id of each plug-in loaded, 0 for those that failed. */
+
+std::vector<int> readPlugins_(Channel* ch, const patch::channel_t& pch)
 {
+	std::vector<int> ids;
+
 #ifdef WITH_VST
 
 	for (const patch::plugin_t& ppl : pch.plugins) {
 		Plugin* plugin = pluginHost::addPlugin(ppl.path, pluginHost::CHANNEL,
 			&mixer::mutex, ch);
+		ids.push_back(plugin != nullptr ? plugin->getId() : 0);
 		if (plugin == nullptr)
 			continue;
 
@@ -124,6 +165,8 @@ void readPlugins_(Channel* ch, const patch::channel_t& pch)
 	}
 
 #endif
+
+	return ids;
 }
 
 
@@ -173,7 +216,7 @@ int writePatch(const Channel* ch, bool isProject)
 	pch.midiOutLmute    = ch->midiOutLmute;
 	pch.midiOutLsolo    = ch->midiOutLsolo;
 
-	writeActions_(ch->index, pch);
+	writeActions_(ch, pch);
 	writePlugins_(ch, pch);
 
 	patch::channels.push_back(pch);
@@ -214,6 +257,7 @@ void writePatch(const SampleChannel* ch, bool isProject, int index)
 	pch.boost             = ch->getBoost();
 	pch.recActive         = ch->readActions;
 	pch.pitch             = ch->getPitch();
+	pch.interpolation     = static_cast<int>(ch->interpolation);
 	pch.inputMonitor      = ch->inputMonitor;
 	pch.midiInReadActions = ch->midiInReadActions;
 	pch.midiInPitch       = ch->midiInPitch;	
@@ -249,15 +293,14 @@ void readPatch(Channel* ch, int i)
 	ch->midiOutLmute    = pch.midiOutLmute;
 	ch->midiOutLsolo    = pch.midiOutLsolo;
 
-	readActions_(ch, pch);
-	readPlugins_(ch, pch);
+	readActions_(ch, pch, readPlugins_(ch, pch));
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void readPatch(SampleChannel* ch, const string& basePath, int i)
+void readPatch(SampleChannel* ch, int i)
 {
 	const patch::channel_t& pch = patch::channels.at(i);
 
@@ -269,15 +312,22 @@ void readPatch(SampleChannel* ch, const string& basePath, int i)
 	ch->midiInPitch       = pch.midiInPitch;
   ch->inputMonitor      = pch.inputMonitor;
 	ch->setBoost(pch.boost);
+}
 
-  Wave* w = nullptr;
-  int res = waveManager::create(basePath + pch.samplePath, &w); 
+
+/* -------------------------------------------------------------------------- */
+
+
+void readPatchWave(SampleChannel* ch, int i, Wave* w, int res)
+{
+	const patch::channel_t& pch = patch::channels.at(i);
 
 	if (res == G_RES_OK) {
 		ch->pushWave(w);
 		ch->setBegin(pch.begin);
 		ch->setEnd(pch.end);
 		ch->setPitch(pch.pitch);
+		ch->setInterpolation(static_cast<Interpolation>(pch.interpolation));
 	}
 	else {
 		if (res == G_RES_ERR_NO_DATA)
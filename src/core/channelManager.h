@@ -36,6 +36,7 @@
 class Channel;
 class SampleChannel;
 class MidiChannel;
+class Wave;
 
 
 namespace giada {
@@ -49,8 +50,14 @@ void writePatch(const SampleChannel* ch, bool isProject, int index);
 void writePatch(const MidiChannel* ch, bool isProject, int index);
 
 void readPatch(Channel* ch, int index);
-void readPatch(SampleChannel* ch, const std::string& basePath, int index);
+void readPatch(SampleChannel* ch, int index);
 void readPatch(MidiChannel* ch, int index);
+
+/* readPatchWave
+Gives sample channel 'ch' its Wave 'w', loaded from patch channel 'index' (see
+patchLoader), or sets its status according to the error 'res'. */
+
+void readPatchWave(SampleChannel* ch, int index, Wave* w, int res);
 }}}; // giada::m::channelManager
 
 
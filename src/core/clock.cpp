@@ -26,12 +26,14 @@
 
 
 #include <cassert>
+#include <algorithm>
 #include "../glue/transport.h"
 #include "../glue/main.h"
 #include "conf.h"
 #include "const.h"
 #include "kernelAudio.h"
 #include "kernelMidi.h"
+#include "recorder.h"
 #include "clock.h"
 
 
@@ -72,6 +74,20 @@ void updateQuanto()
 		quanto = framesInBeat / quantize;
 }
 
+
+/* syncStep
+Distance in frames between two MIDI sync messages, or 0 if no sync has to be
+sent. */
+
+int syncStep()
+{
+	if (conf::midiSync == MIDI_SYNC_CLOCK_M)
+		return framesInBeat / 24;
+	if (conf::midiSync == MIDI_SYNC_MTC_M)
+		return midiTCrate;
+	return 0;
+}
+
 }; // {anonymous}
 
 
@@ -207,6 +223,33 @@ void incrCurrentFrame() {
 }
 
 
+void advance(int frames, int localFrame)
+{
+	/* Jump from one stop to the next, where a stop is either the end of the loop
+	or a frame that needs a MIDI sync message. Same result as calling 
+	incrCurrentFrame() + sendMIDIsync() 'frames' times. */
+
+	int step = syncStep();
+
+	while (frames > 0) {
+		int jump = currentFrame < framesInLoop ? framesInLoop - currentFrame : 1;
+		if (step > 0)
+			jump = std::min(jump, step - currentFrame % step);
+		jump = std::min(jump, frames);
+
+		currentFrame += jump;
+		if (currentFrame >= framesInLoop)
+			currentFrame = 0;
+		currentBeat = framesInBeat > 0 ? currentFrame / framesInBeat : 0;
+		frames     -= jump;
+		localFrame += jump;
+
+		if (step > 0)
+			sendMIDIsync(localFrame);
+	}
+}
+
+
 void rewind()
 {
 	currentFrame = 0;
@@ -231,6 +274,7 @@ void updateFrameBars()
 	framesInBeat = framesInLoop / beats;
 	framesInSeq  = framesInBeat * G_MAX_BEATS;
 
+	recorder::setFramesInBeat(framesInBeat);
 	updateQuanto();
 }
 
@@ -238,13 +282,13 @@ void updateFrameBars()
 /* -------------------------------------------------------------------------- */
 
 
-void sendMIDIsync()
+void sendMIDIsync(int offset)
 {
 	/* TODO - only Master (_M) is implemented so far. */
 
 	if (conf::midiSync == MIDI_SYNC_CLOCK_M) {
 		if (currentFrame % (framesInBeat/24) == 0)
-			kernelMidi::send(MIDI_CLOCK, -1, -1);
+			kernelMidi::send(MIDI_CLOCK, -1, -1, offset);
 		return;
 	}
 
@@ -264,10 +308,10 @@ void sendMIDIsync()
 		 * seconds high nibble */
 
 		if (midiTCframes % 2 == 0) {
-			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCframes & 0x0F)  | 0x00, -1);
-			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCframes >> 4)    | 0x10, -1);
-			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCseconds & 0x0F) | 0x20, -1);
-			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCseconds >> 4)   | 0x30, -1);
+			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCframes & 0x0F)  | 0x00, -1, offset);
+			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCframes >> 4)    | 0x10, -1, offset);
+			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCseconds & 0x0F) | 0x20, -1, offset);
+			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCseconds >> 4)   | 0x30, -1, offset);
 		}
 
 		/* minutes low nibble
@@ -276,10 +320,10 @@ void sendMIDIsync()
 		 * hours high nibble SMPTE frame rate */
 
 		else {
-			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCminutes & 0x0F) | 0x40, -1);
-			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCminutes >> 4)   | 0x50, -1);
-			kernelMidi::send(MIDI_MTC_QUARTER, (midiTChours & 0x0F)   | 0x60, -1);
-			kernelMidi::send(MIDI_MTC_QUARTER, (midiTChours >> 4)     | 0x70, -1);
+			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCminutes & 0x0F) | 0x40, -1, offset);
+			kernelMidi::send(MIDI_MTC_QUARTER, (midiTCminutes >> 4)   | 0x50, -1, offset);
+			kernelMidi::send(MIDI_MTC_QUARTER, (midiTChours & 0x0F)   | 0x60, -1, offset);
+			kernelMidi::send(MIDI_MTC_QUARTER, (midiTChours >> 4)     | 0x70, -1, offset);
 		}
 
 		midiTCframes++;
@@ -378,6 +422,13 @@ int getCurrentFrame()
 }
 
 
+int getFrameAt(int localFrame)
+{
+	int frame = currentFrame + localFrame;
+	return framesInLoop > 0 && frame >= framesInLoop ? frame - framesInLoop : frame;
+}
+
+
 int getFramesInLoop()
 {
 	return framesInLoop;
@@ -432,6 +483,13 @@ int getFramesInBeat()
 }
 
 
+int getFramesInBeat(int samplerate, float bpm, int beats)
+{
+	int loop = (samplerate * (60.0f / bpm)) * beats;
+	return loop / beats;
+}
+
+
 int getFramesInSeq()
 {
 	return framesInSeq;
@@ -36,9 +36,10 @@ namespace clock
 void init(int sampleRate, float midiTCfps);
 
 /* sendMIDIsync
-Generates MIDI sync output data. */
+Generates MIDI sync output data. 'offset' is the current frame in the audio
+block. */
 
-void sendMIDIsync();
+void sendMIDIsync(int offset=0);
 
 /* sendMIDIrewind
 Rewinds timecode to beat 0 and also send a MTC full frame to cue the slave. */
@@ -54,8 +55,21 @@ int getBeats();
 int getBars();
 int getCurrentBeat();
 int getCurrentFrame();
+
+/* getFrameAt
+Returns the sequencer frame matching position 'localFrame' in the current audio
+block, wrapped around the loop. */
+
+int getFrameAt(int localFrame);
+
 int getFramesInBar();
 int getFramesInBeat();
+
+/* getFramesInBeat (2)
+Frames in a beat at any samplerate, tempo and meter, computed as for the 
+current ones. */
+
+int getFramesInBeat(int samplerate, float bpm, int beats);
 int getFramesInLoop();
 int getFramesInSeq();
 int getQuantize();
@@ -66,6 +80,13 @@ Increases current frame of a single step (+1). */
 
 void incrCurrentFrame();
 
+/* advance
+Moves the current frame forward by 'frames' steps in one go, wrapping around
+the loop and sending MIDI sync messages along the way, if any. 'localFrame' is
+the position in the audio block the sequencer is currently at. */
+
+void advance(int frames, int localFrame);
+
 /* quantoHasPassed
 Tells whether a quanto unit has passed yet. */
 
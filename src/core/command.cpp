@@ -0,0 +1,405 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include "../utils/log.h"
+#include "../utils/time.h"
+#include "channel.h"
+#include "midiEvent.h"
+#include "sampleChannel.h"
+#include "plugin.h"
+#include "pluginHost.h"
+#include "mixer.h"
+#include "mixerHandler.h"
+#include "wave.h"
+#include "kernelAudio.h"
+#include "clock.h"
+#include "recorder.h"
+#include "conf.h"
+#include "const.h"
+#include "queue.h"
+#include "command.h"
+
+
+namespace giada {
+namespace m {
+namespace command
+{
+namespace
+{
+constexpr int QUEUE_SIZE    = 1024;
+constexpr int FLUSH_TIMEOUT = 1000;  // in milliseconds
+
+constexpr int PRODUCERS     = 2;     // see Producer
+
+/* Producers' bookkeeping. 'pushed' is written by the producer only, 'applied' 
+by the audio thread only. */
+
+struct Line
+{
+	Queue<Command, QUEUE_SIZE> queue;
+	std::atomic<unsigned>      pushed;
+	std::atomic<unsigned>      applied;
+};
+
+Line lines[PRODUCERS];
+
+/* line
+The line of the calling thread, set by bind(). nullptr if the thread is not a
+producer. */
+
+thread_local Line* line = nullptr;
+
+/* Timed
+A timed command set aside by process(), waiting to be applied on 'localFrame'
+by processTimed(). */
+
+struct Timed
+{
+	Command c;
+	int     localFrame;
+	Line*   line;
+};
+
+Timed timed[QUEUE_SIZE];
+int   timedCount = 0;
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* getLocalFrame_
+Maps the arrival time of an event to a frame of the current block. Events are
+rendered one block after they arrive, spread over the block the same way they 
+were spread over the previous one: latency is constant and jitter is gone. */
+
+int getLocalFrame_(Time t, Time blockTime, int bufferSize)
+{
+	double age = std::chrono::duration<double>(blockTime - t).count();
+	int frame  = bufferSize - static_cast<int>(age * conf::samplerate);
+	return std::max(0, std::min(frame, bufferSize - 1));
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void start_(Channel* ch, int velocity, int localFrame)
+{
+	bool doQuantize = clock::canQuantize();
+	if (!ch->recordStart(doQuantize, localFrame))
+		return;
+
+	ChannelStatus status = ch->status;
+	ch->start(localFrame, doQuantize, velocity);
+
+	/* Past the first frame the channel buffer has already been prepared: fill
+	the rest of it if the channel has just started, as the sequencer does with 
+	recorded key presses. */
+
+	if (localFrame > 0 && ch->type == ChannelType::SAMPLE && 
+	    status == ChannelStatus::OFF && ch->status == ChannelStatus::PLAY) {
+		SampleChannel* sch = static_cast<SampleChannel*>(ch);
+		sch->tracker += sch->fillBuffer(sch->buffer, sch->tracker, localFrame);
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+#ifdef WITH_VST
+
+/* getPlugin_
+Looks up plug-in 'id' in the stack of channel 'ch', or in every stack if 'ch' 
+is nullptr. */
+
+Plugin* getPlugin_(int id, Channel* ch)
+{
+	using namespace pluginHost;
+
+	if (ch != nullptr)
+		return getPluginByIndex(getPluginIndex(id, CHANNEL, ch), CHANNEL, ch);
+
+	Plugin* p = getPluginByIndex(getPluginIndex(id, MASTER_IN), MASTER_IN);
+	if (p == nullptr)
+		p = getPluginByIndex(getPluginIndex(id, MASTER_OUT), MASTER_OUT);
+	for (unsigned i=0; p == nullptr && i<mixer::channels.size(); i++)
+		p = getPlugin_(id, mixer::channels.at(i));
+	return p;
+}
+
+#endif
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void applyToChannel_(const Command& c, Channel* ch, int localFrame)
+{
+	switch (c.type) {
+		case CommandType::KEY_PRESS:
+			start_(ch, c.iValue, localFrame);
+			break;
+		case CommandType::KEY_RELEASE:
+			ch->recordStop();
+			ch->stop();
+			break;
+		case CommandType::KILL:
+			if (c.iValue == 0 || ch->recordKill(localFrame))
+				ch->kill(localFrame);
+			break;
+		case CommandType::MIDI_EVENT:
+			ch->receiveMidi(MidiEvent(static_cast<uint32_t>(c.iValue)), localFrame);
+			break;
+		case CommandType::SET_VOLUME:
+			ch->volume = c.fValue;
+			break;
+		case CommandType::SET_PITCH:
+			static_cast<SampleChannel*>(ch)->setPitch(c.fValue);
+			break;
+		case CommandType::SET_INTERPOLATION:
+			static_cast<SampleChannel*>(ch)->setInterpolation(static_cast<Interpolation>(c.iValue));
+			break;
+		case CommandType::SET_PAN:
+			ch->setPan(c.fValue);
+			break;
+		case CommandType::SET_BOOST:
+			static_cast<SampleChannel*>(ch)->setBoost(c.fValue);
+			break;
+		case CommandType::TOGGLE_MUTE:
+			ch->setMute(!ch->mute);
+			break;
+		case CommandType::TOGGLE_SOLO:
+			ch->setSolo(!ch->solo);
+			break;
+		case CommandType::SET_WAVE:
+			static_cast<SampleChannel*>(ch)->swapWave(c.wave);
+			break;
+		case CommandType::PUSH_WAVE:
+			static_cast<SampleChannel*>(ch)->pushWave(c.wave);
+			break;
+		default: break;
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+#ifdef WITH_VST
+
+/* recordPluginParam_
+Records a parameter change coming from MIDI learn as a G_ACTION_PLUGIN action,
+if the recorder can. */
+
+void recordPluginParam_(const Command& c, Channel* ch, int localFrame)
+{
+	if (!recorder::canRec(ch, clock::isRunning(), mixer::recording))
+		return;
+
+	recorder::recEnvelope(ch->index, G_ACTION_PLUGIN, clock::getFrameAt(localFrame),
+		clock::getFramesInLoop() - 1, pluginHost::makeParamKey(c.plugin, c.iValue), 
+		c.fValue, c.fValue);
+	ch->hasActions = true;
+}
+
+#endif
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void apply_(const Command& c, int localFrame=0)
+{
+	/* Targets might have gone since the command was pushed: drop it then. A
+	wave on its way in goes with it. */
+
+	Channel* ch = c.chan == -1 ? nullptr : mh::getChannelByIndex(c.chan);
+	if (c.chan != -1 && ch == nullptr) {
+		delete c.wave;
+		return;
+	}
+
+	if (c.type == CommandType::SET_PLUGIN_PARAM) {
+#ifdef WITH_VST
+		Plugin* p = getPlugin_(c.plugin, ch);
+		if (p == nullptr) {
+			gu_log("[command::apply_] plug-in %d not found!\n", c.plugin);
+			return;
+		}
+		p->setParameter(c.iValue, c.fValue);
+		if (ch != nullptr)
+			recordPluginParam_(c, ch, localFrame);
+#endif
+		return;
+	}
+	applyToChannel_(c, ch, localFrame);
+}
+}; // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+void init()
+{
+	for (Line& l : lines) {
+		l.pushed  = 0;
+		l.applied = 0;
+	}
+	bind(Producer::GUI);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void bind(Producer p)
+{
+	line = &lines[static_cast<int>(p)];
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool push(const Command& c)
+{
+	/* No audio thread to talk to: nothing can race, apply the change now. */
+
+	if (!kernelAudio::getStatus()) {
+		apply_(c);
+		return true;
+	}
+
+	assert(line != nullptr);
+	if (line == nullptr) {
+		gu_log("[command::push] not a producer thread, command discarded! type=%d\n", 
+			(int) c.type);
+		return false;
+	}
+	if (!line->queue.push(c)) {
+		gu_log("[command::push] queue full, command discarded! type=%d\n", (int) c.type);
+		return false;
+	}
+	line->pushed++;
+	return true;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool flush()
+{
+	unsigned targets[PRODUCERS];
+	for (int i=0; i<PRODUCERS; i++)
+		targets[i] = lines[i].pushed;
+
+	for (int t=0; ; t++) {
+		bool done = true;
+		for (int i=0; i<PRODUCERS; i++)
+			done = done && lines[i].applied >= targets[i];
+		if (done)
+			return true;
+		if (!kernelAudio::getStatus() || t >= FLUSH_TIMEOUT) {
+			gu_log("[command::flush] audio engine not responding, giving up\n");
+			return false;
+		}
+		u::time::sleep(1);
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void process(int bufferSize)
+{
+	Time blockTime = std::chrono::steady_clock::now();
+	Command c;
+
+	timedCount = 0;
+	for (Line& l : lines)
+		while (l.queue.pop(c)) {
+			int localFrame = c.time == Time() ? 0 : 
+				getLocalFrame_(c.time, blockTime, bufferSize);
+			if (localFrame > 0 && timedCount < QUEUE_SIZE) {
+				timed[timedCount++] = { c, localFrame, &l };
+				continue;
+			}
+			apply_(c);
+			l.applied++;
+		}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void processTimed()
+{
+	/* Timed commands come from a single producer in arrival order: they are
+	already sorted by frame. */
+
+	for (int i=0; i<timedCount; i++) {
+		apply_(timed[i].c, timed[i].localFrame);
+		timed[i].line->applied++;
+	}
+	timedCount = 0;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Command make(CommandType type, Channel* ch, int iValue, float fValue)
+{
+	Command c;
+	c.type   = type;
+	c.chan   = ch == nullptr ? -1 : ch->index;
+	c.plugin = 0;
+	c.wave   = nullptr;
+	c.iValue = iValue;
+	c.fValue = fValue;
+	c.time   = Time();
+	return c;
+}
+
+
+Command makeTimed(CommandType type, Channel* ch, Time time, int iValue)
+{
+	Command c = make(type, ch, iValue);
+	c.time = time;
+	return c;
+}
+}}} // giada::m::command::
@@ -0,0 +1,138 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#ifndef G_COMMAND_H
+#define G_COMMAND_H
+
+
+#include <chrono>
+#include <cstdint>
+
+
+class Channel;
+class Wave;
+
+
+namespace giada {
+namespace m {
+namespace command
+{
+enum class CommandType
+{
+	KEY_PRESS,        // iValue: velocity
+	KEY_RELEASE,
+	KILL,             // iValue: 1 to record the kill action, if recording
+	MIDI_EVENT,       // iValue: raw MIDI message for Channel::receiveMidi()
+	SET_VOLUME,       // fValue: volume
+	SET_PITCH,        // fValue: pitch (sample channels only)
+	SET_INTERPOLATION, // iValue: Interpolation (sample channels only)
+	SET_PAN,          // fValue: pan (sample channels only)
+	SET_BOOST,        // fValue: boost (sample channels only)
+	TOGGLE_MUTE,
+	TOGGLE_SOLO,
+	SET_PLUGIN_PARAM, // plugin; iValue: parameter index; fValue: value; chan: if set, record it
+	SET_WAVE,         // wave: edited copy of the current one (sample channels only)
+	PUSH_WAVE         // wave: a new one, from scratch (sample channels only)
+};
+
+
+using Time = std::chrono::steady_clock::time_point;
+
+/* Command
+A state change aimed at the audio engine. Plain data, so that it can travel
+through a lock-free queue. Only the fields relevant to 'type' are used. Commands
+with a 'time' (i.e. incoming MIDI events) are applied at the matching frame of
+the block, the others at the very beginning. Channels and plug-ins are referred
+to by index and id: the audio thread looks them up when the command is applied
+and discards it if they are gone in the meantime. */
+
+struct Command
+{
+	CommandType      type;
+	int              chan;    // Channel::index, -1 if none
+	int              plugin;  // Plugin::getId(), 0 if none
+	Wave*            wave;
+	int              iValue;
+	float            fValue;
+	Time             time;
+};
+
+
+/* Producer
+Threads allowed to push commands. Each one has a queue of its own, with a 
+single producer on it. */
+
+enum class Producer { GUI, MIDI };
+
+/* init
+Call it from the GUI thread: it becomes the GUI producer. */
+
+void init();
+
+/* bind
+Makes the calling thread producer 'p'. The MIDI input thread calls it on 
+start. */
+
+void bind(Producer p);
+
+/* push
+Sends a command to the audio engine. It will be applied at the beginning of the
+next block. If the audio engine is not running the command is applied right 
+away. Returns false if the queue is full or the calling thread is not a 
+producer: the command has been discarded. */
+
+bool push(const Command& c);
+
+/* flush
+Waits until all commands pushed so far, from any thread, have been applied. Use
+it when the caller needs to read back the engine state, or before freeing 
+something pending commands might refer to. Returns false if the audio engine
+didn't make it in time: some of them might still be pending. */
+
+bool flush();
+
+/* process
+Applies all pending commands. Timed ones that fall past the first frame of the
+block are set aside for processTimed(). Audio thread only, at the top of each
+block. */
+
+void process(int bufferSize);
+
+/* processTimed
+Applies the commands set aside by process() at their frame. Audio thread only,
+once the channel buffers have been prepared. */
+
+void processTimed();
+
+/* Helpers for building commands. */
+
+Command make(CommandType type, Channel* ch, int iValue=0, float fValue=0.0f);
+Command makeTimed(CommandType type, Channel* ch, Time time, int iValue=0);
+}}} // giada::m::command::
+
+
+#endif
@@ -64,6 +64,10 @@ void sanitize()
 	if (midiPortOut < -1) midiPortOut = G_DEFAULT_MIDI_SYSTEM;
 	if (midiPortOut < -1) midiPortOut = G_DEFAULT_MIDI_PORT_OUT;
 	if (midiPortIn < -1) midiPortIn = G_DEFAULT_MIDI_PORT_IN;
+	for (MidiPortIn& p : midiPortsIn) {
+		if (p.filter < -1 || p.filter >= G_MAX_MIDI_CHANS) p.filter = -1;
+		if (p.ns < 0 || p.ns > G_MAX_MIDI_IN_NS) p.ns = 0;
+	}
 	if (browserX < 0) browserX = 0;
 	if (browserY < 0) browserY = 0;
 	if (browserW < 396) browserW = 396;
@@ -105,6 +109,62 @@ void sanitize()
 	if (aboutY < 0) aboutY = 0;
 	if (samplerate < 8000) samplerate = G_DEFAULT_SAMPLERATE;
 	if (rsmpQuality < 0 || rsmpQuality > 4) rsmpQuality = 0;
+	if (renderThreads < 1 || renderThreads > G_MAX_RENDER_THREADS) renderThreads = G_DEFAULT_RENDER_THREADS;
+	if (streamThreshold < 0) streamThreshold = G_DEFAULT_STREAM_THRESHOLD;
+	if (waveCacheSize < 0) waveCacheSize = G_DEFAULT_WAVE_CACHE_SIZE;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* readMidiPortsIn, writeMidiPortsIn
+Input ports are stored as an array of objects. Configuration files written 
+before multiple ports were supported have only 'midiPortIn'. Malformed entries
+are skipped. */
+
+void readMidiPortsIn(json_t* jRoot)
+{
+	midiPortsIn.clear();
+
+	json_t* jPorts = json_object_get(jRoot, CONF_KEY_MIDI_PORTS_IN);
+	if (!json_is_array(jPorts)) {
+		if (midiPortIn != -1)
+			midiPortsIn.push_back({ midiPortIn, -1, 0 });
+		return;
+	}
+
+	size_t  portIndex;
+	json_t* jPort;
+	json_array_foreach(jPorts, portIndex, jPort) {
+		json_t* jIndex  = json_object_get(jPort, CONF_KEY_MIDI_PORT_IN_INDEX);
+		json_t* jFilter = json_object_get(jPort, CONF_KEY_MIDI_PORT_IN_FILTER);
+		json_t* jNs     = json_object_get(jPort, CONF_KEY_MIDI_PORT_IN_NAMESPACE);
+		if (!json_is_integer(jIndex) || json_integer_value(jIndex) < 0 || 
+		    midiPortsIn.size() == G_MAX_MIDI_IN_PORTS) {
+			gu_log("[conf::readMidiPortsIn] MIDI input port %d skipped\n", (int) portIndex);
+			continue;
+		}
+		midiPortsIn.push_back({ 
+			(int) json_integer_value(jIndex), 
+			json_is_integer(jFilter) ? (int) json_integer_value(jFilter) : -1,
+			json_is_integer(jNs)     ? (int) json_integer_value(jNs)     : 0 
+		});
+	}
+}
+
+
+json_t* writeMidiPortsIn()
+{
+	json_t* jPorts = json_array();
+	for (const MidiPortIn& p : midiPortsIn) {
+		json_t* jPort = json_object();
+		json_object_set_new(jPort, CONF_KEY_MIDI_PORT_IN_INDEX,     json_integer(p.port));
+		json_object_set_new(jPort, CONF_KEY_MIDI_PORT_IN_FILTER,    json_integer(p.filter));
+		json_object_set_new(jPort, CONF_KEY_MIDI_PORT_IN_NAMESPACE, json_integer(p.ns));
+		json_array_append_new(jPorts, jPort);
+	}
+	return jPorts;
 }
 
 
@@ -161,10 +221,17 @@ int  buffersize     = G_DEFAULT_BUFSIZE;
 int  delayComp      = G_DEFAULT_DELAYCOMP;
 bool limitOutput    = false;
 int  rsmpQuality    = 0;
+int  renderThreads  = G_DEFAULT_RENDER_THREADS;
+int  streamThreshold = G_DEFAULT_STREAM_THRESHOLD;
+int  waveCacheSize   = G_DEFAULT_WAVE_CACHE_SIZE;
+bool nativeSamples   = false;
+bool peakFiles       = false;
+bool pitchCache      = false;
 
 int    midiSystem  = 0;
 int    midiPortOut = G_DEFAULT_MIDI_PORT_OUT;
 int    midiPortIn  = G_DEFAULT_MIDI_PORT_IN;
+std::vector<MidiPortIn> midiPortsIn;
 string midiMapPath = "";
 string lastFileMap = "";
 int    midiSync    = MIDI_SYNC_NONE;
@@ -324,9 +391,16 @@ int read()
 	if (!storager::setInt(jRoot, CONF_KEY_DELAY_COMPENSATION, delayComp)) return 0;
 	if (!storager::setBool(jRoot, CONF_KEY_LIMIT_OUTPUT, limitOutput)) return 0;
 	if (!storager::setInt(jRoot, CONF_KEY_RESAMPLE_QUALITY, rsmpQuality)) return 0;
+	if (!storager::setInt(jRoot, CONF_KEY_RENDER_THREADS, renderThreads)) return 0;
+	if (!storager::setInt(jRoot, CONF_KEY_STREAM_THRESHOLD, streamThreshold)) return 0;
+	if (!storager::setInt(jRoot, CONF_KEY_WAVE_CACHE_SIZE, waveCacheSize)) return 0;
+	if (!storager::setBool(jRoot, CONF_KEY_NATIVE_SAMPLES, nativeSamples)) return 0;
+	if (!storager::setBool(jRoot, CONF_KEY_PEAK_FILES, peakFiles)) return 0;
+	if (!storager::setBool(jRoot, CONF_KEY_PITCH_CACHE, pitchCache)) return 0;
 	if (!storager::setInt(jRoot, CONF_KEY_MIDI_SYSTEM, midiSystem)) return 0;
 	if (!storager::setInt(jRoot, CONF_KEY_MIDI_PORT_OUT, midiPortOut)) return 0;
 	if (!storager::setInt(jRoot, CONF_KEY_MIDI_PORT_IN, midiPortIn)) return 0;
+	readMidiPortsIn(jRoot);
 	if (!storager::setString(jRoot, CONF_KEY_MIDIMAP_PATH, midiMapPath)) return 0;
 	if (!storager::setString(jRoot, CONF_KEY_LAST_MIDIMAP, lastFileMap)) return 0;
 	if (!storager::setInt(jRoot, CONF_KEY_MIDI_SYNC, midiSync)) return 0;
@@ -436,9 +510,16 @@ int write()
 	json_object_set_new(jRoot, CONF_KEY_DELAY_COMPENSATION,        json_integer(delayComp));
 	json_object_set_new(jRoot, CONF_KEY_LIMIT_OUTPUT,              json_boolean(limitOutput));
 	json_object_set_new(jRoot, CONF_KEY_RESAMPLE_QUALITY,          json_integer(rsmpQuality));
+	json_object_set_new(jRoot, CONF_KEY_RENDER_THREADS,            json_integer(renderThreads));
+	json_object_set_new(jRoot, CONF_KEY_STREAM_THRESHOLD,          json_integer(streamThreshold));
+	json_object_set_new(jRoot, CONF_KEY_WAVE_CACHE_SIZE,           json_integer(waveCacheSize));
+	json_object_set_new(jRoot, CONF_KEY_NATIVE_SAMPLES,            json_boolean(nativeSamples));
+	json_object_set_new(jRoot, CONF_KEY_PEAK_FILES,                json_boolean(peakFiles));
+	json_object_set_new(jRoot, CONF_KEY_PITCH_CACHE,               json_boolean(pitchCache));
 	json_object_set_new(jRoot, CONF_KEY_MIDI_SYSTEM,               json_integer(midiSystem));
 	json_object_set_new(jRoot, CONF_KEY_MIDI_PORT_OUT,             json_integer(midiPortOut));
 	json_object_set_new(jRoot, CONF_KEY_MIDI_PORT_IN,              json_integer(midiPortIn));
+	json_object_set_new(jRoot, CONF_KEY_MIDI_PORTS_IN,             writeMidiPortsIn());
 	json_object_set_new(jRoot, CONF_KEY_MIDIMAP_PATH,              json_string(midiMapPath.c_str()));
 	json_object_set_new(jRoot, CONF_KEY_LAST_MIDIMAP,              json_string(lastFileMap.c_str()));
 	json_object_set_new(jRoot, CONF_KEY_MIDI_SYNC,                 json_integer(midiSync));
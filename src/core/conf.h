@@ -30,6 +30,7 @@
 
 
 #include <string>
+#include <vector>
 
 
 namespace giada {
@@ -59,10 +60,30 @@ extern int  buffersize;
 extern int  delayComp;
 extern bool limitOutput;
 extern int  rsmpQuality;
+extern int  renderThreads;  // audio thread included, 1 = no parallel rendering
+extern int  streamThreshold;  // MB, samples larger than this are streamed from disk
+extern int  waveCacheSize;    // MB, disk space for decoded samples (see waveCache)
+extern bool nativeSamples;    // keep samples in their file format (see NativeBuffer)
+extern bool peakFiles;        // save waveform overviews next to samples (see Peaks)
+extern bool pitchCache;       // pre-render channels playing at a fixed pitch (see pitchCache)
+
+/* MidiPortIn
+An input port to open. 'filter' is the only MIDI channel accepted from it (-1 =
+any). 'ns' is its learn namespace: messages from ports in the same namespace 
+trigger the same learned functions. The default one (0) is shared with messages
+learned before namespaces existed; 1-255 keep identical controllers apart. */
+
+struct MidiPortIn
+{
+	int port;
+	int filter;
+	int ns;
+};
 
 extern int  midiSystem;
 extern int  midiPortOut;
-extern int  midiPortIn;
+extern int  midiPortIn;   // first of midiPortsIn, for older versions
+extern std::vector<MidiPortIn> midiPortsIn;
 extern std::string midiMapPath;
 extern std::string lastFileMap;
 extern int   midiSync;  // see const.h
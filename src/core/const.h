@@ -65,6 +65,7 @@
 /* -- GUI ------------------------------------------------------------------- */
 #define G_GUI_REFRESH_RATE   1000/24
 #define G_GUI_PLUGIN_RATE    0.05  // refresh rate for plugin GUI
+#define G_GUI_LOAD_RATE      0.02  // progress refresh rate while loading a patch
 #define G_GUI_FONT_SIZE_BASE 12
 #define G_GUI_INNER_MARGIN   4
 #define G_GUI_OUTER_MARGIN   8
@@ -112,6 +113,8 @@
 #define G_MAX_IO_CHANS      2
 #define G_MAX_VELOCITY      0x7F
 #define G_MAX_MIDI_CHANS    16
+#define G_MAX_MIDI_IN_PORTS 16
+#define G_MAX_MIDI_IN_NS    255  // learn namespaces, see conf::MidiPortIn
 
 
 
@@ -151,6 +154,15 @@
 #define G_DEFAULT_SAMPLERATE       44100
 #define G_DEFAULT_BUFSIZE          1024
 #define G_DEFAULT_DELAYCOMP        0
+#define G_DEFAULT_RENDER_THREADS   1
+#define G_MAX_RENDER_THREADS       32
+#define G_DEFAULT_STREAM_THRESHOLD 64     // MB of decoded audio, 0 = never stream
+#define G_STREAM_HEAD_FRAMES       65536  // kept in memory from the begin point
+#define G_STREAM_RING_FRAMES       131072 // read ahead from disk
+#define G_STREAM_CHUNK_FRAMES      8192   // disk read size
+#define G_DEFAULT_WAVE_CACHE_SIZE  2048   // MB of decoded audio on disk, 0 = no cache
+#define G_WAVE_CACHE_DIR           "cache"
+#define G_PEAKS_EXT                ".peaks" // waveform overview next to samples
 #define G_DEFAULT_BIT_DEPTH        32     // float
 #define G_DEFAULT_VOL              1.0f
 #define G_DEFAULT_PITCH            1.0f
@@ -175,11 +187,14 @@
 #define G_ACTION_KEYPRESS		0x01 // 0000 0001
 #define G_ACTION_KEYREL			0x02 // 0000 0010
 #define G_ACTION_KILL		    0x04 // 0000 0100
+#define G_ACTION_PLUGIN     0x10 // 0001 0000 plug-in parameter automation
 #define G_ACTION_VOLUME     0x20 // 0010 0000
 #define G_ACTION_MIDI       0x40 // 0100 0000
 
 #define G_ACTION_KEYS       0x03 // 0000 0011 any key
 
+#define G_MAX_PLUGIN_ENVS   64   // automated plug-in parameters per channel
+
 #define G_RANGE_CHAR        0x01 // range for MIDI (0-127)
 #define G_RANGE_FLOAT       0x02 // range for volumes and VST params (0.0-1.0)
 
@@ -347,6 +362,7 @@ const int MIDI_CHANS[G_MAX_MIDI_CHANS] = {
 #define PATCH_KEY_CHANNEL_BOOST                "boost"
 #define PATCH_KEY_CHANNEL_REC_ACTIVE           "rec_active"
 #define PATCH_KEY_CHANNEL_PITCH                "pitch"
+#define PATCH_KEY_CHANNEL_INTERPOLATION        "interpolation"
 #define PATCH_KEY_CHANNEL_INPUT_MONITOR        "input_monitor"
 #define PATCH_KEY_CHANNEL_MIDI_IN_READ_ACTIONS "midi_in_read_actions"
 #define PATCH_KEY_CHANNEL_MIDI_IN_PITCH        "midi_in_pitch"
@@ -381,9 +397,19 @@ const int MIDI_CHANS[G_MAX_MIDI_CHANS] = {
 #define CONF_KEY_DELAY_COMPENSATION       "delay_compensation"
 #define CONF_KEY_LIMIT_OUTPUT             "limit_output"
 #define CONF_KEY_RESAMPLE_QUALITY         "resample_quality"
+#define CONF_KEY_RENDER_THREADS           "render_threads"
+#define CONF_KEY_STREAM_THRESHOLD         "stream_threshold"
+#define CONF_KEY_WAVE_CACHE_SIZE          "wave_cache_size"
+#define CONF_KEY_NATIVE_SAMPLES           "native_samples"
+#define CONF_KEY_PEAK_FILES               "peak_files"
+#define CONF_KEY_PITCH_CACHE              "pitch_cache"
 #define CONF_KEY_MIDI_SYSTEM              "midi_system"
 #define CONF_KEY_MIDI_PORT_OUT            "midi_port_out"
 #define CONF_KEY_MIDI_PORT_IN             "midi_port_in"
+#define CONF_KEY_MIDI_PORTS_IN            "midi_ports_in"
+#define CONF_KEY_MIDI_PORT_IN_INDEX       "port"
+#define CONF_KEY_MIDI_PORT_IN_FILTER      "filter"
+#define CONF_KEY_MIDI_PORT_IN_NAMESPACE   "namespace"
 #define CONF_KEY_MIDIMAP_PATH             "midimap_path"
 #define CONF_KEY_LAST_MIDIMAP             "last_midimap"
 #define CONF_KEY_MIDI_SYNC                "midi_sync"
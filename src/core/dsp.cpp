@@ -0,0 +1,1081 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include "../utils/log.h"
+#include "audioBuffer.h"
+#include "dsp.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define G_DSP_X86
+	#include <immintrin.h>
+	#define G_TARGET_SSE2 __attribute__((target("sse2")))
+	#define G_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+
+namespace giada {
+namespace m {
+namespace dsp
+{
+namespace
+{
+/* Kernels
+A set of kernels for a given instruction set. They all work on raw interleaved
+data: 'samples' is frames * channels. */
+
+struct Kernels
+{
+	void  (*add)    (float* dest, const float* src, int frames, int channels, const float* gains);
+	void  (*addRamp)(float* dest, const float* src, int frames, int channels, const float* gains, float start, float step);
+	void  (*scale)  (float* buf, int samples, float gain);
+	void  (*clip)   (float* buf, int samples, float limit);
+	float (*peak)   (const float* buf, int samples);
+
+	/* measure, finalize
+	Return the peak and add the sum of squares to 'sum'. */
+
+	float (*measure) (const float* buf, int samples, float* sum);
+	float (*finalize)(float* buf, const float* mix, int samples, float gain, float limit, float* sum);
+
+	/* decode16, upmix
+	Convert 16 bit integers ('channels' = 1 or 2) and mono floats to stereo 
+	floats. */
+
+	void (*decode16)(float* dest, const int16_t* src, int frames, int channels);
+	void (*upmix)   (float* dest, const float* src, int frames);
+
+	/* fade, reverse
+	Work in place on a range of frames, e.g. a selection in the sample editor. */
+
+	void (*fade)   (float* buf, int first, int last, int channels, float start, float step);
+	void (*reverse)(float* buf, int frames, int channels);
+
+	/* convolve
+	One frame of a FIR filter: a weighted sum of 'taps' consecutive frames. */
+
+	void (*convolve)(float* dest, const float* src, const float* coefs, int taps, int channels);
+};
+
+constexpr float INT16_SCALE = 1.0f / 32768.0f;
+constexpr float INT32_SCALE = 1.0f / 2147483648.0f;
+
+
+/* -------------------------------------------------------------------------- */
+
+/* Scalar kernels. Also used by the SIMD ones for leftovers and for buffers with
+unusual channel layouts. */
+
+void addScalar_(float* dest, const float* src, int frames, int channels, 
+	const float* gains)
+{
+	for (int i=0; i<frames; i++)
+		for (int j=0; j<channels; j++)
+			dest[i*channels + j] += src[i*channels + j] * gains[j];
+}
+
+
+float envelope_(float start, float step, int frame)
+{
+	return std::min(std::max(start + frame * step, 0.0f), 1.0f);
+}
+
+
+void addRampFrom_(float* dest, const float* src, int frames, int channels, 
+	const float* gains, float start, float step, int first)
+{
+	for (int i=first; i<frames; i++) {
+		float env = envelope_(start, step, i);
+		for (int j=0; j<channels; j++)
+			dest[i*channels + j] += src[i*channels + j] * gains[j] * env;
+	}
+}
+
+
+void addRampScalar_(float* dest, const float* src, int frames, int channels, 
+	const float* gains, float start, float step)
+{
+	addRampFrom_(dest, src, frames, channels, gains, start, step, 0);
+}
+
+
+void scaleScalar_(float* buf, int samples, float gain)
+{
+	for (int i=0; i<samples; i++)
+		buf[i] *= gain;
+}
+
+
+void clipScalar_(float* buf, int samples, float limit)
+{
+	for (int i=0; i<samples; i++)
+		buf[i] = std::min(std::max(buf[i], -limit), limit);
+}
+
+
+float peakScalar_(const float* buf, int samples)
+{
+	float peak = 0.0f;
+	for (int i=0; i<samples; i++)
+		peak = std::max(peak, std::fabs(buf[i]));
+	return peak;
+}
+
+
+float measureScalar_(const float* buf, int samples, float* sum)
+{
+	float peak = 0.0f;
+	for (int i=0; i<samples; i++) {
+		peak  = std::max(peak, std::fabs(buf[i]));
+		*sum += buf[i] * buf[i];
+	}
+	return peak;
+}
+
+
+float finalizeScalar_(float* buf, const float* mix, int samples, float gain, 
+	float limit, float* sum)
+{
+	float peak = 0.0f;
+	for (int i=0; i<samples; i++) {
+		float s = mix != nullptr ? buf[i] + mix[i] : buf[i];
+		s = std::min(std::max(s * gain, -limit), limit);
+		buf[i] = s;
+		peak   = std::max(peak, std::fabs(s));
+		*sum  += s * s;
+	}
+	return peak;
+}
+
+
+void decode16Scalar_(float* dest, const int16_t* src, int frames, int channels)
+{
+	for (int i=0; i<frames; i++) {
+		dest[i*2]     = src[i*channels] * INT16_SCALE;
+		dest[i*2 + 1] = src[i*channels + channels - 1] * INT16_SCALE;
+	}
+}
+
+
+void upmixScalar_(float* dest, const float* src, int frames)
+{
+	for (int i=0; i<frames; i++)
+		dest[i*2] = dest[i*2 + 1] = src[i];
+}
+
+
+void fadeScalar_(float* buf, int first, int last, int channels, float start, 
+	float step)
+{
+	for (int i=first; i<last; i++) {
+		float env = envelope_(start, step, i);
+		for (int j=0; j<channels; j++)
+			buf[i*channels + j] *= env;
+	}
+}
+
+
+void reverseScalar_(float* buf, int frames, int channels)
+{
+	for (int i=0, k=frames-1; i<k; i++, k--)
+		for (int j=0; j<channels; j++)
+			std::swap(buf[i*channels + j], buf[k*channels + j]);
+}
+
+
+void convolveScalar_(float* dest, const float* src, const float* coefs, int taps,
+	int channels)
+{
+	for (int j=0; j<channels; j++)
+		dest[j] = 0.0f;
+	for (int k=0; k<taps; k++)
+		for (int j=0; j<channels; j++)
+			dest[j] += src[k*channels + j] * coefs[k];
+}
+
+
+const Kernels scalar = { addScalar_, addRampScalar_, scaleScalar_, clipScalar_, 
+	peakScalar_, measureScalar_, finalizeScalar_, decode16Scalar_, upmixScalar_,
+	fadeScalar_, reverseScalar_, convolveScalar_ };
+
+
+/* -------------------------------------------------------------------------- */
+
+/* decodeAny_
+Generic conversion, for any format and number of channels: each destination 
+channel takes the matching source one, or the last available. */
+
+void decodeAny_(float* dest, int destChannels, const void* src, Format fmt, 
+	int channels, int frames)
+{
+	const int16_t* s16 = static_cast<const int16_t*>(src);
+	const uint8_t* s24 = static_cast<const uint8_t*>(src);
+	const float*   s32 = static_cast<const float*>(src);
+
+	for (int i=0; i<frames; i++)
+		for (int j=0; j<destChannels; j++) {
+			int k = i * channels + std::min(j, channels - 1);
+			float v;
+			switch (fmt) {
+				case Format::INT16: 
+					v = s16[k] * INT16_SCALE; 
+					break;
+				case Format::INT24: {
+					/* Packed little endian: place it in the upper bytes of an int32. */
+					const uint8_t* b = s24 + k * 3;
+					int32_t i32 = static_cast<int32_t>((uint32_t(b[0]) << 8) | 
+						(uint32_t(b[1]) << 16) | (uint32_t(b[2]) << 24));
+					v = i32 * INT32_SCALE;
+					break;
+				}
+				default:
+					v = s32[k];
+					break;
+			}
+			dest[i * destChannels + j] = v;
+		}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+#ifdef G_DSP_X86
+
+/* fillPattern_
+Fills 'out' with 'width' per-channel values, repeating 'gains'. Works only if a
+vector holds a whole number of frames. */
+
+bool fillPattern_(float* out, int width, int channels, const float* gains)
+{
+	if (width % channels != 0)
+		return false;
+	for (int i=0; i<width; i++)
+		out[i] = gains[i % channels];
+	return true;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* SSE2 kernels: 4 samples at a time. */
+
+G_TARGET_SSE2 
+void addSse2_(float* dest, const float* src, int frames, int channels, 
+	const float* gains)
+{
+	alignas(16) float pattern[4];
+	if (!fillPattern_(pattern, 4, channels, gains))
+		return addScalar_(dest, src, frames, channels, gains);
+
+	int samples = frames * channels;
+	int i = 0;
+	__m128 g = _mm_load_ps(pattern);
+	for (; i + 4 <= samples; i += 4) {
+		__m128 d = _mm_loadu_ps(dest + i);
+		__m128 s = _mm_loadu_ps(src + i);
+		_mm_storeu_ps(dest + i, _mm_add_ps(d, _mm_mul_ps(s, g)));
+	}
+	for (; i<samples; i++)
+		dest[i] += src[i] * gains[i % channels];
+}
+
+
+G_TARGET_SSE2 
+void addRampSse2_(float* dest, const float* src, int frames, int channels, 
+	const float* gains, float start, float step)
+{
+	alignas(16) float pattern[4];
+	alignas(16) float lanes[4];
+	if (!fillPattern_(pattern, 4, channels, gains))
+		return addRampScalar_(dest, src, frames, channels, gains, start, step);
+	for (int i=0; i<4; i++)
+		lanes[i] = i / channels;  // frame offset of each lane
+
+	int samples = frames * channels;
+	int i = 0;
+	__m128 g      = _mm_load_ps(pattern);
+	__m128 lane   = _mm_load_ps(lanes);
+	__m128 vStart = _mm_set1_ps(start);
+	__m128 vStep  = _mm_set1_ps(step);
+	__m128 zero   = _mm_setzero_ps();
+	__m128 one    = _mm_set1_ps(1.0f);
+	for (; i + 4 <= samples; i += 4) {
+		__m128 frame = _mm_add_ps(_mm_set1_ps(static_cast<float>(i / channels)), lane);
+		__m128 env   = _mm_add_ps(vStart, _mm_mul_ps(frame, vStep));
+		env = _mm_min_ps(_mm_max_ps(env, zero), one);
+		__m128 d = _mm_loadu_ps(dest + i);
+		__m128 s = _mm_loadu_ps(src + i);
+		_mm_storeu_ps(dest + i, _mm_add_ps(d, _mm_mul_ps(_mm_mul_ps(s, g), env)));
+	}
+	addRampFrom_(dest, src, frames, channels, gains, start, step, i / channels);
+}
+
+
+G_TARGET_SSE2 
+void scaleSse2_(float* buf, int samples, float gain)
+{
+	int i = 0;
+	__m128 g = _mm_set1_ps(gain);
+	for (; i + 4 <= samples; i += 4)
+		_mm_storeu_ps(buf + i, _mm_mul_ps(_mm_loadu_ps(buf + i), g));
+	scaleScalar_(buf + i, samples - i, gain);
+}
+
+
+G_TARGET_SSE2 
+void clipSse2_(float* buf, int samples, float limit)
+{
+	int i = 0;
+	__m128 hi = _mm_set1_ps(limit);
+	__m128 lo = _mm_set1_ps(-limit);
+	for (; i + 4 <= samples; i += 4)
+		_mm_storeu_ps(buf + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(buf + i), lo), hi));
+	clipScalar_(buf + i, samples - i, limit);
+}
+
+
+G_TARGET_SSE2 
+float peakSse2_(const float* buf, int samples)
+{
+	int i = 0;
+	__m128 sign = _mm_set1_ps(-0.0f);
+	__m128 peak = _mm_setzero_ps();
+	for (; i + 4 <= samples; i += 4)
+		peak = _mm_max_ps(peak, _mm_andnot_ps(sign, _mm_loadu_ps(buf + i)));
+
+	alignas(16) float p[4];
+	_mm_store_ps(p, peak);
+	float out = std::max(std::max(p[0], p[1]), std::max(p[2], p[3]));
+	return std::max(out, peakScalar_(buf + i, samples - i));
+}
+
+
+G_TARGET_SSE2 
+float measureSse2_(const float* buf, int samples, float* sum)
+{
+	int i = 0;
+	__m128 sign = _mm_set1_ps(-0.0f);
+	__m128 peak = _mm_setzero_ps();
+	__m128 acc  = _mm_setzero_ps();
+	for (; i + 4 <= samples; i += 4) {
+		__m128 s = _mm_loadu_ps(buf + i);
+		peak = _mm_max_ps(peak, _mm_andnot_ps(sign, s));
+		acc  = _mm_add_ps(acc, _mm_mul_ps(s, s));
+	}
+
+	alignas(16) float p[4];
+	alignas(16) float a[4];
+	_mm_store_ps(p, peak);
+	_mm_store_ps(a, acc);
+	*sum += a[0] + a[1] + a[2] + a[3];
+	float out = std::max(std::max(p[0], p[1]), std::max(p[2], p[3]));
+	return std::max(out, measureScalar_(buf + i, samples - i, sum));
+}
+
+
+G_TARGET_SSE2 
+float finalizeSse2_(float* buf, const float* mix, int samples, float gain, 
+	float limit, float* sum)
+{
+	int i = 0;
+	__m128 g    = _mm_set1_ps(gain);
+	__m128 hi   = _mm_set1_ps(limit);
+	__m128 lo   = _mm_set1_ps(-limit);
+	__m128 sign = _mm_set1_ps(-0.0f);
+	__m128 peak = _mm_setzero_ps();
+	__m128 acc  = _mm_setzero_ps();
+	for (; i + 4 <= samples; i += 4) {
+		__m128 s = _mm_loadu_ps(buf + i);
+		if (mix != nullptr)
+			s = _mm_add_ps(s, _mm_loadu_ps(mix + i));
+		s = _mm_min_ps(_mm_max_ps(_mm_mul_ps(s, g), lo), hi);
+		_mm_storeu_ps(buf + i, s);
+		peak = _mm_max_ps(peak, _mm_andnot_ps(sign, s));
+		acc  = _mm_add_ps(acc, _mm_mul_ps(s, s));
+	}
+
+	alignas(16) float p[4];
+	alignas(16) float a[4];
+	_mm_store_ps(p, peak);
+	_mm_store_ps(a, acc);
+	*sum += a[0] + a[1] + a[2] + a[3];
+	float out = std::max(std::max(p[0], p[1]), std::max(p[2], p[3]));
+	return std::max(out, finalizeScalar_(buf + i, mix != nullptr ? mix + i : nullptr, 
+		samples - i, gain, limit, sum));
+}
+
+
+G_TARGET_SSE2 
+void decode16Sse2_(float* dest, const int16_t* src, int frames, int channels)
+{
+	int i = 0;
+	__m128 k = _mm_set1_ps(INT16_SCALE);
+	if (channels == 2) {
+		for (; i + 4 <= frames; i += 4) {
+			__m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i*2));
+			__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);  // sign extend
+			__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+			_mm_storeu_ps(dest + i*2,     _mm_mul_ps(_mm_cvtepi32_ps(lo), k));
+			_mm_storeu_ps(dest + i*2 + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), k));
+		}
+	}
+	else {
+		for (; i + 4 <= frames; i += 4) {
+			__m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+			__m128  f = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)), k);
+			_mm_storeu_ps(dest + i*2,     _mm_unpacklo_ps(f, f));
+			_mm_storeu_ps(dest + i*2 + 4, _mm_unpackhi_ps(f, f));
+		}
+	}
+	decode16Scalar_(dest + i*2, src + i*channels, frames - i, channels);
+}
+
+
+G_TARGET_SSE2 
+void upmixSse2_(float* dest, const float* src, int frames)
+{
+	int i = 0;
+	for (; i + 4 <= frames; i += 4) {
+		__m128 f = _mm_loadu_ps(src + i);
+		_mm_storeu_ps(dest + i*2,     _mm_unpacklo_ps(f, f));
+		_mm_storeu_ps(dest + i*2 + 4, _mm_unpackhi_ps(f, f));
+	}
+	upmixScalar_(dest + i*2, src + i, frames - i);
+}
+
+
+G_TARGET_SSE2 
+void fadeSse2_(float* buf, int first, int last, int channels, float start, 
+	float step)
+{
+	alignas(16) float lanes[4];
+	if (4 % channels != 0)
+		return fadeScalar_(buf, first, last, channels, start, step);
+	for (int i=0; i<4; i++)
+		lanes[i] = i / channels;
+
+	int i   = first * channels;
+	int end = last * channels;
+	__m128 lane   = _mm_load_ps(lanes);
+	__m128 vStart = _mm_set1_ps(start);
+	__m128 vStep  = _mm_set1_ps(step);
+	__m128 zero   = _mm_setzero_ps();
+	__m128 one    = _mm_set1_ps(1.0f);
+	for (; i + 4 <= end; i += 4) {
+		__m128 frame = _mm_add_ps(_mm_set1_ps(static_cast<float>(i / channels)), lane);
+		__m128 env   = _mm_add_ps(vStart, _mm_mul_ps(frame, vStep));
+		env = _mm_min_ps(_mm_max_ps(env, zero), one);
+		_mm_storeu_ps(buf + i, _mm_mul_ps(_mm_loadu_ps(buf + i), env));
+	}
+	fadeScalar_(buf, i / channels, last, channels, start, step);
+}
+
+
+/* reverseSse2_
+Swaps 4 samples from the front with 4 from the back, reversing the order of 
+frames within each vector. The middle part left over goes to the scalar kernel. */
+
+G_TARGET_SSE2 
+void reverseSse2_(float* buf, int frames, int channels)
+{
+	if (channels != 1 && channels != 2)
+		return reverseScalar_(buf, frames, channels);
+
+	int i = 0;                    // front
+	int k = frames * channels;    // back, one past
+	for (; i + 4 <= k - 4; i += 4, k -= 4) {
+		__m128 f = _mm_loadu_ps(buf + i);
+		__m128 b = _mm_loadu_ps(buf + k - 4);
+		if (channels == 1) {
+			f = _mm_shuffle_ps(f, f, _MM_SHUFFLE(0, 1, 2, 3));
+			b = _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 1, 2, 3));
+		}
+		else {
+			f = _mm_shuffle_ps(f, f, _MM_SHUFFLE(1, 0, 3, 2));
+			b = _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2));
+		}
+		_mm_storeu_ps(buf + i, b);
+		_mm_storeu_ps(buf + k - 4, f);
+	}
+	reverseScalar_(buf + i, (k - i) / channels, channels);
+}
+
+
+/* convolveSse2_
+Mono: 4 taps at a time. Stereo: 2 taps at a time, each coefficient duplicated
+over the two channels of its frame. Lanes are added up per channel at the 
+end. */
+
+G_TARGET_SSE2 
+void convolveSse2_(float* dest, const float* src, const float* coefs, int taps,
+	int channels)
+{
+	alignas(16) float lanes[4];
+	if (channels != 1 && channels != 2)
+		return convolveScalar_(dest, src, coefs, taps, channels);
+
+	int k = 0;
+	__m128 acc = _mm_setzero_ps();
+	if (channels == 1) {
+		for (; k + 4 <= taps; k += 4)
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(src + k), _mm_loadu_ps(coefs + k)));
+	}
+	else {
+		for (; k + 2 <= taps; k += 2) {
+			__m128 c = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(coefs + k)));
+			c   = _mm_unpacklo_ps(c, c);
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(src + k*2), c));
+		}
+	}
+	_mm_store_ps(lanes, acc);
+
+	if (channels == 1)
+		dest[0] = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	else {
+		dest[0] = lanes[0] + lanes[2];
+		dest[1] = lanes[1] + lanes[3];
+	}
+	for (; k<taps; k++)
+		for (int j=0; j<channels; j++)
+			dest[j] += src[k*channels + j] * coefs[k];
+}
+
+
+const Kernels sse2 = { addSse2_, addRampSse2_, scaleSse2_, clipSse2_, peakSse2_,
+	measureSse2_, finalizeSse2_, decode16Sse2_, upmixSse2_, fadeSse2_, reverseSse2_,
+	convolveSse2_ };
+
+
+/* -------------------------------------------------------------------------- */
+
+/* AVX2 kernels: 8 samples at a time. */
+
+G_TARGET_AVX2 
+void addAvx2_(float* dest, const float* src, int frames, int channels, 
+	const float* gains)
+{
+	alignas(32) float pattern[8];
+	if (!fillPattern_(pattern, 8, channels, gains))
+		return addScalar_(dest, src, frames, channels, gains);
+
+	int samples = frames * channels;
+	int i = 0;
+	__m256 g = _mm256_load_ps(pattern);
+	for (; i + 8 <= samples; i += 8) {
+		__m256 d = _mm256_loadu_ps(dest + i);
+		__m256 s = _mm256_loadu_ps(src + i);
+		_mm256_storeu_ps(dest + i, _mm256_add_ps(d, _mm256_mul_ps(s, g)));
+	}
+	for (; i<samples; i++)
+		dest[i] += src[i] * gains[i % channels];
+}
+
+
+G_TARGET_AVX2 
+void addRampAvx2_(float* dest, const float* src, int frames, int channels, 
+	const float* gains, float start, float step)
+{
+	alignas(32) float pattern[8];
+	alignas(32) float lanes[8];
+	if (!fillPattern_(pattern, 8, channels, gains))
+		return addRampScalar_(dest, src, frames, channels, gains, start, step);
+	for (int i=0; i<8; i++)
+		lanes[i] = i / channels;
+
+	int samples = frames * channels;
+	int i = 0;
+	__m256 g      = _mm256_load_ps(pattern);
+	__m256 lane   = _mm256_load_ps(lanes);
+	__m256 vStart = _mm256_set1_ps(start);
+	__m256 vStep  = _mm256_set1_ps(step);
+	__m256 zero   = _mm256_setzero_ps();
+	__m256 one    = _mm256_set1_ps(1.0f);
+	for (; i + 8 <= samples; i += 8) {
+		__m256 frame = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(i / channels)), lane);
+		__m256 env   = _mm256_add_ps(vStart, _mm256_mul_ps(frame, vStep));
+		env = _mm256_min_ps(_mm256_max_ps(env, zero), one);
+		__m256 d = _mm256_loadu_ps(dest + i);
+		__m256 s = _mm256_loadu_ps(src + i);
+		_mm256_storeu_ps(dest + i, _mm256_add_ps(d, _mm256_mul_ps(_mm256_mul_ps(s, g), env)));
+	}
+	addRampFrom_(dest, src, frames, channels, gains, start, step, i / channels);
+}
+
+
+G_TARGET_AVX2 
+void scaleAvx2_(float* buf, int samples, float gain)
+{
+	int i = 0;
+	__m256 g = _mm256_set1_ps(gain);
+	for (; i + 8 <= samples; i += 8)
+		_mm256_storeu_ps(buf + i, _mm256_mul_ps(_mm256_loadu_ps(buf + i), g));
+	scaleScalar_(buf + i, samples - i, gain);
+}
+
+
+G_TARGET_AVX2 
+void clipAvx2_(float* buf, int samples, float limit)
+{
+	int i = 0;
+	__m256 hi = _mm256_set1_ps(limit);
+	__m256 lo = _mm256_set1_ps(-limit);
+	for (; i + 8 <= samples; i += 8)
+		_mm256_storeu_ps(buf + i, _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(buf + i), lo), hi));
+	clipScalar_(buf + i, samples - i, limit);
+}
+
+
+G_TARGET_AVX2 
+float peakAvx2_(const float* buf, int samples)
+{
+	int i = 0;
+	__m256 sign = _mm256_set1_ps(-0.0f);
+	__m256 peak = _mm256_setzero_ps();
+	for (; i + 8 <= samples; i += 8)
+		peak = _mm256_max_ps(peak, _mm256_andnot_ps(sign, _mm256_loadu_ps(buf + i)));
+
+	alignas(32) float p[8];
+	_mm256_store_ps(p, peak);
+	float out = *std::max_element(p, p + 8);
+	return std::max(out, peakScalar_(buf + i, samples - i));
+}
+
+
+G_TARGET_AVX2 
+float measureAvx2_(const float* buf, int samples, float* sum)
+{
+	int i = 0;
+	__m256 sign = _mm256_set1_ps(-0.0f);
+	__m256 peak = _mm256_setzero_ps();
+	__m256 acc  = _mm256_setzero_ps();
+	for (; i + 8 <= samples; i += 8) {
+		__m256 s = _mm256_loadu_ps(buf + i);
+		peak = _mm256_max_ps(peak, _mm256_andnot_ps(sign, s));
+		acc  = _mm256_add_ps(acc, _mm256_mul_ps(s, s));
+	}
+
+	alignas(32) float p[8];
+	alignas(32) float a[8];
+	_mm256_store_ps(p, peak);
+	_mm256_store_ps(a, acc);
+	for (float v : a)
+		*sum += v;
+	float out = *std::max_element(p, p + 8);
+	return std::max(out, measureScalar_(buf + i, samples - i, sum));
+}
+
+
+G_TARGET_AVX2 
+float finalizeAvx2_(float* buf, const float* mix, int samples, float gain, 
+	float limit, float* sum)
+{
+	int i = 0;
+	__m256 g    = _mm256_set1_ps(gain);
+	__m256 hi   = _mm256_set1_ps(limit);
+	__m256 lo   = _mm256_set1_ps(-limit);
+	__m256 sign = _mm256_set1_ps(-0.0f);
+	__m256 peak = _mm256_setzero_ps();
+	__m256 acc  = _mm256_setzero_ps();
+	for (; i + 8 <= samples; i += 8) {
+		__m256 s = _mm256_loadu_ps(buf + i);
+		if (mix != nullptr)
+			s = _mm256_add_ps(s, _mm256_loadu_ps(mix + i));
+		s = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(s, g), lo), hi);
+		_mm256_storeu_ps(buf + i, s);
+		peak = _mm256_max_ps(peak, _mm256_andnot_ps(sign, s));
+		acc  = _mm256_add_ps(acc, _mm256_mul_ps(s, s));
+	}
+
+	alignas(32) float p[8];
+	alignas(32) float a[8];
+	_mm256_store_ps(p, peak);
+	_mm256_store_ps(a, acc);
+	for (float v : a)
+		*sum += v;
+	float out = *std::max_element(p, p + 8);
+	return std::max(out, finalizeScalar_(buf + i, mix != nullptr ? mix + i : nullptr, 
+		samples - i, gain, limit, sum));
+}
+
+
+/* storeUpmixed_
+Writes the 8 mono samples in 'f' as 16 stereo ones. Unpacking works within 
+128 bit lanes, so halves must be put back in order. */
+
+G_TARGET_AVX2 
+void storeUpmixed_(float* dest, __m256 f)
+{
+	__m256 lo = _mm256_unpacklo_ps(f, f);  // a a b b | e e f f
+	__m256 hi = _mm256_unpackhi_ps(f, f);  // c c d d | g g h h
+	_mm256_storeu_ps(dest,     _mm256_permute2f128_ps(lo, hi, 0x20));
+	_mm256_storeu_ps(dest + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+}
+
+
+G_TARGET_AVX2 
+void decode16Avx2_(float* dest, const int16_t* src, int frames, int channels)
+{
+	int i = 0;
+	__m256 k = _mm256_set1_ps(INT16_SCALE);
+	if (channels == 2) {
+		for (; i + 8 <= frames; i += 8) {
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i*2));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i*2 + 8));
+			_mm256_storeu_ps(dest + i*2,     _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(a)), k));
+			_mm256_storeu_ps(dest + i*2 + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(b)), k));
+		}
+	}
+	else {
+		for (; i + 8 <= frames; i += 8) {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			storeUpmixed_(dest + i*2, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(v)), k));
+		}
+	}
+	decode16Scalar_(dest + i*2, src + i*channels, frames - i, channels);
+}
+
+
+G_TARGET_AVX2 
+void upmixAvx2_(float* dest, const float* src, int frames)
+{
+	int i = 0;
+	for (; i + 8 <= frames; i += 8)
+		storeUpmixed_(dest + i*2, _mm256_loadu_ps(src + i));
+	upmixScalar_(dest + i*2, src + i, frames - i);
+}
+
+
+G_TARGET_AVX2 
+void fadeAvx2_(float* buf, int first, int last, int channels, float start, 
+	float step)
+{
+	alignas(32) float lanes[8];
+	if (8 % channels != 0)
+		return fadeScalar_(buf, first, last, channels, start, step);
+	for (int i=0; i<8; i++)
+		lanes[i] = i / channels;
+
+	int i   = first * channels;
+	int end = last * channels;
+	__m256 lane   = _mm256_load_ps(lanes);
+	__m256 vStart = _mm256_set1_ps(start);
+	__m256 vStep  = _mm256_set1_ps(step);
+	__m256 zero   = _mm256_setzero_ps();
+	__m256 one    = _mm256_set1_ps(1.0f);
+	for (; i + 8 <= end; i += 8) {
+		__m256 frame = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(i / channels)), lane);
+		__m256 env   = _mm256_add_ps(vStart, _mm256_mul_ps(frame, vStep));
+		env = _mm256_min_ps(_mm256_max_ps(env, zero), one);
+		_mm256_storeu_ps(buf + i, _mm256_mul_ps(_mm256_loadu_ps(buf + i), env));
+	}
+	fadeScalar_(buf, i / channels, last, channels, start, step);
+}
+
+
+/* reverseAvx2_
+As reverseSse2_, with a cross-lane permutation that works for any number of 
+channels a vector can hold whole frames of. */
+
+G_TARGET_AVX2 
+void reverseAvx2_(float* buf, int frames, int channels)
+{
+	alignas(32) int32_t order[8];
+	if (8 % channels != 0)
+		return reverseScalar_(buf, frames, channels);
+	for (int p=0; p<8; p++)
+		order[p] = (8 / channels - 1 - p / channels) * channels + p % channels;
+
+	int i = 0;
+	int k = frames * channels;
+	__m256i idx = _mm256_load_si256(reinterpret_cast<const __m256i*>(order));
+	for (; i + 8 <= k - 8; i += 8, k -= 8) {
+		__m256 f = _mm256_permutevar8x32_ps(_mm256_loadu_ps(buf + i), idx);
+		__m256 b = _mm256_permutevar8x32_ps(_mm256_loadu_ps(buf + k - 8), idx);
+		_mm256_storeu_ps(buf + i, b);
+		_mm256_storeu_ps(buf + k - 8, f);
+	}
+	reverseScalar_(buf + i, (k - i) / channels, channels);
+}
+
+
+/* convolveAvx2_
+As convolveSse2_, 8 taps (mono) or 4 (stereo) at a time. */
+
+G_TARGET_AVX2 
+void convolveAvx2_(float* dest, const float* src, const float* coefs, int taps,
+	int channels)
+{
+	alignas(32) float lanes[8];
+	if (channels != 1 && channels != 2)
+		return convolveScalar_(dest, src, coefs, taps, channels);
+
+	int k = 0;
+	__m256 acc = _mm256_setzero_ps();
+	if (channels == 1) {
+		for (; k + 8 <= taps; k += 8)
+			acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(src + k), _mm256_loadu_ps(coefs + k)));
+	}
+	else {
+		const __m256i dup = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+		for (; k + 4 <= taps; k += 4) {
+			__m256 c = _mm256_castps128_ps256(_mm_loadu_ps(coefs + k));
+			c   = _mm256_permutevar8x32_ps(c, dup);
+			acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(src + k*2), c));
+		}
+	}
+	_mm256_store_ps(lanes, acc);
+
+	if (channels == 1)
+		dest[0] = lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + 
+		          lanes[6] + lanes[7];
+	else {
+		dest[0] = lanes[0] + lanes[2] + lanes[4] + lanes[6];
+		dest[1] = lanes[1] + lanes[3] + lanes[5] + lanes[7];
+	}
+	for (; k<taps; k++)
+		for (int j=0; j<channels; j++)
+			dest[j] += src[k*channels + j] * coefs[k];
+}
+
+
+const Kernels avx2 = { addAvx2_, addRampAvx2_, scaleAvx2_, clipAvx2_, peakAvx2_,
+	measureAvx2_, finalizeAvx2_, decode16Avx2_, upmixAvx2_, fadeAvx2_, reverseAvx2_,
+	convolveAvx2_ };
+
+#endif
+
+
+/* -------------------------------------------------------------------------- */
+
+
+const Kernels* kernels = &scalar;
+Isa            isa     = Isa::SCALAR;
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Meter makeMeter_(float peak, float sum, int samples)
+{
+	return { peak, samples > 0 ? std::sqrt(sum / samples) : 0.0f };
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool isSupported_(Isa i)
+{
+	switch (i) {
+		case Isa::SCALAR: 
+			return true;
+#ifdef G_DSP_X86
+		case Isa::SSE2:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("sse2");
+		case Isa::AVX2:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+#endif
+		default:
+			return false;
+	}
+}
+}; // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+void init()
+{
+	if (!setIsa(Isa::AVX2) && !setIsa(Isa::SSE2))
+		setIsa(Isa::SCALAR);
+	gu_log("[dsp::init] using %s kernels\n", getIsaName(isa));
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool setIsa(Isa i)
+{
+	if (!isSupported_(i))
+		return false;
+	switch (i) {
+#ifdef G_DSP_X86
+		case Isa::SSE2: kernels = &sse2; break;
+		case Isa::AVX2: kernels = &avx2; break;
+#endif
+		default:        kernels = &scalar; break;
+	}
+	isa = i;
+	return true;
+}
+
+
+Isa getIsa()
+{
+	return isa;
+}
+
+
+const char* getIsaName(Isa i)
+{
+	switch (i) {
+		case Isa::SSE2: return "SSE2";
+		case Isa::AVX2: return "AVX2";
+		default:        return "scalar";
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void add(AudioBuffer& dest, const AudioBuffer& src, const float* gains)
+{
+	kernels->add(dest[0], src[0], dest.countFrames(), dest.countChannels(), gains);
+}
+
+
+void addRamp(AudioBuffer& dest, const AudioBuffer& src, const float* gains, 
+	float start, float step)
+{
+	kernels->addRamp(dest[0], src[0], dest.countFrames(), dest.countChannels(), 
+		gains, start, step);
+}
+
+
+void addRamp(AudioBuffer& dest, const AudioBuffer& src, int offset, int frames,
+	const float* gains, float start, float step)
+{
+	kernels->addRamp(dest[offset], src[offset], frames, dest.countChannels(), 
+		gains, start, step);
+}
+
+
+void scale(AudioBuffer& buf, float gain)
+{
+	kernels->scale(buf[0], buf.countSamples(), gain);
+}
+
+
+void clip(AudioBuffer& buf, float limit)
+{
+	kernels->clip(buf[0], buf.countSamples(), limit);
+}
+
+
+float peak(const AudioBuffer& buf)
+{
+	return kernels->peak(buf[0], buf.countSamples());
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void scale(float* buf, int samples, float gain)
+{
+	kernels->scale(buf, samples, gain);
+}
+
+
+float peak(const float* buf, int samples)
+{
+	return kernels->peak(buf, samples);
+}
+
+
+void fade(float* buf, int first, int last, int channels, float start, float step)
+{
+	kernels->fade(buf, first, last, channels, start, step);
+}
+
+
+void reverse(float* buf, int frames, int channels)
+{
+	kernels->reverse(buf, frames, channels);
+}
+
+
+void convolve(float* dest, const float* src, const float* coefs, int taps, 
+	int channels)
+{
+	kernels->convolve(dest, src, coefs, taps, channels);
+}
+
+
+Meter measure(const AudioBuffer& buf)
+{
+	float sum  = 0.0f;
+	float peak = kernels->measure(buf[0], buf.countSamples(), &sum);
+	return makeMeter_(peak, sum, buf.countSamples());
+}
+
+
+Meter finalize(AudioBuffer& buf, const AudioBuffer* mix, float gain, float limit)
+{
+	if (limit <= 0.0f)
+		limit = std::numeric_limits<float>::infinity();
+	float sum  = 0.0f;
+	float peak = kernels->finalize(buf[0], mix != nullptr ? (*mix)[0] : nullptr, 
+		buf.countSamples(), gain, limit, &sum);
+	return makeMeter_(peak, sum, buf.countSamples());
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void decode(AudioBuffer& dest, int offset, const void* src, Format fmt, 
+	int channels, int frames)
+{
+	float* out = dest[offset];
+
+	if (dest.countChannels() != 2 || channels > 2)
+		decodeAny_(out, dest.countChannels(), src, fmt, channels, frames);
+	else
+	if (fmt == Format::INT16)
+		kernels->decode16(out, static_cast<const int16_t*>(src), frames, channels);
+	else
+	if (fmt == Format::FLOAT32 && channels == 1)
+		kernels->upmix(out, static_cast<const float*>(src), frames);
+	else
+	if (fmt == Format::FLOAT32)
+		std::copy(static_cast<const float*>(src), static_cast<const float*>(src) + frames * 2, out);
+	else
+		decodeAny_(out, 2, src, fmt, channels, frames);
+}
+}}} // giada::m::dsp::
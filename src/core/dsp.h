@@ -0,0 +1,163 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#ifndef G_DSP_H
+#define G_DSP_H
+
+
+namespace giada {
+namespace m 
+{
+class AudioBuffer;
+
+namespace dsp
+{
+/* Isa
+Instruction sets the kernels are available for. */
+
+enum class Isa { SCALAR, SSE2, AVX2 };
+
+/* Meter
+Levels of a buffer: highest absolute sample value and root mean square of all 
+samples. */
+
+struct Meter
+{
+	float peak;
+	float rms;
+};
+
+/* Format
+Sample formats decode() reads from. INT24 is packed: 3 bytes per sample, little
+endian. */
+
+enum class Format { INT16, INT24, FLOAT32 };
+
+/* init
+Picks the best kernels for the running CPU. Until then the scalar ones are 
+used. */
+
+void init();
+
+/* setIsa
+Forces a specific implementation. Returns false if the CPU doesn't support it. 
+Useful for tests and benchmarks. */
+
+bool setIsa(Isa isa);
+Isa getIsa();
+const char* getIsaName(Isa isa);
+
+/* The kernels below work on interleaved buffers of the same size. 'gains' is an
+array of one gain per channel, e.g. volume and panning combined. */
+
+/* add
+dest += src * gains */
+
+void add(AudioBuffer& dest, const AudioBuffer& src, const float* gains);
+
+/* addRamp
+dest += src * gains * env, where 'env' is a linear gain ramp clamped to [0, 1]:
+start + frame * step on each frame. */
+
+void addRamp(AudioBuffer& dest, const AudioBuffer& src, const float* gains, 
+	float start, float step);
+
+/* addRamp (range)
+Same as above, on 'frames' frames from frame 'offset' of both buffers: for 
+envelopes made of several ramps in the same block. */
+
+void addRamp(AudioBuffer& dest, const AudioBuffer& src, int offset, int frames,
+	const float* gains, float start, float step);
+
+/* scale
+buf *= gain */
+
+void scale(AudioBuffer& buf, float gain);
+
+/* clip
+Clamps each sample in buf to [-limit, limit]. */
+
+void clip(AudioBuffer& buf, float limit);
+
+/* peak
+Returns the highest absolute sample value in buf. */
+
+float peak(const AudioBuffer& buf);
+
+/* measure
+Returns peak and RMS levels of buf. */
+
+Meter measure(const AudioBuffer& buf);
+
+/* finalize
+Fused output pass: buf = clamp((buf + mix) * gain, -limit, limit), measuring
+the result on the way. 'mix' is optional and can be nullptr; a 'limit' <= 0 
+disables clamping. */
+
+Meter finalize(AudioBuffer& buf, const AudioBuffer* mix, float gain, float limit);
+
+/* The ones below work on raw interleaved data instead, so that callers can 
+split a large buffer in chunks (see wfx). */
+
+/* scale, peak
+As above, on 'samples' samples of buf. */
+
+void  scale(float* buf, int samples, float gain);
+float peak(const float* buf, int samples);
+
+/* fade
+Multiplies frames [first, last) of buf by a linear gain ramp clamped to [0, 1]:
+start + frame * step on each frame, 'frame' counted from the beginning of buf. */
+
+void fade(float* buf, int first, int last, int channels, float start, float step);
+
+/* reverse
+Reverses the order of 'frames' frames in buf, leaving the channels of each one 
+in place. */
+
+void reverse(float* buf, int frames, int channels);
+
+/* convolve
+Writes into the single frame 'dest' the sum of 'taps' frames of src, each 
+weighted by the matching coefficient in 'coefs' (one per frame, shared by all
+channels), i.e. one output frame of a FIR filter. */
+
+void convolve(float* dest, const float* src, const float* coefs, int taps, 
+	int channels);
+
+/* decode
+Converts 'frames' frames of 'src', in format 'fmt' with 'channels' channels, to
+float into 'dest' starting at frame 'offset'. Missing channels (e.g. mono to 
+stereo) take the last source one. */
+
+void decode(AudioBuffer& dest, int offset, const void* src, Format fmt, 
+	int channels, int frames);
+}}} // giada::m::dsp::
+
+
+#endif
@@ -0,0 +1,189 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+
+#include <algorithm>
+#include "recorder.h"
+#include "envelope.h"
+
+
+namespace giada {
+namespace m 
+{
+Envelope::Envelope(int type, uint32_t iValue)
+: m_incoming(nullptr),
+  m_current (nullptr),
+  m_type    (type),
+  m_iValue  (iValue),
+  m_chan    (-1),
+  m_version (0),
+  m_cursor  (0)
+{
+}
+
+
+/* Envelopes are moved only before the audio thread gets to see them. */
+
+Envelope::Envelope(Envelope&& o)
+: m_incoming(o.m_incoming.exchange(nullptr)),
+  m_current (o.m_current),
+  m_type    (o.m_type),
+  m_iValue  (o.m_iValue),
+  m_chan    (o.m_chan),
+  m_version (o.m_version),
+  m_cursor  (0)
+{
+	o.m_current = nullptr;
+}
+
+
+Envelope::~Envelope()
+{
+	std::vector<Point>* p;
+	while (m_trash.pop(p))
+		delete p;
+	delete m_incoming.load();
+	delete m_current;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Envelope::compile(int chan)
+{
+	unsigned version = recorder::getVersion();
+	if (chan == m_chan && version == m_version)
+		return;
+
+	m_chan    = chan;
+	m_version = version;
+
+	/* The timeline is sorted: so are the breakpoints. */
+
+	std::vector<Point>* points = new std::vector<Point>();
+	recorder::forEachAction([this, points] (const recorder::action* a)
+	{
+		if (a->chan != m_chan || a->type != m_type)
+			return;
+		if (m_iValue != 0 && a->iValue != m_iValue)
+			return;
+		points->push_back(Point{ a->frame, a->fValue });
+	});
+
+	/* The audio thread hasn't picked up the previous one, if any: it can go 
+	right away. */
+
+	delete m_incoming.exchange(points);
+
+	std::vector<Point>* old;
+	while (m_trash.pop(old))
+		delete old;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Envelope::prepare()
+{
+	/* Pick up the new breakpoints, as long as the old ones can be given back. */
+
+	if (m_incoming.load() != nullptr && (m_current == nullptr || m_trash.push(m_current)))
+		m_current = m_incoming.exchange(nullptr);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool Envelope::isEmpty() const
+{
+	return m_current == nullptr || m_current->empty();
+}
+
+
+uint32_t Envelope::getIValue() const
+{
+	return m_iValue;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Envelope::seek_(const std::vector<Point>& points, int frame)
+{
+	/* The cursor may come from an older array: out of range or past 'frame' it 
+	is searched again, behind it just walks forward. */
+
+	if (m_cursor >= points.size() || points[m_cursor].frame > frame) {
+		auto it = std::upper_bound(points.begin(), points.end(), frame, 
+			[] (int f, const Point& p) { return f < p.frame; });
+		m_cursor = it == points.begin() ? 0 : it - points.begin() - 1;
+		return;
+	}
+	while (m_cursor + 1 < points.size() && points[m_cursor + 1].frame <= frame)
+		m_cursor++;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Envelope::Ramp Envelope::getRamp(int frame, int frames)
+{
+	const std::vector<Point>* points = m_current;
+	if (isEmpty())
+		return Ramp{ frames, 1.0f, 0.0f };
+
+	seek_(*points, frame);
+
+	const Point& p0 = (*points)[m_cursor];
+
+	if (frame < p0.frame)  // before the first breakpoint
+		return Ramp{ std::min(frames, p0.frame - frame), p0.value, 0.0f };
+	if (m_cursor + 1 == points->size())  // after the last one
+		return Ramp{ frames, p0.value, 0.0f };
+
+	const Point& p1 = (*points)[m_cursor + 1];
+
+	float step = (p1.value - p0.value) / (p1.frame - p0.frame);
+	return Ramp{ std::min(frames, p1.frame - frame), 
+		p0.value + step * (frame - p0.frame), step };
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+float Envelope::getValue(int frame)
+{
+	return getRamp(frame, 1).start;
+}
+}} // giada::m::
@@ -0,0 +1,136 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+
+#ifndef G_ENVELOPE_H
+#define G_ENVELOPE_H
+
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "queue.h"
+
+
+namespace giada {
+namespace m 
+{
+/* Envelope
+An automation curve of a channel (e.g. its volume), compiled from the recorded
+actions of one type into a flat array of breakpoints, in frames at the current 
+tempo. The value moves linearly from a breakpoint to the next one and holds 
+before the first and after the last. The array is built off the audio thread 
+and published with an atomic pointer swap. The audio thread only reads it: it
+walks it with a cursor and gets it back as ramps, so what it costs depends on 
+the number of breakpoints crossed, not on the number of frames in between. It 
+gives the old arrays back to be freed elsewhere, as pitchCache::Slot does. */
+
+class Envelope
+{
+public:
+
+	/* Ramp
+	A straight piece of the envelope: 'frames' frames long, starting from value
+	'start' and moving by 'step' each frame. */
+
+	struct Ramp
+	{
+		int   frames;
+		float start;
+		float step;
+	};
+
+	/* Envelope
+	Follows actions of type 'type'. If 'iValue' != 0 only the actions with that
+	iValue are taken, e.g. one plug-in parameter among many. */
+
+	Envelope(int type, uint32_t iValue=0);
+	Envelope(Envelope&& o);
+	~Envelope();
+
+	/* compile
+	Rebuilds the breakpoints from the actions of channel 'chan', if they or the
+	tempo changed since the last call, and publishes them. Also frees the arrays
+	given back by the audio thread. One non-audio thread only. */
+
+	void compile(int chan);
+
+	/* prepare
+	Picks up the breakpoints published by compile(). Audio thread only, once per
+	block before any of the functions below. */
+
+	void prepare();
+
+	bool isEmpty() const;
+	uint32_t getIValue() const;
+
+	/* getRamp
+	Returns the ramp from frame 'frame' of the sequencer, no longer than 
+	'frames': it stops on the next breakpoint. Consecutive calls on ascending 
+	frames cost amortized O(1). */
+
+	Ramp getRamp(int frame, int frames);
+
+	/* getValue
+	Returns the value on frame 'frame'. */
+
+	float getValue(int frame);
+
+private:
+
+	struct Point
+	{
+		int   frame;
+		float value;
+	};
+
+	/* seek_
+	Moves the cursor to the last breakpoint in 'points' on or before 'frame', or
+	to the first one if none. */
+
+	void seek_(const std::vector<Point>& points, int frame);
+
+	/* m_incoming, m_current, m_trash
+	Breakpoints published by compile() and not picked up yet, those in use by the
+	audio thread (nullptr if none yet), and those it gave back. */
+
+	std::atomic<std::vector<Point>*> m_incoming;
+	std::vector<Point>*              m_current;
+	Queue<std::vector<Point>*, 8>    m_trash;
+
+	int         m_type;
+	uint32_t    m_iValue;
+	int         m_chan;     // compile() only
+	unsigned    m_version;  // compile() only
+	std::size_t m_cursor;   // audio thread only
+};
+}} // giada::m::
+
+
+#endif
@@ -52,6 +52,13 @@
 #include "midiMapConf.h"
 #include "kernelMidi.h"
 #include "kernelAudio.h"
+#include "command.h"
+#include "workers.h"
+#include "dsp.h"
+#include "streamer.h"
+#include "peakBuilder.h"
+#include "pitchCache.h"
+#include "waveCache.h"
 
 
 extern bool		 		   G_quit;
@@ -83,9 +90,16 @@ void init_prepareParser()
 void init_prepareKernelAudio()
 {
   kernelAudio::openDevice();
+  command::init();
+  dsp::init();
   clock::init(conf::samplerate, conf::midiTCfps);
 	mixer::init(clock::getFramesInLoop(), kernelAudio::getRealBufSize());
 	recorder::init();
+	workers::init(conf::renderThreads);
+	streamer::init();
+	peakBuilder::init();
+	pitchCache::init();
+	waveCache::init(gu_getHomePath() + G_SLASH + G_WAVE_CACHE_DIR, conf::waveCacheSize);
 
 #ifdef WITH_VST
 
@@ -111,7 +125,9 @@ void init_prepareKernelMIDI()
 {
 	kernelMidi::setApi(conf::midiSystem);
 	kernelMidi::openOutDevice(conf::midiPortOut);
-	kernelMidi::openInDevice(conf::midiPortIn);
+	kernelMidi::openInDevice(-1);
+	for (const conf::MidiPortIn& p : conf::midiPortsIn)
+		kernelMidi::openInDevice(p.port, p.filter, p.ns);
 }
 
 
@@ -212,6 +228,22 @@ void init_shutdown()
 		gu_log("[init] Mixer closed\n");
 	}
 
+	workers::close();
+	gu_log("[init] Render threads stopped\n");
+
+	streamer::close();
+	gu_log("[init] Disk streamer stopped\n");
+
+	peakBuilder::close();
+	gu_log("[init] Peak builder stopped\n");
+
+	pitchCache::close();
+	gu_log("[init] Pitch cache stopped\n");
+
+	kernelMidi::closeInDevice();
+	kernelMidi::closeOutDevice();
+	gu_log("[init] KernelMidi closed\n");
+
 	gu_log("[init] Giada " G_VERSION_STR " closed\n\n");
 	gu_logClose();
 }
@@ -25,6 +25,11 @@
  * -------------------------------------------------------------------------- */
 
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include "const.h"
 #ifdef G_OS_MAC
 	#include <RtMidi.h>
@@ -34,6 +39,9 @@
 #include "../utils/log.h"
 #include "midiDispatcher.h"
 #include "midiMapConf.h"
+#include "conf.h"
+#include "queue.h"
+#include "command.h"
 #include "kernelMidi.h"
 
 
@@ -54,9 +62,107 @@ RtMidiIn*  midiIn  = nullptr;
 unsigned numOutPorts = 0;
 unsigned numInPorts  = 0;
 
+using Clock = std::chrono::steady_clock;
+
+constexpr int OUT_QUEUE_SIZE     = 2048;
+constexpr int IN_QUEUE_SIZE      = 512;
+constexpr int MAX_BLOCK_MESSAGES = 256;
+constexpr int SENDER_POLL        = 250;  // in microseconds
+constexpr int READER_POLL        = 250;  // in microseconds
+
+/* OutMessage
+A MIDI message produced by the audio thread, waiting for the sender thread. 
+'offset' is the frame within the block it belongs to, 'time' the moment it is
+due, computed from the block start time and 'offset'. */
+
+struct OutMessage
+{
+	unsigned char     data[3];
+	int               size;
+	int               offset;
+	Clock::time_point time;
+};
+
+/* outQueue, sender
+The audio thread never talks to RtMidi directly: messages travel through 
+outQueue, drained by the sender thread. Other threads send right away: outMutex
+serializes them with the sender thread. */
+
+Queue<OutMessage, OUT_QUEUE_SIZE> outQueue;
+std::thread       sender;
+std::atomic<bool> senderRunning(false);
+std::mutex        outMutex;
+
+/* Audio thread state: messages of the current block are kept sorted by offset
+and handed to outQueue in endBlock(). */
+
+thread_local bool isAudioThread = false;
+OutMessage        blockMessages[MAX_BLOCK_MESSAGES];
+int               blockCount = 0;
+Clock::time_point blockTime;
+std::atomic<unsigned> dropped(0);
+
+/* Jitter statistics, written by the sender thread only. */
+
+std::atomic<unsigned> jitterCount(0);
+std::atomic<long>     jitterSum(0);
+std::atomic<long>     jitterMax(0);
+
+/* InMessage
+A MIDI message received from an input port, stamped on arrival. */
+
+struct InMessage
+{
+	unsigned char     data[3];
+	Clock::time_point time;
+};
+
+/* InPort
+An open input port. RtMidi's own thread for the port pushes messages into 
+'queue', the reader thread pops them. Latency statistics belong to the device:
+from arrival to the moment the reader takes the message off this queue, so that
+traffic on the other ports doesn't show up in them. Written by the reader 
+thread only. */
+
+struct InPort
+{
+	InPort(RtMidiIn* device, int port, int filter, int ns)
+	: device(device), port(port), filter(filter), ns(ns), dropped(0),
+	  latencyCount(0), latencySum(0), latencyMax(0)
+	{
+	}
+
+	RtMidiIn* device;
+	int       port;
+	int       filter;
+	int       ns;
+
+	Queue<InMessage, IN_QUEUE_SIZE> queue;
+
+	std::atomic<unsigned> dropped;
+	std::atomic<unsigned> latencyCount;
+	std::atomic<long>     latencySum;
+	std::atomic<long>     latencyMax;
+};
+
+/* inPorts, reader
+Messages from all input ports are merged into a single stream, in arrival 
+order, by the reader thread: midiDispatcher is never called concurrently. 
+inPorts changes only while the reader is stopped. */
+
+vector<std::unique_ptr<InPort>> inPorts;
+std::thread       reader;
+std::atomic<bool> readerRunning(false);
+
 
 static void callback(double t, std::vector<unsigned char>* msg, void* data)
 {
+	/* RtMidi's 't' is the delta time from the previous message, useless to 
+	place the message on the audio timeline: stamp it on arrival instead. */
+
+	Clock::time_point now = Clock::now();
+	InPort* in = static_cast<InPort*>(data);
+
 	if (msg->size() < 3) {
 		//gu_log("[KM] MIDI received - unknown signal - size=%d, value=0x", (int) msg->size());
 		//for (unsigned i=0; i<msg->size(); i++)
@@ -64,7 +170,165 @@ static void callback(double t, std::vector<unsigned char>* msg, void* data)
 		//gu_log("\n");
 		return;
 	}
-	midiDispatcher::dispatch(msg->at(0), msg->at(1), msg->at(2));
+
+	/* Port filter: channel messages on other MIDI channels never leave here. */
+
+	if (in->filter != -1 && msg->at(0) < 0xF0 && (msg->at(0) & 0x0F) != in->filter)
+		return;
+
+	InMessage m = { { msg->at(0), msg->at(1), msg->at(2) }, now };
+	if (!in->queue.push(m))
+		in->dropped++;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void sendNow_(const unsigned char* data, int size)
+{
+	static vector<unsigned char> msg;  // reused, guarded by outMutex
+
+	std::lock_guard<std::mutex> lock(outMutex);
+	msg.assign(data, data + size);
+	midiOut->sendMessage(&msg);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* enqueue_
+Adds a message to the current block, keeping messages sorted by offset (and by
+arrival order on the same offset). Audio thread only. */
+
+void enqueue_(const unsigned char* data, int size, int offset)
+{
+	if (blockCount == MAX_BLOCK_MESSAGES) {
+		dropped++;
+		return;
+	}
+
+	int i = blockCount++;
+	for (; i > 0 && blockMessages[i - 1].offset > offset; i--)
+		blockMessages[i] = blockMessages[i - 1];
+
+	OutMessage& m = blockMessages[i];
+	for (int j=0; j<size; j++)
+		m.data[j] = data[j];
+	m.size   = size;
+	m.offset = offset;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void send_(const unsigned char* data, int size, int offset)
+{
+	if (isAudioThread)
+		enqueue_(data, size, offset);
+	else
+		sendNow_(data, size);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void updateJitter_(Clock::duration late)
+{
+	long us = std::chrono::duration_cast<std::chrono::microseconds>(late).count();
+	jitterCount++;
+	jitterSum += us;
+	if (us > jitterMax)
+		jitterMax = us;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+void updateLatency_(InPort& in, Clock::duration late)
+{
+	long us = std::chrono::duration_cast<std::chrono::microseconds>(late).count();
+	in.latencyCount++;
+	in.latencySum += us;
+	if (us > in.latencyMax)
+		in.latencyMax = us;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* readerLoop_
+Reader thread body. Keeps the oldest message of each port aside and dispatches
+the earliest among them, so that the merged stream is ordered by arrival time
+(each port's queue already is). */
+
+void readerLoop_()
+{
+	command::bind(command::Producer::MIDI);
+
+	vector<InMessage> heads(inPorts.size());
+	vector<bool>      hasHead(inPorts.size(), false);
+
+	while (readerRunning) {
+		int next = -1;
+		for (unsigned i=0; i<inPorts.size(); i++) {
+			if (!hasHead[i]) {
+				hasHead[i] = inPorts[i]->queue.pop(heads[i]);
+				if (hasHead[i])
+					updateLatency_(*inPorts[i], Clock::now() - heads[i].time);
+			}
+			if (hasHead[i] && (next == -1 || heads[i].time < heads[next].time))
+				next = i;
+		}
+		if (next == -1) {
+			std::this_thread::sleep_for(std::chrono::microseconds(READER_POLL));
+			continue;
+		}
+		const InMessage& m = heads[next];
+		midiDispatcher::dispatch(m.data[0], m.data[1], m.data[2], m.time, 
+			inPorts[next]->ns);
+		hasHead[next] = false;
+	}
+}
+
+
+void startReader_()
+{
+	if (inPorts.empty())
+		return;
+	readerRunning = true;
+	reader = std::thread(readerLoop_);
+}
+
+
+void stopReader_()
+{
+	if (!readerRunning)
+		return;
+	readerRunning = false;
+	reader.join();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* senderLoop_
+Sender thread body. Waits for each message to be due, then sends it. */
+
+void senderLoop_()
+{
+	OutMessage m;
+	while (senderRunning) {
+		if (!outQueue.pop(m)) {
+			std::this_thread::sleep_for(std::chrono::microseconds(SENDER_POLL));
+			continue;
+		}
+		std::this_thread::sleep_until(m.time);
+		sendNow_(m.data, m.size);
+		updateJitter_(Clock::now() - m.time);
+	}
 }
 
 
@@ -102,9 +366,13 @@ void setApi(int _api)
 
 int openOutDevice(int port)
 {
+	closeOutDevice();
+
 	try {
 		midiOut = new RtMidiOut((RtMidi::Api) api, "Giada MIDI Output");
 		status = true;
+		senderRunning = true;
+		sender = std::thread(senderLoop_);
 	}
 	catch (RtMidiError &error) {
 		gu_log("[KM] MIDI out device error: %s\n", error.getMessage().c_str());
@@ -146,43 +414,84 @@ int openOutDevice(int port)
 /* -------------------------------------------------------------------------- */
 
 
-int openInDevice(int port)
+int openInDevice(int port, int filter, int ns)
 {
+	/* The first call creates the device used to list ports: each port is then 
+	opened on a device of its own, as RtMidi wants. */
+
+	if (midiIn == nullptr) {
+		try {
+			midiIn = new RtMidiIn((RtMidi::Api) api, "Giada MIDI input");
+			status = true;
+		}
+		catch (RtMidiError &error) {
+			gu_log("[KM] MIDI in device error: %s\n", error.getMessage().c_str());
+			status = false;
+			return 0;
+		}
+
+		/* print input ports */
+
+		numInPorts = midiIn->getPortCount();
+		gu_log("[KM] %d input MIDI ports found\n", numInPorts);
+		for (unsigned i=0; i<numInPorts; i++)
+			gu_log("  %d) %s\n", i, getInPortName(i).c_str());
+	}
+
+	/* try to open a port, if enabled */
+
+	if (port == -1 || numInPorts == 0)
+		return 2;
+
+	if (port >= (int) numInPorts || inPorts.size() == G_MAX_MIDI_IN_PORTS) {
+		gu_log("[KM] unable to open MIDI in port %d: not available\n", port);
+		return 0;
+	}
+
+	RtMidiIn* device = nullptr;
 	try {
-		midiIn = new RtMidiIn((RtMidi::Api) api, "Giada MIDI input");
-		status = true;
+		device = new RtMidiIn((RtMidi::Api) api, "Giada MIDI input");
+		device->openPort(port, getInPortName(port));
+		device->ignoreTypes(true, false, true); // ignore all system/time msgs, for now
 	}
 	catch (RtMidiError &error) {
-		gu_log("[KM] MIDI in device error: %s\n", error.getMessage().c_str());
-		status = false;
+		gu_log("[KM] unable to open MIDI in port %d: %s\n", port, error.getMessage().c_str());
+		delete device;
 		return 0;
 	}
 
-	/* print input ports */
+	stopReader_();
+	inPorts.emplace_back(new InPort(device, port, filter, ns));
+	device->setCallback(&callback, inPorts.back().get());
+	startReader_();
 
-	numInPorts = midiIn->getPortCount();
-	gu_log("[KM] %d input MIDI ports found\n", numInPorts);
-	for (unsigned i=0; i<numInPorts; i++)
-		gu_log("  %d) %s\n", i, getInPortName(i).c_str());
+	gu_log("[KM] MIDI in port %d open (filter=%d, namespace=%d), %zu ports open\n", 
+		port, filter, ns, inPorts.size());
+	return 1;
+}
 
-	/* try to open a port, if enabled */
 
-	if (port != -1 && numInPorts > 0) {
-		try {
-			midiIn->openPort(port, getInPortName(port));
-			midiIn->ignoreTypes(true, false, true); // ignore all system/time msgs, for now
-			gu_log("[KM] MIDI in port %d open\n", port);
-			midiIn->setCallback(&callback);
-			return 1;
-		}
-		catch (RtMidiError &error) {
-			gu_log("[KM] unable to open MIDI in port %d: %s\n", port, error.getMessage().c_str());
-			status = false;
-			return 0;
-		}
+/* -------------------------------------------------------------------------- */
+
+
+int closeInDevice()
+{
+	if (midiIn == nullptr)
+		return 0;
+
+	stopReader_();
+
+	for (const std::unique_ptr<InPort>& in : inPorts) {
+		JitterStats stats = getInLatencyStats(in->port);
+		gu_log("[KM] MIDI in port %d closed - latency avg=%.1fus max=%ldus (%u msgs, %u dropped)\n", 
+			in->port, stats.average, stats.max, stats.count, in->dropped.load());
+		delete in->device;  // closes the port
 	}
-	else
-		return 2;
+	inPorts.clear();
+
+	delete midiIn;
+	midiIn = nullptr;
+	return 1;
 }
 
 
@@ -219,36 +528,63 @@ string getInPortName(unsigned p)
 /* -------------------------------------------------------------------------- */
 
 
-void send(uint32_t data)
+int closeOutDevice()
+{
+	if (midiOut == nullptr)
+		return 0;
+
+	if (senderRunning) {
+		senderRunning = false;
+		sender.join();
+	}
+
+	JitterStats stats = getJitterStats();
+	gu_log("[KM] MIDI out closed - jitter avg=%.1fus max=%ldus (%u msgs, %u dropped)\n", 
+		stats.average, stats.max, stats.count, dropped.load());
+
+	delete midiOut;
+	midiOut = nullptr;
+	return 1;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void send(uint32_t data, int offset)
 {
 	if (!status)
 		return;
 
-	vector<unsigned char> msg(1, getB1(data));
-	msg.push_back(getB2(data));
-	msg.push_back(getB3(data));
+	unsigned char msg[3] = { 
+		(unsigned char) getB1(data), 
+		(unsigned char) getB2(data), 
+		(unsigned char) getB3(data) 
+	};
+	send_(msg, 3, offset);
 
-	midiOut->sendMessage(&msg);
-	gu_log("[KM] send msg=0x%X (%X %X %X)\n", data, msg[0], msg[1], msg[2]);
+	if (!isAudioThread)
+		gu_log("[KM] send msg=0x%X (%X %X %X)\n", data, msg[0], msg[1], msg[2]);
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void send(int b1, int b2, int b3)
+void send(int b1, int b2, int b3, int offset)
 {
 	if (!status)
 		return;
 
-	vector<unsigned char> msg(1, b1);
+	unsigned char msg[3] = { (unsigned char) b1 };
+	int size = 1;
 
 	if (b2 != -1)
-		msg.push_back(b2);
+		msg[size++] = b2;
 	if (b3 != -1)
-		msg.push_back(b3);
+		msg[size++] = b3;
 
-	midiOut->sendMessage(&msg);
+	send_(msg, size, offset);
 	//gu_log("[KM] send msg=(%X %X %X)\n", b1, b2, b3);
 }
 
@@ -256,18 +592,87 @@ void send(int b1, int b2, int b3)
 /* -------------------------------------------------------------------------- */
 
 
+void beginBlock()
+{
+	isAudioThread = true;
+	blockTime     = Clock::now();
+	blockCount    = 0;
+}
+
+
+void endBlock(int bufferSize)
+{
+	/* Messages are due one block later than the block start, i.e. when the audio
+	rendered in this block is actually played. */
+
+	double frameTime = 1.0 / conf::samplerate;
+
+	for (int i=0; i<blockCount; i++) {
+		OutMessage& m = blockMessages[i];
+		m.time = blockTime + std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double>((bufferSize + m.offset) * frameTime));
+		if (!outQueue.push(m))
+			dropped++;
+	}
+	blockCount = 0;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+JitterStats getJitterStats()
+{
+	JitterStats stats;
+	stats.count   = jitterCount;
+	stats.average = stats.count > 0 ? jitterSum / (double) stats.count : 0.0;
+	stats.max     = jitterMax;
+	return stats;
+}
+
+
+void resetJitterStats()
+{
+	jitterCount = 0;
+	jitterSum   = 0;
+	jitterMax   = 0;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+JitterStats getInLatencyStats(int port)
+{
+	JitterStats stats = { 0, 0.0, 0 };
+	for (const std::unique_ptr<InPort>& in : inPorts) {
+		if (in->port != port)
+			continue;
+		stats.count   = in->latencyCount;
+		stats.average = stats.count > 0 ? in->latencySum / (double) stats.count : 0.0;
+		stats.max     = in->latencyMax;
+	}
+	return stats;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 void sendMidiLightning(uint32_t learn, const midimap::message_t& msg)
 {
 	// Skip lightning message if not defined in midi map
 
 	if (!midimap::isDefined(msg))
 	{
-		gu_log("[KM] message skipped (not defined in midimap)");
+		if (!isAudioThread)
+			gu_log("[KM] message skipped (not defined in midimap)");
 		return;
 	}
 
-	gu_log("[KM] learn=%#X, chan=%d, msg=%#X, offset=%d\n", learn, msg.channel, 
-		msg.value, msg.offset);
+	if (!isAudioThread)
+		gu_log("[KM] learn=%#X, chan=%d, msg=%#X, offset=%d\n", learn, msg.channel, 
+			msg.value, msg.offset);
 
 	/* Isolate 'channel' from learnt message and offset it as requested by 'nn' in 
 	the midimap configuration file. */
@@ -289,6 +694,12 @@ unsigned countInPorts()
 }
 
 
+unsigned countOpenInPorts()
+{
+	return inPorts.size();
+}
+
+
 unsigned countOutPorts()
 {
 	return numOutPorts;
@@ -51,10 +51,41 @@ channel. */
 uint32_t setChannel(uint32_t iValue, int channel);
 
 /* send
-Sends a MIDI message 's' as uint32_t or as separate bytes. */
+Sends a MIDI message 's' as uint32_t or as separate bytes. When called by the 
+audio thread the message is not sent right away: it is queued and sent by a
+separate thread when due, according to 'offset', i.e. its frame in the current
+block. Other threads send immediately and ignore 'offset'. */
 
-void send(uint32_t s);
-void send(int b1, int b2=-1, int b3=-1);
+void send(uint32_t s, int offset=0);
+void send(int b1, int b2=-1, int b3=-1, int offset=0);
+
+/* beginBlock, endBlock
+Mark the boundaries of an audio block. Call them from the audio callback: 
+messages sent in between are stamped with the block start time. */
+
+void beginBlock();
+void endBlock(int bufferSize);
+
+/* JitterStats
+How late MIDI messages coming from the audio thread have been sent with respect
+to their due time, in microseconds. */
+
+struct JitterStats
+{
+	unsigned count;
+	double   average;
+	long     max;
+};
+
+JitterStats getJitterStats();
+void resetJitterStats();
+
+/* getInLatencyStats
+How long messages from input port 'port' (as passed to openInDevice()) have 
+waited before the reader picked them up, in microseconds. All zeros if the 
+port isn't open. */
+
+JitterStats getInLatencyStats(int port);
 
 /* sendMidiLightning
 Sends a MIDI lightning message defined by 'msg'. */
@@ -74,10 +105,21 @@ bool getStatus();
 /* open/close/in/outDevice */
 
 int openOutDevice(int port);
-int openInDevice(int port);
-int closeInDevice();
 int closeOutDevice();
 
+/* openInDevice
+Opens the input port 'port', on top of the ones already open: messages from 
+all of them are merged into a single stream, ordered by arrival time. Only 
+messages on MIDI channel 'filter' (-1 = any) get through; 'ns' is the learn 
+namespace of the port (see conf::MidiPortIn). Port -1 just lists the ports. */
+
+int openInDevice(int port, int filter=-1, int ns=0);
+
+/* closeInDevice
+Closes all input ports. */
+
+int closeInDevice();
+
 /* getIn/OutPortName
  * return the name of the port 'p'. */
 
@@ -86,6 +128,7 @@ std::string getOutPortName(unsigned p);
 
 unsigned countInPorts();
 unsigned countOutPorts();
+unsigned countOpenInPorts();
 
 bool hasAPI(int API);
 
@@ -40,6 +40,7 @@
 
 
 using std::string;
+using std::vector;
 using namespace giada;
 using namespace giada::m;
 
@@ -67,9 +68,10 @@ void MidiChannel::copy(const Channel* src_, pthread_mutex_t* pluginMutex)
 /* -------------------------------------------------------------------------- */
 
 
-void MidiChannel::parseEvents(mixer::FrameEvents fe)
+void MidiChannel::parseEvents(const vector<mixer::FrameEvents>& events)
 {
-	midiChannelProc::parseEvents(this, fe);
+	for (const mixer::FrameEvents& fe : events)
+		midiChannelProc::parseEvents(this, fe);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -189,7 +191,7 @@ void MidiChannel::sendMidi(recorder::action* a, int localFrame)
 {
 	if (isPlaying() && !mute) {
 		if (midiOut)
-			kernelMidi::send(a->iValue | MIDI_CHANS[midiOutChan]);
+			kernelMidi::send(a->iValue | MIDI_CHANS[midiOutChan], localFrame);
 
 #ifdef WITH_VST
 		addVstMidiEvent(a->iValue, localFrame);
@@ -213,7 +215,7 @@ void MidiChannel::sendMidi(uint32_t data)
 /* -------------------------------------------------------------------------- */
 
 
-void MidiChannel::receiveMidi(const MidiEvent& midiEvent)
+void MidiChannel::receiveMidi(const MidiEvent& midiEvent, int localFrame)
 {
 	if (!armed)
 		return;
@@ -226,20 +228,12 @@ void MidiChannel::receiveMidi(const MidiEvent& midiEvent)
 	midiEventFlat.setChannel(0);
 
 #ifdef WITH_VST
-
-	while (true) {
-		if (pthread_mutex_trylock(&pluginHost::mutex_midi) != 0)
-			continue;
-		gu_log("[MidiChannel::processMidi] msg=%X\n", midiEventFlat.getRaw());
-		addVstMidiEvent(midiEventFlat.getRaw(), 0);
-		pthread_mutex_unlock(&pluginHost::mutex_midi);
-		break;
-	}
-
+	addVstMidiEvent(midiEventFlat.getRaw(), localFrame);
 #endif
 
 	if (recorder::canRec(this, clock::isRunning(), mixer::recording)) {
-		recorder::rec(index, G_ACTION_MIDI, clock::getCurrentFrame(), midiEventFlat.getRaw());
+		recorder::rec(index, G_ACTION_MIDI, clock::getFrameAt(localFrame), 
+			midiEventFlat.getRaw());
 		hasActions = true;
 	}
 }
@@ -46,7 +46,7 @@ public:
 	MidiChannel(int bufferSize);
 
 	void copy(const Channel* src, pthread_mutex_t* pluginMutex) override;
-	void parseEvents(giada::m::mixer::FrameEvents fe) override;
+	void parseEvents(const std::vector<giada::m::mixer::FrameEvents>& events) override;
 	void process(giada::m::AudioBuffer& out, const giada::m::AudioBuffer& in, 
 		bool audible, bool running) override;
 	void start(int frame, bool doQuantize, int velocity) override;
@@ -59,7 +59,7 @@ public:
 	void setSolo(bool value) override;
 	void readPatch(const std::string& basePath, int i) override;
 	void writePatch(int i, bool isProject) override;
-	void receiveMidi(const giada::m::MidiEvent& midiEvent) override;
+	void receiveMidi(const giada::m::MidiEvent& midiEvent, int localFrame) override;
 	bool canInputRec() override;
 
 	/* sendMidi
@@ -2,6 +2,7 @@
 #include "pluginHost.h"
 #include "kernelMidi.h"
 #include "const.h"
+#include "dsp.h"
 #include "midiChannelProc.h"
 #include "mixerHandler.h"
 
@@ -32,7 +33,7 @@ void parseAction_(MidiChannel* ch, const recorder::action* a, int localFrame)
 {
 	if (ch->isPlaying() && !ch->mute) {
 		if (ch->midiOut)
-			kernelMidi::send(a->iValue | MIDI_CHANS[ch->midiOutChan]);
+			kernelMidi::send(a->iValue | MIDI_CHANS[ch->midiOutChan], localFrame);
 #ifdef WITH_VST
 		ch->addVstMidiEvent(a->iValue, localFrame);
 #endif
@@ -47,13 +48,13 @@ void parseAction_(MidiChannel* ch, const recorder::action* a, int localFrame)
 /* -------------------------------------------------------------------------- */
 
 
-void parseEvents(MidiChannel* ch, mixer::FrameEvents fe)
+void parseEvents(MidiChannel* ch, const mixer::FrameEvents& fe)
 {
 	if (fe.onFirstBeat)
 		onFirstBeat_(ch);
-	for (const recorder::action* action : fe.actions)
-		if (action->chan == ch->index && action->type == G_ACTION_MIDI)
-			parseAction_(ch, action, fe.frameLocal);
+	for (const recorder::action& action : fe.actions)
+		if (action.chan == ch->index && action.type == G_ACTION_MIDI)
+			parseAction_(ch, &action, fe.frameLocal);
 }
 
 
@@ -72,10 +73,10 @@ void process(MidiChannel* ch, giada::m::AudioBuffer& out,
 	note-off while triggering a mute/solo. */
 
 	/* TODO - this is meaningful only if WITH_VST is defined */
-	if (audible)
-		for (int i=0; i<out.countFrames(); i++)
-			for (int j=0; j<out.countChannels(); j++)
-				out[i][j] += ch->buffer[i][j] * ch->volume;	
+	if (audible) {
+		const float gains[G_MAX_IO_CHANS] = { ch->volume, ch->volume };
+		dsp::add(out, ch->buffer, gains);
+	}
 }
 
 
@@ -109,7 +110,7 @@ void start(MidiChannel* ch)
 /* -------------------------------------------------------------------------- */
 
 
-void kill(MidiChannel* ch, int localFrame)
+void kill(MidiChannel* ch, int /*localFrame*/)
 {
 	if (ch->isPlaying()) {
 		if (ch->midiOut)
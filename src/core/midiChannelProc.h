@@ -14,9 +14,9 @@ namespace m {
 namespace midiChannelProc
 {
 /* parseEvents
-Parses events gathered by Mixer::masterPlay(). */
+Parses a single event gathered by Mixer::masterPlay(). */
 
-void parseEvents(MidiChannel* ch, mixer::FrameEvents ev);
+void parseEvents(MidiChannel* ch, const mixer::FrameEvents& fe);
 
 /**/
 void process(MidiChannel* ch, giada::m::AudioBuffer& out, 
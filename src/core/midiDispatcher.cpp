@@ -25,7 +25,9 @@
  * -------------------------------------------------------------------------- */
 
 
+#include <atomic>
 #include <vector>
+#include <unordered_map>
 #include "../glue/plugin.h"
 #include "../glue/io.h"
 #include "../glue/channel.h"
@@ -39,6 +41,7 @@
 #include "mixer.h"
 #include "pluginHost.h"
 #include "plugin.h"
+#include "command.h"
 #include "midiDispatcher.h"
 
 
@@ -59,107 +62,193 @@ cb_midiLearn* cb_learn = nullptr;
 void* cb_data = nullptr;	
 
 
+/* RouteType, Route
+A learned binding: what to do and on which target. 'ch' is nullptr for master
+bindings, 'plugin' and 'param' are used by plug-in parameters only. */
+
+enum class RouteType
+{
+	KEY_PRESS, KEY_RELEASE, MUTE, KILL, ARM, SOLO, VOLUME, PITCH, READ_ACTIONS,
+	PLUGIN_PARAM, REWIND, START_STOP, ACTION_REC, INPUT_REC, METRONOME, 
+	VOLUME_IN, VOLUME_OUT, BEAT_DOUBLE, BEAT_HALF
+};
+
+struct Route
+{
+	RouteType type;
+	Channel*  ch;
+	int       param;   // plug-in parameter, 0 if none
+	int       plugin;  // Plugin::getId(), 0 if none
+};
+
+
+/* routes
+Routing index: pure MIDI message (i.e. without velocity, with the namespace of 
+the port in its lowest byte) -> bindings learned for it, master ones first, 
+then channels in mixer order. Rebuilt by the MIDI 
+thread when 'dirty' is set, so that each message costs only the bindings it 
+matches. */
+
+std::unordered_map<uint32_t, vector<Route>> routes;
+
+
+/* midiChannels
+MIDI channels receive every message (the full one, velocity included), learned
+or not. */
+
+vector<Channel*> midiChannels;
+
+std::atomic<bool> dirty(true);
+
+
 /* -------------------------------------------------------------------------- */
 
 
-#ifdef WITH_VST
+void addRoute(uint32_t pure, Route r)
+{
+	if (pure == 0x0)  // Not learned
+		return;
+
+	vector<Route>& targets = routes[pure];
+
+	/* Master and channel functions sharing the same message are mutually 
+	exclusive on the same target: only the first one in the chain is triggered. 
+	Plug-in parameters always are, on top of them. */
+
+	if (r.type != RouteType::PLUGIN_PARAM)
+		for (const Route& t : targets)
+			if (t.ch == r.ch && t.type != RouteType::PLUGIN_PARAM)
+				return;
+
+	targets.push_back(r);
+}
+
 
-void processPlugins(Channel* ch, const MidiEvent& midiEvent)
+/* -------------------------------------------------------------------------- */
+
+
+void rebuild()
 {
-	uint32_t pure = midiEvent.getRawNoVelocity();
+	routes.clear();
+	midiChannels.clear();
+
+	addRoute(conf::midiInRewind,     { RouteType::REWIND,      nullptr, 0, 0 });
+	addRoute(conf::midiInStartStop,  { RouteType::START_STOP,  nullptr, 0, 0 });
+	addRoute(conf::midiInActionRec,  { RouteType::ACTION_REC,  nullptr, 0, 0 });
+	addRoute(conf::midiInInputRec,   { RouteType::INPUT_REC,   nullptr, 0, 0 });
+	addRoute(conf::midiInMetronome,  { RouteType::METRONOME,   nullptr, 0, 0 });
+	addRoute(conf::midiInVolumeIn,   { RouteType::VOLUME_IN,   nullptr, 0, 0 });
+	addRoute(conf::midiInVolumeOut,  { RouteType::VOLUME_OUT,  nullptr, 0, 0 });
+	addRoute(conf::midiInBeatDouble, { RouteType::BEAT_DOUBLE, nullptr, 0, 0 });
+	addRoute(conf::midiInBeatHalf,   { RouteType::BEAT_HALF,   nullptr, 0, 0 });
 
-	/* Plugins' parameters layout reflects the structure of the matrix
-	Channel::midiInPlugins. It is safe to assume then that i (i.e. Plugin*) and k 
-	indexes match both the structure of Channel::midiInPlugins and 
-	vector<Plugin*>* plugins. */
+	for (Channel* ch : mixer::channels) {
 
-	vector<Plugin*>* plugins = pluginHost::getStack(pluginHost::CHANNEL, ch);
+		addRoute(ch->midiInKeyPress, { RouteType::KEY_PRESS,   ch, 0, 0 });
+		addRoute(ch->midiInKeyRel,   { RouteType::KEY_RELEASE, ch, 0, 0 });
+		addRoute(ch->midiInMute,     { RouteType::MUTE,        ch, 0, 0 });
+		addRoute(ch->midiInKill,     { RouteType::KILL,        ch, 0, 0 });
+		addRoute(ch->midiInArm,      { RouteType::ARM,         ch, 0, 0 });
+		addRoute(ch->midiInSolo,     { RouteType::SOLO,        ch, 0, 0 });
+		addRoute(ch->midiInVolume,   { RouteType::VOLUME,      ch, 0, 0 });
 
-	for (Plugin* plugin : *plugins) {
-		for (unsigned k=0; k<plugin->midiInParams.size(); k++) {
-			uint32_t midiInParam = plugin->midiInParams.at(k);
-			if (pure != midiInParam)
-				continue;
-			float vf = midiEvent.getVelocity() / 127.0f;
-			c::plugin::setParameter(plugin, k, vf, false); // false: not from GUI
-			gu_log("  >>> [plugin %d parameter %d] ch=%d (pure=0x%X, value=%d, float=%f)\n",
-				plugin->getId(), k, ch->index, pure, midiEvent.getVelocity(), vf);
+		if (ch->type == ChannelType::SAMPLE) {
+			SampleChannel* sch = static_cast<SampleChannel*>(ch);
+			addRoute(sch->midiInPitch,       { RouteType::PITCH,        ch, 0, 0 });
+			addRoute(sch->midiInReadActions, { RouteType::READ_ACTIONS, ch, 0, 0 });
 		}
-	}
-}
+		else
+			midiChannels.push_back(ch);
+
+#ifdef WITH_VST
+
+		/* Plugins' parameters layout reflects the structure of the matrix
+		Channel::midiInPlugins. It is safe to assume then that i (i.e. Plugin*) 
+		and k indexes match both the structure of Channel::midiInPlugins and 
+		vector<Plugin*>* plugins. */
+
+		for (Plugin* plugin : *pluginHost::getStack(pluginHost::CHANNEL, ch))
+			for (unsigned k=0; k<plugin->midiInParams.size(); k++)
+				addRoute(plugin->midiInParams.at(k), 
+					{ RouteType::PLUGIN_PARAM, ch, static_cast<int>(k), plugin->getId() });
 
 #endif
+	}
+
+	gu_log("[midiDispatcher::rebuild] %zu learned messages, %zu MIDI channels\n", 
+		routes.size(), midiChannels.size());
+}
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void processChannels(const MidiEvent& midiEvent)
+void processChannel(const Route& r, const MidiEvent& midiEvent, command::Time time)
 {
-	uint32_t pure = midiEvent.getRawNoVelocity();
+	using namespace command;
 
-	for (Channel* ch : mixer::channels) {
+	Channel* ch   = r.ch;
+	uint32_t pure = midiEvent.getRawNoVelocity();
 
-		/* Do nothing on this channel if MIDI in is disabled or filtered out for
-		the current MIDI channel. */
+	/* Do nothing on this channel if MIDI in is disabled or filtered out for
+	the current MIDI channel. */
 
-		if (!ch->midiIn || !ch->isMidiInAllowed(midiEvent.getChannel()))
-			continue;
+	if (!ch->midiIn || !ch->isMidiInAllowed(midiEvent.getChannel()))
+		return;
 
-		if      (pure == ch->midiInKeyPress) {
+	switch (r.type) {
+		case RouteType::KEY_PRESS:
 			gu_log("  >>> keyPress, ch=%d (pure=0x%X)\n", ch->index, pure);
-			c::io::keyPress(ch, false, false, midiEvent.getVelocity());
-		}
-		else if (pure == ch->midiInKeyRel) {
+			push(makeTimed(CommandType::KEY_PRESS, ch, time, midiEvent.getVelocity()));
+			break;
+		case RouteType::KEY_RELEASE:
 			gu_log("  >>> keyRel ch=%d (pure=0x%X)\n", ch->index, pure);
-			c::io::keyRelease(ch, false, false);
-		}
-		else if (pure == ch->midiInMute) {
+			push(makeTimed(CommandType::KEY_RELEASE, ch, time));
+			break;
+		case RouteType::MUTE:
 			gu_log("  >>> mute ch=%d (pure=0x%X)\n", ch->index, pure);
 			c::channel::toggleMute(ch, false);
-		}		
-		else if (pure == ch->midiInKill) {
+			break;
+		case RouteType::KILL:
 			gu_log("  >>> kill ch=%d (pure=0x%X)\n", ch->index, pure);
-			c::channel::kill(ch);
-		}		
-		else if (pure == ch->midiInArm) {
+			push(makeTimed(CommandType::KILL, ch, time));
+			break;
+		case RouteType::ARM:
 			gu_log("  >>> arm ch=%d (pure=0x%X)\n", ch->index, pure);
 			c::channel::toggleArm(ch, false);
-		}
-		else if (pure == ch->midiInSolo) {
+			break;
+		case RouteType::SOLO:
 			gu_log("  >>> solo ch=%d (pure=0x%X)\n", ch->index, pure);
 			c::channel::toggleSolo(ch, false);
-		}
-		else if (pure == ch->midiInVolume) {
+			break;
+		case RouteType::VOLUME: {
 			float vf = midiEvent.getVelocity() / 127.0f;
 			gu_log("  >>> volume ch=%d (pure=0x%X, value=%d, float=%f)\n",
 				ch->index, pure, midiEvent.getVelocity(), vf);
 			c::channel::setVolume(ch, vf, false);
+			break;
 		}
-		else {
-			SampleChannel* sch = static_cast<SampleChannel*>(ch);
-			if (pure == sch->midiInPitch) {
-				float vf = midiEvent.getVelocity() / (127/4.0f); // [0-127] ~> [0.0-4.0]
-				gu_log("  >>> pitch ch=%d (pure=0x%X, value=%d, float=%f)\n",
-					sch->index, pure, midiEvent.getVelocity(), vf);
-				c::channel::setPitch(sch, vf);
-			}
-			else 
-			if (pure == sch->midiInReadActions) {
-				gu_log("  >>> toggle read actions ch=%d (pure=0x%X)\n", sch->index, pure);
-				c::channel::toggleReadingActions(sch, false);
-			}
+		case RouteType::PITCH: {
+			float vf = midiEvent.getVelocity() / (127/4.0f); // [0-127] ~> [0.0-4.0]
+			gu_log("  >>> pitch ch=%d (pure=0x%X, value=%d, float=%f)\n",
+				ch->index, pure, midiEvent.getVelocity(), vf);
+			c::channel::setPitch(static_cast<SampleChannel*>(ch), vf, false);
+			break;
 		}
-
+		case RouteType::READ_ACTIONS:
+			gu_log("  >>> toggle read actions ch=%d (pure=0x%X)\n", ch->index, pure);
+			c::channel::toggleReadingActions(static_cast<SampleChannel*>(ch), false);
+			break;
 #ifdef WITH_VST
-
-		/* Process learned plugins parameters. */
-		processPlugins(ch, midiEvent); 
-
+		case RouteType::PLUGIN_PARAM: {
+			float vf = midiEvent.getVelocity() / 127.0f;
+			c::plugin::automateParameter(ch, r.plugin, r.param, vf, time);
+			gu_log("  >>> [plugin %d parameter %d] ch=%d (pure=0x%X, value=%d, float=%f)\n",
+				r.plugin, r.param, ch->index, pure, midiEvent.getVelocity(), vf);
+			break;
+		}
 #endif
-
-		/* Redirect full midi message (pure + velocity) to plugins. */
-		ch->receiveMidi(midiEvent.getRaw());
+		default: break;
 	}
 }
 
@@ -167,52 +256,84 @@ void processChannels(const MidiEvent& midiEvent)
 /* -------------------------------------------------------------------------- */
 
 
-void processMaster(const MidiEvent& midiEvent)
+void processMaster(const Route& r, const MidiEvent& midiEvent)
 {
 	uint32_t pure = midiEvent.getRawNoVelocity();
 
-	if      (pure == conf::midiInRewind) {
-		gu_log("  >>> rewind (master) (pure=0x%X)\n", pure);
-		glue_rewindSeq(false);
-	}
-	else if (pure == conf::midiInStartStop) {
-		gu_log("  >>> startStop (master) (pure=0x%X)\n", pure);
-		glue_startStopSeq(false);
-	}
-	else if (pure == conf::midiInActionRec) {
-		gu_log("  >>> actionRec (master) (pure=0x%X)\n", pure);
-		c::io::startStopActionRec(false);
-	}
-	else if (pure == conf::midiInInputRec) {
-		gu_log("  >>> inputRec (master) (pure=0x%X)\n", pure);
-		c::io::startStopInputRec(false);
-	}
-	else if (pure == conf::midiInMetronome) {
-		gu_log("  >>> metronome (master) (pure=0x%X)\n", pure);
-		glue_startStopMetronome(false);
-	}
-	else if (pure == conf::midiInVolumeIn) {
-		float vf = midiEvent.getVelocity() / 127.0f;
-		gu_log("  >>> input volume (master) (pure=0x%X, value=%d, float=%f)\n",
-			pure, midiEvent.getVelocity(), vf);
-		glue_setInVol(vf, false);
-	}
-	else if (pure == conf::midiInVolumeOut) {
-		float vf = midiEvent.getVelocity() / 127.0f;
-		gu_log("  >>> output volume (master) (pure=0x%X, value=%d, float=%f)\n",
-			pure, midiEvent.getVelocity(), vf);
-		glue_setOutVol(vf, false);
-	}
-	else if (pure == conf::midiInBeatDouble) {
-		gu_log("  >>> sequencer x2 (master) (pure=0x%X)\n", pure);
-		glue_beatsMultiply();
-	}
-	else if (pure == conf::midiInBeatHalf) {
-		gu_log("  >>> sequencer /2 (master) (pure=0x%X)\n", pure);
-		glue_beatsDivide();
+	switch (r.type) {
+		case RouteType::REWIND:
+			gu_log("  >>> rewind (master) (pure=0x%X)\n", pure);
+			glue_rewindSeq(false);
+			break;
+		case RouteType::START_STOP:
+			gu_log("  >>> startStop (master) (pure=0x%X)\n", pure);
+			glue_startStopSeq(false);
+			break;
+		case RouteType::ACTION_REC:
+			gu_log("  >>> actionRec (master) (pure=0x%X)\n", pure);
+			c::io::startStopActionRec(false);
+			break;
+		case RouteType::INPUT_REC:
+			gu_log("  >>> inputRec (master) (pure=0x%X)\n", pure);
+			c::io::startStopInputRec(false);
+			break;
+		case RouteType::METRONOME:
+			gu_log("  >>> metronome (master) (pure=0x%X)\n", pure);
+			glue_startStopMetronome(false);
+			break;
+		case RouteType::VOLUME_IN: {
+			float vf = midiEvent.getVelocity() / 127.0f;
+			gu_log("  >>> input volume (master) (pure=0x%X, value=%d, float=%f)\n",
+				pure, midiEvent.getVelocity(), vf);
+			glue_setInVol(vf, false);
+			break;
+		}
+		case RouteType::VOLUME_OUT: {
+			float vf = midiEvent.getVelocity() / 127.0f;
+			gu_log("  >>> output volume (master) (pure=0x%X, value=%d, float=%f)\n",
+				pure, midiEvent.getVelocity(), vf);
+			glue_setOutVol(vf, false);
+			break;
+		}
+		case RouteType::BEAT_DOUBLE:
+			gu_log("  >>> sequencer x2 (master) (pure=0x%X)\n", pure);
+			glue_beatsMultiply();
+			break;
+		case RouteType::BEAT_HALF:
+			gu_log("  >>> sequencer /2 (master) (pure=0x%X)\n", pure);
+			glue_beatsDivide();
+			break;
+		default: break;
 	}
 }
 
+
+/* -------------------------------------------------------------------------- */
+
+
+void process(const MidiEvent& midiEvent, command::Time time, int ns)
+{
+	using namespace command;
+
+	if (dirty.exchange(false))
+		rebuild();
+
+	auto it = routes.find(midiEvent.getRawNoVelocity() | ns);
+	if (it != routes.end())
+		for (const Route& r : it->second) {
+			if (r.ch == nullptr)
+				processMaster(r, midiEvent);
+			else
+				processChannel(r, midiEvent, time);
+		}
+
+	/* Redirect full midi message (pure + velocity) to plugins. */
+
+	for (Channel* ch : midiChannels)
+		if (ch->midiIn && ch->isMidiInAllowed(midiEvent.getChannel()))
+			push(makeTimed(CommandType::MIDI_EVENT, ch, time, midiEvent.getRaw()));
+}
+
 } // {anonymous}
 
 
@@ -241,7 +362,8 @@ void stopMidiLearn()
 /* -------------------------------------------------------------------------- */
 
 
-void dispatch(int byte1, int byte2, int byte3)
+void dispatch(int byte1, int byte2, int byte3, 
+	std::chrono::steady_clock::time_point time, int ns)
 {
 	/* Here we want to catch two things: a) note on/note off from a keyboard and 
 	b) knob/wheel/slider movements from a controller. 
@@ -251,8 +373,8 @@ void dispatch(int byte1, int byte2, int byte3)
 	MidiEvent midiEvent(byte1, byte2, byte3);
 	midiEvent.fixVelocityZero();
 
-	gu_log("[midiDispatcher] MIDI received - 0x%X (chan %d)\n", midiEvent.getRaw(), 
-		midiEvent.getChannel());
+	gu_log("[midiDispatcher] MIDI received - 0x%X (chan %d, namespace %d)\n", 
+		midiEvent.getRaw(), midiEvent.getChannel(), ns);
 
 	/* Start dispatcher. If midi learn is on don't parse channels, just learn 
 	incoming MIDI signal. Learn callback wants 'pure' MIDI event, i.e. with
@@ -261,11 +383,18 @@ void dispatch(int byte1, int byte2, int byte3)
 	by glue_* when MIDI learning is on. */
 
 	if (cb_learn)
-		cb_learn(midiEvent.getRawNoVelocity(), cb_data);
-	else {
-		processMaster(midiEvent);
-		processChannels(midiEvent);
-	}	
+		cb_learn(midiEvent.getRawNoVelocity() | ns, cb_data);
+	else
+		process(midiEvent, time, ns);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void invalidate()
+{
+	dirty.store(true);
 }
 }}}; // giada::m::midiDispatcher::
 
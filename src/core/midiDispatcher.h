@@ -34,6 +34,7 @@
 #else
 	#include <cstdint>
 #endif
+#include <chrono>
 
 
 namespace giada {
@@ -45,7 +46,21 @@ typedef void (cb_midiLearn) (uint32_t, void*);
 void startMidiLearn(cb_midiLearn* cb, void* data);
 void stopMidiLearn();
 
-void dispatch(int byte1, int byte2, int byte3);
+/* dispatch
+Routes an incoming MIDI message. 'time' is the moment it has been received: 
+messages that play or record something are handed to the audio thread with it,
+so that they are applied on the matching frame. 'ns' is the learn namespace of
+the port it comes from: it takes the lowest byte of learned messages, unused 
+by MIDI (see conf::MidiPortIn). Call it from a single thread. */
+
+void dispatch(int byte1, int byte2, int byte3, 
+	std::chrono::steady_clock::time_point time, int ns=0);
+
+/* invalidate
+Tells the dispatcher that learned messages, channels or plug-ins have changed:
+the routing index is rebuilt on the next incoming message. */
+
+void invalidate();
 
 }}}; // giada::m::midiDispatcher::
 
@@ -25,12 +25,17 @@
  * -------------------------------------------------------------------------- */
 
 
+#include <atomic>
+#include <mutex>
 #include <cassert>
 #include <cstring>
+#include <climits>
+#include <algorithm>
 #include "../deps/rtaudio-mod/RtAudio.h"
 #include "../utils/log.h"
 #include "wave.h"
 #include "kernelAudio.h"
+#include "kernelMidi.h"
 #include "recorder.h"
 #include "pluginHost.h"
 #include "conf.h"
@@ -41,6 +46,9 @@
 #include "sampleChannel.h"
 #include "midiChannel.h"
 #include "audioBuffer.h"
+#include "command.h"
+#include "workers.h"
+#include "dsp.h"
 #include "mixer.h"
 
 
@@ -80,22 +88,70 @@ Frame tockTracker = 0;
 bool tickPlay = false;
 bool tockPlay = false;
 
+/* rendering
+True on the audio thread while it renders a block, holding the mutex. Jack 
+transport changes call back into the engine from there. */
+
+thread_local bool rendering = false;
+
+/* mergePending, mergeMutex
+Input takes stopped by the audio thread wait to be merged by a non-audio 
+thread, see mergePendingInput(). The mutex keeps two merges apart. */
+
+std::atomic<bool> mergePending(false);
+std::mutex        mergeMutex;
+
 /* inputTracker
 Sample position while recording. */
 
 Frame inputTracker = 0;
 
+/* HardClipper
+Default output stage: merge, gain and clamp to [-1.0, 1.0] if the limiter is
+enabled, in a single pass. */
 
-/* -------------------------------------------------------------------------- */
+class HardClipper : public OutputStage
+{
+public:
 
-/* computePeak */
+	dsp::Meter process(AudioBuffer& out, const AudioBuffer* in, float gain) override
+	{
+		return dsp::finalize(out, in, gain, conf::limitOutput ? 1.0f : 0.0f);
+	}
+};
+
+HardClipper                  defaultStage;
+std::unique_ptr<OutputStage> customStage;
+OutputStage*                 outputStage = &defaultStage;
 
-void computePeak(const AudioBuffer& buf, float& peak, Frame frame)
+/* Meters
+Written by the audio thread on each block, read by the GUI. Peaks grow until 
+the reader resets them. */
+
+struct Meters
 {
-	for (int i=0; i<buf.countChannels(); i++)
-		if (buf[frame][i] > peak)
-			peak = buf[frame][i];
-}
+	std::atomic<float> peak;
+	std::atomic<float> rms;
+};
+
+Meters metersOut;
+Meters metersIn;
+
+/* events, eventActions
+Events of the block being rendered and the actions they refer to. Both are 
+cleared on each block but keep their capacity: no allocations once warmed 
+up. */
+
+std::vector<FrameEvents>      events;
+std::vector<recorder::action> eventActions;
+
+/* spans
+Where the sequencer went during the block being rendered, see getSpans(). 
+Cleared on each block, like the events. */
+
+std::vector<Span> spans;
+
+constexpr int MAX_EVENTS = 1024;
 
 
 /* -------------------------------------------------------------------------- */
@@ -125,24 +181,47 @@ void lineInRec(const AudioBuffer& inBuf, unsigned frame)
 }
 
 
+/* -------------------------------------------------------------------------- */
+
+/* updateMeters_
+Single writer: a plain load-store is enough to hold the peak, but the reader 
+might reset it in between, hence the compare-exchange. */
+
+void updateMeters_(Meters& meters, dsp::Meter m)
+{
+	float peak = meters.peak.load(std::memory_order_relaxed);
+	while (m.peak > peak && 
+		!meters.peak.compare_exchange_weak(peak, m.peak, std::memory_order_relaxed));
+	meters.rms.store(m.rms, std::memory_order_relaxed);
+}
+
+
+dsp::Meter readMeters_(Meters& meters)
+{
+	return { meters.peak.exchange(0.0f, std::memory_order_relaxed), 
+		meters.rms.load(std::memory_order_relaxed) };
+}
+
+
 /* -------------------------------------------------------------------------- */
 
 /* ProcessLineIn
 Computes line in peaks, plus handles "hear what you're playin'" thing. */
 
-void processLineIn(const AudioBuffer& inBuf, unsigned frame)
+void processLineIn(const AudioBuffer& inBuf)
 {
 	if (!kernelAudio::isInputEnabled())
 		return;
 
-	computePeak(inBuf, peakIn, frame);
+	updateMeters_(metersIn, dsp::measure(inBuf));
 
 	/* "hear what you're playing" - process, copy and paste the input buffer onto 
-	the output buffer. */
+	the output buffer. Adding is fine: vChanInToOut has just been cleared. */
 
-	if (inToOut)
-		for (int i=0; i<vChanInToOut.countChannels(); i++)
-			vChanInToOut[frame][i] = inBuf[frame][i] * inVol;
+	if (inToOut) {
+		const float gains[G_MAX_IO_CHANS] = { inVol, inVol };
+		dsp::add(vChanInToOut, inBuf, gains);
+	}
 }
 
 
@@ -165,7 +244,7 @@ void prepareBuffers(AudioBuffer& outBuf)
 /* doQuantize
 Computes quantization on 'rewind' button and all channels. */
 
-void doQuantize(unsigned frame)
+void doQuantize()
 {
 	/* Nothing to do if quantizer disabled or a quanto has not passed yet. */
 
@@ -175,6 +254,8 @@ void doQuantize(unsigned frame)
 	if (rewindWait) {
 		rewindWait = false;
 		rewind();
+		if (metronome)
+			tickPlay = true;  // back on the first beat
 	}
 }
 
@@ -186,6 +267,8 @@ Generates metronome when needed and pastes it to the output buffer. */
 
 void renderMetronome(AudioBuffer& outBuf, unsigned frame)
 {
+	if (!tickPlay && !tockPlay)
+		return;
 	if (tockPlay) {
 		for (int i=0; i<outBuf.countChannels(); i++)
 			outBuf[frame][i] += tock[tockTracker];
@@ -207,16 +290,48 @@ void renderMetronome(AudioBuffer& outBuf, unsigned frame)
 }
 
 
+/* -------------------------------------------------------------------------- */
+
+/* RenderData, renderChannel_
+Job run by the worker pool: renders channel 'index' into its own mix buffer. */
+
+struct RenderData
+{
+	const AudioBuffer* in;
+	bool               running;
+};
+
+void renderChannel_(int index, void* data)
+{
+	const RenderData* rd = static_cast<const RenderData*>(data);
+	Channel* ch = channels[index];
+	ch->mixBuffer.clear();
+	ch->process(ch->mixBuffer, *rd->in, isChannelAudible(ch), rd->running);
+}
+
+
 /* -------------------------------------------------------------------------- */
 
 /* renderIO
 Final processing stage. Take each channel and process it (i.e. copy its
-content to the output buffer). Process plugins too, if any. */
+content to the output buffer). Process plugins too, if any. With more than one
+render thread channels are processed in parallel, each one into its own buffer,
+then summed up in channel order: the result doesn't depend on scheduling. */
 
 void renderIO(AudioBuffer& outBuf, const AudioBuffer& inBuf)
 {
-	for (Channel* channel : channels)
-		channel->process(outBuf, inBuf, isChannelAudible(channel), clock::isRunning());
+	bool running = clock::isRunning();
+
+	if (workers::count() > 1) {
+		RenderData rd = { &inBuf, running };
+		workers::run(channels.size(), renderChannel_, &rd);
+		const float unity[G_MAX_IO_CHANS] = { 1.0f, 1.0f };
+		for (const Channel* channel : channels)
+			dsp::add(outBuf, channel->mixBuffer, unity);
+	}
+	else
+		for (Channel* channel : channels)
+			channel->process(outBuf, inBuf, isChannelAudible(channel), running);
 
 #ifdef WITH_VST
 	pluginHost::processStack(outBuf, pluginHost::MASTER_OUT);
@@ -227,49 +342,198 @@ void renderIO(AudioBuffer& outBuf, const AudioBuffer& inBuf)
 
 /* -------------------------------------------------------------------------- */
 
-/* limitOutput
-Applies a very dumb hard limiter. */
+/* finalizeOutput
+Last touches after the output has been rendered: the output stage merges 
+inToOut if any, applies output volume and limiting. Updates the output 
+meters. */
 
-void limitOutput(AudioBuffer& outBuf, unsigned frame)
+void finalizeOutput(AudioBuffer& outBuf)
 {
-	for (int i=0; i<outBuf.countChannels(); i++)
-		if      (outBuf[frame][i] > 1.0f)
-			outBuf[frame][i] = 1.0f;
-		else if (outBuf[frame][i] < -1.0f)	
-			outBuf[frame][i] = -1.0f;	
+	const AudioBuffer* in = inToOut && kernelAudio::isInputEnabled() ? &vChanInToOut : nullptr;
+	updateMeters_(metersOut, outputStage->process(outBuf, in, outVol));
 }
 
 
 /* -------------------------------------------------------------------------- */
 
-/* finalizeOutput
-Last touches after the output has been rendered: apply inToOut if any, apply
-output volume. */
 
-void finalizeOutput(AudioBuffer& outBuf, unsigned frame)
+void renderMetronome(const FrameEvents& fe)
 {
-	/* Merge vChanInToOut, if enabled. */
+	if (!metronome)
+		return;
+	if (fe.onBar || fe.onFirstBeat)
+		tickPlay = true;
+	else
+	if (fe.onBeat)
+		tockPlay = true;
+}
 
-	if (inToOut)
-		outBuf.copyFrame(frame, vChanInToOut[frame]); 
 
-	for (int i=0; i<outBuf.countChannels(); i++)
-		outBuf[frame][i] *= outVol; 
+/* -------------------------------------------------------------------------- */
+
+/* isMultiple, nextMultiple
+Helpers for sequencer boundaries. A non-positive step means 'never'. */
+
+bool isMultiple_(Frame frame, Frame step)
+{
+	return step > 0 && frame % step == 0;
+}
+
+
+Frame nextMultiple_(Frame frame, Frame step)
+{
+	return step > 0 ? (frame / step + 1) * step : INT_MAX;
 }
 
 
 /* -------------------------------------------------------------------------- */
 
+/* linkActions_
+Points each event to its own slice of 'eventActions'. Done at the end, since
+the pool might have been reallocated while growing. */
 
-void renderMetronome()
+void linkActions_()
 {
-	if (!metronome)
-		return;
-	if (clock::isOnBar() || clock::isOnFirstBeat())
-		tickPlay = true;
-	else
-	if (clock::isOnBeat())
-		tockPlay = true;
+	const recorder::action* a   = eventActions.data();
+	const recorder::action* end = a + eventActions.size();
+	for (FrameEvents& fe : events) {
+		fe.actions.first = a;
+		while (a != end && a->frame == fe.frameGlobal)
+			a++;
+		fe.actions.last = a;
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* scheduleEvents_
+Fills 'events' with everything that happens between local frame 'start' and 
+the end of the block, walking the sequencer from its current position. Frames 
+with nothing going on are skipped entirely. Returns the local frame where the
+scan stopped: a pending quantized rewind ends the scan right after the quanto
+it waits for, since the sequencer moves elsewhere from there on. */
+
+Frame scheduleEvents_(Frame start, Frame bufferSize)
+{
+	events.clear();
+	eventActions.clear();
+
+	Frame framesInLoop = clock::getFramesInLoop();
+	Frame framesInBar  = clock::getFramesInBar();
+	Frame framesInBeat = clock::getFramesInBeat();
+	Frame quanto       = clock::getQuantize() != 0 ? clock::getQuanto() : 0;
+
+	Frame local  = start;
+	Frame global = clock::getCurrentFrame();
+
+	spans.push_back(Span{ local, global });
+
+	while (local < bufferSize) {
+
+		FrameEvents fe;
+		fe.frameLocal   = local;
+		fe.frameGlobal  = global;
+		fe.onBar        = global != 0 && isMultiple_(global, framesInBar);
+		fe.onBeat       = global > 0 && isMultiple_(global, framesInBeat);
+		fe.onFirstBeat  = global == 0;
+		/* Without quantizer every frame is a quanto: the first one of the block
+		is enough to release any channel still waiting for it. */
+		fe.quantoPassed = quanto == 0 ? local == start : isMultiple_(global, quanto);
+
+		recorder::ActionRange actions = recorder::getActionsOnFrame(global);
+		eventActions.insert(eventActions.end(), actions.begin(), actions.end());
+
+		if (fe.onBar || fe.onBeat || fe.onFirstBeat || fe.quantoPassed || !actions.empty())
+			events.push_back(fe);
+
+		if (rewindWait && quanto != 0 && fe.quantoPassed) {
+			local++;
+			break;
+		}
+
+		/* Jump straight to the next frame where something happens. */
+
+		Frame loopEnd = std::max(framesInLoop, global + 1);
+		Frame next    = std::min(loopEnd, global + (bufferSize - local));
+		next = std::min(next, nextMultiple_(global, framesInBar));
+		next = std::min(next, nextMultiple_(global, framesInBeat));
+		next = std::min(next, nextMultiple_(global, quanto));
+
+		recorder::ActionRange pending = recorder::getActionsInRange(global + 1, next);
+		if (!pending.empty())
+			next = pending.begin()->frame;
+
+		local += next - global;
+		global = next >= loopEnd ? 0 : next;
+
+		if (global == 0 && local < bufferSize)
+			spans.push_back(Span{ local, global });
+	}
+
+	linkActions_();
+	return local;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* mergeInto_
+Writes the virtual input over the wave of channel 'ch'. Its data might be 
+streamed, native, chunked or shared with other waves: never write it in place. 
+A private direct copy is built aside, with the previous data underneath, and 
+goes in place of the old wave while the audio thread is out. Never called by
+the audio thread. */
+
+void mergeInto_(SampleChannel* ch)
+{
+	Wave* old    = ch->wave;
+	int   frames = old->getSize();
+	int   chans  = old->getChannels();
+
+	/* Streamed data can be read by the audio thread only: the take goes over
+	silence then. */
+
+	AudioBuffer data;
+	data.alloc(frames, chans);
+	if (frames > 0 && !old->isStreamed())
+		old->read(data, 0, frames, 0);
+
+	int inFrames = std::min(frames, vChanInput.countFrames());
+	int inChans  = std::min(chans, vChanInput.countChannels());
+	for (int i=0; i<inFrames; i++)
+		for (int j=0; j<inChans; j++)
+			data[i][j] = vChanInput[i][j];
+
+	Wave* wave = new Wave();
+	wave->alloc(0, chans, old->getRate(), old->getBits(), old->getPath());
+	wave->moveData(data);
+	wave->setLogical(old->isLogical());
+	wave->setEdited(old->isEdited());
+
+	pthread_mutex_lock(&mutex);
+	ch->swapWave(wave);
+	pthread_mutex_unlock(&mutex);
+
+	delete old;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void merge_()
+{
+	for (Channel* ch : channels) {
+		/* TODO - move this to audioProc::*/
+		if (ch->type == ChannelType::MIDI)
+			continue;
+		SampleChannel* sch = static_cast<SampleChannel*>(ch);
+		if (sch->armed && sch->wave != nullptr)
+			mergeInto_(sch);
+	}
+	vChanInput.clear();
 }
 }; // {anonymous}
 
@@ -285,8 +549,6 @@ bool   recording    = false;
 bool   ready        = true;
 float  outVol       = G_DEFAULT_OUT_VOL;
 float  inVol        = G_DEFAULT_IN_VOL;
-float  peakOut      = 0.0f;
-float  peakIn       = 0.0f;
 bool	 metronome    = false;
 int    waitRec      = 0;
 bool   rewindWait   = false;
@@ -307,6 +569,10 @@ void init(Frame framesInSeq, Frame framesInBuffer)
 	vChanInput.alloc(framesInSeq, G_MAX_IO_CHANS);
 	vChanInToOut.alloc(framesInBuffer, G_MAX_IO_CHANS);
 
+	events.reserve(MAX_EVENTS);
+	eventActions.reserve(MAX_EVENTS);
+	spans.reserve(MAX_EVENTS);
+
 	gu_log("[Mixer::init] buffers ready - framesInSeq=%d, framesInBuffer=%d\n", 
 		framesInSeq, framesInBuffer);	
 
@@ -321,6 +587,44 @@ void init(Frame framesInSeq, Frame framesInBuffer)
 /* -------------------------------------------------------------------------- */
 
 
+void setOutputStage(std::unique_ptr<OutputStage> stage)
+{
+	/* Swap under the mutex, destroy the old stage outside of it. */
+
+	pthread_mutex_lock(&mutex);
+	customStage.swap(stage);
+	outputStage = customStage != nullptr ? customStage.get() : &defaultStage;
+	pthread_mutex_unlock(&mutex);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+const std::vector<Span>& getSpans()
+{
+	return spans;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+dsp::Meter getOutMeter()
+{
+	return readMeters_(metersOut);
+}
+
+
+dsp::Meter getInMeter()
+{
+	return readMeters_(metersIn);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 void allocVirtualInput(Frame frames)
 {
 	vChanInput.alloc(frames, G_MAX_IO_CHANS);
@@ -336,62 +640,88 @@ int masterPlay(void* outBuf, void* inBuf, unsigned bufferSize,
 	if (!ready)
 		return 0;
 
-	pthread_mutex_lock(&mutex);
-
-#ifdef __linux__
-	clock::recvJackSync();
-#endif
-
 	AudioBuffer out, in;
 	out.setData((float*) outBuf, bufferSize, G_MAX_IO_CHANS);
 	if (kernelAudio::isInputEnabled())
 		in.setData((float*) inBuf, bufferSize, G_MAX_IO_CHANS);
 
-	peakOut = 0.0f;  // reset peak calculator
-	peakIn  = 0.0f;  // reset peak calculator
+	/* Never wait for the mutex: it is held by other threads only while they 
+	change the engine structure (channels, plug-ins, samples). Skip this block
+	and play silence instead. */
+
+	if (pthread_mutex_trylock(&mutex) != 0) {
+		out.clear();
+		out.setData(nullptr, 0, 0);
+		in.setData(nullptr, 0, 0);
+		return 0;
+	}
+	rendering = true;
+
+	kernelMidi::beginBlock();
+	recorder::beginBlock();
+
+	/* Apply state changes sent by the other threads before anything else. */
+
+	command::process(bufferSize);
+
+#ifdef __linux__
+	clock::recvJackSync();
+#endif
 
 	prepareBuffers(out);
 
-	for (unsigned j=0; j<bufferSize; j++) {
-		processLineIn(in, j);   // TODO - can go outside this loop
+	/* Incoming MIDI events land on their own frame, now that channel buffers
+	are ready. */
+
+	command::processTimed();
 
-		if (clock::isRunning()) {
-			FrameEvents fe;
-			fe.frameLocal   = j;
-			fe.frameGlobal  = clock::getCurrentFrame();
-			fe.doQuantize   = clock::getQuantize() == 0 || !clock::quantoHasPassed();
-			fe.onBar        = clock::isOnBar();
-			fe.onFirstBeat  = clock::isOnFirstBeat();
-			fe.quantoPassed = clock::quantoHasPassed();
-			fe.actions      = recorder::getActionsOnFrame(clock::getCurrentFrame());
+	processLineIn(in);
+
+	spans.clear();
+
+	if (clock::isRunning()) {
+		for (unsigned j=0; j<bufferSize; j++)
+			lineInRec(in, j);
+
+		/* Process the block in one pass, unless a quantized rewind splits it: 
+		events past the rewind point must be computed against the new sequencer
+		position. */
+
+		Frame start = 0;
+		while (start < (Frame) bufferSize) {
+			Frame end = scheduleEvents_(start, bufferSize);
 
 			for (Channel* channel : channels)
-				channel->parseEvents(fe);
+				channel->parseEvents(events);
+			for (const FrameEvents& fe : events)
+				renderMetronome(fe);
+
+			/* Move the sequencer to the last frame of this pass, where a quantized
+			rewind might take place, then step over it. */
 
-			lineInRec(in, j);   // TODO - can go outside this loop
-			doQuantize(j);
-			renderMetronome();
-			clock::incrCurrentFrame();
-			clock::sendMIDIsync();
+			clock::advance(end - start - 1, start);
+			doQuantize();
+			clock::advance(1, end - 1);
+			start = end;
 		}
 	}
 	
 	renderIO(out, in);
 
 	/* Post processing. */
-	for (unsigned j=0; j<bufferSize; j++) {
-		finalizeOutput(out, j); 
-		if (conf::limitOutput)
-			limitOutput(out, j);
-		computePeak(out, peakOut, j); 
+	finalizeOutput(out);
+	for (unsigned j=0; j<bufferSize; j++)
 		renderMetronome(out, j);
-	}
 
 	/* Unset data in buffers. If you don't do this, buffers go out of scope and
 	destroy memory allocated by RtAudio ---> havoc. */
 	out.setData(nullptr, 0, 0);
 	in.setData(nullptr, 0, 0);
 
+	kernelMidi::endBlock(bufferSize);
+	recorder::endBlock();
+
+	rendering = false;
 	pthread_mutex_unlock(&mutex);
 
 	return 0;
@@ -459,14 +789,25 @@ void startInputRec()
 
 void mergeVirtualInput()
 {
-	for (Channel* ch : channels) {
-		/* TODO - move this to audioProc::*/
-		if (ch->type == ChannelType::MIDI)
-			continue;
-		SampleChannel* sch = static_cast<SampleChannel*>(ch);
-		if (sch->armed)
-			sch->wave->copyData(vChanInput[0], vChanInput.countFrames());
+	if (rendering) {
+		mergePending.store(true);
+		return;
 	}
-	vChanInput.clear();
+	std::lock_guard<std::mutex> lock(mergeMutex);
+	mergePending.store(false);
+	merge_();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void mergePendingInput()
+{
+	if (!mergePending.load())
+		return;
+	std::lock_guard<std::mutex> lock(mergeMutex);
+	if (mergePending.exchange(false))
+		merge_();
 }
 }}}; // giada::m::mixer::
@@ -31,8 +31,10 @@
 
 #include <pthread.h>
 #include <vector>
+#include <memory>
 #include "recorder.h"
 #include "types.h"
+#include "dsp.h"
 #include "../deps/rtaudio-mod/RtAudio.h"
 
 
@@ -41,17 +43,38 @@ class Channel;
 
 namespace giada {
 namespace m {
+
+class AudioBuffer;
+
 namespace mixer
 {
+/* FrameEvents
+Something that happens on a specific frame of the current block: a sequencer 
+boundary (bar, beat, quanto) and/or some recorded actions. Mixer collects them 
+once per block, sorted by frame, and passes the whole list to each channel. 
+Actions are copies owned by the mixer, valid until the next block. */
+
 struct FrameEvents
 {
 	Frame frameLocal;
 	Frame frameGlobal;
-	bool  doQuantize;
 	bool  onBar;
+	bool  onBeat;
 	bool  onFirstBeat;
 	bool  quantoPassed;
-	std::vector<recorder::action*> actions;
+	recorder::ActionRange actions;
+};
+
+/* Span
+A stretch of the current block where the sequencer moves forward one frame at
+a time: from local frame 'frameLocal' on, it plays global frame 'frameGlobal' 
+onwards. A new one starts when the sequencer loops and after a quantized 
+rewind. */
+
+struct Span
+{
+	Frame frameLocal;
+	Frame frameGlobal;
 };
 
 extern std::vector<Channel*> channels;
@@ -60,8 +83,6 @@ extern bool   recording;         // is recording something?
 extern bool   ready;
 extern float  outVol;
 extern float  inVol;
-extern float  peakOut;
-extern float  peakIn;
 extern bool	  metronome;
 extern int    waitRec;       // delayComp guard
 extern bool   rewindWait;	   // rewind guard, if quantized
@@ -73,8 +94,48 @@ what you're playing" feature. */
 
 extern bool inToOut;
 
+/* mutex
+Guards structural changes to the engine (adding/removing channels, plug-ins,
+samples). Plain state changes go through command::push() instead. The audio
+thread never waits for it: if busy, the block is skipped. */
+
 extern pthread_mutex_t mutex;
 
+/* OutputStage
+Last step on the master output: merges the "hear what you're playing" input, if
+any ('in' is nullptr otherwise), applies the output volume 'gain' and keeps the
+signal in range. Returns the levels of the final output. Runs on the audio 
+thread: no locks, no allocations. The default stage is a hard clipper, enabled
+by conf::limitOutput. */
+
+class OutputStage
+{
+public:
+
+	virtual ~OutputStage() {}
+	virtual dsp::Meter process(AudioBuffer& out, const AudioBuffer* in, float gain) = 0;
+};
+
+/* setOutputStage
+Replaces the output stage, e.g. with a lookahead limiter. Pass nullptr to 
+restore the default one. */
+
+void setOutputStage(std::unique_ptr<OutputStage> stage);
+
+/* getSpans
+Where the sequencer went during the current block, in order; empty if it 
+didn't run. Audio thread only, valid until the next block: channels follow 
+their envelopes with it. */
+
+const std::vector<Span>& getSpans();
+
+/* getOutMeter, getInMeter
+Levels of output and input since the last call, lock-free. Peaks are held until
+read: the GUI doesn't miss the blocks rendered between two refreshes. */
+
+dsp::Meter getOutMeter();
+dsp::Meter getInMeter();
+
 void init(Frame framesInSeq, Frame framesInBuffer);
 
 /* allocVirtualInput
@@ -110,9 +171,17 @@ void startInputRec();
 
 /* mergeVirtualInput
 Copies the virtual channel input in the channels designed for input recording. 
-Called by mixerHandler on stopInputRec(). */
+Called by mixerHandler on stopInputRec(). Their waves are replaced, not written
+to, while the audio thread is out. On the audio thread (Jack transport stop) 
+nothing is allocated: the merge is left to mergePendingInput(). */
 
 void mergeVirtualInput();
+
+/* mergePendingInput
+Merges the input take stopped by the audio thread, if any. Non-audio threads 
+only: called periodically, and before a new input recording starts. */
+
+void mergePendingInput();
 }}} // giada::m::mixer::;
 
 
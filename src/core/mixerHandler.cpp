@@ -26,6 +26,7 @@
 
 
 #include <vector>
+#include <atomic>
 #include <algorithm>
 #include "../utils/fs.h"
 #include "../utils/string.h"
@@ -51,6 +52,7 @@
 #include "wave.h"
 #include "waveManager.h"
 #include "channelManager.h"
+#include "midiDispatcher.h"
 #include "mixerHandler.h"
 
 
@@ -64,6 +66,16 @@ namespace mh
 {
 namespace
 {
+/* envelopesVersion, envelopesDirty
+Recorder version the envelopes were last compiled on, and whether some channel
+showed up since then. See updateEnvelopes(). */
+
+unsigned envelopesVersion = 0;
+std::atomic<bool> envelopesDirty(true);
+
+
+/* -------------------------------------------------------------------------- */
+
 #ifdef WITH_VST
 
 int readPatchPlugins(vector<patch::plugin_t>* list, int type)
@@ -134,25 +146,47 @@ bool uniqueSamplePath(const SampleChannel* skip, const string& path)
 
 
 Channel* addChannel(ChannelType type)
+{
+	Channel* ch = createChannel(type);
+	if (ch == nullptr)
+		return nullptr;
+
+	addChannels({ch});
+
+	ch->index = getNewChanIndex();
+	envelopesDirty.store(true);
+	gu_log("[addChannel] channel index=%d added, type=%d, total=%d\n",
+		ch->index, ch->type, mixer::channels.size());
+	return ch;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Channel* createChannel(ChannelType type)
 {
 	Channel* ch = nullptr;
 	channelManager::create(type, kernelAudio::getRealBufSize(), 
 		conf::inputMonitorDefaultOn, &ch);
-	if (ch == nullptr)
-		return nullptr;
+	return ch;
+}
+
 
+/* -------------------------------------------------------------------------- */
+
+
+void addChannels(const vector<Channel*>& chans)
+{
 	while (true) {
 		if (pthread_mutex_trylock(&mixer::mutex) != 0)
 			continue;
-		mixer::channels.push_back(ch);
+		mixer::channels.insert(mixer::channels.end(), chans.begin(), chans.end());
 		pthread_mutex_unlock(&mixer::mutex);
+		midiDispatcher::invalidate();
+		envelopesDirty.store(true);
 		break;
 	}
-
-	ch->index = getNewChanIndex();
-	gu_log("[addChannel] channel index=%d added, type=%d, total=%d\n",
-		ch->index, ch->type, mixer::channels.size());
-	return ch;
 }
 
 
@@ -168,7 +202,27 @@ void deleteChannel(Channel* target)
 		if (it != mixer::channels.end()) 
 			mixer::channels.erase(it);
 		pthread_mutex_unlock(&mixer::mutex);
+		midiDispatcher::invalidate();
+		return;
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void updateEnvelopes()
+{
+	unsigned version = recorder::getVersion();
+	if (!envelopesDirty.exchange(false) && version == envelopesVersion)
 		return;
+	envelopesVersion = version;
+
+	for (Channel* ch : mixer::channels) {
+		ch->volumeEnv.compile(ch->index);
+#ifdef WITH_VST
+		pluginHost::updateEnvelopes(ch);
+#endif
 	}
 }
 
@@ -285,6 +339,11 @@ void rewindSequencer()
 
 bool startInputRec()
 {
+	/* The previous take, if stopped by the audio thread, goes in first: it still
+	sits in the virtual input. */
+
+	mixer::mergePendingInput();
+
 	int channelsReady = 0;
 
 	for (Channel* ch : mixer::channels) {
@@ -30,6 +30,7 @@
 
 
 #include <string>
+#include <vector>
 #include "types.h"
 
 
@@ -46,11 +47,31 @@ Adds a new channel of type 'type' into mixer's stack. */
 
 Channel* addChannel(ChannelType type);
 
+/* createChannel
+Makes a new channel of type 'type', not yet in mixer's stack. See 
+addChannels(). */
+
+Channel* createChannel(ChannelType type);
+
+/* addChannels
+Adds channels made with createChannel() into mixer's stack in one go: the audio
+thread sees either none or all of them. */
+
+void addChannels(const std::vector<Channel*>& chans);
+
 /* deleteChannel
 Completely removes a channel from the stack. */
 
 void deleteChannel(Channel* ch);
 
+/* updateEnvelopes
+Compiles the automation envelopes of all channels again if the recorded actions
+or the tempo changed since the last call. Called periodically by a non-audio 
+thread, while channels can't come and go: the audio thread only picks the new
+envelopes up. */
+
+void updateEnvelopes();
+
 /* getChannelByIndex
 Returns channel with given index 'i'. */
 
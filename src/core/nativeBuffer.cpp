@@ -0,0 +1,90 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#include <cassert>
+#include "audioBuffer.h"
+#include "nativeBuffer.h"
+
+
+namespace giada {
+namespace m 
+{
+NativeBuffer::NativeBuffer(int frames, int channels, dsp::Format format, 
+	const std::string& path)
+: m_frames  (frames),
+  m_channels(channels),
+  m_format  (format),
+  m_path    (path)
+{
+	m_data.resize(static_cast<size_t>(frames) * getFrameBytes_());
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int NativeBuffer::countFrames() const { return m_frames; }
+int NativeBuffer::countChannels() const { return m_channels; }
+dsp::Format NativeBuffer::getFormat() const { return m_format; }
+const std::string& NativeBuffer::getPath() const { return m_path; }
+size_t NativeBuffer::getBytes() const { return m_data.size(); }
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int NativeBuffer::getFrameBytes_() const
+{
+	switch (m_format) {
+		case dsp::Format::INT16: return m_channels * 2;
+		case dsp::Format::INT24: return m_channels * 3;
+		default:                 return m_channels * 4;
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void* NativeBuffer::getFrame(int f)
+{
+	assert(f < m_frames);
+	return m_data.data() + static_cast<size_t>(f) * getFrameBytes_();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void NativeBuffer::read(AudioBuffer& dest, int start, int frames, int offset) const
+{
+	assert(start + frames <= m_frames);
+	const char* src = m_data.data() + static_cast<size_t>(start) * getFrameBytes_();
+	dsp::decode(dest, offset, src, m_format, m_channels, frames);
+}
+}} // giada::m::
@@ -0,0 +1,93 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#ifndef G_NATIVE_BUFFER_H
+#define G_NATIVE_BUFFER_H
+
+
+#include <string>
+#include <vector>
+#include "dsp.h"
+
+
+namespace giada {
+namespace m 
+{
+class AudioBuffer;
+
+/* NativeBuffer
+Sample data kept as found in the file: original channel count and bit depth 
+(see dsp::Format), converted to stereo float only when read. Takes from half to
+a quarter of the memory of an AudioBuffer. Read-only once filled. */
+
+class NativeBuffer
+{
+public:
+
+	NativeBuffer(int frames, int channels, dsp::Format format, 
+		const std::string& path);
+
+	int countFrames() const;
+	int countChannels() const;
+	dsp::Format getFormat() const;
+
+	/* getPath
+	Source file the data comes from. */
+
+	const std::string& getPath() const;
+
+	/* getBytes
+	Returns the memory taken by data. */
+
+	size_t getBytes() const;
+
+	/* getFrame
+	Returns raw data starting from frame 'f', for filling. */
+
+	void* getFrame(int f);
+
+	/* read
+	Converts 'frames' frames starting from 'start' to float into 'dest' at frame
+	'offset'. */
+
+	void read(AudioBuffer& dest, int start, int frames, int offset) const;
+
+private:
+
+	int getFrameBytes_() const;
+
+	std::vector<char> m_data;
+	int               m_frames;
+	int               m_channels;
+	dsp::Format       m_format;
+	std::string       m_path;
+};
+}} // giada::m::
+
+
+#endif
@@ -91,6 +91,7 @@ struct channel_t
 	float       boost;
 	int         recActive;
 	float       pitch;
+	int         interpolation;
 	bool        inputMonitor;
 	uint32_t    midiInReadActions;
 	uint32_t    midiInPitch;
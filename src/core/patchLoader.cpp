@@ -0,0 +1,190 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <thread>
+#include <vector>
+#include "../utils/log.h"
+#include "const.h"
+#include "conf.h"
+#include "patch.h"
+#include "types.h"
+#include "wave.h"
+#include "waveManager.h"
+#include "patchLoader.h"
+
+
+using std::string;
+using std::vector;
+
+
+namespace giada {
+namespace m {
+namespace patchLoader
+{
+namespace
+{
+/* Job_
+A sample to load, possibly shared by several channels. 'claimed' tells if 
+'wave' has been handed out already: following channels get a copy. */
+
+struct Job_
+{
+	string path;
+	int    res;
+	Wave*  wave;
+	bool   claimed;
+};
+
+vector<Job_>        jobs;
+vector<int>         channelJobs;  // patch channel index -> job index, -1 if none
+vector<std::thread> threads;
+std::atomic<int>    next(0);
+std::atomic<int>    done(0);
+
+
+/* -------------------------------------------------------------------------- */
+
+/* work_
+Grabs pending jobs until there are none left. */
+
+void work_()
+{
+	int i;
+	while ((i = next++) < static_cast<int>(jobs.size())) {
+		Job_& job = jobs.at(i);
+		job.res = waveManager::create(job.path, &job.wave, waveManager::Storage::AUTO, 
+			conf::samplerate);
+		done++;
+	}
+}
+}; // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+void start(const string& basePath)
+{
+	clear();
+
+	std::map<string, int> paths;
+	for (const patch::channel_t& pch : patch::channels) {
+		if (static_cast<ChannelType>(pch.type) != ChannelType::SAMPLE) {
+			channelJobs.push_back(-1);
+			continue;
+		}
+		string path = basePath + pch.samplePath;
+		auto it = paths.find(path);
+		if (it == paths.end()) {
+			it = paths.insert(std::make_pair(path, jobs.size())).first;
+			jobs.push_back({path, G_RES_ERR_NO_DATA, nullptr, false});
+		}
+		channelJobs.push_back(it->second);
+	}
+
+	int count = std::min<int>(std::max(1u, std::thread::hardware_concurrency()), 
+		jobs.size());
+	for (int i=0; i<count; i++)
+		threads.push_back(std::thread(work_));
+
+	gu_log("[patchLoader::start] loading %zu samples on %d threads\n", jobs.size(), 
+		count);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+float getProgress()
+{
+	if (jobs.empty())
+		return 1.0f;
+	return done / static_cast<float>(jobs.size());
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void finish()
+{
+	for (std::thread& t : threads)
+		t.join();
+	threads.clear();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int getWave(int index, Wave** out)
+{
+	*out = nullptr;
+
+	int i = channelJobs.at(index);
+	if (i == -1)
+		return G_RES_ERR_NO_DATA;
+
+	Job_& job = jobs.at(i);
+	if (job.res != G_RES_OK)
+		return job.res;
+
+	if (!job.claimed) {
+		job.claimed = true;
+		*out = job.wave;
+	}
+	else {
+		/* The original belongs to some other channel by now, alive until the 
+		loading is over. A copy shares its data anyway (see Wave). */
+		*out = new Wave(*job.wave);
+		(*out)->setLogical(job.wave->isLogical());
+	}
+	return G_RES_OK;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void clear()
+{
+	finish();
+	for (Job_& job : jobs)
+		if (!job.claimed)
+			delete job.wave;
+	jobs.clear();
+	channelJobs.clear();
+	next = 0;
+	done = 0;
+}
+}}}; // giada::m::patchLoader::
@@ -0,0 +1,74 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#ifndef G_PATCH_LOADER_H
+#define G_PATCH_LOADER_H
+
+
+#include <string>
+
+
+class Wave;
+
+
+namespace giada {
+namespace m {
+namespace patchLoader
+{
+/* start
+Begins loading samples of all sample channels in the current patch on a pool of
+background threads, converted to the current samplerate if needed. Samples 
+used by more than one channel are read only once. 'basePath' is prepended to 
+sample paths (projects). */
+
+void start(const std::string& basePath);
+
+/* getProgress
+Returns how much of the job is done, from 0.0 to 1.0. */
+
+float getProgress();
+
+/* finish
+Waits for the background threads to complete. */
+
+void finish();
+
+/* getWave
+Returns the outcome of loading the sample of channel 'index' in the patch and 
+its Wave, owned by the caller from now on. Call after finish(). */
+
+int getWave(int index, Wave** out);
+
+/* clear
+Frees any Wave not claimed with getWave(). */
+
+void clear();
+}}}; // giada::m::patchLoader::
+
+
+#endif
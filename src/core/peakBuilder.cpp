@@ -0,0 +1,339 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sndfile.h>
+#include "../utils/fs.h"
+#include "../utils/log.h"
+#include "const.h"
+#include "conf.h"
+#include "audioBuffer.h"
+#include "nativeBuffer.h"
+#include "rope.h"
+#include "peaks.h"
+#include "wave.h"
+#include "peakBuilder.h"
+
+
+using std::string;
+
+
+namespace giada {
+namespace m {
+namespace peakBuilder
+{
+namespace
+{
+/* CHUNK_FRAMES
+Frames read at once. Jobs check for cancellation between chunks. */
+
+constexpr int CHUNK_FRAMES = Peaks::BIN_FRAMES * 1024;
+
+/* Job_
+A wave to build peaks for. It holds its own reference to data, so it doesn't
+depend on the Wave, which can change or go away in the meantime: if so, the 
+slot tells and the job is dropped. */
+
+struct Job_
+{
+	std::weak_ptr<PeakSlot>             slot;
+	unsigned                            version;
+	int                                 frames;
+	std::shared_ptr<const AudioBuffer>  buffer;  // direct waves
+	std::shared_ptr<const NativeBuffer> native;  // native waves
+	std::shared_ptr<const Rope>         rope;    // chunked waves
+	string                              path;    // streamed waves read from here
+	string                              file;    // peak file, if any
+};
+
+std::thread             thread;
+std::atomic<bool>       running(false);
+std::atomic<bool>       busy(false);
+std::mutex              mutex;
+std::condition_variable cond;
+std::deque<Job_>        jobs;
+
+
+/* -------------------------------------------------------------------------- */
+
+/* isStale_
+True if the job's wave has changed or is gone. */
+
+bool isStale_(const Job_& job)
+{
+	std::shared_ptr<PeakSlot> slot = job.slot.lock();
+	if (slot == nullptr)
+		return true;
+	std::lock_guard<std::mutex> lock(slot->mutex);
+	return slot->version != job.version;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* readFile_
+Computes peaks of streamed waves straight from the sample file. */
+
+bool readFile_(const Job_& job, Peaks& peaks)
+{
+	SF_INFO  header = SF_INFO();
+	SNDFILE* file   = sf_open(job.path.c_str(), SFM_READ, &header);
+	if (file == nullptr)
+		return false;
+
+	std::vector<float> chunk(CHUNK_FRAMES * header.channels);
+	int  start = 0;
+	bool ok    = true;
+	while (ok && start < job.frames) {
+		int frames = sf_readf_float(file, chunk.data(), CHUNK_FRAMES);
+		frames = std::min(frames, job.frames - start);
+		if (frames <= 0 || isStale_(job) || !running)
+			ok = false;
+		else
+			peaks.write(chunk.data(), header.channels, start, frames);
+		start += frames;
+	}
+	sf_close(file);
+	return ok;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* readData_
+Computes peaks of waves in memory: direct, native or chunked. */
+
+bool readData_(const Job_& job, Peaks& peaks)
+{
+	AudioBuffer chunk;
+	if (job.native != nullptr)
+		chunk.alloc(CHUNK_FRAMES, G_MAX_IO_CHANS);
+	else
+	if (job.rope != nullptr)
+		chunk.alloc(CHUNK_FRAMES, job.rope->countChannels());
+
+	for (int start=0; start<job.frames; start+=CHUNK_FRAMES) {
+		if (isStale_(job) || !running)
+			return false;
+		int frames = std::min(CHUNK_FRAMES, job.frames - start);
+		if (job.native != nullptr) {
+			job.native->read(chunk, start, frames, 0);
+			peaks.write(chunk[0], chunk.countChannels(), start, frames);
+		}
+		else
+		if (job.rope != nullptr) {
+			job.rope->read(chunk, start, frames, 0);
+			peaks.write(chunk[0], chunk.countChannels(), start, frames);
+		}
+		else
+			peaks.write((*job.buffer)[start], job.buffer->countChannels(), start, frames);
+	}
+	return true;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void build_(const Job_& job)
+{
+	std::shared_ptr<Peaks> peaks = std::make_shared<Peaks>(job.frames);
+
+	int64_t size  = 0;
+	int64_t mtime = 0;
+	bool    stamp = !job.file.empty() && gu_getFileStamp(job.path, size, mtime);
+
+	if (!stamp || !peaks->load(job.file, size, mtime)) {
+		bool ok = job.buffer == nullptr && job.native == nullptr && job.rope == nullptr ? 
+			readFile_(job, *peaks) : readData_(job, *peaks);
+		if (!ok)
+			return;
+		if (stamp)
+			peaks->save(job.file, size, mtime);
+	}
+
+	std::shared_ptr<PeakSlot> slot = job.slot.lock();
+	if (slot == nullptr)
+		return;
+	std::lock_guard<std::mutex> lock(slot->mutex);
+	if (slot->version != job.version)
+		return;
+	slot->peaks   = peaks;
+	slot->pending = false;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void loop_()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (running) {
+		if (jobs.empty()) {
+			busy = false;
+			cond.wait(lock);
+			continue;
+		}
+		Job_ job = jobs.front();
+		jobs.pop_front();
+		lock.unlock();
+		build_(job);
+		lock.lock();
+	}
+}
+}; // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+void init()
+{
+	if (running)
+		return;
+	running = true;
+	thread  = std::thread(loop_);
+	gu_log("[peakBuilder::init] peak thread started\n");
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void close()
+{
+	if (!running)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+		jobs.clear();
+	}
+	cond.notify_one();
+	thread.join();
+	busy = false;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void request(const Wave& w)
+{
+	std::shared_ptr<PeakSlot> slot = w.getPeakSlot();
+
+	Job_ job;
+	{
+		std::lock_guard<std::mutex> lock(slot->mutex);
+		if (slot->peaks != nullptr || slot->pending || !running)
+			return;
+		slot->pending = true;
+		job.slot    = slot;
+		job.version = slot->version;
+	}
+
+	job.frames = w.getSize();
+	job.path   = w.getPath();
+	if (w.isNative())
+		job.native = w.getNative();
+	else
+	if (w.isChunked())
+		job.rope = w.getRope();
+	else
+	if (w.isDirect())
+		job.buffer = w.getBuffer();
+	if (conf::peakFiles && !w.isLogical() && !w.isEdited())
+		job.file = job.path + G_PEAKS_EXT;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	jobs.push_back(job);
+	busy = true;
+	cond.notify_one();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void update(const Wave& w, int a, int b)
+{
+	std::shared_ptr<PeakSlot> slot = w.getPeakSlot();
+	{
+		std::lock_guard<std::mutex> lock(slot->mutex);
+
+		/* No peaks yet, or the size has changed: whatever is being built comes 
+		from old data. Start over. */
+
+		if (slot->peaks == nullptr || slot->peaks->countFrames() != w.getSize() ||
+			  !(w.isDirect() || w.isChunked())) 
+		{
+			slot->peaks.reset();
+			slot->version++;
+			slot->pending = false;
+		}
+		else {
+			a = std::max(0, a) / Peaks::BIN_FRAMES * Peaks::BIN_FRAMES;
+			b = (b + Peaks::BIN_FRAMES - 1) / Peaks::BIN_FRAMES * Peaks::BIN_FRAMES;
+			b = std::min(b, w.getSize());
+			if (a >= b)
+				return;
+			std::shared_ptr<Peaks> peaks = std::make_shared<Peaks>(*slot->peaks);
+			if (w.isChunked()) {
+				AudioBuffer data;
+				data.alloc(b - a, w.getChannels());
+				w.getRope()->read(data, a, b - a, 0);
+				peaks->write(data[0], w.getChannels(), a, b - a);
+			}
+			else
+				peaks->write(w.getFrame(a), w.getChannels(), a, b - a);
+			slot->peaks = peaks;
+			return;
+		}
+	}
+	request(w);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool isBusy()
+{
+	return busy;
+}
+}}}; // giada::m::peakBuilder::
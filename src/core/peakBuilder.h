@@ -0,0 +1,69 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#ifndef G_PEAK_BUILDER_H
+#define G_PEAK_BUILDER_H
+
+
+class Wave;
+
+
+namespace giada {
+namespace m {
+namespace peakBuilder
+{
+/* init
+Starts the thread that builds waveform overviews (see Peaks). */
+
+void init();
+void close();
+
+/* request
+Builds peaks of wave 'w' in background, unless they are already there or on 
+their way. Wave::getPeaks() returns them when done. If conf::peakFiles is on, 
+peaks of unedited samples are read from (or written to) a file next to the 
+sample. Call it from the thread that owns 'w': the GUI one, or an editing job
+(see waveEditor). */
+
+void request(const Wave& w);
+
+/* update
+Recomputes peaks of wave 'w' in frames [a, b) right away, after an in-place 
+edit. Falls back to request() if there's nothing to update yet. Same threading
+rules as request(). */
+
+void update(const Wave& w, int a, int b);
+
+/* isBusy
+Tells whether some peaks are still being built. */
+
+bool isBusy();
+}}}; // giada::m::peakBuilder::
+
+
+#endif
@@ -0,0 +1,271 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "../utils/log.h"
+#include "peaks.h"
+
+
+using std::string;
+
+
+namespace giada {
+namespace m 
+{
+namespace
+{
+/* Header_
+Peak files are a header followed by level 0 bins, in native byte order. */
+
+struct Header_
+{
+	char     magic[4];
+	uint32_t version;
+	uint32_t frames;
+	uint32_t binFrames;
+	int64_t  size;
+	int64_t  mtime;
+	char     padding[32];
+};
+
+static_assert(sizeof(Header_) == 64, "Header_ must be 64 bytes long");
+
+constexpr char     MAGIC[4] = {'G', 'P', 'K', 'F'};
+constexpr uint32_t VERSION  = 1;
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int divCeil_(int a, int b)
+{
+	return (a + b - 1) / b;
+}
+}; // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+Peaks::Peaks(int frames)
+: m_frames(frames)
+{
+	int bins = divCeil_(frames, BIN_FRAMES);
+	m_levels.emplace_back(bins, Bin_{0.0f, 0.0f, 0.0f});
+	while (bins > 1) {
+		bins = divCeil_(bins, FACTOR);
+		m_levels.emplace_back(bins, Bin_{0.0f, 0.0f, 0.0f});
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int Peaks::countFrames() const { return m_frames; }
+int Peaks::countLevels() const { return m_levels.size(); }
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Peaks::write(const float* data, int channels, int start, int frames)
+{
+	assert(start % BIN_FRAMES == 0);
+	assert(start + frames <= m_frames);
+
+	if (frames <= 0)
+		return;
+
+	int first = start / BIN_FRAMES;
+	int last  = divCeil_(start + frames, BIN_FRAMES);
+
+	for (int i=first; i<last; i++) {
+		int from = (i - first) * BIN_FRAMES;
+		int to   = std::min(from + BIN_FRAMES, frames);
+		Bin_ bin = { 0.0f, 0.0f, 0.0f };
+		for (int f=from; f<to; f++) {
+			float avg = 0.0f;
+			for (int j=0; j<channels; j++)
+				avg += data[f * channels + j];
+			avg /= channels;
+			bin.min = f == from ? avg : std::min(bin.min, avg);
+			bin.max = f == from ? avg : std::max(bin.max, avg);
+			bin.ms += avg * avg;
+		}
+		bin.ms /= to - from;
+		m_levels[0][i] = bin;
+	}
+
+	for (int l=1; l<countLevels(); l++)
+		merge_(l, first, last);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Peaks::merge_(int l, int a, int b)
+{
+	int span = BIN_FRAMES;  // frames in a bin of level l-1
+	for (int i=1; i<l; i++) {
+		span *= FACTOR;
+		a /= FACTOR;
+		b  = divCeil_(b, FACTOR);
+	}
+	a /= FACTOR;
+	b  = divCeil_(b, FACTOR);
+
+	const std::vector<Bin_>& src  = m_levels[l - 1];
+	std::vector<Bin_>&       dest = m_levels[l];
+
+	for (int i=a; i<b && i<(int) dest.size(); i++) {
+		int from   = i * FACTOR;
+		int to     = std::min(from + FACTOR, (int) src.size());
+		int frames = 0;
+		Bin_ bin = src[from];
+		bin.ms = 0.0f;
+		for (int j=from; j<to; j++) {
+			int n = std::min(span, m_frames - j * span);
+			bin.min = std::min(bin.min, src[j].min);
+			bin.max = std::max(bin.max, src[j].max);
+			bin.ms += src[j].ms * n;
+			frames += n;
+		}
+		bin.ms /= frames;
+		dest[i] = bin;
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Peak Peaks::get(int a, int b) const
+{
+	a = std::max(0, std::min(a, m_frames));
+	b = std::max(a, std::min(b, m_frames));
+	if (a == b)
+		return { 0.0f, 0.0f, 0.0f };
+
+	int l    = 0;
+	int span = BIN_FRAMES;
+	while (l + 1 < countLevels() && span * FACTOR <= b - a) {
+		span *= FACTOR;
+		l++;
+	}
+
+	const std::vector<Bin_>& bins = m_levels[l];
+	int from   = a / span;
+	int to     = std::min(divCeil_(b, span), (int) bins.size());
+	int frames = 0;
+	Bin_ out   = bins[from];
+	out.ms = 0.0f;
+	for (int i=from; i<to; i++) {
+		int n = std::min(span, m_frames - i * span);
+		out.min = std::min(out.min, bins[i].min);
+		out.max = std::max(out.max, bins[i].max);
+		out.ms += bins[i].ms * n;
+		frames += n;
+	}
+	return { out.min, out.max, std::sqrt(out.ms / frames) };
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool Peaks::load(const string& path, int64_t size, int64_t mtime)
+{
+	FILE* f = fopen(path.c_str(), "rb");
+	if (f == nullptr)
+		return false;
+
+	Header_ h;
+	std::vector<Bin_>& bins = m_levels[0];
+	bool ok = fread(&h, sizeof(h), 1, f) == 1   &&
+	          memcmp(h.magic, MAGIC, 4) == 0    &&
+	          h.version   == VERSION            &&
+	          h.frames    == (uint32_t) m_frames &&
+	          h.binFrames == BIN_FRAMES          &&
+	          h.size      == size                &&
+	          h.mtime     == mtime               &&
+	          fread(bins.data(), sizeof(Bin_), bins.size(), f) == bins.size();
+	fclose(f);
+
+	if (!ok) {
+		gu_log("[Peaks::load] %s is missing or outdated\n", path.c_str());
+		return false;
+	}
+
+	for (int l=1; l<countLevels(); l++)
+		merge_(l, 0, bins.size());
+	return true;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool Peaks::save(const string& path, int64_t size, int64_t mtime) const
+{
+	Header_ h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, MAGIC, 4);
+	h.version   = VERSION;
+	h.frames    = m_frames;
+	h.binFrames = BIN_FRAMES;
+	h.size      = size;
+	h.mtime     = mtime;
+
+	/* Write to a temporary file first: a reader never finds half a file. */
+
+	string tmp = path + ".tmp";
+	FILE* f = fopen(tmp.c_str(), "wb");
+	if (f == nullptr)
+		return false;
+	const std::vector<Bin_>& bins = m_levels[0];
+	bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+	          fwrite(bins.data(), sizeof(Bin_), bins.size(), f) == bins.size();
+	ok = fclose(f) == 0 && ok;
+
+	std::remove(path.c_str());  // rename() doesn't overwrite on Windows
+	if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+		gu_log("[Peaks::save] unable to write %s\n", path.c_str());
+		std::remove(tmp.c_str());
+		return false;
+	}
+	return true;
+}
+}} // giada::m::
@@ -0,0 +1,138 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#ifndef G_PEAKS_H
+#define G_PEAKS_H
+
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+namespace giada {
+namespace m 
+{
+/* Peak
+Levels of a range of frames, channels averaged: lowest and highest sample value
+plus root mean square. */
+
+struct Peak
+{
+	float min;
+	float max;
+	float rms;
+};
+
+
+/* Peaks
+Waveform overview: a pyramid of Peak bins. Level 0 has a bin every BIN_FRAMES
+frames, each next level merges FACTOR bins of the previous one. Reading the 
+levels of any range takes a handful of bins, whatever its length. */
+
+class Peaks
+{
+public:
+
+	static const int BIN_FRAMES = 64;
+	static const int FACTOR     = 4;
+
+	/* Peaks (1)
+	Silent peaks for a wave of 'frames' frames. Fill them with write(). */
+
+	Peaks(int frames);
+
+	int countFrames() const;
+	int countLevels() const;
+
+	/* write
+	Computes bins from 'frames' frames of interleaved 'data' with 'channels'
+	channels, which are frames starting from 'start' in the wave. 'start' must be
+	a multiple of BIN_FRAMES, 'frames' too unless the range reaches the end of the
+	wave. Coarser levels follow. */
+
+	void write(const float* data, int channels, int start, int frames);
+
+	/* get
+	Returns levels of frames [a, b), reading from the coarsest level with bins 
+	not larger than the range. Bins at the edges might exceed it a little. */
+
+	Peak get(int a, int b) const;
+
+	/* load, save
+	Reads/writes level 0 from/to file 'path'. 'size' and 'mtime' describe the 
+	source sample: load() fails if they don't match, i.e. the sample has changed
+	in the meantime. */
+
+	bool load(const std::string& path, int64_t size, int64_t mtime);
+	bool save(const std::string& path, int64_t size, int64_t mtime) const;
+
+private:
+
+	/* Bin_
+	Like Peak, with mean square instead of its root: easier to merge. */
+
+	struct Bin_
+	{
+		float min;
+		float max;
+		float ms;
+	};
+
+	/* merge_
+	Recomputes bins of level 'l' from the previous one, for level 0 bins 
+	[a, b). */
+
+	void merge_(int l, int a, int b);
+
+	int m_frames;
+	std::vector<std::vector<Bin_>> m_levels;
+};
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* PeakSlot
+Where a Wave keeps its Peaks. Shared with peakBuilder, so that a Wave can go 
+away while its peaks are being built. Peaks in a slot are never changed: new 
+ones replace them. */
+
+struct PeakSlot
+{
+	std::mutex                   mutex;
+	std::shared_ptr<const Peaks> peaks;
+	unsigned                     version = 0;  // bumped on each change
+	bool                         pending = false;
+};
+}} // giada::m::
+
+
+#endif
@@ -0,0 +1,446 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <samplerate.h>
+#include "../utils/log.h"
+#include "audioBuffer.h"
+#include "nativeBuffer.h"
+#include "rope.h"
+#include "const.h"
+#include "conf.h"
+#include "wave.h"
+#include "pitchCache.h"
+
+
+namespace giada {
+namespace m {
+namespace pitchCache
+{
+/* Render
+A whole wave played at a constant pitch: frame i of 'data' matches frame 
+i * pitch of the original one. 'source' keeps the original data alive, so that
+its address can't be taken by some other data while the render is around. */
+
+struct Render
+{
+	AudioBuffer                 data;
+	std::shared_ptr<const void> source;
+	float                       pitch;
+	int                         quality;
+};
+
+
+namespace
+{
+/* CHUNK_FRAMES
+Frames of the original wave read at once. Jobs check whether they are still 
+wanted between chunks. */
+
+constexpr int CHUNK_FRAMES = 65536;
+
+/* Job_
+A wave to render. It holds its own reference to data, so it doesn't depend on 
+the Wave, which can change or go away in the meantime. */
+
+struct Job_
+{
+	std::weak_ptr<Slot>                 slot;
+	std::shared_ptr<const void>         source;
+	std::shared_ptr<const AudioBuffer>  buffer;  // direct waves
+	std::shared_ptr<const NativeBuffer> native;  // native waves
+	std::shared_ptr<const Rope>         rope;    // chunked waves
+	int                                 frames;
+	float                               pitch;
+	int                                 quality;
+};
+
+std::thread             thread;
+std::atomic<bool>       running(false);
+std::atomic<bool>       busy(false);
+std::mutex              mutex;
+std::condition_variable cond;
+std::deque<Job_>        jobs;
+
+
+/* -------------------------------------------------------------------------- */
+
+/* sourceOf_
+Returns the data of wave 'w', which tells one render from another. Streamed 
+waves have none in memory. */
+
+std::shared_ptr<const void> sourceOf_(const Wave& w)
+{
+	if (w.isNative())  return w.getNative();
+	if (w.isChunked()) return w.getRope();
+	if (w.isDirect())  return w.getBuffer();
+	return nullptr;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void readSource_(const Job_& job, AudioBuffer& dest, int start, int frames)
+{
+	if (job.native != nullptr)
+		job.native->read(dest, start, frames, 0);
+	else
+	if (job.rope != nullptr)
+		job.rope->read(dest, start, frames, 0);
+	else
+		dest.copyData((*job.buffer)[start], frames);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* isWanted_
+True if the job is still worth doing: the slot is there and its channel is 
+still at the same pitch. */
+
+bool isWanted_(const Job_& job)
+{
+	std::shared_ptr<Slot> slot = job.slot.lock();
+	return running && slot != nullptr && slot->isWanted(job.pitch);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Render* render_(const Job_& job)
+{
+	int error;
+	SRC_STATE* state = src_new(job.quality, G_MAX_IO_CHANS, &error);
+	if (state == nullptr) {
+		gu_log("[pitchCache::render_] unable to start resampler: %s\n", 
+			src_strerror(error));
+		return nullptr;
+	}
+
+	std::unique_ptr<Render> r(new Render());
+	r->source  = job.source;
+	r->pitch   = job.pitch;
+	r->quality = job.quality;
+	r->data.alloc(static_cast<int>(std::ceil(job.frames / job.pitch)), G_MAX_IO_CHANS);
+
+	AudioBuffer chunk;
+	chunk.alloc(CHUNK_FRAMES, G_MAX_IO_CHANS);
+
+	SRC_DATA data;
+	data.src_ratio = 1 / job.pitch;
+
+	int read    = 0;  // frames read from the original wave
+	int used    = 0;  // frames of 'chunk' consumed so far
+	int avail   = 0;  // frames in 'chunk'
+	int written = 0;  // frames in the render
+	bool ok     = true;
+
+	while (ok && written < r->data.countFrames()) {
+		if (used == avail && read < job.frames) {
+			if (!isWanted_(job)) {
+				ok = false;
+				break;
+			}
+			avail = std::min(CHUNK_FRAMES, job.frames - read);
+			readSource_(job, chunk, read, avail);
+			read += avail;
+			used  = 0;
+		}
+		data.data_in       = chunk[used < avail ? used : 0];
+		data.input_frames  = avail - used;
+		data.data_out      = r->data[written];
+		data.output_frames = r->data.countFrames() - written;
+		data.end_of_input  = read == job.frames;
+
+		if ((error = src_process(state, &data)) != 0) {
+			gu_log("[pitchCache::render_] resampling failed: %s\n", src_strerror(error));
+			ok = false;
+			break;
+		}
+		used    += data.input_frames_used;
+		written += data.output_frames_gen;
+
+		/* All input consumed and nothing more coming out: the rest of the render
+		stays silent. */
+
+		if (data.end_of_input && data.input_frames_used == 0 && data.output_frames_gen == 0)
+			break;
+	}
+	src_delete(state);
+
+	return ok ? r.release() : nullptr;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void loop_()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (running) {
+		if (jobs.empty()) {
+			busy = false;
+			cond.wait(lock);
+			continue;
+		}
+		Job_ job = jobs.front();
+		jobs.pop_front();
+		lock.unlock();
+
+		Render* r = render_(job);
+		if (r != nullptr)
+			gu_log("[pitchCache] %d frames rendered at pitch %f\n", 
+				r->data.countFrames(), r->pitch);
+		std::shared_ptr<Slot> slot = job.slot.lock();
+		if (slot != nullptr)
+			slot->post(r);
+		else
+			delete r;
+
+		lock.lock();
+	}
+}
+}; // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+Slot::Slot()
+: m_incoming(nullptr),
+  m_wanted  (0.0f),
+  m_busy    (false),
+  m_current (nullptr),
+  m_pitch   (0.0f),
+  m_still   (0),
+  m_next    (-1),
+  m_pos     (0)
+{
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Slot::~Slot()
+{
+	Render* r;
+	while (m_trash.pop(r))
+		delete r;
+	delete m_incoming.load();
+	delete m_current;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Slot::retire_()
+{
+	if (m_current != nullptr && m_trash.push(m_current))
+		m_current = nullptr;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool Slot::prepare(const Wave& w, float pitch, int frames)
+{
+	/* Pick up a new render, as long as the old one can be given back. */
+
+	if (m_incoming.load() != nullptr && (m_current == nullptr || m_trash.push(m_current))) {
+		m_current = m_incoming.exchange(nullptr);
+		m_next    = -1;
+	}
+
+	if (pitch != m_pitch) {
+		m_pitch = pitch;
+		m_still = 0;
+	}
+	else
+		m_still = std::min(m_still + frames, conf::samplerate * 60);
+
+	bool settled = m_still >= SETTLE_TIME * conf::samplerate;
+
+	if (!conf::pitchCache || (settled && pitch == 1.0f)) {
+		retire_();
+		m_wanted = 0.0f;
+		return false;
+	}
+
+	bool ready = m_current != nullptr      && 
+	             m_current->pitch == pitch && 
+	             m_current->quality == conf::rsmpQuality && 
+	             m_current->source == sourceOf_(w);
+
+	m_wanted = settled && !ready ? pitch : 0.0f;
+	return ready;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int Slot::read(AudioBuffer& dest, int start, int end, int offset)
+{
+	const Render& r = *m_current;
+
+	/* Carry on from the previous read if contiguous: rounding positions back and
+	forth could skip or repeat a frame. */
+
+	int pos  = start == m_next ? m_pos : static_cast<int>(std::ceil(start / r.pitch));
+	int last = std::min(r.data.countFrames(), static_cast<int>(std::ceil(end / r.pitch)));
+	int n    = std::min(dest.countFrames() - offset, last - pos);
+
+	if (n <= 0) {
+		m_next = -1;
+		return std::max(end - start, 0);  // nothing left to hear before 'end'
+	}
+
+	dest.copyData(r.data[pos], n, offset);
+	m_pos  = pos + n;
+	m_next = std::max(start + 1, static_cast<int>(std::ceil(m_pos * r.pitch)));
+	return m_next - start;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool Slot::isWanted(float pitch) const
+{
+	return m_wanted == pitch;
+}
+
+
+void Slot::post(Render* r)
+{
+	if (r != nullptr)
+		delete m_incoming.exchange(r);
+	m_busy = false;
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+void init()
+{
+	if (running)
+		return;
+	running = true;
+	thread  = std::thread(loop_);
+	gu_log("[pitchCache::init] render thread started\n");
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void close()
+{
+	if (!running)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+		jobs.clear();
+	}
+	cond.notify_one();
+	thread.join();
+	busy = false;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void update(const std::shared_ptr<Slot>& s, const Wave& w)
+{
+	Render* r;
+	while (s->m_trash.pop(r))
+		delete r;
+
+	float pitch = s->m_wanted;
+	if (pitch == 0.0f || s->m_busy || s->m_incoming.load() != nullptr || !running)
+		return;
+
+	/* Waves that are too large to be kept in memory once are too large to be 
+	kept twice. */
+
+	double bytes = std::ceil(w.getSize() / pitch) * G_MAX_IO_CHANS * sizeof(float);
+	if (w.isStreamed() || w.getSize() == 0 ||
+	    (conf::streamThreshold > 0 && bytes > conf::streamThreshold * 1024.0 * 1024.0))
+		return;
+	if (!w.isNative() && w.getChannels() != G_MAX_IO_CHANS)
+		return;
+
+	Job_ job;
+	job.slot    = s;
+	job.source  = sourceOf_(w);
+	job.frames  = w.getSize();
+	job.pitch   = pitch;
+	job.quality = conf::rsmpQuality;
+	if (w.isNative())
+		job.native = w.getNative();
+	else
+	if (w.isChunked())
+		job.rope = w.getRope();
+	else
+		job.buffer = w.getBuffer();
+
+	s->m_busy = true;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	jobs.push_back(job);
+	busy = true;
+	cond.notify_one();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool isBusy()
+{
+	return busy;
+}
+}}}; // giada::m::pitchCache::
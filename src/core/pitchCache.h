@@ -0,0 +1,142 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#ifndef G_PITCH_CACHE_H
+#define G_PITCH_CACHE_H
+
+
+#include <atomic>
+#include <memory>
+#include "queue.h"
+
+
+class Wave;
+
+
+namespace giada {
+namespace m {
+class AudioBuffer;
+
+namespace pitchCache
+{
+/* SETTLE_TIME
+Seconds the pitch of a channel must stay still before its wave is rendered. */
+
+constexpr float SETTLE_TIME = 0.5f;
+
+struct Render;
+
+/* Slot
+Where a sample channel meets the pitch cache. Once the pitch has been still for
+a while, the audio thread asks for the whole wave rendered at that pitch; the 
+render thread makes it and hands it over without locks. Old renders go back the
+same way and are freed elsewhere: the audio thread never allocates or frees. */
+
+class Slot
+{
+public:
+
+	Slot();
+	~Slot();
+
+	/* prepare
+	Audio thread only, once per block before any read(). Picks up new renders 
+	and follows pitch changes of wave 'w', 'frames' at a time. Returns true if 
+	the render of 'w' at 'pitch' is ready, i.e. read() can be used. */
+
+	bool prepare(const Wave& w, float pitch, int frames);
+
+	/* read
+	Audio thread only. Works like SampleChannel::fillBuffer(): fills 'dest' from
+	frame 'offset' on with the render, starting from frame 'start' of the 
+	original wave and up to 'end'. Returns how many frames of the original wave 
+	have been used. */
+
+	int read(AudioBuffer& dest, int start, int end, int offset);
+
+	/* isWanted
+	Render thread side: tells whether a render at 'pitch' is still needed. */
+
+	bool isWanted(float pitch) const;
+
+	/* post
+	Render thread side: hands render 'r' over to the audio thread, replacing the
+	previous one if not picked up yet. Takes ownership of 'r'. Post nullptr when
+	a job is dropped. */
+
+	void post(Render* r);
+
+private:
+
+	friend void update(const std::shared_ptr<Slot>& s, const Wave& w);
+
+	/* Shared with the render thread. 'wanted' is the pitch asked for, 0.0f for
+	none; 'busy' is true while a job for this slot is around. */
+
+	std::atomic<Render*> m_incoming;
+	std::atomic<float>   m_wanted;
+	std::atomic<bool>    m_busy;
+
+	/* Renders given back by the audio thread, to be freed by update(). */
+
+	Queue<Render*, 8> m_trash;
+
+	/* Audio thread only. 'next' and 'pos' link consecutive reads: where the 
+	previous one has stopped, in the original wave and in the render. */
+
+	Render* m_current;
+	float   m_pitch;
+	int     m_still;
+	int     m_next;
+	int     m_pos;
+
+	void retire_();
+};
+
+/* init
+Starts the thread that renders pitched waves. */
+
+void init();
+void close();
+
+/* update
+Starts rendering wave 'w' if slot 's' asks for it, and frees renders that are 
+no longer in use. Call it periodically from the thread that owns 'w' (see 
+gu_refreshUI). Streamed waves and renders larger than conf::streamThreshold are
+left out: those channels keep resampling on the fly. */
+
+void update(const std::shared_ptr<Slot>& s, const Wave& w);
+
+/* isBusy
+Tells whether some render is in progress. */
+
+bool isBusy();
+}}}; // giada::m::pitchCache::
+
+
+#endif
@@ -200,7 +200,7 @@ int Plugin::getEditorH() const { assert(ui != nullptr); return ui->getHeight();
 /* -------------------------------------------------------------------------- */
 
 
-void Plugin::process(juce::AudioBuffer<float>& b, juce::MidiBuffer m) const
+void Plugin::process(juce::AudioBuffer<float>& b, juce::MidiBuffer& m) const
 {
 	plugin->processBlock(b, m);
 }
@@ -59,13 +59,13 @@ public:
 	std::string getUniqueId() const;
 
 	/* process
-	Process the plug-in with audio and MIDI data. The audio buffer is a reference:
-	it has to be altered by the plug-in itself. Conversely, the MIDI buffer must
-	be passed by copy: each plug-in must receive its own copy of the event set, so
-	that any attempt to change/clear the MIDI buffer will only modify the local 
-	copy. */
+	Process the plug-in with audio and MIDI data. Both buffers are references and
+	both might be altered by the plug-in itself. Each plug-in must receive its own
+	copy of the MIDI event set, so that any attempt to change/clear the MIDI 
+	buffer will only modify that copy: pluginHost::processStack() takes care of 
+	it without allocating memory. */
 
-	void process(juce::AudioBuffer<float>& b, juce::MidiBuffer m) const;
+	void process(juce::AudioBuffer<float>& b, juce::MidiBuffer& m) const;
 
 	std::string getName() const;
 	bool isEditorOpen() const;
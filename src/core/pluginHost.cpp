@@ -29,12 +29,20 @@
 
 
 #include <cassert>
+#if defined(__SSE__)
+	#include <xmmintrin.h>
+#endif
 #include "../utils/log.h"
 #include "../utils/fs.h"
 #include "../utils/string.h"
 #include "const.h"
 #include "channel.h"
 #include "plugin.h"
+#include "workers.h"
+#include "mixer.h"
+#include "recorder.h"
+#include "envelope.h"
+#include "midiDispatcher.h"
 #include "pluginHost.h"
 
 
@@ -68,10 +76,28 @@ vector<string> unknownPluginList;
 vector<Plugin*> masterOut;
 vector<Plugin*> masterIn;
 
-/* Audio|MidiBuffer
- * Dynamic buffers. */
+/* Scratch
+Scratch buffers, allocated once in init(): processStack() runs on the audio 
+thread and must never touch the heap. 'instrumentBuffer' receives the output of
+each MIDI instrument, 'midiBuffer' the copy of the MIDI events each plug-in 
+works on. Channels might be rendered in parallel: one set for each render 
+thread, picked by workers::getIndex(). */
 
-juce::AudioBuffer<float> audioBuffer;
+struct Scratch
+{
+	juce::AudioBuffer<float> audioBuffer;
+	juce::AudioBuffer<float> instrumentBuffer;
+	juce::MidiBuffer         midiBuffer;
+};
+
+vector<Scratch> scratch;
+
+constexpr int MIDI_BUFFER_SIZE = 16384;  // in bytes
+
+/* MAX_SPLITS
+Most pieces a block can be split into by parameter automation. */
+
+constexpr int MAX_SPLITS = 32;
 
 int samplerate;
 int buffersize;
@@ -124,24 +150,228 @@ const juce::PluginDescription* findPluginDescription(const string& id)
 	}
 	return nullptr;
 }
-}; // {anonymous}
 
 
 /* -------------------------------------------------------------------------- */
+
+/* deinterleave_, interleave_
+Convert audio data between Giada's interleaved buffers and Juce's planar ones.
+Stereo, the only layout Giada deals with, gets a SIMD path. */
+
+void deinterleave_(const AudioBuffer& src, juce::AudioBuffer<float>& dest)
+{
+	const float* in = src[0];
+	int frames      = src.countFrames();
+	int channels    = src.countChannels();
+	int i = 0;
+
+	if (channels == 2) {
+		float* l = dest.getWritePointer(0);
+		float* r = dest.getWritePointer(1);
+#if defined(__SSE__)
+		for (; i + 4 <= frames; i += 4) {
+			__m128 a = _mm_loadu_ps(in + i*2);      // l0 r0 l1 r1
+			__m128 b = _mm_loadu_ps(in + i*2 + 4);  // l2 r2 l3 r3
+			_mm_storeu_ps(l + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(r + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+#endif
+		for (; i<frames; i++) {
+			l[i] = in[i*2];
+			r[i] = in[i*2 + 1];
+		}
+		return;
+	}
+
+	for (int j=0; j<channels; j++) {
+		float* out = dest.getWritePointer(j);
+		for (i=0; i<frames; i++)
+			out[i] = in[i*channels + j];
+	}
+}
+
+
+void interleave_(const juce::AudioBuffer<float>& src, AudioBuffer& dest)
+{
+	float* out   = dest[0];
+	int frames   = dest.countFrames();
+	int channels = dest.countChannels();
+	int i = 0;
+
+	if (channels == 2) {
+		const float* l = src.getReadPointer(0);
+		const float* r = src.getReadPointer(1);
+#if defined(__SSE__)
+		for (; i + 4 <= frames; i += 4) {
+			__m128 a = _mm_loadu_ps(l + i);
+			__m128 b = _mm_loadu_ps(r + i);
+			_mm_storeu_ps(out + i*2,     _mm_unpacklo_ps(a, b));  // l0 r0 l1 r1
+			_mm_storeu_ps(out + i*2 + 4, _mm_unpackhi_ps(a, b));  // l2 r2 l3 r3
+		}
+#endif
+		for (; i<frames; i++) {
+			out[i*2]     = l[i];
+			out[i*2 + 1] = r[i];
+		}
+		return;
+	}
+
+	for (int j=0; j<channels; j++) {
+		const float* in = src.getReadPointer(j);
+		for (i=0; i<frames; i++)
+			out[i*channels + j] = in[i];
+	}
+}
+
+
 /* -------------------------------------------------------------------------- */
+
+/* copyMidi_
+Fills the scratch MIDI buffer 'dest' with the events in 'src' that fall in 
+['start', 'start' + 'frames'), moved back by 'start'. Juce keeps the storage
+around on clear(), so this doesn't allocate as long as the events fit in 
+MIDI_BUFFER_SIZE. */
+
+juce::MidiBuffer& copyMidi_(const juce::MidiBuffer& src, juce::MidiBuffer& dest,
+	int start, int frames)
+{
+	dest.clear();
+	dest.addEvents(src, start, frames, -start);
+	return dest;
+}
+
+
 /* -------------------------------------------------------------------------- */
 
+/* split_
+Fills 'splits' with the local frames where the block must be cut for the
+automation of channel 'ch' to land on time: where the sequencer jumps and where
+an envelope has a breakpoint. Sorted, starting from 0. Returns how many, up to
+MAX_SPLITS: breakpoints past that land on the previous piece. */
 
-pthread_mutex_t mutex_midi;
+int split_(Channel* ch, int* splits)
+{
+	int count = 0;
+
+	auto add = [&] (int frame)
+	{
+		int i = count;
+		while (i > 0 && splits[i-1] > frame)
+			i--;
+		if ((i > 0 && splits[i-1] == frame) || count == MAX_SPLITS)
+			return;
+		for (int j=count; j>i; j--)
+			splits[j] = splits[j-1];
+		splits[i] = frame;
+		count++;
+	};
+
+	add(0);
+
+	const vector<mixer::Span>& spans = mixer::getSpans();
+	for (size_t i=0; i<spans.size(); i++) {
+		Frame end = i + 1 < spans.size() ? spans[i+1].frameLocal : buffersize;
+		add(spans[i].frameLocal);
+		for (unsigned k=0; k<ch->pluginEnvsCount.load(); k++) {
+			Envelope& e = ch->pluginEnvs[k];
+			if (e.isEmpty())
+				continue;
+			Frame local  = spans[i].frameLocal;
+			Frame global = spans[i].frameGlobal;
+			while (local < end) {
+				int frames = e.getRamp(global, end - local).frames;
+				local  += frames;
+				global += frames;
+				if (local < end)
+					add(local);
+			}
+		}
+	}
+	return count;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* applyEnvelopes_
+Sets the automated parameters of the plug-ins in 'stack' to the value their 
+envelopes have on local frame 'local'. */
+
+void applyEnvelopes_(Channel* ch, const vector<Plugin*>& stack, Frame local)
+{
+	const vector<mixer::Span>& spans = mixer::getSpans();
+	size_t i = 0;
+	while (i + 1 < spans.size() && spans[i+1].frameLocal <= local)
+		i++;
+	Frame global = spans[i].frameGlobal + (local - spans[i].frameLocal);
+
+	for (unsigned k=0; k<ch->pluginEnvsCount.load(); k++) {
+		Envelope& e = ch->pluginEnvs[k];
+		if (e.isEmpty())
+			continue;
+		int id    = getParamKeyPlugin(e.getIValue());
+		int param = getParamKeyParam(e.getIValue());
+		for (const Plugin* p : stack)
+			if (p->getId() == id && param < p->getNumParameters())
+				p->setParameter(param, e.getValue(global));
+	}
+}
 
 
 /* -------------------------------------------------------------------------- */
 
+/* processPlugins_
+Runs the plug-ins in 'stack' on 'frames' frames of the scratch buffers, from
+frame 'start'. Juce buffers referring to existing data don't allocate. */
+
+void processPlugins_(const vector<Plugin*>& stack, Channel* ch, Scratch& s, 
+	int start, int frames)
+{
+	juce::AudioBuffer<float> audioBuffer(s.audioBuffer.getArrayOfWritePointers(), 
+		s.audioBuffer.getNumChannels(), start, frames);
+	juce::AudioBuffer<float> instrumentBuffer(s.instrumentBuffer.getArrayOfWritePointers(), 
+		s.instrumentBuffer.getNumChannels(), 0, frames);
+
+	/* Hardcore processing. At the end we swap input and output, so that he N-th
+	plugin will process the result of the plugin N-1. No locking needed around
+	the channel MIDI buffer: incoming MIDI events are added by the audio thread 
+	too, at the top of the block (see command::processTimed()). */
+
+	for (const Plugin* plugin : stack) {
+		if (plugin->isSuspended() || plugin->isBypassed())
+			continue;
+
+		/* If this is a Channel (ch != nullptr) and the current plugin is an 
+		instrument (i.e. accepts MIDI), don't let it fill the current audio buffer: 
+		use the instrument buffer instead and then merge the result into the main
+		one when done. This way each plug-in generates its own audio data and we can
+		play more than one plug-in instrument in the same stack, driven by the same
+		set of MIDI events. */
+
+		if (ch != nullptr && plugin->acceptsMidi()) {
+			instrumentBuffer.clear();
+			plugin->process(instrumentBuffer, 
+				copyMidi_(ch->getPluginMidiEvents(), s.midiBuffer, start, frames));
+			for (int j=0; j<audioBuffer.getNumChannels(); j++)
+				audioBuffer.addFrom(j, 0, instrumentBuffer, j, 0, frames);
+		}
+		else {
+			s.midiBuffer.clear(); // Empty MIDI buffer
+			plugin->process(audioBuffer, s.midiBuffer);
+		}
+	}
+}
+}; // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 
 void close()
 {
 	messageManager->deleteInstance();
-	pthread_mutex_destroy(&mutex_midi);
 }
 
 
@@ -151,15 +381,18 @@ void close()
 void init(int buffersize_, int samplerate_)
 {
 	messageManager = juce::MessageManager::getInstance();
-	audioBuffer.setSize(G_MAX_IO_CHANS, buffersize_);
+	scratch.resize(workers::count());
+	for (Scratch& s : scratch) {
+		s.audioBuffer.setSize(G_MAX_IO_CHANS, buffersize_);
+		s.instrumentBuffer.setSize(G_MAX_IO_CHANS, buffersize_);
+		s.midiBuffer.ensureSize(MIDI_BUFFER_SIZE);
+	}
 	samplerate = samplerate_;
 	buffersize = buffersize_;
 	missingPlugins = false;
 	//unknownPluginList.empty();
 	loadList(gu_getHomePath() + G_SLASH + "plugins.xml");
 
-	pthread_mutex_init(&mutex_midi, nullptr);
-
 	gu_log("[pluginHost::init] initialized with buffersize=%d, samplerate=%d\n",
 	buffersize, samplerate);
 }
@@ -265,6 +498,7 @@ Plugin* addPlugin(const string& fid, int stackType, pthread_mutex_t* mutex,
 			continue;
 		pStack->push_back(p);
 		pthread_mutex_unlock(mutex);
+		midiDispatcher::invalidate();
 		break;
 	}
 
@@ -390,6 +624,7 @@ void freeStack(int stackType, pthread_mutex_t* mutex, Channel* ch)
 			delete pStack->at(i);
 		pStack->clear();
 		pthread_mutex_unlock(mutex);
+		midiDispatcher::invalidate();
 		break;
 	}
 	gu_log("[pluginHost::freeStack] stack type=%d freed\n", stackType);
@@ -399,6 +634,37 @@ void freeStack(int stackType, pthread_mutex_t* mutex, Channel* ch)
 /* -------------------------------------------------------------------------- */
 
 
+void updateEnvelopes(Channel* ch)
+{
+	unsigned version = recorder::getVersion();
+	if (version == ch->pluginEnvsVersion)
+		return;
+	ch->pluginEnvsVersion = version;
+
+	recorder::forEachAction([ch] (const recorder::action* a)
+	{
+		if (a->chan != ch->index || a->type != G_ACTION_PLUGIN)
+			return;
+		for (const Envelope& e : ch->pluginEnvs)
+			if (e.getIValue() == a->iValue)
+				return;
+		if (ch->pluginEnvs.size() == G_MAX_PLUGIN_ENVS) {
+			gu_log("[pluginHost::updateEnvelopes] too many automated parameters on channel %d!\n", 
+				ch->index);
+			return;
+		}
+		ch->pluginEnvs.emplace_back(G_ACTION_PLUGIN, a->iValue);
+	});
+
+	for (Envelope& e : ch->pluginEnvs)
+		e.compile(ch->index);
+	ch->pluginEnvsCount.store(ch->pluginEnvs.size());
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 void processStack(AudioBuffer& outBuf, int stackType, Channel* ch)
 {
 	vector<Plugin*>* pStack = getStack(stackType, ch);
@@ -408,6 +674,9 @@ void processStack(AudioBuffer& outBuf, int stackType, Channel* ch)
 	if (pStack == nullptr || pStack->size() == 0)
 		return;
 
+	Scratch& s = scratch[workers::getIndex()];
+	juce::AudioBuffer<float>& audioBuffer = s.audioBuffer;
+
 	assert(outBuf.countFrames() == audioBuffer.getNumSamples());
 
 	/* MIDI channels must not process the current buffer: give them an empty one. 
@@ -417,56 +686,38 @@ void processStack(AudioBuffer& outBuf, int stackType, Channel* ch)
 	if (ch != nullptr && ch->type == ChannelType::MIDI) 
 		audioBuffer.clear();
 	else
-		for (int i=0; i<outBuf.countFrames(); i++)
-			for (int j=0; j<outBuf.countChannels(); j++)
-				audioBuffer.setSample(j, i, outBuf[i][j]);
+		deinterleave_(outBuf, audioBuffer);
 
-	/* Hardcore processing. At the end we swap input and output, so that he N-th
-	plugin will process the result of the plugin N-1. Part of this loop must be
-	guarded by mutexes, i.e. the MIDI process part. You definitely don't want
-	a situation like the following one:
-		this::processStack()
-		[a new midi event comes in from kernelMidi thread]
-		channel::clearMidiBuffer()
-	The midi event in between would be surely lost, deleted by the last call to
-	channel::clearMidiBuffer()! */
-
-	if (ch != nullptr)
-		pthread_mutex_lock(&mutex_midi);
+	/* Split the block where parameter automation says so, if the sequencer is
+	running and the channel reads its actions. One piece otherwise. While the 
+	recorder is on, parameters are left to whoever is moving them live. */
 
-	for (const Plugin* plugin : *pStack) {
-		if (plugin->isSuspended() || plugin->isBypassed())
-			continue;
+	int splits[MAX_SPLITS + 1] = { 0 };
+	int count = 1;
+	bool automated = false;
 
-		/* If this is a Channel (ch != nullptr) and the current plugin is an 
-		instrument (i.e. accepts MIDI), don't let it fill the current audio buffer: 
-		create a new temporary one instead and then merge the result into the main
-		one when done. This way each plug-in generates its own audio data and we can
-		play more than one plug-in instrument in the same stack, driven by the same
-		set of MIDI events. */
+	if (ch != nullptr) {
+		for (unsigned k=0; k<ch->pluginEnvsCount.load(); k++)
+			ch->pluginEnvs[k].prepare();
+		automated = ch->readActions && !recorder::active && !mixer::getSpans().empty();
+		if (automated)
+			count = split_(ch, splits);
+	}
+	splits[count] = buffersize;
 
-		if (ch != nullptr && plugin->acceptsMidi()) {
-			juce::AudioBuffer<float> tmp(audioBuffer.getNumChannels(), buffersize);
-			plugin->process(tmp, ch->getPluginMidiEvents());
-			for (int i=0; i<audioBuffer.getNumSamples(); i++)
-				for (int j=0; j<audioBuffer.getNumChannels(); j++)
-					audioBuffer.addSample(j, i, tmp.getSample(j, i));	
-		}
-		else
-			plugin->process(audioBuffer, juce::MidiBuffer()); // Empty MIDI buffer
+	for (int i=0; i<count; i++) {
+		if (automated)
+			applyEnvelopes_(ch, *pStack, splits[i]);
+		processPlugins_(*pStack, ch, s, splits[i], splits[i+1] - splits[i]);
 	}
 
-	if (ch != nullptr) {
+	if (ch != nullptr)
 		ch->clearMidiBuffer();
-		pthread_mutex_unlock(&mutex_midi);
-	}
 
 	/* Converting buffer from Juce to Giada. A note for the future: if we 
 	overwrite (=) (as we do now) it's SEND, if we add (+) it's INSERT. */
 
-	for (int i=0; i<outBuf.countFrames(); i++)
-		for (int j=0; j<outBuf.countChannels(); j++)	
-			outBuf[i][j] = audioBuffer.getSample(j, i);
+	interleave_(audioBuffer, outBuf);
 }
 
 
@@ -531,6 +782,7 @@ int freePlugin(int id, int stackType, pthread_mutex_t* mutex, Channel* ch)
 			delete pPlugin;
 			pStack->erase(pStack->begin() + i);
 			pthread_mutex_unlock(mutex);
+			midiDispatcher::invalidate();
 			gu_log("[pluginHost::freePlugin] plugin id=%d removed\n", id);
 			return i;
 		}
@@ -627,6 +879,27 @@ void forEachPlugin(int stackType, const Channel* ch, std::function<void(const Pl
 }
 
 
+/* -------------------------------------------------------------------------- */
+
+
+uint32_t makeParamKey(int pluginId, int paramIndex)
+{
+	return (static_cast<uint32_t>(pluginId) << 16) | (paramIndex & 0xFFFF);
+}
+
+
+int getParamKeyPlugin(uint32_t key)
+{
+	return key >> 16;
+}
+
+
+int getParamKeyParam(uint32_t key)
+{
+	return key & 0xFFFF;
+}
+
+
 }}}; // giada::m::pluginHost::
 
 
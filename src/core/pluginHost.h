@@ -31,6 +31,7 @@
 #define G_PLUGIN_HOST_H
 
 
+#include <cstdint>
 #include <functional>
 #include <pthread.h>
 #include "../deps/juce-config.h"
@@ -70,8 +71,6 @@ struct PluginInfo
 	bool isInstrument;
 };
 
-extern pthread_mutex_t mutex_midi;
-
 void init(int bufSize, int samplerate);
 void close();
 
@@ -131,8 +130,18 @@ std::string getUnknownPluginInfo(int index);
 
 void freeStack(int stackType, pthread_mutex_t* mutex, Channel* ch=nullptr);
 
+/* updateEnvelopes
+Keeps the plug-in parameter envelopes of channel 'ch' in sync with the recorded
+actions: one for each parameter ever automated, up to G_MAX_PLUGIN_ENVS. 
+Envelopes are emptied, never removed. One non-audio thread only. */
+
+void updateEnvelopes(Channel* ch);
+
 /* processStack
-Applies the fx list to the buffer. */
+Applies the fx list to the buffer. On a channel stack, while the sequencer runs,
+recorded parameter automation is applied too: the block is split where the 
+envelopes have a breakpoint and parameters are set at the beginning of each 
+piece. */
 
 void processStack(AudioBuffer& outBuf, int stackType, Channel* ch=nullptr);
 
@@ -185,6 +194,16 @@ void sortPlugins(int sortMethod);
 
 void forEachPlugin(int stackType, const Channel* ch, std::function<void(const Plugin* p)> f);
 
+/* makeParamKey, getParamKeyPlugin, getParamKeyParam
+Plug-in parameter actions (G_ACTION_PLUGIN) keep in their iValue which 
+parameter they automate: the plug-in id in the upper 16 bits, the parameter 
+index in the lower ones. Ids change from one session to the next: patches store
+the position of the plug-in in the channel stack, plus one, instead. */
+
+uint32_t makeParamKey(int pluginId, int paramIndex);
+int getParamKeyPlugin(uint32_t key);
+int getParamKeyParam(uint32_t key);
+
 }}}; // giada::m::pluginHost::
 
 
@@ -0,0 +1,104 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+#ifndef G_QUEUE_H
+#define G_QUEUE_H
+
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+
+namespace giada {
+namespace m 
+{
+/* Queue
+Single-producer, single-consumer lock-free ring buffer of fixed capacity. One
+thread pushes, another one pops: neither of them ever blocks or allocates. 
+'size' must be a power of two; the queue holds up to 'size' - 1 items. */
+
+template<typename T, std::size_t size>
+class Queue
+{
+	static_assert(size >= 2 && (size & (size - 1)) == 0, "Queue size must be a power of two");
+
+public:
+
+	Queue() : m_head(0), m_tail(0) {}
+
+	Queue(const Queue&) = delete;
+	Queue& operator=(const Queue&) = delete;
+
+	/* push
+	Producer side. Returns false if the queue is full: the item is discarded. */
+
+	bool push(const T& item)
+	{
+		std::size_t head = m_head.load(std::memory_order_relaxed);
+		std::size_t next = (head + 1) & (size - 1);
+		if (next == m_tail.load(std::memory_order_acquire))
+			return false;
+		m_data[head] = item;
+		m_head.store(next, std::memory_order_release);
+		return true;
+	}
+
+	/* pop
+	Consumer side. Returns false if there is nothing to read. */
+
+	bool pop(T& item)
+	{
+		std::size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail == m_head.load(std::memory_order_acquire))
+			return false;
+		item = m_data[tail];
+		m_tail.store((tail + 1) & (size - 1), std::memory_order_release);
+		return true;
+	}
+
+	bool isEmpty() const
+	{
+		return m_head.load(std::memory_order_acquire) == 
+		       m_tail.load(std::memory_order_acquire);
+	}
+
+private:
+
+	std::array<T, size> m_data;
+
+	/* m_head, m_tail
+	Next slot to write (owned by the producer) and next slot to read (owned by
+	the consumer). */
+
+	std::atomic<std::size_t> m_head;
+	std::atomic<std::size_t> m_tail;
+};
+}} // giada::m::
+
+
+#endif
@@ -27,8 +27,13 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 #include "../utils/log.h"
 #include "const.h"
+#include "queue.h"
 #include "sampleChannel.h"
 #include "recorder.h"
 
@@ -42,6 +47,72 @@ namespace recorder
 {
 namespace
 {
+/* timeline, mutex
+All recorded actions, sorted by tick. Actions on the same tick are stored in 
+recording order. Stored by value: lookups walk a contiguous block of memory. 
+This is the master copy, edited and read by non-audio threads under the mutex.
+Recursive: forEachAction() callbacks look the timeline up again. */
+
+vector<action>       timeline;
+std::recursive_mutex mutex;
+
+using Lock_ = std::lock_guard<std::recursive_mutex>;
+
+/* dirty
+Whether the timeline has changed since update() last published it. */
+
+bool dirty = false;
+
+/* incoming, current, trash
+The audio thread reads its own copy of the timeline. update() publishes a new
+one in 'incoming', beginBlock() picks it up as 'current' and gives the old one
+back through 'trash': the audio thread never allocates nor frees memory, nor 
+waits for the mutex. */
+
+std::atomic<vector<action>*> incoming(nullptr);
+vector<action>*              current = nullptr;
+Queue<vector<action>*, 8>    trash;
+
+/* cursor
+Index of the first action in 'current' on or after the last frame requested by
+getActionsInRange(). Consecutive lookups on ascending frames just move it 
+forward. Audio thread only. */
+
+size_t cursor = 0;
+
+/* rendering
+True on the audio thread between beginBlock() and endBlock(). */
+
+thread_local bool rendering = false;
+
+/* Edit_, edits, dropped
+Edits made by the audio thread, applied to the timeline later on by update().
+Those that don't fit in the queue are dropped and counted. */
+
+enum class EditType_ { REC, REC_ENVELOPE, START_OVERDUB, STOP_OVERDUB };
+
+struct Edit_
+{
+	EditType_ type;
+	action    a;
+	int       iArg;  // REC_ENVELOPE: last frame, START_OVERDUB: buffer size, STOP_OVERDUB: total frames
+	float     fArg;  // REC_ENVELOPE: value on the boundaries
+};
+
+Queue<Edit_, 1024>    edits;
+std::atomic<unsigned> dropped(0);
+
+/* framesInBeat
+Current length of a beat in frames (see setFramesInBeat()). Ticks are turned
+into frames and back with it. */
+
+std::atomic<int> framesInBeat(static_cast<int>(G_DEFAULT_SAMPLERATE * 60 / G_DEFAULT_BPM));
+
+/* version
+Bumped on each change to the timeline or to the tempo, see getVersion(). */
+
+std::atomic<unsigned> version(1);
+
 /* Composite
 A group of two actions (keypress+keyrel, muteon+muteoff) used during the overdub 
 process. */
@@ -52,374 +123,416 @@ Composite cmp;
 /* -------------------------------------------------------------------------- */
 
 
-/* fixOverdubTruncation
-Fixes underlying action truncation when overdubbing over a longer action. I.e.:
-	Original:    |#############|
-	Overdub:     ---|#######|---
-	fix:         |#||#######|--- */
+/* toTick_, toFrame_
+Conversions between frames and ticks at the current tempo. toTick_ rounds up, 
+toFrame_ down: a tick belongs to the frame it falls in, and the first tick of a
+frame converts back to that very frame, with no drift. */
 
-void fixOverdubTruncation(const Composite& comp, pthread_mutex_t* mixerMutex)
+int toTick_(int frame)
 {
-	action* next = nullptr;
-	int res = getNextAction(comp.a2.chan, comp.a1.type | comp.a2.type, comp.a2.frame,
-		&next);
-	if (res != 1 || next->type != comp.a2.type)
-		return;
-	gu_log("[recorder::fixOverdubTruncation] add truncation at frame %d, type=%d\n",
-		next->frame, next->type);
-	deleteAction(next->chan, next->frame, next->type, false, mixerMutex);
+	int64_t fpb = framesInBeat.load();
+	return static_cast<int>((frame * static_cast<int64_t>(TICKS_PER_BEAT) + fpb - 1) / fpb);
 }
 
-}; // {anonymous}
+
+int toFrame_(int tick)
+{
+	return static_cast<int>(tick * static_cast<int64_t>(framesInBeat.load()) / TICKS_PER_BEAT);
+}
 
 
-/* -------------------------------------------------------------------------- */
-/* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
 
-vector<int> frames;
-vector<vector<action*>> global;
-vector<action*> actions;     // used internally
+bool compareTick_(const action& a, int tick) { return a.tick < tick; }
 
-bool active = false;
-bool sortedActions = false;
+
+/* lowerBound_, upperBound_
+Index of the first action in 'v' on frame >= 'frame' (lowerBound_) or > 'frame'
+(upperBound_). */
+
+size_t lowerBound_(int frame, const vector<action>& v=timeline)
+{
+	return std::lower_bound(v.begin(), v.end(), toTick_(frame), compareTick_) - 
+		v.begin();
+}
+
+
+size_t upperBound_(int frame)
+{
+	return lowerBound_(frame + 1);
+}
+
+
+/* stamp_
+Fills in the frame of an action on its way out of the recorder. Only the audio
+thread stamps in place, on its own copy (see getActionsInRange()): everybody 
+else stamps a copy. */
+
+action& stamp_(action& a)
+{
+	a.frame = toFrame_(a.tick);
+	return a;
+}
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void init()
+bool isEqual_(const action& a, const action& b)
 {
-	active = false;
-	sortedActions = false;
-	clearAll();
+	return a.chan   == b.chan   && 
+	       a.type   == b.type   && 
+	       a.tick   == b.tick   && 
+	       a.iValue == b.iValue && 
+	       a.fValue == b.fValue;
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-bool canRec(Channel* ch, bool clockRunning, bool mixerRecording)
+/* touch_
+Marks the timeline as changed. */
+
+void touch_()
 {
-	/* Can record on a channel if:
-		- recorder is on
-		- mixer is running
-		- mixer is not recording a take somewhere
-		- channel is MIDI or SAMPLE type with data in it  */
-	return active && clockRunning && !mixerRecording && 
-	       (ch->type == ChannelType::MIDI || (ch->type == ChannelType::SAMPLE && ch->hasData()));
+	version++;
+	dirty = true;
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void rec(int index, int type, int frame, uint32_t iValue, float fValue)
+action make_(int chan, int type, int frame, uint32_t iValue, float fValue)
 {
-	/* allocating the action */
+	action a;
+	a.chan   = chan;
+	a.type   = type;
+	a.tick   = toTick_(frame);
+	a.frame  = frame;
+	a.iValue = iValue;
+	a.fValue = fValue;
+	return a;
+}
+
 
-	action* a = (action*) malloc(sizeof(action)); /* TODO - AAARRRGGHHHHHH!!!! */
-	a->chan   = index;
-	a->type   = type;
-	a->frame  = frame;
-	a->iValue = iValue;
-	a->fValue = fValue;
+/* -------------------------------------------------------------------------- */
 
-	/* check if the frame exists in the stack. If it exists, we don't extend
-	 * the stack, but we add (or push) a new action to it. */
 
-	int frameToExpand = frames.size();
-	for (int i=0; i<frameToExpand; i++)
-		if (frames.at(i) == frame) {
-			frameToExpand = i;
-			break;
-		}
+/* insert_
+Adds action 'a' to the timeline, after the existing ones on the same tick. */
 
-	/* espansione dello stack frames nel caso l'azione ricada in frame
-	 * non precedentemente memorizzati (frameToExpand == frames.size()).
-	 * Espandere frames è facile, basta aggiungere un frame in coda.
-	 * Espandere global è più complesso: bisogna prima allocare una
-	 * cella in global (per renderlo parallelo a frames) e poi
-	 * inizializzare il suo sub-stack (di action). */
-
-	if (frameToExpand == (int) frames.size()) {
-		frames.push_back(frame);
-		global.push_back(actions);               // array of actions added
-		global.at(global.size()-1).push_back(a); // action added
-	}
-	else {
-
-		/* no duplicates, please */
-
-		for (unsigned t=0; t<global.at(frameToExpand).size(); t++) {
-			action* ac = global.at(frameToExpand).at(t);
-			if (ac->chan   == index  &&
-					ac->type   == type   &&
-					ac->frame  == frame  &&
-					ac->iValue == iValue &&
-					ac->fValue == fValue)
-				return;
-		}
+void insert_(const action& a)
+{
+	/* No duplicates, please. Only actions on the same tick can be equal, so 
+	just look at those. */
 
-		global.at(frameToExpand).push_back(a);		// expand array
-	}
+	size_t last = std::lower_bound(timeline.begin(), timeline.end(), a.tick, 
+		compareTick_) - timeline.begin();
+	for (; last<timeline.size() && timeline[last].tick == a.tick; last++)
+		if (isEqual_(timeline[last], a))
+			return;
 
-	sortedActions = false;
+	timeline.insert(timeline.begin() + last, a);
+	touch_();
 
 	gu_log("[recorder::rec] action recorded, type=%d frame=%d chan=%d iValue=%d (0x%X) fValue=%f\n",
-		a->type, a->frame, a->chan, a->iValue, a->iValue, a->fValue);
-	//print();
+		a.type, a.frame, a.chan, a.iValue, a.iValue, a.fValue);
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void clearChan(int index)
-{
-	gu_log("[recorder::clearChan] clearing chan %d...\n", index);
+/* recEnvelope_
+Body of recEnvelope(), on an action already converted to ticks. */
 
-	for (unsigned i=0; i<global.size(); i++) {	// for each frame i
-		unsigned j=0;
-		while (true) {
-			if (j == global.at(i).size()) break; 	  // for each action j of frame i
-			action* a = global.at(i).at(j);
-			if (a->chan == index)	{
-				free(a);
-				global.at(i).erase(global.at(i).begin() + j);
-			}
-			else
-				j++;
-		}
+void recEnvelope_(const action& a, int lastFrame, float bValue)
+{
+	if (!hasActions(a.chan, a.type, a.iValue)) {
+		insert_(make_(a.chan, a.type, 0, a.iValue, bValue));
+		insert_(make_(a.chan, a.type, lastFrame, a.iValue, bValue));
 	}
-	optimize();
-	//print();
+	insert_(a);
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void clearAction(int index, char act)
+/* push_
+Hands an edit made by the audio thread over to update(). */
+
+void push_(EditType_ type, const action& a, int iArg=0, float fArg=0.0f)
 {
-	gu_log("[recorder::clearAction] clearing action %d from chan %d...\n", act, index);
-	for (unsigned i=0; i<global.size(); i++) {						// for each frame i
-		unsigned j=0;
-		while (true) {                                   // for each action j of frame i
-			if (j == global.at(i).size())
-				break;
-			action* a = global.at(i).at(j);
-			if (a->chan == index && (act & a->type) == a->type)	{ // bitmask
-				free(a);
-				global.at(i).erase(global.at(i).begin() + j);
-			}
-			else
-				j++;
-		}
-	}
-	optimize();
-	//print();
+	if (!edits.push(Edit_{ type, a, iArg, fArg }))
+		dropped++;
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void deleteAction(int chan, int frame, char type, bool checkValues,
-	pthread_mutex_t* mixerMutex, uint32_t iValue, float fValue)
+/* removeIf_
+Removes all actions that satisfy predicate 'f'. Order is preserved. */
+
+void removeIf_(std::function<bool(const action&)> f)
 {
-	/* find the frame 'frame' */
+	timeline.erase(std::remove_if(timeline.begin(), timeline.end(), f), 
+		timeline.end());
+	touch_();
+}
 
-	bool found = false;
-	for (unsigned i=0; i<frames.size() && !found; i++) {
 
-		if (frames.at(i) != frame)
-			continue;
+/* -------------------------------------------------------------------------- */
 
-			/* find the action in frame i */
 
-		for (unsigned j=0; j<global.at(i).size(); j++) {
-			action* a = global.at(i).at(j);
+/* sortAndCompact_
+Restores the timeline order after a bulk insertion, then drops any duplicate 
+that it might have produced. */
 
-			/* action comparison logic */
+void sortAndCompact_()
+{
+	std::stable_sort(timeline.begin(), timeline.end(), 
+		[] (const action& a, const action& b) { return a.tick < b.tick; });
+
+	size_t out = 0;
+	size_t run = 0;  // first action of the current tick group in the output
+	for (size_t i=0; i<timeline.size(); i++) {
+		if (out > 0 && timeline[out-1].tick != timeline[i].tick)
+			run = out;
+		bool duplicate = false;
+		for (size_t j=run; j<out && !duplicate; j++)
+			duplicate = isEqual_(timeline[j], timeline[i]);
+		if (!duplicate)
+			timeline[out++] = timeline[i];
+	}
+	timeline.resize(out);
+	touch_();
+}
 
-			bool doit = (a->chan == chan && a->type == (type & a->type));
-			if (checkValues)
-				doit &= (a->iValue == iValue && a->fValue == fValue);
 
-			if (!doit)
-				continue;
+/* -------------------------------------------------------------------------- */
 
-			while (true) {
-				if (pthread_mutex_trylock(mixerMutex)) {
-					free(a);
-					global.at(i).erase(global.at(i).begin() + j);
-					pthread_mutex_unlock(mixerMutex);
-					found = true;
-					break;
-				}
-				else
-					gu_log("[recorder::deleteAction] waiting for mutex...\n");
-			}
-		}
-	}
-	if (found) {
-		optimize();
-		gu_log("[recorder::deleteAction] action deleted, type=%d frame=%d chan=%d iValue=%d (%X) fValue=%f\n",
-			type, frame, chan, iValue, iValue, fValue);
-	}
-	else
-		gu_log("[recorder::deleteAction] unable to delete action, not found! type=%d frame=%d chan=%d iValue=%d (%X) fValue=%f\n",
-			type, frame, chan, iValue, iValue, fValue);
+
+/* fixOverdubTruncation
+Fixes underlying action truncation when overdubbing over a longer action. I.e.:
+	Original:    |#############|
+	Overdub:     ---|#######|---
+	fix:         |#||#######|--- */
+
+void fixOverdubTruncation(const Composite& comp)
+{
+	action next;
+	int res = getNextAction(comp.a2.chan, comp.a1.type | comp.a2.type, comp.a2.frame,
+		&next);
+	if (res != 1 || next.type != comp.a2.type)
+		return;
+	gu_log("[recorder::fixOverdubTruncation] add truncation at frame %d, type=%d\n",
+		next.frame, next.type);
+	deleteAction(next.chan, next.frame, next.type, false);
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void deleteActions(int chan, int frame_a, int frame_b, char type,
-	pthread_mutex_t* mixerMutex)
+void apply_(const Edit_& e)
 {
-	sortActions();
-	vector<int> dels;
+	switch (e.type) {
+		case EditType_::REC:
+			insert_(e.a);
+			break;
+		case EditType_::REC_ENVELOPE:
+			recEnvelope_(e.a, e.iArg, e.fArg);
+			break;
+		case EditType_::START_OVERDUB:
+			startOverdub(e.a.chan, e.a.type, e.a.frame, e.iArg);
+			break;
+		case EditType_::STOP_OVERDUB:
+			stopOverdub(e.a.frame, e.iArg);
+			break;
+	}
+}
+}; // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
 
-	for (unsigned i=0; i<frames.size(); i++)
-		if (frames.at(i) > frame_a && frames.at(i) < frame_b)
-			dels.push_back(frames.at(i));
 
-	for (unsigned i=0; i<dels.size(); i++)
-		deleteAction(chan, dels.at(i), type, false, mixerMutex); // false == don't check values
+bool active = false;
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void init()
+{
+	active = false;
+	clearAll();
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void clearAll()
+bool canRec(Channel* ch, bool clockRunning, bool mixerRecording)
 {
-	while (global.size() > 0) {
-		for (unsigned i=0; i<global.size(); i++) {
-			for (unsigned k=0; k<global.at(i).size(); k++)
-				free(global.at(i).at(k));									// free action
-			global.at(i).clear();												// free action container
-			global.erase(global.begin() + i);
-		}
-	}
-	global.clear();
-	frames.clear();
+	/* Can record on a channel if:
+		- recorder is on
+		- mixer is running
+		- mixer is not recording a take somewhere
+		- channel is MIDI or SAMPLE type with data in it  */
+	return active && clockRunning && !mixerRecording && 
+	       (ch->type == ChannelType::MIDI || (ch->type == ChannelType::SAMPLE && ch->hasData()));
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void optimize()
+void rec(int index, int type, int frame, uint32_t iValue, float fValue)
 {
-	/* do something until the i frame is empty. */
+	/* Frames to ticks right away: the tempo might change before update() gets
+	to an edit from the audio thread. */
 
-	unsigned i = 0;
-	while (true) {
-		if (i == global.size()) return;
-		if (global.at(i).size() == 0) {
-			global.erase(global.begin() + i);
-			frames.erase(frames.begin() + i);
-		}
-		else
-			i++;
+	action a = make_(index, type, frame, iValue, fValue);
+	if (rendering) {
+		push_(EditType_::REC, a);
+		return;
 	}
-
-	sortActions();
+	Lock_ lock(mutex);
+	insert_(a);
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void sortActions()
+void recEnvelope(int chan, int type, int frame, int lastFrame, uint32_t iValue, 
+	float fValue, float bValue)
 {
-	if (sortedActions)
+	action a = make_(chan, type, frame, iValue, fValue);
+	if (rendering) {
+		push_(EditType_::REC_ENVELOPE, a, lastFrame, bValue);
 		return;
-	for (unsigned i=0; i<frames.size(); i++)
-		for (unsigned j=0; j<frames.size(); j++)
-			if (frames.at(j) > frames.at(i)) {
-				std::swap(frames.at(j), frames.at(i));
-				std::swap(global.at(j), global.at(i));
-			}
-	sortedActions = true;
-	//print();
+	}
+	Lock_ lock(mutex);
+	recEnvelope_(a, lastFrame, bValue);
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void updateBpm(float oldval, float newval, int oldquanto)
+void clearChan(int index)
 {
-	for (unsigned i=0; i<frames.size(); i++) {
+	gu_log("[recorder::clearChan] clearing chan %d...\n", index);
 
-		float frame  = ((float) frames.at(i)/newval) * oldval;
-		frames.at(i) = (int) frame;
+	Lock_ lock(mutex);
+	removeIf_([=] (const action& a) { return a.chan == index; });
+}
 
-		/* the division up here cannot be precise. A new frame can be 44099
-		 * and the quantizer set to 44100. That would mean two recs completely
-		 * useless. So we compute a reject value ('scarto'): if it's lower
-		 * than 6 frames the new frame is collapsed with a quantized frame. */
-		/** XXX - maybe 6 frames are too low */
 
-		if (frames.at(i) != 0) {
-			int scarto = oldquanto % frames.at(i);
-			if (scarto > 0 && scarto <= 6)
-				frames.at(i) = frames.at(i) + scarto;
-		}
-	}
+/* -------------------------------------------------------------------------- */
 
-	/* update structs */
 
-	for (unsigned i=0; i<frames.size(); i++) {
-		for (unsigned j=0; j<global.at(i).size(); j++) {
-			action* a = global.at(i).at(j);
-			a->frame = frames.at(i);
-		}
-	}
+void clearAction(int index, char act, uint32_t iValue)
+{
+	gu_log("[recorder::clearAction] clearing action %d from chan %d...\n", act, index);
 
-	//print();
+	Lock_ lock(mutex);
+	removeIf_([=] (const action& a) 
+	{ 
+		return a.chan == index && (act & a.type) == a.type &&  // bitmask
+		       (iValue == 0 || a.iValue == iValue);
+	});
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void updateSamplerate(int systemRate, int patchRate)
+void deleteAction(int chan, int frame, char type, bool checkValues,
+	uint32_t iValue, float fValue)
 {
-	/* diff ratio: systemRate / patchRate
-	 * e.g.  44100 / 96000 = 0.4... */
+	Lock_ lock(mutex);
 
-	if (systemRate == patchRate)
-		return;
+	/* Find the action among those on frame 'frame'. */
 
-	gu_log("[recorder::updateSamplerate] systemRate (%d) != patchRate (%d), converting...\n", systemRate, patchRate);
+	size_t last = upperBound_(frame);
+	for (size_t i=lowerBound_(frame); i<last; i++) {
+		
+		const action& a = timeline[i];
 
-	float ratio = systemRate / (float) patchRate;
-	for (unsigned i=0; i<frames.size(); i++) {
+		/* action comparison logic */
 
-		gu_log("[recorder::updateSamplerate]    oldFrame = %d", frames.at(i));
+		bool doit = (a.chan == chan && a.type == (type & a.type));
+		if (checkValues)
+			doit &= (a.iValue == iValue && a.fValue == fValue);
 
-		float newFrame = frames.at(i);
-		newFrame = floorf(newFrame * ratio);
+		if (!doit)
+			continue;
 
-		frames.at(i) = (int) newFrame;
+		timeline.erase(timeline.begin() + i);
+		touch_();
 
-		gu_log(", newFrame = %d\n", frames.at(i));
+		gu_log("[recorder::deleteAction] action deleted, type=%d frame=%d chan=%d iValue=%d (%X) fValue=%f\n",
+			type, frame, chan, iValue, iValue, fValue);
+		return;
 	}
+	gu_log("[recorder::deleteAction] unable to delete action, not found! type=%d frame=%d chan=%d iValue=%d (%X) fValue=%f\n",
+		type, frame, chan, iValue, iValue, fValue);
+}
 
-	/* update structs */
 
-	for (unsigned i=0; i<frames.size(); i++) {
-		for (unsigned j=0; j<global.at(i).size(); j++) {
-			action* a = global.at(i).at(j);
-			a->frame = frames.at(i);
-		}
+/* -------------------------------------------------------------------------- */
+
+
+void deleteActions(int chan, int frame_a, int frame_b, char type)
+{
+	if (frame_b - frame_a < 2)  // exclusive range: nothing in between
+		return;
+
+	Lock_ lock(mutex);
+	auto first = timeline.begin() + upperBound_(frame_a);
+	auto last  = timeline.begin() + lowerBound_(frame_b);
+
+	timeline.erase(std::remove_if(first, last, [=] (const action& a)
+	{
+		return a.chan == chan && a.type == (type & a.type);
+	}), last);
+	touch_();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void clearAll()
+{
+	Lock_ lock(mutex);
+	timeline.clear();
+	touch_();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void setFramesInBeat(int frames)
+{
+	/* Ticks don't depend on the tempo: there's nothing to publish, lookups just
+	convert them differently from now on. It might come from the audio thread, 
+	e.g. on Jack tempo changes. */
+
+	if (frames > 0 && frames != framesInBeat.load()) {
+		framesInBeat.store(frames);
+		version++;
 	}
 }
 
@@ -427,31 +540,33 @@ void updateSamplerate(int systemRate, int patchRate)
 /* -------------------------------------------------------------------------- */
 
 
-void expand(int old_fpb, int new_fpb)
+void expand(int oldBeats, int newBeats)
 {
 	/* this algorithm requires multiple passages if we expand from e.g. 2
 	 * to 16 beats, precisely 16 / 2 - 1 = 7 times (-1 is the first group,
 	 * which exists yet). If we expand by a non-multiple, the result is zero,
 	 * due to float->int implicit cast */
 
-	unsigned pass = (int) (new_fpb / old_fpb) - 1;
+	unsigned pass = (int) (newBeats / oldBeats) - 1;
 	if (pass == 0) pass = 1;
 
-	unsigned init_fs = frames.size();
+	Lock_ lock(mutex);
+
+	/* Append copies of the existing actions, then sort everything in one go. 
+	Ticks don't depend on the tempo: a copy is just an offset away. */
 
+	size_t count = timeline.size();
+	timeline.reserve(count * (pass + 1));
 	for (unsigned z=1; z<=pass; z++) {
-		for (unsigned i=0; i<init_fs; i++) {
-			unsigned newframe = frames.at(i) + (old_fpb*z);
-			frames.push_back(newframe);
-			global.push_back(actions);
-			for (unsigned k=0; k<global.at(i).size(); k++) {
-				action* a = global.at(i).at(k);
-				rec(a->chan, a->type, newframe, a->iValue, a->fValue);
-			}
+		for (size_t i=0; i<count; i++) {
+			action a = timeline[i];
+			a.tick += oldBeats * TICKS_PER_BEAT * z;
+			timeline.push_back(a);
 		}
 	}
+	sortAndCompact_();
+
 	gu_log("[recorder::expand] expanded recs\n");
-	//print();
 }
 
 
@@ -462,40 +577,23 @@ void shrink(int new_fpb)
 {
 	/* easier than expand(): here we delete eveything beyond old_framesPerBars. */
 
-	unsigned i=0;
-	while (true) {
-		if (i == frames.size()) break;
-
-		if (frames.at(i) >= new_fpb) {
-			for (unsigned k=0; k<global.at(i).size(); k++)
-				free(global.at(i).at(k));		      // free action
-			global.at(i).clear();								// free action container
-			global.erase(global.begin() + i);   // shrink global
-			frames.erase(frames.begin() + i);   // shrink frames
-		}
-		else
-			i++;
-	}
-	optimize();
+	Lock_ lock(mutex);
+	timeline.erase(timeline.begin() + lowerBound_(new_fpb), timeline.end());
+	touch_();
 	gu_log("[recorder::shrink] shrinked recs\n");
-	//print();
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-bool hasActions(int chanIndex, int type)
+bool hasActions(int chanIndex, int type, uint32_t iValue)
 {
-	if (global.size() == 0)
-		return false;
-	for (unsigned i=0; i<global.size(); i++) {
-		for (unsigned j=0; j<global.at(i).size(); j++) {
-			if (global.at(i).at(j)->chan == chanIndex)
-				if (type == -1 || global.at(i).at(j)->type == type)
-					return true;
-		}
-	}
+	Lock_ lock(mutex);
+	for (const action& a : timeline)
+		if (a.chan == chanIndex && (type == -1 || a.type == type) && 
+		    (iValue == 0 || a.iValue == iValue))
+			return true;
 	return false;
 }
 
@@ -503,42 +601,34 @@ bool hasActions(int chanIndex, int type)
 /* -------------------------------------------------------------------------- */
 
 
-int getNextAction(int chan, char type, int fromFrame, action** out, 
+int getNextAction(int chan, char type, int fromFrame, action* out, 
 	uint32_t iValue, uint32_t mask)
 {
-	sortActions();  // mandatory
-
-	/* Increase 'i' until it reaches 'fromFrame'. That's the point where to start
-	to look for the next action. */
-
-	unsigned i = 0;
-	while (i < frames.size() && frames.at(i) <= fromFrame) i++;
+	/* Start looking right after 'fromFrame'. No actions past 'fromFrame': there 
+	are no more actions to look for. Return -1. */
 
-	/* No other actions past 'fromFrame': there are no more actions to look for.
-	Return -1. */
-
-	if (i == frames.size())
+	Lock_ lock(mutex);
+	size_t i = upperBound_(fromFrame);
+	if (i == timeline.size())
 		return -1;
 
-	for (; i<global.size(); i++) {
-
-		for (unsigned j=0; j<global.at(i).size(); j++) {
+	for (; i<timeline.size(); i++) {
 
-			action* a = global.at(i).at(j);
+		const action& a = timeline[i];
 
-			/* If the requested channel and type don't match, continue. */
+		/* If the requested channel and type don't match, continue. */
 
-			if (a->chan != chan || (type & a->type) != a->type) 
-				continue;
+		if (a.chan != chan || (type & a.type) != a.type) 
+			continue;
 
-			/* If no iValue has been specified (iValue == 0), then the next action has 
-			been found, return it. Otherwise, make sure the iValue matches the 
-			action's iValue, according to the mask provided. */
+		/* If no iValue has been specified (iValue == 0), then the next action has 
+		been found, return it. Otherwise, make sure the iValue matches the 
+		action's iValue, according to the mask provided. */
 
-			if (iValue == 0 || (iValue != 0 && (a->iValue | mask) == (iValue | mask))) {
-				*out = global.at(i).at(j);
-				return 1;
-			}
+		if (iValue == 0 || (iValue != 0 && (a.iValue | mask) == (iValue | mask))) {
+			*out = a;
+			stamp_(*out);
+			return 1;
 		}
 	}
 	return -2;   // no 'type' actions found
@@ -548,17 +638,16 @@ int getNextAction(int chan, char type, int fromFrame, action** out,
 /* -------------------------------------------------------------------------- */
 
 
-int getAction(int chan, char action, int frame, struct action** out)
+int getAction(int chan, char type, int frame, struct action* out)
 {
-	for (unsigned i=0; i<global.size(); i++)
-		for (unsigned j=0; j<global.at(i).size(); j++)
-			if (frame  == global.at(i).at(j)->frame &&
-					action == global.at(i).at(j)->type &&
-					chan   == global.at(i).at(j)->chan)
-			{
-				*out = global.at(i).at(j);
-				return 1;
-			}
+	Lock_ lock(mutex);
+	size_t last = upperBound_(frame);
+	for (size_t i=lowerBound_(frame); i<last; i++)
+		if (timeline[i].type == type && timeline[i].chan == chan) {
+			*out = timeline[i];
+			stamp_(*out);
+			return 1;
+		}
 	return 0;
 }
 
@@ -568,6 +657,13 @@ int getAction(int chan, char action, int frame, struct action** out)
 
 void startOverdub(int index, char actionMask, int frame, unsigned bufferSize)
 {
+	if (rendering) {
+		push_(EditType_::START_OVERDUB, make_(index, actionMask, frame, 0, 0.0f), 
+			bufferSize);
+		return;
+	}
+	Lock_ lock(mutex);
+
 	/* prepare the composite struct */
 
 	cmp.a1.type  = G_ACTION_KEYPRESS;
@@ -582,10 +678,10 @@ void startOverdub(int index, char actionMask, int frame, unsigned bufferSize)
 
 	rec(index, cmp.a1.type, frame);
 
-	action* act = nullptr;
+	action act;
 	int res = getNextAction(index, cmp.a1.type | cmp.a2.type, cmp.a1.frame, &act);
 	if (res == 1) {
-		if (act->type == cmp.a2.type) {
+		if (act.type == cmp.a2.type) {
 			int truncFrame = cmp.a1.frame - bufferSize;
 			if (truncFrame < 0)
 				truncFrame = 0;
@@ -599,8 +695,15 @@ void startOverdub(int index, char actionMask, int frame, unsigned bufferSize)
 /* -------------------------------------------------------------------------- */
 
 
-void stopOverdub(int currentFrame, int totalFrames, pthread_mutex_t* mixerMutex)
+void stopOverdub(int currentFrame, int totalFrames)
 {
+	if (rendering) {
+		push_(EditType_::STOP_OVERDUB, make_(0, 0, currentFrame, 0, 0.0f), 
+			totalFrames);
+		return;
+	}
+	Lock_ lock(mutex);
+
 	cmp.a2.frame  = currentFrame;
 	bool ringLoop = false;
 	bool nullLoop = false;
@@ -624,8 +727,8 @@ void stopOverdub(int currentFrame, int totalFrames, pthread_mutex_t* mixerMutex)
 	if (cmp.a2.frame == cmp.a1.frame) { // null loop
 		nullLoop = true;
 		gu_log("[recorder::stopOverdub] null loop! frame1=%d == frame2=%d\n", cmp.a1.frame, cmp.a2.frame);
-		deleteAction(cmp.a1.chan, cmp.a1.frame, cmp.a1.type, false, mixerMutex); // false == don't check values
-		fixOverdubTruncation(cmp, mixerMutex);
+		deleteAction(cmp.a1.chan, cmp.a1.frame, cmp.a1.type, false); // false == don't check values
+		fixOverdubTruncation(cmp);
 	}
 
 	if (nullLoop)
@@ -633,8 +736,8 @@ void stopOverdub(int currentFrame, int totalFrames, pthread_mutex_t* mixerMutex)
 
 	/* Remove any nested action between keypress----keyrel. */
 
-	deleteActions(cmp.a2.chan, cmp.a1.frame, cmp.a2.frame, cmp.a1.type, mixerMutex);
-	deleteActions(cmp.a2.chan, cmp.a1.frame, cmp.a2.frame, cmp.a2.type, mixerMutex);
+	deleteActions(cmp.a2.chan, cmp.a1.frame, cmp.a2.frame, cmp.a1.type);
+	deleteActions(cmp.a2.chan, cmp.a1.frame, cmp.a2.frame, cmp.a2.type);
 
 	if (ringLoop)
 		return;
@@ -643,32 +746,117 @@ void stopOverdub(int currentFrame, int totalFrames, pthread_mutex_t* mixerMutex)
 	underlying action truncation, if keyrel happens inside a composite action. */
 
 	rec(cmp.a2.chan, cmp.a2.type, cmp.a2.frame);
-	fixOverdubTruncation(cmp, mixerMutex);
+	fixOverdubTruncation(cmp);
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-vector<action*> getActionsOnFrame(int frame)
+unsigned getVersion()
 {
-	for (size_t i=0; i<frames.size(); i++) {
-		if (recorder::frames.at(i) != frame)
-			continue;
-		return global.at(i);
+	return version.load();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void update()
+{
+	Lock_ lock(mutex);
+
+	Edit_ e;
+	while (edits.pop(e))
+		apply_(e);
+
+	unsigned lost = dropped.exchange(0);
+	if (lost > 0)
+		gu_log("[recorder::update] %u actions from the audio thread dropped!\n", lost);
+
+	if (dirty) {
+		delete incoming.exchange(new vector<action>(timeline));
+		dirty = false;
 	}
-	return vector<action*>();
+
+	vector<action>* old;
+	while (trash.pop(old))
+		delete old;
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void forEachAction(std::function<void(const action*)> f)
+void beginBlock()
 {
+	rendering = true;
+
+	/* Pick up a new timeline, as long as the old one can be given back. The 
+	cursor checks itself on the next lookup. */
 
-	for (const vector<action*> actions : recorder::global)
-		for (const action* action : actions)
-			f(action);
+	if (incoming.load() != nullptr && (current == nullptr || trash.push(current)))
+		current = incoming.exchange(nullptr);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void endBlock()
+{
+	rendering = false;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+ActionRange getActionsOnFrame(int frame)
+{
+	return getActionsInRange(frame, frame + 1);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+ActionRange getActionsInRange(int a, int b)
+{
+	/* Frames to ticks at the current tempo: a tempo change just makes the 
+	cursor look somewhere else. Rewind it with a binary search if it went past 
+	'a' (e.g. the sequencer looped or the timeline has been changed), then walk
+	forward. Ascending lookups never take the slow path. */
+
+	if (current == nullptr)
+		return ActionRange{ nullptr, nullptr };
+
+	vector<action>& v = *current;
+
+	int ta = toTick_(a);
+	int tb = toTick_(b);
+
+	if (cursor > v.size() || (cursor > 0 && v[cursor-1].tick >= ta))
+		cursor = lowerBound_(a, v);
+	while (cursor < v.size() && v[cursor].tick < ta)
+		cursor++;
+
+	size_t last = cursor;
+	while (last < v.size() && v[last].tick < tb)
+		stamp_(v[last++]);
+
+	const action* data = v.data();
+	return ActionRange{ data + cursor, data + last };
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void forEachAction(std::function<void(const action*)> f)
+{
+	Lock_ lock(mutex);
+	for (action a : timeline)
+		f(&stamp_(a));
 }
 }}}; // giada::m::recorder::
@@ -32,7 +32,6 @@
 #include <cstdint>
 #include <vector>
 #include <functional>
-#include <pthread.h>
 
 
 class Channel;
@@ -42,6 +41,13 @@ namespace giada {
 namespace m {
 namespace recorder
 {
+/* TICKS_PER_BEAT
+Resolution of musical time. Larger than the frames in a beat at any supported
+samplerate and tempo, so that a frame always converts to a tick and back to 
+itself. */
+
+constexpr int TICKS_PER_BEAT = 1 << 20;
+
 /* action
  * struct containing fields to describe an atomic action. Note from
  * VST sdk: parameter values, like all VST parameters, are declared as
@@ -51,7 +57,8 @@ struct action
 {
 	int      chan;    // channel index, i.e. Channel->index
  	int      type;
-	int      frame;   // redundant info, used by helper functions
+	int      tick;    // position in musical time, see TICKS_PER_BEAT
+	int      frame;   // position at the current tempo, filled in by lookups
 	float    fValue;  // used only for envelopes (volumes, vst params).
 	uint32_t iValue;  // used only for MIDI events
 };
@@ -65,25 +72,22 @@ struct Composite
 	action a2;
 };
 
-/* frames
-Frame counter sentinel. It tells which frames contain actions. E.g.:
-  frames[0] = 155   // some actions on frame 155
-  frames[1] = 2048  // some actions on frame 2048
-It always matches 'global''s size: frames.size() == global.size() */
-
-extern std::vector<int> frames;
+/* ActionRange
+A read-only view over a contiguous slice of the timeline, as returned by 
+getActionsOnFrame() and getActionsInRange(). It doesn't own anything and it 
+doesn't allocate: it stays valid until the next beginBlock(). */
 
-/* global
-Contains the actual actions. E.g.:
-  global[0] = <actions>
-  global[1] = <actions> */
+struct ActionRange
+{
+	const action* first;
+	const action* last;
 
-extern std::vector<std::vector<action*>> global;
-/* TODO - this frames vs global madness must be replaced with a map:
-std::map<int, vector<actions>> */
+	const action* begin() const { return first; }
+	const action* end()   const { return last; }
+	bool empty() const          { return first == last; }
+};
 
 extern bool active;
-extern bool sortedActions;   // are actions sorted via sortActions()?
 
 /* init
  * everything starts from here. */
@@ -92,9 +96,10 @@ void init();
 
 /* hasActions
 Checks if the channel has at least one action recorded. Used after an
-action deletion. Type != -1: check if channel has actions of type 'type'.*/
+action deletion. Type != -1: check if channel has actions of type 'type'. 
+iValue != 0: only actions with that iValue count. */
 
-bool hasActions(int chanIndex, int type=-1);
+bool hasActions(int chanIndex, int type=-1, uint32_t iValue=0);
 
 /* canRec
  * can a channel rec an action? Call this one BEFORE rec(). */
@@ -102,60 +107,63 @@ bool hasActions(int chanIndex, int type=-1);
 bool canRec(Channel* ch, bool clockRunning, bool mixerRecording);
 
 /* rec
- * record an action. */
+Records an action on frame 'frame' at the current tempo. The timeline is kept 
+sorted by tick: actions on the same tick are kept in recording order. 
+
+Editing and reading functions are thread-safe. Between beginBlock() and 
+endBlock() the audio thread may only call rec(), recEnvelope(), 
+start/stopOverdub(), setFramesInBeat() and its own lookups below: edits are 
+queued, with no waiting nor allocation, and applied by update(). */
 
 void rec(int chan, int action, int frame, uint32_t iValue=0, float fValue=0.0f);
 
+/* recEnvelope
+Records a point of an envelope, e.g. a volume or a plug-in parameter ('iValue')
+change. The first point of an envelope also brings the boundaries along, on
+frame 0 and 'lastFrame' with value 'bValue', as the envelope editor expects. */
+
+void recEnvelope(int chan, int type, int frame, int lastFrame, uint32_t iValue, 
+	float fValue, float bValue);
+
 /* clearChan
  * clear all actions from a channel. */
 
 void clearChan(int chan);
 
 /* clearAction
- * clear the 'action' action type from a channel. */
+Clears the 'action' action type from a channel. iValue != 0: only actions with
+that iValue, e.g. one automated plug-in parameter. */
 
-void clearAction(int chan, char action);
+void clearAction(int chan, char action, uint32_t iValue=0);
 
 /* deleteAction
  * delete ONE action. Useful in the action editor. 'type' can be a mask. */
 
 void deleteAction(int chan, int frame, char type, bool checkValues,
-  pthread_mutex_t* mixerMutex, uint32_t iValue=0, float fValue=0.0);
+  uint32_t iValue=0, float fValue=0.0);
 
 /* deleteActions
 Deletes A RANGE of actions from frame_a to frame_b in channel 'chan' of type
 'type' (can be a bitmask). Exclusive range (frame_a, frame_b). */
 
-void deleteActions(int chan, int frame_a, int frame_b, char type,
-  pthread_mutex_t* mixerMutex);
+void deleteActions(int chan, int frame_a, int frame_b, char type);
 
 /* clearAll
  * delete everything. */
 
 void clearAll();
 
-/* optimize
- * clear frames without actions. */
-
-void optimize();
-
-/* sortActions
- * sorts actions by frame, asc mode. */
-
-void sortActions();
+/* setFramesInBeat
+Sets how long a beat is in frames, i.e. the current tempo and samplerate. 
+Actions live in musical time and follow it, whatever their number: frames are
+computed on the fly by lookups. Called by clock on each tempo change. */
 
-/* updateBpm
- * reassign frames by calculating the new bpm value. */
+void setFramesInBeat(int frames);
 
-void updateBpm(float oldval, float newval, int oldquanto);
+/* expand
+Repeats the actions of the first 'oldBeats' beats up to 'newBeats'. */
 
-/* updateSamplerate
- * reassign frames taking in account the samplerate. If f_system ==
- * f_patch nothing changes, otherwise the conversion is mandatory. */
-
-void updateSamplerate(int systemRate, int patchRate);
-
-void expand(int old_fpb, int new_fpb);
+void expand(int oldBeats, int newBeats);
 void shrink(int new_fpb);
 
 /* getNextAction
@@ -168,28 +176,61 @@ Mask example:
 	mask   = 0x0000FF00  // ignore byte 3
 	action = 0x803D3200  // <--- this action will be found */
 
-int getNextAction(int chan, char action, int frame, struct action** out,
+int getNextAction(int chan, char action, int frame, struct action* out,
 	uint32_t iValue=0, uint32_t mask=0);
 
 /* getAction
-Returns a pointer to action in chan 'chan' of type 'action' at frame 'frame'. */
+Copies into 'out' the action in chan 'chan' of type 'action' at frame 'frame'. 
+Both getAction() and getNextAction() hand out copies and leave the timeline
+untouched. */
+
+int getAction(int chan, char action, int frame, struct action* out);
+
+/* getVersion
+Returns a number that changes on each edit of the recorded actions and on each
+tempo change. Views compiled from the timeline (e.g. Envelope) compare it with
+the one they were built on to know when to rebuild. */
+
+unsigned getVersion();
 
-int getAction(int chan, char action, int frame, struct action** out);
+/* update
+Applies the edits made by the audio thread, then publishes the timeline for it
+if something has changed. Call it periodically from a non-audio thread: other
+edits reach the audio thread only then. */
+
+void update();
+
+/* beginBlock, endBlock
+beginBlock() picks up the timeline published by the last update(). Audio thread
+only, around each block: the recorder must not be called from there outside of
+them. */
+
+void beginBlock();
+void endBlock();
 
 /* getActionsOnFrame
-Returns a vector of actions that occur on frame 'frame'. */
+Returns the actions that occur on frame 'frame', in the timeline picked up by 
+beginBlock(). Audio thread only: lookups are driven by an internal cursor and 
+fill in the frames in place, so querying frames in ascending order costs 
+amortized O(1). */
+
+ActionRange getActionsOnFrame(int frame);
+
+/* getActionsInRange
+Same as above, for all actions in range [a, b). */
 
-std::vector<action*> getActionsOnFrame(int frame);
+ActionRange getActionsInRange(int a, int b);
 
 /* start/stopOverdub
 These functions are used when you overwrite existing actions. For example:
 pressing Mute button on a channel with some existing mute actions. */
 
 void startOverdub(int chan, char action, int frame, unsigned bufferSize);
-void stopOverdub(int currentFrame, int totalFrames, pthread_mutex_t* mixerMutex);
+void stopOverdub(int currentFrame, int totalFrames);
 
 /* forEachAction
-Applies a read-only callback on each action recorded. */
+Applies a read-only callback on a copy of each action recorded. The callback 
+may look the recorder up, but not edit it. Not for the audio thread. */
 
 void forEachAction(std::function<void(const action*)> f);
 }}}; // giada::m::recorder::
@@ -0,0 +1,277 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "dsp.h"
+#include "resampler.h"
+
+
+namespace giada {
+namespace m 
+{
+namespace
+{
+/* PHASES
+How many fractional positions between two frames each sinc filter is computed
+for. Positions in between are interpolated from the two nearest ones. */
+
+constexpr int PHASES = 128;
+
+/* STEPS
+Filter banks are designed for these steps (i.e. pitches): the cutoff is 
+1 / step of the Nyquist frequency, so that going faster doesn't fold the upper
+part of the spectrum back as aliasing. The first bank is used up to 1.0. */
+
+constexpr float STEPS[] = { 1.0f, 1.25f, 1.5f, 2.0f, 2.5f, 3.0f, 4.0f };
+constexpr int   BANKS   = sizeof(STEPS) / sizeof(STEPS[0]);
+
+constexpr int HISTORY = Resampler::MAX_TAPS / 2 - 1;
+
+
+/* Sinc_
+Windowed-sinc filters for a given length: BANKS banks, each one made of 
+PHASES + 1 rows of 'taps' coefficients. */
+
+struct Sinc_
+{
+	int taps;
+	std::vector<float> data;
+
+	Sinc_(int taps) : taps(taps), data(BANKS * (PHASES + 1) * taps)
+	{
+		const double PI   = 3.14159265358979323846;
+		const int    left = taps / 2 - 1;
+
+		for (int b=0; b<BANKS; b++)
+			for (int ph=0; ph<=PHASES; ph++) {
+				float* row = getRow(b, ph);
+				double cut = 1.0 / STEPS[b];
+				double sum = 0.0;
+				for (int k=0; k<taps; k++) {
+					double x = (k - left) - ph / static_cast<double>(PHASES);
+					double u = x / (taps / 2);  // [-1, 1] over the filter
+					double s = x == 0.0 ? 1.0 : std::sin(PI * cut * x) / (PI * cut * x);
+					double w = 0.42 + 0.5 * std::cos(PI * u) + 0.08 * std::cos(2 * PI * u);
+					row[k] = static_cast<float>(cut * s * w);
+					sum   += row[k];
+				}
+				for (int k=0; k<taps; k++)  // unity gain at DC
+					row[k] /= sum;
+			}
+	}
+
+	float* getRow(int bank, int phase)
+	{
+		return &data[(bank * (PHASES + 1) + phase) * taps];
+	}
+};
+
+
+/* getSinc_
+Returns the filters for 'taps' taps. Built the first time they are asked for:
+Resampler's constructor does it, off the audio thread. */
+
+Sinc_& getSinc_(int taps)
+{
+	static Sinc_ sinc8 (8);
+	static Sinc_ sinc16(16);
+	static Sinc_ sinc32(32);
+	return taps == 8 ? sinc8 : taps == 16 ? sinc16 : sinc32;
+}
+
+
+int getBank_(float step)
+{
+	int b = 0;
+	while (b < BANKS - 1 && STEPS[b] < step)
+		b++;
+	return b;
+}
+}; // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+constexpr int Resampler::MAX_TAPS;
+constexpr int Resampler::LOOKAHEAD;
+
+
+Resampler::Resampler(int channels, int maxFrames)
+: m_interpolation(Interpolation::LINEAR),
+  m_channels     (channels),
+  m_maxFrames    (maxFrames),
+  m_pos          (0.0),
+  m_scratch      ((HISTORY + maxFrames + MAX_TAPS / 2) * channels, 0.0f)
+{
+	getSinc_(8);
+	getSinc_(16);
+	getSinc_(32);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Resampler::setInterpolation(Interpolation i)
+{
+	m_interpolation = i == Interpolation::LIBSAMPLERATE ? Interpolation::LINEAR : i;
+}
+
+
+Interpolation Resampler::getInterpolation() const
+{
+	return m_interpolation;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Resampler::reset()
+{
+	m_pos = 0.0;
+	std::fill(m_scratch.begin(), m_scratch.begin() + HISTORY * m_channels, 0.0f);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int Resampler::getTaps_() const
+{
+	switch (m_interpolation) {
+		case Interpolation::HERMITE: return 4;
+		case Interpolation::SINC_8:  return 8;
+		case Interpolation::SINC_16: return 16;
+		case Interpolation::SINC_32: return 32;
+		default:                     return 2;
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Resampler::setCoefs_(float frac, const float* table)
+{
+	float* w = m_coefs;
+
+	if (m_interpolation == Interpolation::LINEAR) {
+		w[0] = 1.0f - frac;
+		w[1] = frac;
+	}
+	else
+	if (m_interpolation == Interpolation::HERMITE) {  // Catmull-Rom spline
+		float t2 = frac * frac;
+		float t3 = t2 * frac;
+		w[0] = -0.5f * t3 + t2 - 0.5f * frac;
+		w[1] =  1.5f * t3 - 2.5f * t2 + 1.0f;
+		w[2] = -1.5f * t3 + 2.0f * t2 + 0.5f * frac;
+		w[3] =  0.5f * t3 - 0.5f * t2;
+	}
+	else {
+		float pos   = frac * PHASES;
+		int   phase = std::min(static_cast<int>(pos), PHASES - 1);
+		float f     = pos - phase;
+		int   taps  = getTaps_();
+		const float* a = table + phase * taps;
+		const float* b = a + taps;
+		for (int k=0; k<taps; k++)
+			w[k] = a[k] + (b[k] - a[k]) * f;
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Resampler::Result Resampler::process(const float* in, int frames, bool last, 
+	float* out, int outFrames, float stepStart, float stepEnd)
+{
+	int taps  = getTaps_();
+	int left  = taps / 2 - 1;
+	int right = taps / 2;
+
+	/* Copy what this block needs after the history. If that's not the whole 
+	input, the end of it isn't the end of the sample either. */
+
+	double need = m_pos + outFrames * std::max(stepStart, stepEnd);
+	int    n    = std::max(0, std::min({ frames, m_maxFrames, static_cast<int>(need) + right + 1 }));
+	last = last && n == frames;
+
+	float* scratch = m_scratch.data();
+	std::memcpy(scratch + HISTORY * m_channels, in, n * m_channels * sizeof(float));
+	int avail = n;
+	if (last) {
+		std::fill_n(scratch + (HISTORY + n) * m_channels, right * m_channels, 0.0f);
+		avail += right;
+	}
+
+	const float* table = nullptr;
+	if (taps >= 8)
+		table = getSinc_(taps).getRow(getBank_(std::max(stepStart, stepEnd)), 0);
+
+	double p     = m_pos;
+	float  slope = (stepEnd - stepStart) / std::max(outFrames, 1);
+	int    j     = 0;
+	for (; j<outFrames; j++) {
+		int i = static_cast<int>(p);
+		if (i + right >= avail)
+			break;
+		const float* x = scratch + (HISTORY + i - left) * m_channels;
+		float*       y = out + j * m_channels;
+		setCoefs_(static_cast<float>(p - i), table);
+
+		/* Too short for vectors to pay off: inline. */
+
+		if (taps > 4)
+			dsp::convolve(y, x, m_coefs, taps, m_channels);
+		else
+			for (int c=0; c<m_channels; c++) {
+				float sum = 0.0f;
+				for (int k=0; k<taps; k++)
+					sum += x[k*m_channels + c] * m_coefs[k];
+				y[c] = sum;
+			}
+		p += stepStart + slope * j;
+	}
+
+	/* Keep the frames before the next position as history. */
+
+	int used = std::min(static_cast<int>(p), n);
+	m_pos = p - used;
+	std::memmove(scratch, scratch + used * m_channels, HISTORY * m_channels * sizeof(float));
+
+	return { used, j };
+}
+}} // giada::m::
@@ -0,0 +1,133 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#ifndef G_RESAMPLER_H
+#define G_RESAMPLER_H
+
+
+#include <vector>
+#include "types.h"
+
+
+namespace giada {
+namespace m 
+{
+/* Resampler
+Built-in real-time resampler for pitched playback, an alternative to 
+libsamplerate with a selectable interpolation and pitch that can glide within a
+block. Works on interleaved frames of any channel count; the position between 
+two frames and the last frames read are kept from one call to the next. All 
+memory is allocated in the constructor: process() is safe on the audio 
+thread. */
+
+class Resampler
+{
+public:
+
+	/* MAX_TAPS
+	Length of the longest filter, i.e. how many input frames an output frame
+	is made of. */
+
+	static constexpr int MAX_TAPS = 32;
+
+	/* LOOKAHEAD
+	Frames read past the position of the last output frame: callers must
+	provide this many frames in addition to outFrames * pitch. */
+
+	static constexpr int LOOKAHEAD = MAX_TAPS / 2 + 1;
+
+	struct Result
+	{
+		int used;       // input frames consumed
+		int generated;  // output frames written
+	};
+
+	/* Resampler
+	'maxFrames' is the largest number of input frames process() will look at 
+	in a single call. */
+
+	Resampler(int channels, int maxFrames);
+
+	/* setInterpolation
+	Interpolation::LIBSAMPLERATE is not handled here and falls back to 
+	LINEAR. */
+
+	void setInterpolation(Interpolation i);
+	Interpolation getInterpolation() const;
+
+	/* reset
+	Forgets past frames, e.g. when jumping somewhere else in the sample. */
+
+	void reset();
+
+	/* process
+	Writes up to 'outFrames' frames into 'out' reading from 'in', which holds 
+	'frames' frames. 'step' is how many input frames make an output one, i.e. 
+	the pitch: it moves linearly from 'stepStart' to 'stepEnd' across the block,
+	one output frame at a time. If 'last' is true nothing follows 'in': its 
+	tail is resampled against silence and fully consumed. */
+
+	Result process(const float* in, int frames, bool last, float* out, 
+		int outFrames, float stepStart, float stepEnd);
+
+private:
+
+	/* getTaps_
+	Returns how many taps the current interpolation uses. */
+
+	int getTaps_() const;
+
+	/* setCoefs_
+	Computes in m_coefs the weights of taps for an output frame that falls at 
+	'frac' between two input frames. 'table' is the sinc filter bank in use, if
+	any. */
+
+	void setCoefs_(float frac, const float* table);
+
+	Interpolation m_interpolation;
+	int m_channels;
+	int m_maxFrames;
+
+	/* m_pos
+	Position of the next output frame, relative to the first frame of the next
+	input block. Usually in [0, 1), larger when the step is big enough to skip 
+	whole frames. */
+
+	double m_pos;
+
+	/* m_scratch
+	Input frames preceded by the last ones of the previous call (history), 
+	followed by room for zero padding. */
+
+	std::vector<float> m_scratch;
+	float m_coefs[MAX_TAPS];
+};
+}} // giada::m::
+
+
+#endif
@@ -0,0 +1,206 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <set>
+#include "audioBuffer.h"
+#include "rope.h"
+
+
+namespace giada {
+namespace m 
+{
+Rope::Rope()
+: m_frames  (0),
+  m_channels(0)
+{
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Rope::Rope(std::shared_ptr<const AudioBuffer> data)
+: m_frames  (0),
+  m_channels(data->countChannels())
+{
+	append_({ data, 0, data->countFrames() });
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int Rope::countFrames() const   { return m_frames; }
+int Rope::countChannels() const { return m_channels; }
+int Rope::countPieces() const   { return m_pieces.size(); }
+
+
+/* -------------------------------------------------------------------------- */
+
+
+size_t Rope::getMemory() const
+{
+	std::set<const AudioBuffer*> seen;
+	size_t bytes = 0;
+	for (const Piece& p : m_pieces)
+		if (seen.insert(p.data.get()).second)
+			bytes += p.data->countSamples() * sizeof(float);
+	return bytes;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+const float* Rope::getSpan(int f, int* frames) const
+{
+	int i = find_(f);
+	const Piece& p = m_pieces.at(i);
+	int local = f - m_offsets.at(i);
+	*frames = p.frames - local;
+	return (*p.data)[p.start + local];
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Rope::read(float* dest, int start, int frames) const
+{
+	assert(start >= 0 && start + frames <= m_frames);
+
+	if (frames <= 0)
+		return;
+	for (int i=find_(start); frames > 0; i++) {
+		const Piece& p = m_pieces.at(i);
+		int local = start - m_offsets.at(i);
+		int n     = std::min(frames, p.frames - local);
+		memcpy(dest, (*p.data)[p.start + local], n * m_channels * sizeof(float));
+		dest   += n * m_channels;
+		start  += n;
+		frames -= n;
+	}
+}
+
+
+void Rope::read(AudioBuffer& dest, int start, int frames, int offset) const
+{
+	assert(dest.countChannels() == m_channels);
+	assert(frames <= dest.countFrames() - offset);
+
+	if (frames > 0)
+		read(dest[offset], start, frames);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Rope Rope::slice(int a, int b) const
+{
+	a = std::max(a, 0);
+	b = std::min(b, m_frames);
+
+	Rope out;
+	out.m_channels = m_channels;
+	if (a >= b)
+		return out;
+	for (int i=find_(a); i<countPieces() && m_offsets.at(i) < b; i++) {
+		const Piece& p = m_pieces.at(i);
+		int first = std::max(a - m_offsets.at(i), 0);
+		int last  = std::min(b - m_offsets.at(i), p.frames);
+		out.append_({ p.data, p.start + first, last - first });
+	}
+	return out;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Rope Rope::concat(const Rope& other) const
+{
+	assert(m_frames == 0 || other.m_frames == 0 || m_channels == other.m_channels);
+
+	Rope out = *this;
+	if (out.m_frames == 0)
+		out.m_channels = other.m_channels;
+	for (const Piece& p : other.m_pieces)
+		out.append_(p);
+	return out;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Rope Rope::replace(int a, std::shared_ptr<const AudioBuffer> data) const
+{
+	int b = a + data->countFrames();
+	assert(b <= m_frames);
+	return slice(0, a).concat(Rope(data)).concat(slice(b, m_frames));
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int Rope::find_(int f) const
+{
+	assert(f >= 0 && f < m_frames);
+	return std::upper_bound(m_offsets.begin(), m_offsets.end(), f) - m_offsets.begin() - 1;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Rope::append_(const Piece& p)
+{
+	if (p.frames <= 0)
+		return;
+
+	/* Consecutive ranges of the same buffer, e.g. after undoing a cut by pasting
+	the same data back: merge them. */
+
+	if (!m_pieces.empty()) {
+		Piece& last = m_pieces.back();
+		if (last.data == p.data && last.start + last.frames == p.start) {
+			last.frames += p.frames;
+			m_frames    += p.frames;
+			return;
+		}
+	}
+	m_pieces.push_back(p);
+	m_offsets.push_back(m_frames);
+	m_frames += p.frames;
+}
+}} // giada::m::
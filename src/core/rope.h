@@ -0,0 +1,122 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#ifndef G_ROPE_H
+#define G_ROPE_H
+
+
+#include <memory>
+#include <vector>
+
+
+namespace giada {
+namespace m 
+{
+class AudioBuffer;
+
+/* Rope
+Sample data as a sequence of pieces, each one a range of a read-only buffer 
+shared by reference. Edits such as cut, paste and trim only rearrange pieces 
+and return a new Rope, leaving the original one untouched: old versions of a 
+sample cost almost nothing to keep (see the undo history in the sample editor).
+Data inside a piece is contiguous. */
+
+class Rope
+{
+public:
+
+	Rope();
+
+	/* Rope (1)
+	A single piece spanning the whole 'data'. */
+
+	Rope(std::shared_ptr<const AudioBuffer> data);
+
+	int countFrames() const;
+	int countChannels() const;
+	int countPieces() const;
+
+	/* getMemory
+	Returns the memory taken by the buffers pieces point to, in bytes. Each buffer 
+	is counted once, even if shared by several pieces. */
+
+	size_t getMemory() const;
+
+	/* getSpan
+	Returns a pointer to frame 'f' and how many contiguous frames can be read 
+	from there in 'frames', i.e. until the end of its piece. */
+
+	const float* getSpan(int f, int* frames) const;
+
+	/* read
+	Copies 'frames' frames starting from 'start' into 'dest' at frame 'offset':
+	one copy per piece. */
+
+	void read(AudioBuffer& dest, int start, int frames, int offset) const;
+	void read(float* dest, int start, int frames) const;
+
+	/* slice
+	Returns frames [a, b). */
+
+	Rope slice(int a, int b) const;
+
+	/* concat
+	Returns this Rope followed by 'other'. */
+
+	Rope concat(const Rope& other) const;
+
+	/* replace
+	Returns a copy where frames [a, a + data.frames) come from 'data'. */
+
+	Rope replace(int a, std::shared_ptr<const AudioBuffer> data) const;
+
+private:
+
+	struct Piece
+	{
+		std::shared_ptr<const AudioBuffer> data;
+		int start;   // first frame in data
+		int frames;
+	};
+
+	/* find_
+	Returns the index of the piece frame 'f' belongs to. */
+
+	int find_(int f) const;
+
+	void append_(const Piece& p);
+
+	std::vector<Piece> m_pieces;
+	std::vector<int>   m_offsets;  // first frame of each piece in the Rope
+	int m_frames;
+	int m_channels;
+};
+}} // giada::m::
+
+
+#endif
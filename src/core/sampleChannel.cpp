@@ -25,22 +25,26 @@
  * -------------------------------------------------------------------------- */
 
 
+#include <algorithm>
 #include "../utils/log.h"
 #include "sampleChannelProc.h"
 #include "sampleChannelRec.h"
 #include "channelManager.h"
 #include "const.h"
+#include "pitchCache.h"
 #include "wave.h"
 #include "sampleChannel.h"
 
 
 using std::string;
+using std::vector;
 using namespace giada;
 using namespace giada::m;
 
 
 SampleChannel::SampleChannel(bool inputMonitor, int bufferSize)
 	: Channel          (ChannelType::SAMPLE, ChannelStatus::EMPTY, bufferSize),
+		pitchSlot        (std::make_shared<pitchCache::Slot>()),
 		mode             (ChannelMode::SINGLE_BASIC),
 		wave             (nullptr),
 		tracker          (0),
@@ -50,11 +54,16 @@ SampleChannel::SampleChannel(bool inputMonitor, int bufferSize)
 		inputMonitor     (inputMonitor),
 		boost            (G_DEFAULT_BOOST),
 		pitch            (G_DEFAULT_PITCH),
+		interpolation    (Interpolation::LIBSAMPLERATE),
 		begin            (0),
 		end              (0),
 		midiInReadActions(0x0),
 		midiInPitch      (0x0),
-		rsmp_state       (nullptr)
+		rsmp_state       (nullptr),
+		pitchCached      (false),
+		resampler        (G_MAX_IO_CHANS, static_cast<int>(bufferSize * G_MAX_PITCH) + Resampler::LOOKAHEAD),
+		rampFrom         (G_DEFAULT_PITCH),
+		rampPitch        (G_DEFAULT_PITCH)
 {
 	rsmp_state = src_new(SRC_LINEAR, G_MAX_IO_CHANS, nullptr);
 	if (rsmp_state == nullptr) {
@@ -62,6 +71,8 @@ SampleChannel::SampleChannel(bool inputMonitor, int bufferSize)
 		throw std::bad_alloc();
 	}
 	bufferPreview.alloc(bufferSize, G_MAX_IO_CHANS);
+	bufferStream.alloc(static_cast<int>(bufferSize * G_MAX_PITCH) + Resampler::LOOKAHEAD, 
+		G_MAX_IO_CHANS);
 }
 
 
@@ -90,6 +101,7 @@ void SampleChannel::copy(const Channel* src_, pthread_mutex_t* pluginMutex)
 	mode            = src->mode;
 	qWait           = src->qWait;
 	setPitch(src->pitch);
+	setInterpolation(src->interpolation);
 
 	if (src->wave)
 		pushWave(new Wave(*src->wave)); // invoke Wave's copy constructor
@@ -99,10 +111,12 @@ void SampleChannel::copy(const Channel* src_, pthread_mutex_t* pluginMutex)
 /* -------------------------------------------------------------------------- */
 
 
-void SampleChannel::parseEvents(m::mixer::FrameEvents fe)
+void SampleChannel::parseEvents(const vector<m::mixer::FrameEvents>& events)
 {
-	sampleChannelProc::parseEvents(this, fe);
-	sampleChannelRec::parseEvents(this, fe);
+	for (const m::mixer::FrameEvents& fe : events) {
+		sampleChannelProc::parseEvents(this, fe);
+		sampleChannelRec::parseEvents(this, fe);
+	}
 }
 
 
@@ -111,6 +125,22 @@ void SampleChannel::parseEvents(m::mixer::FrameEvents fe)
 
 void SampleChannel::prepareBuffer(bool running)
 {
+	/* Input recording writes into the wave: renders of it would go stale. Back 
+	to live resampling, start from a clean state. */
+
+	bool cached = wave != nullptr && !armed && 
+		pitchSlot->prepare(*wave, pitch, buffer.countFrames());
+	if (pitchCached && !cached) {
+		src_reset(rsmp_state);
+		resampler.reset();
+	}
+	pitchCached = cached;
+
+	/* The glide spans the whole block, however many times it is filled. */
+
+	rampFrom  = rampPitch;
+	rampPitch = pitch;
+
 	sampleChannelProc::prepareBuffer(this, running);
 }
 
@@ -164,15 +194,15 @@ void SampleChannel::kill(int localFrame)
 /* -------------------------------------------------------------------------- */
 
 
-bool SampleChannel::recordStart(bool canQuantize) 
+bool SampleChannel::recordStart(bool canQuantize, int localFrame) 
 {
-	return sampleChannelRec::recordStart(this, canQuantize);
+	return sampleChannelRec::recordStart(this, canQuantize, localFrame);
 }
 
 
-bool SampleChannel::recordKill()
+bool SampleChannel::recordKill(int localFrame)
 {
-	return sampleChannelRec::recordKill(this);
+	return sampleChannelRec::recordKill(this, localFrame);
 }
 
 
@@ -241,10 +271,16 @@ void SampleChannel::process(giada::m::AudioBuffer& out,
 /* -------------------------------------------------------------------------- */
 
 
-void SampleChannel::readPatch(const string& basePath, int i)
+void SampleChannel::readPatch(const string& /*basePath*/, int i)
 {
 	Channel::readPatch("", i);
-	channelManager::readPatch(this, basePath, i);
+	channelManager::readPatch(this, i);
+}
+
+
+void SampleChannel::readPatchWave(int i, Wave* w, int res)
+{
+	channelManager::readPatchWave(this, i, w, res);
 }
 
 
@@ -306,6 +342,8 @@ void SampleChannel::setBegin(int f)
 
 	tracker = begin;
 	trackerPreview = begin;
+
+	wave->prefetch(begin);
 }
 
 
@@ -357,6 +395,23 @@ float SampleChannel::getPitch() const { return pitch; }
 /* -------------------------------------------------------------------------- */
 
 
+void SampleChannel::setInterpolation(Interpolation i)
+{
+	/* Each engine has its own state, stale if it hasn't been used lately. */
+
+	if (i == Interpolation::LIBSAMPLERATE)
+		src_reset(rsmp_state);
+	else
+	if (interpolation == Interpolation::LIBSAMPLERATE)
+		resampler.reset();
+	interpolation = i;
+	resampler.setInterpolation(i);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 int SampleChannel::getPosition() const
 {
 	if (status != ChannelStatus::EMPTY   && 
@@ -424,6 +479,21 @@ void SampleChannel::pushWave(Wave* w)
 /* -------------------------------------------------------------------------- */
 
 
+void SampleChannel::swapWave(Wave* w)
+{
+	wave = w;
+
+	int last = std::max(wave->getSize() - 1, 0);
+	end            = std::min(end, last);
+	begin          = std::min(begin, std::max(end - 1, 0));
+	tracker        = std::min(std::max(tracker, begin), end);
+	trackerPreview = std::min(trackerPreview, last);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 bool SampleChannel::canInputRec()
 {
 	return wave == nullptr && armed;
@@ -435,8 +505,20 @@ bool SampleChannel::canInputRec()
 
 int SampleChannel::fillBuffer(giada::m::AudioBuffer& dest, int start, int offset)
 {
-	if (pitch == 1.0) return fillBufferCopy(dest, start, offset);
-	else              return fillBufferResampled(dest, start, offset);
+	/* The built-in resampler glides to the new pitch, even when that's 1.0: it
+	takes one more block before plain copies. A fill that starts past the first
+	frame (e.g. a restart) picks up the glide where it is on that frame. */
+
+	float from    = rampFrom + (rampPitch - rampFrom) * offset / dest.countFrames();
+	bool  builtin = interpolation != Interpolation::LIBSAMPLERATE;
+
+	if (pitch == 1.0 && (from == 1.0 || !builtin)) 
+		return fillBufferCopy(dest, start, offset);
+	else
+	if (pitchCached) return pitchSlot->read(dest, start, end, offset);
+	else
+	if (builtin)     return fillBufferInterpolated(dest, start, offset, from);
+	else             return fillBufferResampled(dest, start, offset);
 }
 
 
@@ -445,8 +527,20 @@ int SampleChannel::fillBuffer(giada::m::AudioBuffer& dest, int start, int offset
 
 int SampleChannel::fillBufferResampled(giada::m::AudioBuffer& dest, int start, int offset)
 {
-	rsmp_data.data_in       = wave->getFrame(start);        // Source data
-	rsmp_data.input_frames  = end - start;                  // How many readable frames
+	/* Streamed and native waves can't be accessed directly: read (and convert) 
+	the next chunk first. The resampler never needs more than what bufferStream
+	can hold. */
+
+	if (!wave->isDirect()) {
+		int frames = std::min(end - start, bufferStream.countFrames());
+		wave->read(bufferStream, start, frames, 0);
+		rsmp_data.data_in      = bufferStream[0];
+		rsmp_data.input_frames = frames;
+	}
+	else {
+		rsmp_data.data_in      = static_cast<const Wave*>(wave)->getFrame(start); // Source data
+		rsmp_data.input_frames = end - start;                 // How many readable frames
+	}
 	rsmp_data.data_out      = dest[offset];                 // Destination (processed data)
 	rsmp_data.output_frames = dest.countFrames() - offset;  // How many frames to process
 	rsmp_data.end_of_input  = false;
@@ -460,13 +554,39 @@ int SampleChannel::fillBufferResampled(giada::m::AudioBuffer& dest, int start, i
 /* -------------------------------------------------------------------------- */
 
 
+int SampleChannel::fillBufferInterpolated(giada::m::AudioBuffer& dest, int start, 
+	int offset, float from)
+{
+	const float* in;
+	int frames = end - start;
+
+	if (!wave->isDirect()) {
+		frames = std::min(frames, bufferStream.countFrames());
+		wave->read(bufferStream, start, frames, 0);
+		in = bufferStream[0];
+	}
+	else
+		in = static_cast<const Wave*>(wave)->getFrame(start);
+
+	/* Nothing after 'end': the resampler must consume the tail against silence,
+	or the tracker would never get there. */
+
+	Resampler::Result res = resampler.process(in, frames, start + frames == end, 
+		dest[offset], dest.countFrames() - offset, from, pitch);
+	return res.used;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 int SampleChannel::fillBufferCopy(giada::m::AudioBuffer& dest, int start, int offset)
 {
 	int used = dest.countFrames() - offset;
 	if (used + start > wave->getSize())
 		used = wave->getSize() - start;
 
-	dest.copyData(wave->getFrame(start), used, offset);
+	wave->read(dest, start, used, offset);
 
 	return used;
 }
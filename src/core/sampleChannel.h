@@ -30,13 +30,21 @@
 
 
 #include <functional>
+#include <memory>
 #include <samplerate.h>
 #include "types.h"
+#include "resampler.h"
 #include "channel.h"
 
 
 class Patch;
 class Wave;
+namespace giada {
+namespace m {
+namespace pitchCache
+{
+class Slot;
+}}}
 
 
 class SampleChannel : public Channel
@@ -48,7 +56,7 @@ public:
 
 	void copy(const Channel* src, pthread_mutex_t* pluginMutex) override;
 	void prepareBuffer(bool running) override;
-	void parseEvents(giada::m::mixer::FrameEvents fe) override;
+	void parseEvents(const std::vector<giada::m::mixer::FrameEvents>& events) override;
 	void process(giada::m::AudioBuffer& out, const giada::m::AudioBuffer& in,
 		bool audible, bool running) override;
 	void readPatch(const std::string& basePath, int i) override;
@@ -57,8 +65,8 @@ public:
 	void start(int frame, bool doQuantize, int velocity) override;
 	void stop() override;
 	void kill(int frame) override;
-	bool recordStart(bool canQuantize) override;
-	bool recordKill() override;
+	bool recordStart(bool canQuantize, int localFrame) override;
+	bool recordKill(int localFrame) override;
 	void recordStop() override;
 	void setMute(bool value) override;
 	void setSolo(bool value) override;
@@ -74,6 +82,12 @@ public:
 	bool hasEditedData() const override;
 	bool hasData() const override;
 
+	/* readPatchWave
+	Completes readPatch() with the sample, which is loaded apart (see 
+	patchLoader). */
+
+	void readPatchWave(int i, Wave* w, int res);
+
 	float getBoost() const;	
 	int   getBegin() const;
 	int   getEnd() const;
@@ -90,7 +104,8 @@ public:
 	/* fillBuffer
 	Fills 'dest' buffer at point 'offset' with Wave data taken from 'start'. 
 	Returns how many frames have been used from the original Wave data. It also
-	resamples data if pitch != 1.0f. */
+	resamples data if pitch != 1.0f, or reads it already resampled from the 
+	pitch cache if ready. */
 
 	int fillBuffer(giada::m::AudioBuffer& dest, int start, int offset);
 
@@ -99,7 +114,15 @@ public:
 
 	void pushWave(Wave* w);
 
+	/* swapWave
+	Replaces the wave with an edited copy of it, keeping the channel going. 
+	Begin, end and trackers are clamped to the new size. The old wave is still 
+	owned by the caller. */
+
+	void swapWave(Wave* w);
+
 	void setPitch(float v);
+	void setInterpolation(giada::Interpolation i);
 	void setBegin(int f);
 	void setEnd(int f);
 	void setBoost(float v);
@@ -115,6 +138,16 @@ public:
 	Extra buffer for audio preview. */
 
 	giada::m::AudioBuffer bufferPreview;
+
+	/* bufferStream
+	Scratch buffer for resampling streamed waves. */
+
+	giada::m::AudioBuffer bufferStream;
+
+	/* pitchSlot
+	Pitched renders of the wave, when pitch doesn't change (see pitchCache). */
+
+	std::shared_ptr<giada::m::pitchCache::Slot> pitchSlot;
 	
 	giada::ChannelMode mode;
 	
@@ -127,6 +160,11 @@ public:
 	float boost;
 	float pitch;
 
+	/* interpolation
+	Which engine resamples when pitched: libsamplerate or the built-in one. */
+
+	giada::Interpolation interpolation;
+
 	/* begin, end
 	Begin/end point to read wave data from/to. */
 
@@ -147,7 +185,22 @@ private:
 	SRC_STATE* rsmp_state;
 	SRC_DATA   rsmp_data;
 
+	/* pitchCached
+	True if this block reads from the pitch cache instead of resampling. */
+
+	bool pitchCached;
+
+	/* resampler, rampFrom, rampPitch
+	The built-in resampler and the pitch it glides from and to across the 
+	current block. Both move forward once per block, in prepareBuffer(). */
+
+	giada::m::Resampler resampler;
+	float rampFrom;
+	float rampPitch;
+
 	int fillBufferResampled(giada::m::AudioBuffer& dest, int start, int offset);
+	int fillBufferInterpolated(giada::m::AudioBuffer& dest, int start, int offset,
+		float from);
 	int fillBufferCopy     (giada::m::AudioBuffer& dest, int start, int offset);
 };
 
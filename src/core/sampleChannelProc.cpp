@@ -26,8 +26,11 @@
 
 
 #include <cassert>
+#include <algorithm>
 #include "../utils/math.h"
 #include "const.h"
+#include "dsp.h"
+#include "mixer.h"
 #include "pluginHost.h"
 #include "sampleChannel.h"
 #include "sampleChannelProc.h"
@@ -185,6 +188,36 @@ void onLastFrame_(SampleChannel* ch, int localFrame, bool running)
 /* -------------------------------------------------------------------------- */
 
 
+/* addEnveloped_
+Adds the channel buffer to 'out' following the volume envelope wherever the 
+sequencer went during this block: one gain ramp for each stretch between two 
+breakpoints, whatever its length. The envelope moves on even if the channel is
+muted. Leaves volume_i on the value reached. */
+
+void addEnveloped_(SampleChannel* ch, m::AudioBuffer& out, const float* gains)
+{
+	const std::vector<mixer::Span>& spans = mixer::getSpans();
+
+	for (size_t i=0; i<spans.size(); i++) {
+		Frame local  = spans[i].frameLocal;
+		Frame global = spans[i].frameGlobal;
+		Frame end    = i + 1 < spans.size() ? spans[i+1].frameLocal : out.countFrames();
+		while (local < end) {
+			Envelope::Ramp r = ch->volumeEnv.getRamp(global, end - local);
+			if (!ch->mute)
+				dsp::addRamp(out, ch->buffer, local, r.frames, gains, r.start, r.step);
+			ch->volume_i = r.start + r.step * r.frames;
+			local  += r.frames;
+			global += r.frames;
+		}
+	}
+	ch->volume_i = std::max(0.0f, std::min(1.0f, ch->volume_i));
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 void processData_(SampleChannel* ch, m::AudioBuffer& out, const m::AudioBuffer& in, 
 	bool running)
 {
@@ -198,21 +231,31 @@ void processData_(SampleChannel* ch, m::AudioBuffer& out, const m::AudioBuffer&
 	(i.e. not plugin-processed). */
 
 	if (ch->armed && in.isAllocd() && ch->inputMonitor) {
-		for (int i=0; i<ch->buffer.countFrames(); i++)
-			for (int j=0; j<ch->buffer.countChannels(); j++)
-				ch->buffer[i][j] += in[i][j];   // add, don't overwrite
+		const float unity[G_MAX_IO_CHANS] = { 1.0f, 1.0f };
+		dsp::add(ch->buffer, in, unity);   // add, don't overwrite
 	}
 
 #ifdef WITH_VST
 	pluginHost::processStack(ch->buffer, pluginHost::CHANNEL, ch);
 #endif
 
-	for (int i=0; i<out.countFrames(); i++) {
-		if (running)
-			ch->calcVolumeEnvelope();
-		if (!ch->mute)
-			for (int j=0; j<out.countChannels(); j++)
-				out[i][j] += ch->buffer[i][j] * ch->volume * ch->volume_i * ch->calcPanning(j) * ch->boost;	
+	/* The volume envelope, if any, is followed while the sequencer is running and
+	actions are read. It is rebuilt elsewhere, see mh::updateEnvelopes(). */
+
+	ch->volumeEnv.prepare();
+
+	float gains[G_MAX_IO_CHANS];
+	for (int j=0; j<G_MAX_IO_CHANS; j++)
+		gains[j] = ch->volume * ch->calcPanning(j) * ch->boost;
+
+	if (running && ch->readActions && !ch->volumeEnv.isEmpty() && 
+	    !mixer::getSpans().empty())
+		addEnveloped_(ch, out, gains);
+	else
+	if (!ch->mute) {
+		for (float& g : gains)
+			g *= ch->volume_i;
+		dsp::add(out, ch->buffer, gains);
 	}
 }
 
@@ -243,9 +286,10 @@ void processPreview_(SampleChannel* ch, m::AudioBuffer& out)
 	else
 		ch->trackerPreview += ch->fillBuffer(ch->bufferPreview, ch->trackerPreview, 0);
 
-	for (int i=0; i<out.countFrames(); i++)
-		for (int j=0; j<out.countChannels(); j++)
-			out[i][j] += ch->bufferPreview[i][j] * ch->volume * ch->calcPanning(j) * ch->boost;	
+	float gains[G_MAX_IO_CHANS];
+	for (int j=0; j<G_MAX_IO_CHANS; j++)
+		gains[j] = ch->volume * ch->calcPanning(j) * ch->boost;
+	dsp::add(out, ch->bufferPreview, gains);
 }
 }; // {anonymous}
 
@@ -464,7 +508,7 @@ void prepareBuffer(SampleChannel* ch, bool running)
 /* -------------------------------------------------------------------------- */
 
 
-void parseEvents(SampleChannel* ch, mixer::FrameEvents fe)
+void parseEvents(SampleChannel* ch, const mixer::FrameEvents& fe)
 {
 	quantize_(ch, fe.frameLocal, fe.quantoPassed);
 	if (fe.onBar)
@@ -45,9 +45,9 @@ namespace sampleChannelProc
 void prepareBuffer(SampleChannel* ch, bool running);
 
 /* parseEvents
-Parses events gathered by Mixer::masterPlay(). */
+Parses a single event gathered by Mixer::masterPlay(). */
 
-void parseEvents(SampleChannel* ch, mixer::FrameEvents ev);
+void parseEvents(SampleChannel* ch, const mixer::FrameEvents& fe);
 
 /**/
 void process(SampleChannel* ch, giada::m::AudioBuffer& out, 
@@ -25,7 +25,6 @@
  * -------------------------------------------------------------------------- */
 
 
-#include <cassert>
 #include "const.h"
 #include "conf.h"
 #include "clock.h"
@@ -76,45 +75,7 @@ bool recorderCanRec_(SampleChannel* ch)
 /* -------------------------------------------------------------------------- */
 
 
-/* calcVolumeEnv
-Computes any changes in volume done via envelope tool. */
-
-void calcVolumeEnv_(SampleChannel* ch, int globalFrame)
-{
-	/* method: check this frame && next frame, then calculate delta */
-
-	recorder::action* a0 = nullptr;
-	recorder::action* a1 = nullptr;
-	int res;
-
-	/* get this action on frame 'frame'. It's unlikely that the action
-	 * is not found. */
-
-	res = recorder::getAction(ch->index, G_ACTION_VOLUME, globalFrame, &a0);
-
-	assert(res != 0);
-
-	/* get the action next to this one.
-	 * res == -1: a1 not found, this is the last one. Rewind the search
-	 * and use action at frame number 0 (actions[0]).
-	 * res == -2 G_ACTION_VOLUME not found. This should never happen */
-
-	res = recorder::getNextAction(ch->index, G_ACTION_VOLUME, globalFrame, &a1);
-	if (res == -1)
-		res = recorder::getAction(ch->index, G_ACTION_VOLUME, 0, &a1);
-
-	assert(res != -2);
-
-	ch->volume_i = a0->fValue;
-	ch->volume_d = ((a1->fValue - a0->fValue) / (a1->frame - a0->frame)) * 1.003f;
-}
-
-
-/* -------------------------------------------------------------------------- */
-
-
-void parseAction_(SampleChannel* ch, const recorder::action* a, int localFrame, 
-	int globalFrame)
+void parseAction_(SampleChannel* ch, const recorder::action* a, int localFrame)
 {
 	if (!ch->readActions)
 		return;
@@ -138,9 +99,6 @@ void parseAction_(SampleChannel* ch, const recorder::action* a, int localFrame,
 			if (ch->isAnySingleMode())
 				ch->kill(localFrame);
 			break;
-		case G_ACTION_VOLUME:
-			calcVolumeEnv_(ch, globalFrame);
-			break;
 	}
 }
 
@@ -148,7 +106,7 @@ void parseAction_(SampleChannel* ch, const recorder::action* a, int localFrame,
 /* -------------------------------------------------------------------------- */
 
 
-void recordKeyPressAction_(SampleChannel* ch)
+void recordKeyPressAction_(SampleChannel* ch, int globalFrame)
 {
 	if (!recorderCanRec_(ch))
 		return;
@@ -156,12 +114,12 @@ void recordKeyPressAction_(SampleChannel* ch)
 	/* SINGLE_PRESS mode needs overdub. Also, disable reading actions while 
 	overdubbing. */
 	if (ch->mode == ChannelMode::SINGLE_PRESS) {
-		recorder::startOverdub(ch->index, G_ACTION_KEYS, clock::getCurrentFrame(), 
+		recorder::startOverdub(ch->index, G_ACTION_KEYS, globalFrame, 
 			kernelAudio::getRealBufSize());
 		ch->readActions = false;
 	}
 	else
-		recorder::rec(ch->index, G_ACTION_KEYPRESS, clock::getCurrentFrame());
+		recorder::rec(ch->index, G_ACTION_KEYPRESS, globalFrame);
 	ch->hasActions = true;
 }
 
@@ -169,14 +127,14 @@ void recordKeyPressAction_(SampleChannel* ch)
 /* -------------------------------------------------------------------------- */
 
 
-void quantize_(SampleChannel* ch, bool quantoPassed)
+void quantize_(SampleChannel* ch, bool quantoPassed, int globalFrame)
 {
 	/* Skip if LOOP_ANY or not in quantizer-wait mode. Otherwise the quantize wait 
 	has expired: record the keypress.  */
 
 	if (ch->isAnyLoopMode() || !ch->qWait || !quantoPassed)
 		return;
-	recordKeyPressAction_(ch);
+	recordKeyPressAction_(ch, globalFrame);
 }
 }; // {anonymous}
 
@@ -186,21 +144,21 @@ void quantize_(SampleChannel* ch, bool quantoPassed)
 /* -------------------------------------------------------------------------- */
 
 
-void parseEvents(SampleChannel* ch, mixer::FrameEvents fe)
+void parseEvents(SampleChannel* ch, const mixer::FrameEvents& fe)
 {
-	quantize_(ch, fe.quantoPassed);
+	quantize_(ch, fe.quantoPassed, fe.frameGlobal);
 	if (fe.onFirstBeat)
 		onFirstBeat_(ch, conf::recsStopOnChanHalt);
-	for (const recorder::action* action : fe.actions)
-		if (action->chan == ch->index)
-			parseAction_(ch, action, fe.frameLocal, fe.frameGlobal);
+	for (const recorder::action& action : fe.actions)
+		if (action.chan == ch->index)
+			parseAction_(ch, &action, fe.frameLocal);
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-bool recordStart(SampleChannel* ch, bool canQuantize)
+bool recordStart(SampleChannel* ch, bool canQuantize, int localFrame)
 {
 	/* Record a 'start' event if the quantizer is off, otherwise let mixer to 
 	handle it when a quantoWait has passed (see quantize_()). Also skip if 
@@ -208,7 +166,7 @@ bool recordStart(SampleChannel* ch, bool canQuantize)
 
 	if (!canQuantize && !ch->isAnyLoopMode() && recorderCanRec_(ch))
 	{
-		recordKeyPressAction_(ch);
+		recordKeyPressAction_(ch, clock::getFrameAt(localFrame));
 
 		/* Why return here? You record an action and then you call ch->start: 
 		Mixer, which is on another thread, reads your newly recorded action if you 
@@ -228,11 +186,11 @@ bool recordStart(SampleChannel* ch, bool canQuantize)
 /* -------------------------------------------------------------------------- */
 
 
-bool recordKill(SampleChannel* ch)
+bool recordKill(SampleChannel* ch, int localFrame)
 {
 	/* Don't record G_ACTION_KILL actions for LOOP channels. */
 	if (recorderCanRec_(ch) && !ch->isAnyLoopMode()) {
-		recorder::rec(ch->index, G_ACTION_KILL, clock::getCurrentFrame());
+		recorder::rec(ch->index, G_ACTION_KILL, clock::getFrameAt(localFrame));
 		ch->hasActions = true;
 	}
 	return true;
@@ -247,8 +205,7 @@ void recordStop(SampleChannel* ch)
 	/* Record a stop event only if channel is SINGLE_PRESS. For any other mode 
 	the stop event is meaningless. */
 	if (recorderCanRec_(ch) && ch->mode == ChannelMode::SINGLE_PRESS) {
-		recorder::stopOverdub(clock::getCurrentFrame(), clock::getFramesInLoop(),
-			&mixer::mutex);
+		recorder::stopOverdub(clock::getCurrentFrame(), clock::getFramesInLoop());
 	}
 }
 
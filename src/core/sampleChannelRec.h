@@ -36,19 +36,19 @@ namespace giada {
 namespace m {
 namespace sampleChannelRec
 {
-void parseEvents(SampleChannel* ch, mixer::FrameEvents fe);
+void parseEvents(SampleChannel* ch, const mixer::FrameEvents& fe);
 
 /* recordStart
-Records a G_ACTION_KEYPRESS if capable of. Returns true if a start() call can
-be performed. */
+Records a G_ACTION_KEYPRESS if capable of, on frame 'localFrame' of the current
+block. Returns true if a start() call can be performed. */
 
-bool recordStart(SampleChannel* ch, bool doQuantize);
+bool recordStart(SampleChannel* ch, bool doQuantize, int localFrame);
 
 /* recordKill
-Records a G_ACTION_KILL if capable of. Returns true if a kill() call can
-be performed. */
+Records a G_ACTION_KILL if capable of, on frame 'localFrame' of the current
+block. Returns true if a kill() call can be performed. */
 
-bool recordKill(SampleChannel* ch);
+bool recordKill(SampleChannel* ch, int localFrame);
 
 /* recordStop
 Ends overdub mode SINGLE_PRESS channels. */
@@ -0,0 +1,130 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../utils/log.h"
+#include "waveStream.h"
+#include "streamer.h"
+
+
+namespace giada {
+namespace m {
+namespace streamer
+{
+namespace
+{
+constexpr std::chrono::milliseconds POLL_INTERVAL(5);
+
+std::thread              thread;
+std::atomic<bool>        running(false);
+std::mutex               mutex;
+std::condition_variable  cond;
+std::vector<WaveStream*> streams;
+
+
+/* -------------------------------------------------------------------------- */
+
+/* loop_
+Serves all streams until there's nothing left to do, then sleeps until woken 
+up or the poll interval expires. Requests from the audio thread are picked up 
+this way. */
+
+void loop_()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (running) {
+		bool busy = false;
+		for (WaveStream* s : streams)
+			busy = s->service() || busy;
+		if (!busy)
+			cond.wait_for(lock, POLL_INTERVAL);
+	}
+}
+}; // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+void init()
+{
+	if (running)
+		return;
+	running = true;
+	thread  = std::thread(loop_);
+	gu_log("[streamer::init] disk thread started\n");
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void close()
+{
+	if (!running)
+		return;
+	running = false;
+	cond.notify_one();
+	thread.join();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void add(WaveStream* s)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	streams.push_back(s);
+	cond.notify_one();
+}
+
+
+void remove(WaveStream* s)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	streams.erase(std::remove(streams.begin(), streams.end(), s), streams.end());
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void wake()
+{
+	cond.notify_one();
+}
+}}}; // giada::m::streamer::
@@ -0,0 +1,61 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#ifndef G_STREAMER_H
+#define G_STREAMER_H
+
+
+namespace giada {
+namespace m 
+{
+class WaveStream;
+
+namespace streamer
+{
+/* init
+Starts the disk thread that feeds all WaveStream objects. */
+
+void init();
+void close();
+
+/* add, remove
+Registers/unregisters a stream. WaveStream does it on its own on construction
+and destruction. remove() waits for the disk thread to be done with it. */
+
+void add(WaveStream* s);
+void remove(WaveStream* s);
+
+/* wake
+Tells the disk thread there's work to do. The thread polls the streams anyway, 
+so this is not needed (nor allowed) on the audio thread. */
+
+void wake();
+}}}; // giada::m::streamer::
+
+
+#endif
@@ -54,6 +54,17 @@ enum class ChannelMode : int
 };
 
 
+/* Interpolation
+How a sample channel resamples when pitched: through libsamplerate, with the
+converter set in the configuration, or with the built-in resampler (see 
+m::Resampler), from the fastest to the cleanest. */
+
+enum class Interpolation : int
+{
+	LIBSAMPLERATE = 0, LINEAR, HERMITE, SINC_8, SINC_16, SINC_32
+};
+
+
 enum class PreviewMode : int { NONE = 0, NORMAL, LOOP };
 enum class EventType : int { AUTO = 0, MANUAL };
 };
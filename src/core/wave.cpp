@@ -31,6 +31,10 @@
 #include "../utils/log.h"
 #include "../utils/string.h"
 #include "const.h"
+#include "waveStream.h"
+#include "nativeBuffer.h"
+#include "rope.h"
+#include "peaks.h"
 #include "wave.h"
 
 
@@ -38,7 +42,10 @@ using std::string;
 
 
 Wave::Wave()
-: m_rate   (0),
+: m_buffer (std::make_shared<giada::m::AudioBuffer>()),
+  m_shared (false),
+  m_peaks  (std::make_shared<giada::m::PeakSlot>()),
+  m_rate   (0),
   m_bits   (0),
   m_logical(false),
   m_edited (false) 
@@ -49,9 +56,18 @@ Wave::Wave()
 /* -------------------------------------------------------------------------- */
 
 
-float* Wave::operator [](int offset) const
+const float* Wave::operator [](int offset) const
 {
-	return buffer[offset];
+	assert(isDirect());
+	return (*m_buffer)[offset];
+}
+
+
+float* Wave::operator [](int offset)
+{
+	assert(isDirect());
+	detach_();
+	return (*m_buffer)[offset];
 }
 
 
@@ -59,14 +75,39 @@ float* Wave::operator [](int offset) const
 
 
 Wave::Wave(const Wave& other)
-:	m_rate    (other.m_rate),
+:	m_buffer  (other.m_buffer),  // shared until one of the two changes
+	m_shared  (true),
+	m_peaks   (std::make_shared<giada::m::PeakSlot>()),
+	m_rate    (other.m_rate),
 	m_bits    (other.m_bits),	
 	m_logical (true),   // a cloned wave does not exist on disk
 	m_edited  (false),
 	m_path    (other.m_path)
 {
-	buffer.alloc(other.getSize(), other.getChannels());
-	buffer.copyData(other.getFrame(0), other.getSize(), other.getChannels());
+	/* A streamed wave is cloned by streaming the same file again. */
+
+	if (other.isStreamed()) {
+		m_stream.reset(new giada::m::WaveStream(other.m_stream->getPath()));
+		m_logical = other.m_logical;
+	}
+
+	/* Native data and pieces never change: just share them. */
+
+	if (other.isNative()) {
+		m_native  = other.m_native;
+		m_logical = other.m_logical;
+	}
+	m_rope = other.m_rope;
+
+	m_peaks->peaks = other.getPeaks();  // same data, same peaks
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Wave::~Wave()
+{
 }
 
 
@@ -75,7 +116,12 @@ Wave::Wave(const Wave& other)
 
 void Wave::alloc(int size, int channels, int rate, int bits, const std::string& path)
 {
-	buffer.alloc(size, channels);
+	m_buffer = std::make_shared<giada::m::AudioBuffer>();
+	m_shared = false;
+	m_native.reset();
+	m_rope.reset();
+	m_buffer->alloc(size, channels);
+	resetPeaks_();
 	m_rate = rate;
 	m_bits = bits;
 	m_path = path;
@@ -95,12 +141,67 @@ string Wave::getBasename(bool ext) const
 
 
 int Wave::getRate() const { return m_rate; }
-int Wave::getChannels() const { return buffer.countChannels(); }
+int Wave::getChannels() const 
+{ 
+	if (isChunked()) return m_rope->countChannels();
+	return isDirect() ? m_buffer->countChannels() : G_MAX_IO_CHANS; 
+}
 std::string Wave::getPath() const { return m_path; }
-int Wave::getSize() const { return buffer.countFrames(); }
+int Wave::getSize() const 
+{ 
+	if (isStreamed()) return m_stream->getSize();
+	if (isNative())   return m_native->countFrames();
+	if (isChunked())  return m_rope->countFrames();
+	return m_buffer->countFrames(); 
+}
 int Wave::getBits() const { return m_bits; }
 bool Wave::isLogical() const { return m_logical; }
 bool Wave::isEdited() const { return m_edited; }
+bool Wave::isStreamed() const { return m_stream != nullptr; }
+const giada::m::WaveStream* Wave::getStream() const { return m_stream.get(); }
+bool Wave::isNative() const { return m_native != nullptr; }
+std::shared_ptr<const giada::m::NativeBuffer> Wave::getNative() const { return m_native; }
+bool Wave::isChunked() const { return m_rope != nullptr; }
+std::shared_ptr<const giada::m::Rope> Wave::getRope() const { return m_rope; }
+bool Wave::isDirect() const { return !isStreamed() && !isNative() && !isChunked(); }
+
+
+/* -------------------------------------------------------------------------- */
+
+
+size_t Wave::getMemory() const
+{
+	if (isStreamed()) return m_stream->getMemory();
+	if (isNative())   return m_native->getBytes();
+	if (isChunked())  return m_rope->getMemory();
+	return m_buffer->countSamples() * sizeof(float);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+std::shared_ptr<const giada::m::AudioBuffer> Wave::getBuffer() const
+{
+	assert(isDirect());
+	return m_buffer;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+std::shared_ptr<const giada::m::Peaks> Wave::getPeaks() const
+{
+	std::lock_guard<std::mutex> lock(m_peaks->mutex);
+	return m_peaks->peaks;
+}
+
+
+std::shared_ptr<giada::m::PeakSlot> Wave::getPeakSlot() const
+{
+	return m_peaks;
+}
 
 
 /* -------------------------------------------------------------------------- */
@@ -108,7 +209,7 @@ bool Wave::isEdited() const { return m_edited; }
 
 int Wave::getDuration() const
 {
-	return buffer.countFrames() / m_rate;
+	return getSize() / m_rate;
 }
 
 
@@ -124,9 +225,18 @@ std::string Wave::getExtension() const
 /* -------------------------------------------------------------------------- */
 
 
-float* Wave::getFrame(int f) const
+const float* Wave::getFrame(int f) const
 {
-	return buffer[f];
+	assert(isDirect());
+	return (*m_buffer)[f];
+}
+
+
+float* Wave::getFrame(int f)
+{
+	assert(isDirect());
+	detach_();
+	return (*m_buffer)[f];
 }
 
 
@@ -153,9 +263,10 @@ void Wave::setPath(const string& p, int id)
 /* -------------------------------------------------------------------------- */
 
 
-void Wave::copyData(float* data, int frames, int offset)
+void Wave::copyData(const float* data, int frames, int offset)
 {
-	buffer.copyData(data, frames, offset);
+	detach_();
+	m_buffer->copyData(data, frames, offset);
 }
 
 
@@ -164,5 +275,160 @@ void Wave::copyData(float* data, int frames, int offset)
 
 void Wave::moveData(giada::m::AudioBuffer& b)
 {
-	buffer.moveData(b);
-}
\ No newline at end of file
+	/* Brand new data: no need to copy the old one, just stop sharing it. */
+
+	m_buffer = std::make_shared<giada::m::AudioBuffer>();
+	m_shared = false;
+	m_native.reset();
+	m_rope.reset();
+	m_buffer->moveData(b);
+	resetPeaks_();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Wave::setStream(std::unique_ptr<giada::m::WaveStream> s, int bits)
+{
+	m_buffer = std::make_shared<giada::m::AudioBuffer>();
+	m_shared = false;
+	m_native.reset();
+	m_rope.reset();
+	m_stream = std::move(s);
+	resetPeaks_();
+	m_rate   = m_stream->getRate();
+	m_bits   = bits;
+	m_path   = m_stream->getPath();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Wave::setNative(std::shared_ptr<const giada::m::NativeBuffer> n, int rate, 
+	int bits)
+{
+	m_buffer = std::make_shared<giada::m::AudioBuffer>();
+	m_shared = false;
+	m_stream.reset();
+	m_rope.reset();
+	m_native = n;
+	resetPeaks_();
+	m_rate   = rate;
+	m_bits   = bits;
+	m_path   = n->getPath();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Wave::read(giada::m::AudioBuffer& dest, int start, int frames, int offset)
+{
+	if (isStreamed())
+		m_stream->read(dest, start, frames, offset);
+	else
+	if (isNative())
+		m_native->read(dest, start, frames, offset);
+	else
+	if (isChunked())
+		m_rope->read(dest, start, frames, offset);
+	else
+		dest.copyData((*m_buffer)[start], frames, offset);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Wave::setRope(std::shared_ptr<const giada::m::Rope> r)
+{
+	m_buffer = std::make_shared<giada::m::AudioBuffer>();
+	m_shared = false;
+	m_stream.reset();
+	m_native.reset();
+	m_rope = r;
+	resetPeaks_();
+}
+
+
+void Wave::makeChunked()
+{
+	if (!isDirect())
+		return;
+	m_rope   = std::make_shared<giada::m::Rope>(m_buffer);
+	m_buffer = std::make_shared<giada::m::AudioBuffer>();
+	m_shared = false;
+}
+
+
+void Wave::replaceData(int a, giada::m::AudioBuffer& b)
+{
+	assert(isChunked());
+	std::shared_ptr<giada::m::AudioBuffer> data = std::make_shared<giada::m::AudioBuffer>();
+	data->moveData(b);
+	m_rope = std::make_shared<giada::m::Rope>(m_rope->replace(a, data));
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Wave::prefetch(int start)
+{
+	if (isStreamed())
+		m_stream->prefetch(start);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+std::shared_ptr<giada::m::AudioBuffer> Wave::shareData()
+{
+	m_shared = true;
+	return m_buffer;
+}
+
+
+void Wave::setSharedData(std::shared_ptr<giada::m::AudioBuffer> data, int rate, 
+	int bits, const std::string& path)
+{
+	m_buffer = data;
+	m_shared = true;
+	m_native.reset();
+	m_rope.reset();
+	resetPeaks_();
+	m_rate   = rate;
+	m_bits   = bits;
+	m_path   = path;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Wave::detach_()
+{
+	if (!m_shared && m_buffer.use_count() == 1)
+		return;
+	std::shared_ptr<giada::m::AudioBuffer> copy = std::make_shared<giada::m::AudioBuffer>();
+	copy->alloc(m_buffer->countFrames(), m_buffer->countChannels());
+	if (m_buffer->countFrames() > 0)
+		copy->copyData((*m_buffer)[0], m_buffer->countFrames());
+	m_buffer = copy;
+	m_shared = false;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void Wave::resetPeaks_()
+{
+	std::lock_guard<std::mutex> lock(m_peaks->mutex);
+	m_peaks->peaks.reset();
+	m_peaks->version++;
+	m_peaks->pending = false;
+}
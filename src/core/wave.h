@@ -30,24 +30,45 @@
 
 
 #include <sndfile.h>
+#include <memory>
 #include <string>
 #include "const.h"
 #include "audioBuffer.h"
 
 
+namespace giada {
+namespace m 
+{
+class WaveStream;
+class NativeBuffer;
+class Rope;
+class Peaks;
+struct PeakSlot;
+}}
+
+
 class Wave
 {
 public:
 
 	Wave();
 	Wave(const Wave& other);
+	~Wave();
 
-	float* operator [](int offset) const;
+	/* operator []
+	Direct access to data. Not available for streamed and native waves (see 
+	isDirect), use read() if you need to deal with all of them. Data might be shared with other waves: non-const 
+	access makes a private copy first (copy-on-write), so read through a const
+	Wave whenever possible. */
+
+	const float* operator [](int offset) const;
+	float* operator [](int offset);
 
 	/* getFrame
 	Works like operator []. See AudioBuffer for reference. */
 	
-	float* getFrame(int f) const;
+	const float* getFrame(int f) const;
+	float* getFrame(int f);
 	
 	std::string getBasename(bool ext=false) const;
 	std::string getExtension() const;
@@ -60,6 +81,51 @@ public:
 	bool isLogical() const;
 	bool isEdited() const;
 
+	/* isStreamed
+	True if data is played from disk instead of being held in memory. */
+
+	bool isStreamed() const;
+	const giada::m::WaveStream* getStream() const;
+
+	/* isNative
+	True if data is held in memory in its original format (see NativeBuffer). */
+
+	bool isNative() const;
+	std::shared_ptr<const giada::m::NativeBuffer> getNative() const;
+
+	/* isChunked
+	True if data is held in memory as float, split in pieces shared with other 
+	waves (see Rope). Waves become chunked when edited in the sample editor. */
+
+	bool isChunked() const;
+	std::shared_ptr<const giada::m::Rope> getRope() const;
+
+	/* isDirect
+	True if data is held in memory as float in one block, i.e. operator [] and
+	getFrame() are available. Streamed, native and chunked waves must be read 
+	through read(). */
+
+	bool isDirect() const;
+
+	/* getMemory
+	Returns how much memory data takes, in bytes. */
+
+	size_t getMemory() const;
+
+	/* getBuffer
+	Returns data for reading on another thread, e.g. by peakBuilder. Writing to
+	this wave makes a private copy while the returned pointer is alive. Direct
+	waves only. */
+
+	std::shared_ptr<const giada::m::AudioBuffer> getBuffer() const;
+
+	/* getPeaks
+	Returns the waveform overview, or nullptr if not built yet (see 
+	peakBuilder). Peaks are dropped when data is replaced. */
+
+	std::shared_ptr<const giada::m::Peaks> getPeaks() const;
+	std::shared_ptr<giada::m::PeakSlot> getPeakSlot() const;
+
 	/* setPath
 	Sets new path 'p'. If 'id' != -1 inserts a numeric id next to the file 
 	extension, e.g. : /path/to/sample-[id].wav */
@@ -80,13 +146,81 @@ public:
 	'offset'. It takes for granted that the new data contains the same number of 
 	channels than m_channels. */
 
-	void copyData(float* data, int frames, int offset=0);
+	void copyData(const float* data, int frames, int offset=0);
 
 	void alloc(int size, int channels, int rate, int bits, const std::string& path);
 
+	/* shareData
+	Returns data for sharing with other waves (see wavePool). From now on data
+	is read-only: any change happens on a private copy. */
+
+	std::shared_ptr<giada::m::AudioBuffer> shareData();
+
+	/* setSharedData
+	Uses 'data' shared by another wave, read-only. */
+
+	void setSharedData(std::shared_ptr<giada::m::AudioBuffer> data, int rate, 
+		int bits, const std::string& path);
+
+	/* setStream
+	Makes this a streamed wave, reading data from disk through 's'. */
+
+	void setStream(std::unique_ptr<giada::m::WaveStream> s, int bits);
+
+	/* setNative
+	Makes this a native wave, with data from 'n'. */
+
+	void setNative(std::shared_ptr<const giada::m::NativeBuffer> n, int rate, 
+		int bits);
+
+	/* setRope
+	Makes this a chunked wave, with data from 'r'. */
+
+	void setRope(std::shared_ptr<const giada::m::Rope> r);
+
+	/* makeChunked
+	Turns a direct wave into a chunked one made of a single piece, sharing the
+	same data. Peaks are kept. No-op for chunked waves. */
+
+	void makeChunked();
+
+	/* replaceData
+	Replaces frames starting from 'a' with data moved from 'b', in a new piece.
+	Chunked waves only. Peaks are kept: update them (see peakBuilder). */
+
+	void replaceData(int a, giada::m::AudioBuffer& b);
+
+	/* read
+	Copies 'frames' frames starting from 'start' into 'dest' at frame 'offset', 
+	converted to float if needed. Works with any wave. Audio thread only for 
+	streamed waves. */
+
+	void read(giada::m::AudioBuffer& dest, int start, int frames, int offset);
+
+	/* prefetch
+	Makes sure playback can start right away from frame 'start'. Streamed waves
+	only, no-op otherwise. */
+
+	void prefetch(int start);
+
 private:
 
-	giada::m::AudioBuffer buffer;
+	/* detach_
+	Makes data private before writing to it, if shared. */
+
+	void detach_();
+
+	/* resetPeaks_
+	Drops peaks, and any being built, when data is replaced. */
+
+	void resetPeaks_();
+
+	std::shared_ptr<giada::m::AudioBuffer> m_buffer;
+	bool m_shared;      // data might be read by others: copy before writing
+	std::unique_ptr<giada::m::WaveStream> m_stream;
+	std::shared_ptr<const giada::m::NativeBuffer> m_native;  // read-only, shared by copies
+	std::shared_ptr<const giada::m::Rope> m_rope;            // read-only, shared by copies
+	std::shared_ptr<giada::m::PeakSlot> m_peaks;
 	int m_rate;
 	int m_bits;
 	bool m_logical;     // memory only (a take)
@@ -0,0 +1,333 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#if defined(_WIN32)
+	#include <windows.h>
+	#include <sys/utime.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
+	#include <utime.h>
+#endif
+#include "../utils/log.h"
+#include "../utils/fs.h"
+#include "../utils/string.h"
+#include "const.h"
+#include "audioBuffer.h"
+#include "waveCache.h"
+
+
+using std::string;
+
+
+namespace giada {
+namespace m {
+namespace waveCache
+{
+namespace
+{
+/* Header_
+Cache files are a header followed by raw interleaved float data, in native 
+byte order: they never leave this machine. The header is 64 bytes long, so 
+that mapped data is aligned for SIMD kernels. */
+
+struct Header_
+{
+	char     magic[4];
+	uint32_t version;
+	uint32_t channels;
+	uint32_t frames;
+	char     padding[48];
+};
+
+static_assert(sizeof(Header_) == 64, "Header_ must be 64 bytes long");
+
+constexpr char     MAGIC[4] = {'G', 'W', 'C', 'F'};
+constexpr uint32_t VERSION  = 1;
+
+string     dir;
+long long  maxBytes = 0;
+std::mutex mutex;
+std::atomic<int> tmpCount(0);
+
+
+/* -------------------------------------------------------------------------- */
+
+/* makePath_
+File name is the FNV-1a hash of the key. */
+
+string makePath_(const string& key)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (unsigned char c : key) {
+		hash ^= c;
+		hash *= 1099511628211ULL;
+	}
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.gwc", static_cast<unsigned long long>(hash));
+	return dir + G_SLASH + name;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* map_, unmap_
+Map a whole file in memory, copy-on-write: stray writes never reach the 
+disk. */
+
+void* map_(const string& path, size_t& size)
+{
+#if defined(_WIN32)
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, 
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+	LARGE_INTEGER s;
+	HANDLE mapping = nullptr;
+	if (GetFileSizeEx(file, &s) && s.QuadPart > 0)
+		mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (mapping == nullptr)
+		return nullptr;
+	void* addr = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	CloseHandle(mapping);  // the view keeps it alive
+	size = s.QuadPart;
+	return addr;
+
+#else
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return nullptr;
+	struct stat st;
+	void* addr = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+		addr = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);  // the mapping keeps it alive
+	if (addr == MAP_FAILED)
+		return nullptr;
+	size = st.st_size;
+	return addr;
+
+#endif
+}
+
+
+void unmap_(void* addr, size_t size)
+{
+#if defined(_WIN32)
+	UnmapViewOfFile(addr);
+#else
+	munmap(addr, size);
+#endif
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* touch_
+Marks a file as recently used, so that prune_() keeps it longer. */
+
+void touch_(const string& path)
+{
+#if defined(_WIN32)
+	_utime(path.c_str(), nullptr);
+#else
+	utime(path.c_str(), nullptr);
+#endif
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* prune_
+Removes the least recently used files until the cache fits in maxBytes. */
+
+void prune_()
+{
+	struct Entry
+	{
+		string    path;
+		long long size;
+		time_t    mtime;
+	};
+
+	std::vector<Entry> entries;
+	long long total = 0;
+
+	DIR* dp = opendir(dir.c_str());
+	if (dp == nullptr)
+		return;
+	dirent* ep;
+	while ((ep = readdir(dp)) != nullptr) {
+		string path = dir + G_SLASH + ep->d_name;
+		struct stat st;
+		if (gu_getExt(path) != "gwc" || stat(path.c_str(), &st) != 0)
+			continue;
+		entries.push_back({path, static_cast<long long>(st.st_size), st.st_mtime});
+		total += st.st_size;
+	}
+	closedir(dp);
+
+	if (total <= maxBytes)
+		return;
+
+	std::sort(entries.begin(), entries.end(), [] (const Entry& a, const Entry& b) {
+		return a.mtime < b.mtime;
+	});
+	for (const Entry& e : entries) {
+		if (total <= maxBytes)
+			break;
+		if (std::remove(e.path.c_str()) == 0)
+			total -= e.size;
+	}
+	gu_log("[waveCache::prune_] cache pruned, %lld bytes left\n", total);
+}
+}; // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+void init(const string& path, int maxSize)
+{
+	dir      = path;
+	maxBytes = maxSize * 1024LL * 1024LL;
+
+	if (maxBytes > 0 && !gu_dirExists(dir) && !gu_mkdir(dir)) {
+		gu_log("[waveCache::init] unable to create %s, cache disabled\n", dir.c_str());
+		maxBytes = 0;
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+std::shared_ptr<AudioBuffer> get(const string& key)
+{
+	if (maxBytes == 0 || key.empty())
+		return nullptr;
+
+	string path = makePath_(key);
+	size_t size = 0;
+	void*  addr = map_(path, size);
+	if (addr == nullptr)
+		return nullptr;
+
+	const Header_* h = static_cast<const Header_*>(addr);
+	if (size < sizeof(Header_) || 
+	    memcmp(h->magic, MAGIC, sizeof(MAGIC)) != 0 || 
+	    h->version != VERSION ||
+	    size != sizeof(Header_) + static_cast<size_t>(h->frames) * h->channels * sizeof(float)) {
+		gu_log("[waveCache::get] invalid file %s\n", path.c_str());
+		unmap_(addr, size);
+		return nullptr;
+	}
+
+	/* The buffer borrows mapped memory: unmap it, not delete it, when the last
+	user goes away. */
+
+	float* data = reinterpret_cast<float*>(static_cast<char*>(addr) + sizeof(Header_));
+	AudioBuffer* buf = new AudioBuffer();
+	buf->setData(data, h->frames, h->channels);
+
+	touch_(path);
+
+	return std::shared_ptr<AudioBuffer>(buf, [addr, size] (AudioBuffer* b) {
+		b->setData(nullptr, 0, 0);
+		delete b;
+		unmap_(addr, size);
+	});
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void put(const string& key, const AudioBuffer& data)
+{
+	if (maxBytes == 0 || key.empty() || !data.isAllocd())
+		return;
+
+	long long bytes = sizeof(Header_) + data.countSamples() * sizeof(float);
+	if (bytes > maxBytes)
+		return;
+
+	/* Write to a temporary file first, then move it in place: readers never see
+	half-written files. */
+
+	string path = makePath_(key);
+	string tmp  = path + "." + gu_iToString(tmpCount++) + ".tmp";
+
+	Header_ h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, MAGIC, sizeof(MAGIC));
+	h.version  = VERSION;
+	h.channels = data.countChannels();
+	h.frames   = data.countFrames();
+
+	FILE* f = fopen(tmp.c_str(), "wb");
+	if (f == nullptr) {
+		gu_log("[waveCache::put] unable to write %s\n", tmp.c_str());
+		return;
+	}
+	bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+	          fwrite(data[0], sizeof(float), data.countSamples(), f) == 
+	            static_cast<size_t>(data.countSamples());
+	ok = fclose(f) == 0 && ok;
+
+#if defined(_WIN32)
+	std::remove(path.c_str());  // rename() doesn't overwrite on Windows
+#endif
+
+	if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+		gu_log("[waveCache::put] unable to write %s\n", path.c_str());
+		std::remove(tmp.c_str());
+		return;
+	}
+
+	gu_log("[waveCache::put] %s cached, %lld bytes\n", path.c_str(), bytes);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	prune_();
+}
+}}}; // giada::m::waveCache::
@@ -0,0 +1,65 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#ifndef G_WAVE_CACHE_H
+#define G_WAVE_CACHE_H
+
+
+#include <memory>
+#include <string>
+
+
+namespace giada {
+namespace m 
+{
+class AudioBuffer;
+
+namespace waveCache
+{
+/* init
+Sets the folder where decoded samples are kept and how much disk space they can
+take, in MB. The oldest ones are removed when full. A size of 0 disables the
+cache. */
+
+void init(const std::string& path, int maxSize);
+
+/* get
+Returns the data cached under 'key', memory-mapped from disk, or nullptr if 
+missing. Data is read-only: Wave copies it before writing (see 
+Wave::setSharedData). */
+
+std::shared_ptr<AudioBuffer> get(const std::string& key);
+
+/* put
+Stores 'data' under 'key' for the next time. Thread safe, like get(). */
+
+void put(const std::string& key, const AudioBuffer& data);
+}}}; // giada::m::waveCache::
+
+
+#endif
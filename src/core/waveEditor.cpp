@@ -0,0 +1,137 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <thread>
+#include "../utils/log.h"
+#include "const.h"
+#include "wave.h"
+#include "waveEditor.h"
+
+
+namespace giada {
+namespace m {
+namespace waveEditor
+{
+namespace
+{
+std::thread           thread;
+std::unique_ptr<Wave> wave;
+wfx::Task             task;
+std::atomic<bool>     running(false);
+int                   result = G_RES_ERR;
+}; // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+bool start(const Wave& w, Op op)
+{
+	if (thread.joinable()) {
+		gu_log("[waveEditor::start] another job is in progress\n");
+		return false;
+	}
+	assert(w.isDirect() || w.isChunked());
+
+	/* A copy is flagged as logical and not edited: keep the original state. 
+	Edit it as a chunked wave, so that only the frames touched take new memory
+	and 'w' can be kept as it is for undo. */
+
+	wave.reset(new Wave(w));
+	wave->setLogical(w.isLogical());
+	wave->setEdited(w.isEdited());
+	wave->makeChunked();
+
+	task.progress  = 0.0f;
+	task.cancelled = false;
+	running        = true;
+
+	thread = std::thread([op]
+	{
+		result  = op(*wave, task);
+		running = false;
+	});
+	return true;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool isBusy()
+{
+	return running;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+float getProgress()
+{
+	return task.progress;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void cancel()
+{
+	task.cancelled = true;
+}
+
+
+bool isCancelled()
+{
+	return task.cancelled;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Wave* finish()
+{
+	if (!thread.joinable())
+		return nullptr;
+	thread.join();
+
+	if (task.cancelled || result != G_RES_OK) {
+		gu_log("[waveEditor::finish] job %s\n", task.cancelled ? "cancelled" : "failed");
+		wave.reset();
+		return nullptr;
+	}
+	return wave.release();
+}
+}}}; // giada::m::waveEditor::
@@ -0,0 +1,84 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#ifndef G_WAVE_EDITOR_H
+#define G_WAVE_EDITOR_H
+
+
+#include <functional>
+#include "waveFx.h"
+
+
+class Wave;
+
+
+namespace giada {
+namespace m {
+namespace waveEditor
+{
+/* Op
+An editing operation (see wfx) applied to 'w'. Returns G_RES_OK on success. */
+
+typedef std::function<int(Wave& w, wfx::Task& t)> Op;
+
+/* start
+Runs 'op' on a background thread, on a chunked copy of Wave 'w' that shares 
+its data (see Rope): 'w' stays untouched and can keep playing. One job at a 
+time: returns false if another one is still in progress. */
+
+bool start(const Wave& w, Op op);
+
+/* isBusy
+True while the job is running. */
+
+bool isBusy();
+
+/* getProgress
+Returns how much of the job is done, from 0.0 to 1.0. */
+
+float getProgress();
+
+/* cancel
+Asks the job to stop as soon as possible. Its result will be discarded. */
+
+void cancel();
+
+/* isCancelled
+True if the last job has been cancelled, as opposed to failed. */
+
+bool isCancelled();
+
+/* finish
+Waits for the job to end and returns the edited Wave, owned by the caller from
+now on, or nullptr if the operation failed or has been cancelled. */
+
+Wave* finish();
+}}}; // giada::m::waveEditor::
+
+
+#endif
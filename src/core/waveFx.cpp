@@ -28,7 +28,13 @@
 #include <cmath>
 #include <cassert>
 #include <algorithm>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
 #include "../utils/log.h"
+#include "dsp.h"
+#include "rope.h"
 #include "wave.h"
 #include "waveFx.h"
 
@@ -39,27 +45,127 @@ namespace wfx
 {
 namespace
 {
-void fadeFrame(Wave& w, int i, float val)
+/* forEachChunk_
+Calls 'fn(first, last)' on chunks of frames [a, b), spread over all the cores.
+Task 't', if any, goes from 'from' to 'to' as chunks are done; chunks not 
+started yet are skipped once it has been cancelled. */
+
+void forEachChunk_(int a, int b, Task* t, std::function<void(int, int)> fn,
+	float from=0.0f, float to=1.0f)
 {
-	for (int j=0; j<w.getChannels(); j++)
-		w[i][j] *= val;
+	int chunks = (b - a + CHUNK_FRAMES - 1) / CHUNK_FRAMES;
+	if (chunks <= 0)
+		return;
+
+	std::atomic<int> next(0);
+	std::atomic<int> done(0);
+
+	auto work = [&]
+	{
+		int i;
+		while ((i = next++) < chunks) {
+			if (t != nullptr && t->cancelled)
+				return;
+			int first = a + i * CHUNK_FRAMES;
+			fn(first, std::min(first + CHUNK_FRAMES, b));
+			if (t == nullptr)
+				continue;
+			/* Threads may finish out of order: never move the progress back. */
+			float p   = from + (to - from) * (++done / (float) chunks);
+			float old = t->progress;
+			while (old < p && !t->progress.compare_exchange_weak(old, p));
+		}
+	};
+
+	int count = std::min<int>(std::max(1u, std::thread::hardware_concurrency()), 
+		chunks);
+	std::vector<std::thread> threads;
+	for (int i=1; i<count; i++)
+		threads.push_back(std::thread(work));
+	work();
+	for (std::thread& th : threads)
+		th.join();
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-float getPeak(const Wave& w, int a, int b)
+bool isCancelled_(const Task* t)
 {
-	float peak = 0.0f;
-	float abs  = 0.0f;
-	for (int i=a; i<b; i++) {
-		for (int j=0; j<w.getChannels(); j++) // Find highest value in any channel
-			abs = fabs(w[i][j]);
-		if (abs > peak)
-			peak = abs;
-	}
-	return peak;
+	return t != nullptr && t->cancelled;
+}
+
+
+void setDone_(Task* t)
+{
+	if (t != nullptr)
+		t->progress = 1.0f;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* toRope_
+Returns data of Wave 'w' as a Rope, for editing. Direct waves become chunked 
+first. */
+
+std::shared_ptr<const Rope> toRope_(Wave& w)
+{
+	w.makeChunked();
+	return w.getRope();
+}
+
+
+/* ropeOf_
+As above, for a Wave that must not change. Data is shared, not copied. */
+
+Rope ropeOf_(const Wave& w)
+{
+	return w.isChunked() ? *w.getRope() : Rope(w.getBuffer());
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* beginEdit_, endEdit_
+Give write access to frames [a, b) of Wave 'w' as a contiguous block. Direct 
+waves are changed in place. For chunked ones the range is copied to 'region', 
+which then goes back in as a new piece: the rest of the data stays shared with
+previous versions. */
+
+float* beginEdit_(Wave& w, int a, int b, AudioBuffer& region)
+{
+	if (!w.isChunked())
+		return w.getFrame(a);
+	region.alloc(b - a, w.getChannels());
+	w.getRope()->read(region, a, b - a, 0);
+	return region[0];
+}
+
+
+void endEdit_(Wave& w, int a, AudioBuffer& region, const Task* t)
+{
+	if (w.isChunked() && !isCancelled_(t))
+		w.replaceData(a, region);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+float peakOf_(const float* data, int frames, int chans, Task* t, 
+	float from=0.0f, float to=1.0f)
+{
+	std::vector<float> peaks((frames + CHUNK_FRAMES - 1) / CHUNK_FRAMES, 0.0f);
+	forEachChunk_(0, frames, t, [&](int first, int last)
+	{
+		peaks[first / CHUNK_FRAMES] = dsp::peak(data + first * chans, 
+			(last - first) * chans);
+	}, from, to);
+	return peaks.empty() ? 0.0f : *std::max_element(peaks.begin(), peaks.end());
 }
 }; // {anonymous}
 
@@ -71,7 +177,16 @@ float getPeak(const Wave& w, int a, int b)
 
 float normalizeSoft(const Wave& w)
 {
-	float peak = getPeak(w, 0, w.getSize());
+	float peak = 0.0f;
+	if (w.isChunked()) {
+		for (int i=0, n=0; i<w.getSize(); i+=n) {
+			const float* data = w.getRope()->getSpan(i, &n);
+			peak = std::max(peak, peakOf_(data, n, w.getChannels(), nullptr));
+		}
+	}
+	else
+	if (w.getSize() > 0)
+		peak = peakOf_(w.getFrame(0), w.getSize(), w.getChannels(), nullptr);
 
 	/* peak == 0.0f: don't normalize the silence
 	 * peak > 1.0f: don't reduce the amplitude, just leave it alone */
@@ -86,16 +201,25 @@ float normalizeSoft(const Wave& w)
 /* -------------------------------------------------------------------------- */
 
 
-void normalizeHard(Wave& w, int a, int b)
+void normalizeHard(Wave& w, int a, int b, Task* t)
 {
-	float peak = getPeak(w, a, b);
-	if (peak == 0.0f || peak > 1.0f)  // as in ::normalizeSoft
+	if (b <= a)
 		return;
 
-	for (int i=a; i<b; i++) {
-		for (int j=0; j<w.getChannels(); j++)
-			w[i][j] = w[i][j] * (1.0f / peak);
-	}
+	AudioBuffer region;
+	float* data  = beginEdit_(w, a, b, region);
+	int    chans = w.getChannels();
+
+	float peak = peakOf_(data, b - a, chans, t, 0.0f, 0.5f);
+	if (peak == 0.0f || peak > 1.0f || isCancelled_(t))  // as in ::normalizeSoft
+		return;
+
+	forEachChunk_(0, b - a, t, [=](int first, int last)
+	{
+		dsp::scale(data + first * chans, (last - first) * chans, 1.0f / peak);
+	}, 0.5f, 1.0f);
+
+	endEdit_(w, a, region, t);
 	w.setEdited(true);
 }
 
@@ -108,12 +232,14 @@ int monoToStereo(Wave& w)
 	if (w.getChannels() >= G_MAX_IO_CHANS)
 		return G_RES_OK;
 
+	const Wave& src = w;  // read-only access, no copy-on-write
+
 	AudioBuffer newData;
 	newData.alloc(w.getSize(), G_MAX_IO_CHANS);
 
 	for (int i=0; i<newData.countFrames(); i++)
 		for (int j=0; j<newData.countChannels(); j++)
-			newData[i][j] = w[i][0];
+			newData[i][j] = src[i][0];
 
 	w.moveData(newData);
 
@@ -124,15 +250,22 @@ int monoToStereo(Wave& w)
 /* -------------------------------------------------------------------------- */
 
 
-void silence(Wave& w, int a, int b)
+void silence(Wave& w, int a, int b, Task* t)
 {
 	gu_log("[wfx::silence] silencing from %d to %d\n", a, b);
 
-	for (int i=a; i<b; i++) {
-		for (int j=0; j<w.getChannels(); j++)	
-			w[i][j] = 0.0f;
-	}
+	if (b <= a)
+		return;
 
+	AudioBuffer region;
+	float* data  = beginEdit_(w, a, b, region);
+	int    chans = w.getChannels();
+	forEachChunk_(0, b - a, t, [=](int first, int last)
+	{
+		std::fill(data + first * chans, data + last * chans, 0.0f);
+	});
+
+	endEdit_(w, a, region, t);
 	w.setEdited(true);
 }
 
@@ -140,31 +273,23 @@ void silence(Wave& w, int a, int b)
 /* -------------------------------------------------------------------------- */
 
 
-int cut(Wave& w, int a, int b)
+int cut(Wave& w, int a, int b, Task* t)
 {
 	if (a < 0) a = 0;
 	if (b > w.getSize()) b = w.getSize();
 
-	/* Create a new temp wave and copy there the original one, skipping the a-b 
-	range. */
-
-	int newSize = w.getSize() - (b - a);
-
-	AudioBuffer newData;
-	newData.alloc(newSize, w.getChannels());
-
 	gu_log("[wfx::cut] cutting from %d to %d\n", a, b);
 
-	for (int i=0, k=0; i<w.getSize(); i++) {
-		if (i < a || i >= b) {
-			for (int j=0; j<w.getChannels(); j++)	
-				newData[k][j] = w[i][j];
-			k++;
-		}
-	}
+	if (isCancelled_(t))
+		return G_RES_ERR;
 
-	w.moveData(newData);
+	/* Just leave the a-b range out: no data is copied. */
+
+	std::shared_ptr<const Rope> rope = toRope_(w);
+	w.setRope(std::make_shared<Rope>(rope->slice(0, a).concat(
+		rope->slice(b, rope->countFrames()))));
 	w.setEdited(true);
+	setDone_(t);
 
 	return G_RES_OK;
 }
@@ -173,24 +298,20 @@ int cut(Wave& w, int a, int b)
 /* -------------------------------------------------------------------------- */
 
 
-int trim(Wave& w, int a, int b)
+int trim(Wave& w, int a, int b, Task* t)
 {
 	if (a < 0) a = 0;
 	if (b > w.getSize()) b = w.getSize();
 
-	int newSize = b - a;
-
-	AudioBuffer newData;
-	newData.alloc(newSize, w.getChannels());
-
 	gu_log("[wfx::trim] trimming from %d to %d (area = %d)\n", a, b, b-a);
 
-	for (int i=0; i<newData.countFrames(); i++)
-		for (int j=0; j<newData.countChannels(); j++)
-			newData[i][j] = w[i+a][j];
+	if (isCancelled_(t))
+		return G_RES_ERR;
 
-	w.moveData(newData);
+	std::shared_ptr<const Rope> rope = toRope_(w);
+	w.setRope(std::make_shared<Rope>(rope->slice(a, b)));
  	w.setEdited(true);
+	setDone_(t);
 
 	return G_RES_OK;
 }
@@ -199,22 +320,21 @@ int trim(Wave& w, int a, int b)
 /* -------------------------------------------------------------------------- */
 
 
-int paste(const Wave& src, Wave& des, int a)
+int paste(const Wave& src, Wave& des, int a, Task* t)
 {
 	assert(src.getChannels() == des.getChannels());
 
-	AudioBuffer newData;
-	newData.alloc(src.getSize() + des.getSize(), des.getChannels());
+	if (isCancelled_(t))
+		return G_RES_ERR;
 
 	/* |---original data---|///paste data///|---original data---|
 	         des[0, a)      src[0, src.size)   des[a, des.size)	*/
 
-	newData.copyData(des[0], a, 0);
-	newData.copyData(src[0], src.getSize(), a);
-	newData.copyData(des[a], des.getSize() - a, src.getSize() + a);
-
-	des.moveData(newData);
+	std::shared_ptr<const Rope> rope = toRope_(des);
+	des.setRope(std::make_shared<Rope>(rope->slice(0, a).concat(ropeOf_(src))
+		.concat(rope->slice(a, rope->countFrames()))));
  	des.setEdited(true);
+	setDone_(t);
 
 	return G_RES_OK;
 }
@@ -223,28 +343,37 @@ int paste(const Wave& src, Wave& des, int a)
 /* -------------------------------------------------------------------------- */
 
 
-void fade(Wave& w, int a, int b, int type)
+void fade(Wave& w, int a, int b, int type, Task* t)
 {
 	gu_log("[wfx::fade] fade from %d to %d (range = %d)\n", a, b, b-a);
 
-	float m = 0.0f;
-	float d = 1.0f / (float) (b - a);
+	if (b <= a)
+		return;
 
-	if (type == FADE_IN)
-		for (int i=a; i<=b; i++, m+=d)
-			fadeFrame(w, i, m);
-	else
-		for (int i=b; i>=a; i--, m+=d)
-			fadeFrame(w, i, m);		
+	/* Gain goes linearly from 0.0 to 1.0 on frames a..b (or the other way 
+	around), so that the silent edge is exactly zero. */
+
+	float d     = 1.0f / (float) (b - a);
+	float start = type == FADE_IN ? 0.0f : (b - a) * d;
+	float step  = type == FADE_IN ? d : -d;
 
-  w.setEdited(true);
+	AudioBuffer region;
+	float* data  = beginEdit_(w, a, b + 1, region);
+	int    chans = w.getChannels();
+	forEachChunk_(0, b - a + 1, t, [=](int first, int last)
+	{
+		dsp::fade(data, first, last, chans, start, step);
+	});
+
+	endEdit_(w, a, region, t);
+	w.setEdited(true);
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void smooth(Wave& w, int a, int b)
+void smooth(Wave& w, int a, int b, Task* t)
 {
 	/* Do nothing if fade edges (both of SMOOTH_SIZE samples) are > than selected 
 	portion of wave. SMOOTH_SIZE*2 to count both edges. */
@@ -254,8 +383,8 @@ void smooth(Wave& w, int a, int b)
 		return;
 	}
 
-	fade(w, a, a+SMOOTH_SIZE, FADE_IN);
-	fade(w, b-SMOOTH_SIZE, b, FADE_OUT);
+	fade(w, a, a+SMOOTH_SIZE, FADE_IN, t);
+	fade(w, b-SMOOTH_SIZE, b, FADE_OUT, t);
 
 	w.setEdited(true);
 }
@@ -264,31 +393,52 @@ void smooth(Wave& w, int a, int b)
 /* -------------------------------------------------------------------------- */
 
 
-void shift(Wave& w, int offset)
+void shift(Wave& w, int offset, Task* t)
 {
+	int size = w.getSize();
+	if (size == 0 || isCancelled_(t))
+		return;
+
+	offset %= size;
 	if (offset < 0)
-		offset = (w.getSize() + w.getChannels()) + offset;
+		offset += size;
 
-	float* begin = w.getFrame(0);
-	float* end   = w.getFrame(0) + (w.getSize() * w.getChannels());
+	/* |---old [size - offset, size)---|---old [0, size - offset)---| */
 
-	std::rotate(begin, end - (offset * w.getChannels()), end);
+	std::shared_ptr<const Rope> rope = toRope_(w);
+	w.setRope(std::make_shared<Rope>(rope->slice(size - offset, size).concat(
+		rope->slice(0, size - offset))));
 	w.setEdited(true);
+	setDone_(t);
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void reverse(Wave& w, int a, int b)
+void reverse(Wave& w, int a, int b, Task* t)
 {
-	/* https://stackoverflow.com/questions/33201528/reversing-an-array-of-structures-in-c */
-
-	float* begin = w.getFrame(0) + (a * w.getChannels());
-	float* end   = w.getFrame(0) + (b * w.getChannels());
-
-	std::reverse(begin, end);
+	if (b - a < 2)
+		return;
 
+	/* Frames are swapped in pairs of chunks, one from the front and one from 
+	the back of the range: each chunk is reversed in place, then the two are 
+	exchanged. Pairs don't overlap, so they can go in parallel. */
+
+	AudioBuffer region;
+	float* data  = beginEdit_(w, a, b, region);
+	int    chans = w.getChannels();
+	int    n     = b - a;
+	forEachChunk_(0, n / 2, t, [=](int first, int last)
+	{
+		float* front = data + first * chans;
+		float* back  = data + (n - last) * chans;
+		dsp::reverse(front, last - first, chans);
+		dsp::reverse(back, last - first, chans);
+		std::swap_ranges(front, front + (last - first) * chans, back);
+	});
+
+	endEdit_(w, a, region, t);
 	w.setEdited(true);
 }
 
@@ -29,6 +29,9 @@
 #define G_WAVE_FX_H
 
 
+#include <atomic>
+
+
 class Wave;
 
 
@@ -40,6 +43,26 @@ static const int FADE_IN  = 0;
 static const int FADE_OUT = 1;
 static const int SMOOTH_SIZE = 32;
 
+/* CHUNK_FRAMES
+Operations below split the work in chunks of this size, spread over all the
+cores. */
+
+static const int CHUNK_FRAMES = 65536;
+
+/* Task
+Lets another thread follow and stop an operation (see waveEditor). 'progress'
+goes from 0.0 to 1.0; 'cancelled' is checked between chunks, after which the
+Wave is left half-done and must be thrown away. All operations take an 
+optional Task. */
+
+struct Task
+{
+	Task() : progress(0.0f), cancelled(false) {}
+
+	std::atomic<float> progress;
+	std::atomic<bool>  cancelled;
+};
+
 /* normalizeSoft
 Normalizes the wave by returning the dB value for the boost volume. */
 
@@ -48,34 +71,38 @@ float normalizeSoft(const Wave& w);
 /* normalizeHard
 Normalizes the wave in range a-b by altering values in memory. */
 
-void normalizeHard(Wave& w, int a, int b);
+void normalizeHard(Wave& w, int a, int b, Task* t=nullptr);
 
 int monoToStereo(Wave& w);
-void silence(Wave& w, int a, int b);
-int cut(Wave& w, int a, int b);
-int trim(Wave& w, int a, int b);
+void silence(Wave& w, int a, int b, Task* t=nullptr);
+int cut(Wave& w, int a, int b, Task* t=nullptr);
+int trim(Wave& w, int a, int b, Task* t=nullptr);
 
 /* paste
 Pastes Wave 'src' into Wave 'dest', starting from frame 'a'. */
 
-int paste(const Wave& src, Wave& dest, int a);
+int paste(const Wave& src, Wave& dest, int a, Task* t=nullptr);
 
 /* fade
-Fades in or fades out selection. Fade In = type 0, Fade Out = type 1 */
+Fades in or fades out selection [a, b], edges included. Fade In = type 0, Fade 
+Out = type 1 */
 
-void fade(Wave& w, int a, int b, int type);
+void fade(Wave& w, int a, int b, int type, Task* t=nullptr);
 
 /* smooth
 Smooth edges of selection. */
 
-void smooth(Wave& w, int a, int b);
+void smooth(Wave& w, int a, int b, Task* t=nullptr);
 
 /* reverse
-Flips Wave's data. */
+Flips the order of frames in range a-b. */
+
+void reverse(Wave& w, int a, int b, Task* t=nullptr);
 
-void reverse(Wave& w, int a, int b);
+/* shift
+Rotates the whole Wave by 'offset' frames, to the right if positive. */
 
-void shift(Wave& w, int offset);
+void shift(Wave& w, int offset, Task* t=nullptr);
 
 }}}; // giada::m::wfx::
 
@@ -25,12 +25,25 @@
  * -------------------------------------------------------------------------- */
 
 
+#include <algorithm>
+#include <cassert>
 #include <cmath>
+#include <memory>
+#include <vector>
 #include <sndfile.h>
 #include <samplerate.h>
 #include "../utils/log.h"
 #include "../utils/fs.h"
+#include "../utils/string.h"
 #include "const.h"
+#include "conf.h"
+#include "audioBuffer.h"
+#include "waveStream.h"
+#include "nativeBuffer.h"
+#include "rope.h"
+#include "dsp.h"
+#include "wavePool.h"
+#include "waveCache.h"
 #include "wave.h"
 #include "waveFx.h"
 #include "waveManager.h"
@@ -45,7 +58,7 @@ namespace waveManager
 {
 namespace
 {
-int getBits(SF_INFO& header)
+int getBits(const SF_INFO& header)
 {
 	if      (header.format & SF_FORMAT_PCM_S8)
 		return 8;
@@ -63,6 +76,198 @@ int getBits(SF_INFO& header)
 		return 64;
 	return 0;
 }
+
+
+/* -------------------------------------------------------------------------- */
+
+/* shouldStream_
+Streams files that would take more than conf::streamThreshold MB once decoded
+(always in stereo). Files that need resampling are loaded anyway: conversion 
+happens on the whole data. */
+
+bool shouldStream_(const SF_INFO& header)
+{
+	if (conf::streamThreshold <= 0 || header.samplerate != conf::samplerate)
+		return false;
+	long long bytes = header.frames * G_MAX_IO_CHANS * sizeof(float);
+	return bytes > conf::streamThreshold * 1024LL * 1024LL;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* makeKey_
+Identifies data decoded from 'path' at 'rate': source file, target rate and,
+if converted, the resampling quality. Empty if the file can't be accessed. */
+
+string makeKey_(const string& path, const SF_INFO& header, int rate)
+{
+	string key = wavePool::makeKey(path);
+	if (key.empty())
+		return key;
+	key += "|" + gu_iToString(rate);
+	if (rate != header.samplerate)
+		key += "|" + gu_iToString(conf::rsmpQuality);
+	return key;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int createStreamed_(const string& path, const SF_INFO& header, Wave** out)
+{
+	std::unique_ptr<WaveStream> stream(new WaveStream(path));
+	if (!stream->isOpen())
+		return G_RES_ERR_IO;
+
+	Wave* wave = new Wave();
+	wave->setStream(std::move(stream), getBits(header));
+
+	*out = wave;
+
+	gu_log("[waveManager::create] new streamed Wave created, %d frames\n", 
+		wave->getSize());
+
+	return G_RES_OK;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* canBeNative_
+Native storage pays off for 16 and 24 bit files, and for mono ones. */
+
+bool canBeNative_(const SF_INFO& header)
+{
+	int sub = header.format & SF_FORMAT_SUBMASK;
+	return sub == SF_FORMAT_PCM_16 || sub == SF_FORMAT_PCM_24 || header.channels == 1;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* readNative_
+Reads the whole file into 'data', in its own format. 24 bit samples come as 
+left-justified 32 bit integers from libsndfile: keep the 3 upper bytes. */
+
+bool readNative_(SNDFILE* f, const SF_INFO& header, NativeBuffer& data)
+{
+	switch (data.getFormat()) {
+		case dsp::Format::INT16:
+			return sf_readf_short(f, static_cast<short*>(data.getFrame(0)), 
+				header.frames) == header.frames;
+		case dsp::Format::INT24: {
+			std::vector<int> chunk(G_STREAM_CHUNK_FRAMES * header.channels);
+			uint8_t* out = static_cast<uint8_t*>(data.getFrame(0));
+			sf_count_t total = 0;
+			sf_count_t n;
+			while ((n = sf_readf_int(f, chunk.data(), G_STREAM_CHUNK_FRAMES)) > 0) {
+				for (sf_count_t i=0; i<n * header.channels; i++) {
+					uint32_t v = static_cast<uint32_t>(chunk[i]);
+					*out++ = v >> 8;
+					*out++ = v >> 16;
+					*out++ = v >> 24;
+				}
+				total += n;
+			}
+			return total == header.frames;
+		}
+		default:
+			return sf_readf_float(f, static_cast<float*>(data.getFrame(0)), 
+				header.frames) == header.frames;
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int createNative_(SNDFILE* f, const string& path, const SF_INFO& header, Wave** out)
+{
+	dsp::Format format = dsp::Format::FLOAT32;
+	if ((header.format & SF_FORMAT_SUBMASK) == SF_FORMAT_PCM_16)
+		format = dsp::Format::INT16;
+	else
+	if ((header.format & SF_FORMAT_SUBMASK) == SF_FORMAT_PCM_24)
+		format = dsp::Format::INT24;
+
+	std::shared_ptr<NativeBuffer> data = std::make_shared<NativeBuffer>(
+		header.frames, header.channels, format, path);
+	if (!readNative_(f, header, *data))
+		gu_log("[waveManager::create] warning: incomplete read!\n");
+
+	Wave* wave = new Wave();
+	wave->setNative(data, header.samplerate, getBits(header));
+
+	*out = wave;
+
+	gu_log("[waveManager::create] new native Wave created, %d frames, %d KB\n", 
+		wave->getSize(), static_cast<int>(wave->getMemory() / 1024));
+
+	return G_RES_OK;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* getSourcePath_
+Where data of non-direct waves comes from. Their path might have changed in 
+the meantime, e.g. when saving a project. */
+
+string getSourcePath_(const Wave* w)
+{
+	return w->isStreamed() ? w->getStream()->getPath() : w->getNative()->getPath();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* saveFromSource_
+Streamed and native waves are saved by copying the source file chunk by chunk,
+converted to stereo float like any other wave. */
+
+bool saveFromSource_(const Wave* w, SNDFILE* dest)
+{
+	SF_INFO header;
+	header.format = 0;
+	SNDFILE* src = sf_open(getSourcePath_(w).c_str(), SFM_READ, &header);
+	if (src == nullptr)
+		return false;
+
+	AudioBuffer in, out;
+	in.alloc(G_STREAM_CHUNK_FRAMES, header.channels);
+	out.alloc(G_STREAM_CHUNK_FRAMES, G_MAX_IO_CHANS);
+
+	bool ok = true;
+	sf_count_t n;
+	while (ok && (n = sf_readf_float(src, in[0], G_STREAM_CHUNK_FRAMES)) > 0) {
+		for (int i=0; i<n; i++)
+			for (int j=0; j<G_MAX_IO_CHANS; j++)
+				out[i][j] = in[i][std::min(j, header.channels - 1)];
+		ok = sf_writef_float(dest, out[0], n) == n;
+	}
+
+	sf_close(src);
+	return ok;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* saveFromRope_
+Chunked waves are written piece by piece, no need to join them first. */
+
+bool saveFromRope_(const Wave* w, SNDFILE* dest)
+{
+	const Rope& rope = *w->getRope();
+	for (int i=0, n=0; i<rope.countFrames(); i+=n) {
+		const float* data = rope.getSpan(i, &n);
+		if (sf_writef_float(dest, data, n) != n)
+			return false;
+	}
+	return true;
+}
 }; // {anonymous}
 
 
@@ -71,7 +276,7 @@ int getBits(SF_INFO& header)
 /* -------------------------------------------------------------------------- */
 
 
-int create(const string& path, Wave** out)
+int create(const string& path, Wave** out, Storage storage, int rate)
 {
 	if (path == "" || gu_isDir(path)) {
 		gu_log("[waveManager::create] malformed path (was '%s')\n", path.c_str());
@@ -91,9 +296,46 @@ int create(const string& path, Wave** out)
 
 	if (header.channels > G_MAX_IO_CHANS) {
 		gu_log("[waveManager::create] unsupported multi-channel sample\n");
+		sf_close(fileIn);
 		return G_RES_ERR_WRONG_DATA;
 	}
 
+	if (storage == Storage::AUTO && shouldStream_(header)) {
+		sf_close(fileIn);
+		return createStreamed_(path, header, out);
+	}
+
+	if (rate == 0)
+		rate = header.samplerate;
+
+	/* Native data can't be resampled: files at a different rate are converted to
+	float anyway. */
+
+	bool native = storage == Storage::NATIVE || 
+	             (storage == Storage::AUTO && conf::nativeSamples);
+	if (native && rate == header.samplerate && canBeNative_(header)) {
+		int res = createNative_(fileIn, path, header, out);
+		sf_close(fileIn);
+		return res;
+	}
+
+	/* Same file already loaded by some other channel: share its data instead of
+	decoding it again. Otherwise try with data decoded in the past. */
+
+	string key = makeKey_(path, header, rate);
+	std::shared_ptr<AudioBuffer> data = wavePool::get(key);
+	if (data == nullptr && (data = waveCache::get(key)) != nullptr)
+		wavePool::put(key, data);
+	if (data != nullptr) {
+		sf_close(fileIn);
+		Wave* wave = new Wave();
+		wave->setSharedData(data, rate, getBits(header), path);
+		*out = wave;
+		gu_log("[waveManager::create] new Wave created from shared data, %d frames\n", 
+			wave->getSize());
+		return G_RES_OK;
+	}
+
 	Wave* wave = new Wave();
 	wave->alloc(header.frames, header.channels, header.samplerate, getBits(header), path);
 
@@ -107,6 +349,19 @@ int create(const string& path, Wave** out)
 		return G_RES_ERR_PROCESSING;
 	}
 
+	if (rate != header.samplerate) {
+		gu_log("[waveManager::create] input rate (%d) != required rate (%d), conversion needed\n",
+			header.samplerate, rate);
+		if (resample(wave, conf::rsmpQuality, rate) != G_RES_OK) {
+			delete wave;
+			return G_RES_ERR_PROCESSING;
+		}
+	}
+
+	data = wave->shareData();
+	wavePool::put(key, data);
+	waveCache::put(key, *data);
+
 	*out = wave;
 
 	gu_log("[waveManager::create] new Wave created, %d frames\n", wave->getSize());
@@ -138,13 +393,17 @@ void createEmpty(int frames, int channels, int samplerate, const string& name,
 
 void createFromWave(const Wave* src, int a, int b, Wave** out)
 {
-	int channels = src->getChannels();
-	int frames   = b - a;
+	assert(src->isDirect() || src->isChunked());
 
-	Wave* wave = new Wave();
-	wave->alloc(frames, channels, src->getRate(), src->getBits(), src->getPath());
+	int frames = b - a;
+
+	/* Share the range with 'src' rather than copying it (see Rope). */
+
+	Rope rope = src->isChunked() ? *src->getRope() : Rope(src->getBuffer());
 
-	wave->copyData(src->getFrame(a), frames);
+	Wave* wave = new Wave();
+	wave->alloc(0, src->getChannels(), src->getRate(), src->getBits(), src->getPath());
+	wave->setRope(std::make_shared<Rope>(rope.slice(a, b)));
 	wave->setLogical(true);
 
 	*out = wave;
@@ -165,7 +424,7 @@ int resample(Wave* w, int quality, int samplerate)
 	newData.alloc(newSizeFrames, w->getChannels());
 
 	SRC_DATA src_data;
-	src_data.data_in       = w->getFrame(0);
+	src_data.data_in       = static_cast<const Wave*>(w)->getFrame(0);
 	src_data.input_frames  = w->getSize();
 	src_data.data_out      = newData[0];
 	src_data.output_frames = newSizeFrames;
@@ -191,6 +450,15 @@ int resample(Wave* w, int quality, int samplerate)
 
 int save(Wave* w, const string& path)
 {
+	/* A streamed or native wave saved onto its own source: data is already 
+	there. */
+
+	if ((w->isStreamed() || w->isNative()) && getSourcePath_(w) == path) {
+		w->setLogical(false);
+		w->setEdited(false);
+		return G_RES_OK;
+	}
+
 	SF_INFO header;
 	header.samplerate = w->getRate();
 	header.channels   = w->getChannels();
@@ -203,7 +471,17 @@ int save(Wave* w, const string& path)
 		return G_RES_ERR_IO;
 	}
 
-	if (sf_writef_float(file, w->getFrame(0), w->getSize()) != w->getSize())
+	if (w->isChunked()) {
+		if (!saveFromRope_(w, file))
+			gu_log("[waveManager::save] warning: incomplete write!\n");
+	}
+	else
+	if (!w->isDirect()) {
+		if (!saveFromSource_(w, file))
+			gu_log("[waveManager::save] warning: incomplete write!\n");
+	}
+	else
+	if (sf_writef_float(file, static_cast<const Wave*>(w)->getFrame(0), w->getSize()) != w->getSize())
 		gu_log("[waveManager::save] warning: incomplete write!\n");
 
 	sf_close(file);
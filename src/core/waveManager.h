@@ -39,10 +39,22 @@ namespace giada {
 namespace m {
 namespace waveManager
 {
+/* Storage
+How a new Wave keeps its data. FLOAT: in memory, ready for editing. NATIVE: in
+memory, in the file format (see NativeBuffer). AUTO: streamed from disk if large
+(see conf::streamThreshold), otherwise NATIVE or FLOAT according to 
+conf::nativeSamples. */
+
+enum class Storage { AUTO, FLOAT, NATIVE };
+
 /* create
-Creates a new Wave object with data read from file 'path'. */
+Creates a new Wave object with data read from file 'path', converted to 'rate'
+if it differs from the file one (0 = keep the file rate). Converted waves are 
+always FLOAT. Decoded data is shared with other waves from the same file (see 
+wavePool) and kept on disk for the next time (see waveCache). */
 
-int create(const std::string& path, Wave** out);
+int create(const std::string& path, Wave** out, Storage storage=Storage::AUTO, 
+	int rate=0);
 
 /* createEmpty
 Creates a new silent Wave object. */
@@ -51,7 +63,8 @@ void createEmpty(int frames, int channels, int samplerate, const std::string& na
 	Wave** out);
 
 /* createFromWave
-Creates a new Wave from an existing one, copying the data in range a - b. */
+Creates a new Wave from an existing one, with the data in range a - b. Data is
+shared, not copied: the new Wave is chunked. */
 
 void createFromWave(const Wave* src, int a, int b, Wave** out);
 
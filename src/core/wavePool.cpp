@@ -0,0 +1,115 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#include <map>
+#include <mutex>
+#include "../utils/fs.h"
+#include "../utils/string.h"
+#include "audioBuffer.h"
+#include "wavePool.h"
+
+
+namespace giada {
+namespace m {
+namespace wavePool
+{
+namespace
+{
+/* pool
+Weak references only: the pool never keeps a sample alive. Guarded by 'mutex',
+as samples might be loaded by several threads at once. */
+
+std::map<std::string, std::weak_ptr<AudioBuffer>> pool;
+std::mutex mutex;
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void purge_()
+{
+	for (auto it = pool.begin(); it != pool.end();)
+		if (it->second.expired())
+			it = pool.erase(it);
+		else
+			++it;
+}
+}; // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+std::string makeKey(const std::string& path)
+{
+	int64_t size;
+	int64_t mtime;
+	if (!gu_getFileStamp(path, size, mtime))
+		return "";
+	return gu_getRealPath(path) + "|" + gu_iToString(size) + "|" + gu_iToString(mtime);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+std::shared_ptr<AudioBuffer> get(const std::string& key)
+{
+	if (key.empty())
+		return nullptr;
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = pool.find(key);
+	return it != pool.end() ? it->second.lock() : nullptr;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void put(const std::string& key, std::shared_ptr<AudioBuffer> data)
+{
+	if (key.empty())
+		return;
+	std::lock_guard<std::mutex> lock(mutex);
+	purge_();
+	pool[key] = data;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int count()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	purge_();
+	return pool.size();
+}
+}}}; // giada::m::wavePool::
@@ -0,0 +1,70 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#ifndef G_WAVE_POOL_H
+#define G_WAVE_POOL_H
+
+
+#include <memory>
+#include <string>
+
+
+namespace giada {
+namespace m 
+{
+class AudioBuffer;
+
+namespace wavePool
+{
+/* makeKey
+Identifies the content of file 'path': canonical path, size and modification 
+time. Returns an empty string if the file can't be accessed. */
+
+std::string makeKey(const std::string& path);
+
+/* get
+Returns the sample data decoded from the file identified by 'key', if some Wave
+still holds it. Returns nullptr otherwise. */
+
+std::shared_ptr<AudioBuffer> get(const std::string& key);
+
+/* put
+Shares 'data' decoded from the file identified by 'key'. The pool doesn't own 
+it: data is freed as soon as the last Wave using it goes away. Data must not 
+change from now on: Wave copies it before writing (see Wave::shareData). */
+
+void put(const std::string& key, std::shared_ptr<AudioBuffer> data);
+
+/* count
+Returns how many distinct samples are alive. */
+
+int count();
+}}}; // giada::m::wavePool::
+
+
+#endif
@@ -0,0 +1,307 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#include <algorithm>
+#include "../utils/log.h"
+#include "streamer.h"
+#include "waveStream.h"
+
+
+namespace giada {
+namespace m 
+{
+WaveStream::WaveStream(const std::string& path, int headFrames, int ringFrames)
+: m_path       (path),
+  m_file       (nullptr),
+  m_headFrames (headFrames),
+  m_current    (0),
+  m_inUse      (-1),
+  m_headRequest(-1),
+  m_base       (0),
+  m_read       (0),
+  m_write      (0),
+  m_seek       (-1)
+{
+	m_header.format = 0;
+	m_file = sf_open(path.c_str(), SFM_READ, &m_header);
+	if (m_file == nullptr) {
+		gu_log("[WaveStream] unable to open %s. %s\n", path.c_str(), sf_strerror(m_file));
+		return;
+	}
+	if (m_header.channels > G_MAX_IO_CHANS) {
+		gu_log("[WaveStream] unsupported multi-channel sample\n");
+		sf_close(m_file);
+		m_file = nullptr;
+		return;
+	}
+
+	m_fileBuffer.alloc(G_STREAM_CHUNK_FRAMES, m_header.channels);
+	m_ring.alloc(ringFrames, G_MAX_IO_CHANS);
+	for (Head& h : m_heads) {
+		h.data.alloc(headFrames, G_MAX_IO_CHANS);
+		h.start  = 0;
+		h.frames = 0;
+	}
+
+	/* Start with the head from frame 0 and the ring buffer right after it. */
+
+	loadHead_(m_heads[0], 0);
+	m_base = m_heads[0].frames;
+
+	streamer::add(this);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+WaveStream::~WaveStream()
+{
+	if (m_file == nullptr)
+		return;
+	streamer::remove(this);
+	sf_close(m_file);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool WaveStream::isOpen() const { return m_file != nullptr; }
+const std::string& WaveStream::getPath() const { return m_path; }
+int WaveStream::getSize() const { return m_file != nullptr ? m_header.frames : 0; }
+int WaveStream::getRate() const { return m_header.samplerate; }
+int WaveStream::getFileChannels() const { return m_header.channels; }
+
+
+/* -------------------------------------------------------------------------- */
+
+
+size_t WaveStream::getMemory() const
+{
+	size_t samples = m_heads[0].data.countSamples() + m_heads[1].data.countSamples() +
+		m_ring.countSamples() + m_fileBuffer.countSamples();
+	return samples * sizeof(float);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void WaveStream::read(AudioBuffer& dest, int start, int frames, int offset)
+{
+	/* Mark the current head as in use, then make sure it is still the current 
+	one: the disk thread might have swapped them in between. */
+
+	int h = m_current.load();
+	m_inUse.store(h);
+	while (m_current.load() != h) {
+		h = m_current.load();
+		m_inUse.store(h);
+	}
+	const Head& head = m_heads[h];
+	int headEnd = head.start + head.frames;
+
+	if (start >= head.start && start < headEnd) {
+		int n = std::min(frames, headEnd - start);
+		dest.copyData(head.data[start - head.start], n, offset);
+		start  += n;
+		offset += n;
+		frames -= n;
+
+		/* Playing the head: keep the ring buffer right after it, that's where 
+		playback goes next. This is what makes rewinds seamless. */
+
+		if (headEnd < getSize() && m_seek.load(std::memory_order_acquire) == -1) {
+			int read  = m_read.load(std::memory_order_relaxed);
+			int write = m_write.load(std::memory_order_acquire);
+			if (headEnd < m_base + read || headEnd > m_base + write)
+				requestSeek_(headEnd);
+			else
+				m_read.store(headEnd - m_base, std::memory_order_release);
+		}
+	}
+	m_inUse.store(-1);
+
+	if (frames > 0)
+		readRing_(dest, start, frames, offset);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void WaveStream::prefetch(int start)
+{
+	if (m_file == nullptr)
+		return;
+	m_headRequest.store(std::max(0, std::min(start, getSize())));
+	streamer::wake();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+bool WaveStream::service()
+{
+	bool busy = false;
+
+	/* New head segment: load the spare one, unless the audio thread is still 
+	reading it. A newer request might come in while loading: keep it. */
+
+	int head = m_headRequest.load();
+	if (head != -1) {
+		int spare = 1 - m_current.load();
+		if (m_inUse.load() != spare) {
+			loadHead_(m_heads[spare], head);
+			m_current.store(spare);
+			m_headRequest.compare_exchange_strong(head, -1);
+		}
+		busy = true;
+	}
+
+	/* Seek request: restart the ring buffer from the new position. The audio 
+	thread doesn't touch it until m_seek is back to -1. */
+
+	int seek = m_seek.load(std::memory_order_acquire);
+	if (seek != -1) {
+		m_base = seek;
+		m_read.store(0, std::memory_order_relaxed);
+		m_write.store(0, std::memory_order_relaxed);
+		m_seek.store(-1, std::memory_order_release);
+		busy = true;
+	}
+
+	/* Refill, one chunk at a time. Chunks never wrap around the end of the 
+	ring. */
+
+	int ringFrames = m_ring.countFrames();
+	int read  = m_read.load(std::memory_order_acquire);
+	int write = m_write.load(std::memory_order_relaxed);
+	int index = write % ringFrames;
+	int n     = std::min(ringFrames - (write - read), ringFrames - index);
+	n = std::min(n, std::min(G_STREAM_CHUNK_FRAMES, getSize() - (m_base + write)));
+	if (n > 0) {
+		n = readFile_(m_ring[index], m_base + write, n);
+		m_write.store(write + n, std::memory_order_release);
+		busy = busy || n > 0;
+	}
+
+	return busy;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int WaveStream::readFile_(float* dest, int start, int frames)
+{
+	if (sf_seek(m_file, start, SEEK_SET) == -1)
+		return 0;
+
+	int channels = m_header.channels;
+	int done     = 0;
+	while (done < frames) {
+		int n   = std::min(frames - done, m_fileBuffer.countFrames());
+		int got = sf_readf_float(m_file, m_fileBuffer[0], n);
+		if (got <= 0)
+			break;
+		for (int i=0; i<got; i++)
+			for (int j=0; j<G_MAX_IO_CHANS; j++)
+				dest[(done + i) * G_MAX_IO_CHANS + j] = m_fileBuffer[i][std::min(j, channels - 1)];
+		done += got;
+	}
+	return done;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void WaveStream::loadHead_(Head& h, int start)
+{
+	h.start  = start;
+	h.frames = readFile_(h.data[0], start, std::min(m_headFrames, getSize() - start));
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void WaveStream::requestSeek_(int frame)
+{
+	m_seek.store(frame, std::memory_order_release);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void WaveStream::readRing_(AudioBuffer& dest, int start, int frames, int offset)
+{
+	if (start >= getSize() || m_seek.load(std::memory_order_acquire) != -1)
+		return silence_(dest, frames, offset);
+
+	/* Out of the ring buffer window: jump there and play silence until data is
+	ready. */
+
+	int read  = m_read.load(std::memory_order_relaxed);
+	int write = m_write.load(std::memory_order_acquire);
+	if (start < m_base + read || start > m_base + write) {
+		requestSeek_(start);
+		return silence_(dest, frames, offset);
+	}
+
+	/* Free what comes before 'start', but not the frames being read: the caller
+	might ask for some of them again (e.g. when resampling). */
+
+	read = start - m_base;
+	m_read.store(read, std::memory_order_release);
+
+	int ringFrames = m_ring.countFrames();
+	int n = std::min(frames, write - read);
+	for (int done=0; done<n;) {
+		int index = (read + done) % ringFrames;
+		int count = std::min(n - done, ringFrames - index);
+		dest.copyData(m_ring[index], count, offset + done);
+		done += count;
+	}
+	if (n < frames)
+		silence_(dest, frames - n, offset + n);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void WaveStream::silence_(AudioBuffer& dest, int frames, int offset)
+{
+	dest.clear(offset, offset + frames);
+}
+}} // giada::m::
@@ -0,0 +1,141 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#ifndef G_WAVE_STREAM_H
+#define G_WAVE_STREAM_H
+
+
+#include <atomic>
+#include <string>
+#include <sndfile.h>
+#include "const.h"
+#include "audioBuffer.h"
+
+
+namespace giada {
+namespace m 
+{
+/* WaveStream
+Plays a sample file from disk, without loading it in memory. A head segment 
+starting from the begin point is always in memory, so that playback can start 
+(and restart) immediately. What follows is read ahead by the disk thread (see
+streamer) into a ring buffer. Data is always stereo: mono files are doubled on
+the fly.
+The ring buffer is single producer (the disk thread, through service()) and 
+single consumer (the audio thread, through read()). The consumer asks for a new
+position by posting a seek request, then stays away from the ring buffer until
+the producer has served it. */
+
+class WaveStream
+{
+public:
+
+	WaveStream(const std::string& path, int headFrames=G_STREAM_HEAD_FRAMES, 
+		int ringFrames=G_STREAM_RING_FRAMES);
+	~WaveStream();
+
+	bool isOpen() const;
+	const std::string& getPath() const;
+	int getSize() const;  // in frames
+	int getRate() const;
+	int getFileChannels() const;
+
+	/* getMemory
+	Returns the memory taken by buffers, in bytes. */
+
+	size_t getMemory() const;
+
+	/* read
+	Audio thread only. Copies 'frames' frames starting from frame 'start' into 
+	'dest' at frame 'offset'. Frames not available yet are filled with silence. */
+
+	void read(AudioBuffer& dest, int start, int frames, int offset);
+
+	/* prefetch
+	Moves the head segment to frame 'start', e.g. when the begin point changes.
+	The disk thread does the actual reading. */
+
+	void prefetch(int start);
+
+	/* service
+	Disk thread only. Serves pending requests and refills the ring buffer. 
+	Returns true if some work has been done: there might be more. */
+
+	bool service();
+
+private:
+
+	struct Head
+	{
+		AudioBuffer data;
+		int start;
+		int frames;
+	};
+
+	/* readFile_
+	Reads 'frames' frames from file position 'start' into 'dest', converting 
+	them to stereo. */
+
+	int readFile_(float* dest, int start, int frames);
+
+	void loadHead_(Head& h, int start);
+	void requestSeek_(int frame);
+	void readRing_(AudioBuffer& dest, int start, int frames, int offset);
+	void silence_(AudioBuffer& dest, int frames, int offset);
+
+	std::string m_path;
+	SNDFILE*    m_file;
+	SF_INFO     m_header;
+	AudioBuffer m_fileBuffer; // raw chunk read from disk
+	int         m_headFrames;
+
+	/* m_heads, m_current, m_inUse, m_headRequest
+	Double-buffered head segment. The disk thread loads the spare one, then 
+	publishes it through m_current. It never touches the one marked as in use by
+	the audio thread. */
+
+	Head             m_heads[2];
+	std::atomic<int> m_current;
+	std::atomic<int> m_inUse;
+	std::atomic<int> m_headRequest;
+
+	/* m_ring, m_base, m_read, m_write, m_seek
+	Ring buffer. It holds file frames [m_base + m_read, m_base + m_write). The 
+	audio thread moves m_read, the disk thread moves m_write. Both counters and 
+	m_base are reset by the disk thread only while a seek request is pending. */
+
+	AudioBuffer      m_ring;
+	int              m_base;
+	std::atomic<int> m_read;
+	std::atomic<int> m_write;
+	std::atomic<int> m_seek;
+};
+}} // giada::m::
+
+
+#endif
@@ -0,0 +1,240 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
+#ifdef __linux__
+	#include <pthread.h>
+#endif
+#include "../utils/log.h"
+#include "workers.h"
+
+
+namespace giada {
+namespace m {
+namespace workers
+{
+namespace
+{
+constexpr int SPIN_ITERATIONS = 4096;  // before going to sleep
+constexpr int RT_PRIORITY     = 70;
+
+std::vector<std::thread> pool;
+std::atomic<bool>        running(false);
+
+/* ticket
+Packs the number of jobs in the current set (upper 32 bits) and the next job to 
+grab (lower 32 bits). Grabbing a job is a single fetch_add, which also tells 
+whether the set is over: no worker can ever pick a job from a stale set. */
+
+std::atomic<uint64_t> ticket(0);
+std::atomic<int>      done(0);
+Job*                  currentJob  = nullptr;
+void*                 currentData = nullptr;
+
+/* generation, sleepers
+Workers spin for a while on 'generation' waiting for a new job set, then sleep
+on the condition variable. The audio thread takes the mutex only if someone is
+sleeping. */
+
+std::atomic<unsigned>   generation(0);
+std::atomic<int>        sleepers(0);
+std::mutex              mutex;
+std::condition_variable cond;
+
+thread_local int threadIndex = 0;
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void pause_()
+{
+#if defined(__SSE2__)
+	_mm_pause();
+#else
+	std::this_thread::yield();
+#endif
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void drain_()
+{
+	while (true) {
+		uint64_t t = ticket.fetch_add(1, std::memory_order_acq_rel);
+		uint32_t i = t & 0xFFFFFFFF;
+		uint32_t n = t >> 32;
+		if (i >= n)
+			return;
+		currentJob(i, currentData);
+		done.fetch_add(1, std::memory_order_release);
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void wait_(unsigned seen)
+{
+	for (int i=0; i<SPIN_ITERATIONS; i++) {
+		if (generation.load(std::memory_order_acquire) != seen || !running)
+			return;
+		pause_();
+	}
+
+	sleepers++;
+	std::unique_lock<std::mutex> lock(mutex);
+	cond.wait(lock, [seen] { return generation != seen || !running; });
+	sleepers--;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void workerLoop_(int i)
+{
+	threadIndex = i;
+	unsigned seen = generation;
+	while (true) {
+		wait_(seen);
+		if (!running)
+			return;
+		seen = generation;
+		drain_();
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void setPriority_(std::thread& t)
+{
+#ifdef __linux__
+	sched_param param;
+	param.sched_priority = RT_PRIORITY;
+	if (pthread_setschedparam(t.native_handle(), SCHED_FIFO, &param) != 0)
+		gu_log("[workers::init] unable to set real-time priority, using default\n");
+#endif
+}
+}; // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+void init(int threads)
+{
+	close();
+	running = true;
+	for (int i=1; i<threads; i++) {
+		pool.emplace_back(workerLoop_, i);
+		setPriority_(pool.back());
+	}
+	gu_log("[workers::init] %d render thread(s) ready\n", threads);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void close()
+{
+	if (pool.empty())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	cond.notify_all();
+	for (std::thread& t : pool)
+		t.join();
+	pool.clear();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int count()
+{
+	return pool.size() + 1;
+}
+
+
+int getIndex()
+{
+	return threadIndex;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void run(int jobs, Job* job, void* data)
+{
+	if (pool.empty() || jobs < 2) {
+		for (int i=0; i<jobs; i++)
+			job(i, data);
+		return;
+	}
+
+	/* Publish the new set, then wake up the workers. The audio thread works on
+	it too and finally waits for the jobs still in progress elsewhere. */
+
+	currentJob  = job;
+	currentData = data;
+	done.store(0, std::memory_order_relaxed);
+	ticket.store(static_cast<uint64_t>(jobs) << 32, std::memory_order_release);
+
+	generation++;
+	if (sleepers > 0) {
+		mutex.lock();
+		mutex.unlock();
+		cond.notify_all();
+	}
+
+	drain_();
+	while (done.load(std::memory_order_acquire) < jobs)
+		pause_();
+}
+}}}; // giada::m::workers::
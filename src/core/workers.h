@@ -0,0 +1,70 @@
+/* -----------------------------------------------------------------------------
+ *
+ * Giada - Your Hardcore Loopmachine
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2018 Giovanni A. Zuliani | Monocasual
+ *
+ * This file is part of Giada - Your Hardcore Loopmachine.
+ *
+ * Giada - Your Hardcore Loopmachine is free software: you can
+ * redistribute it and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation, either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * Giada - Your Hardcore Loopmachine is distributed in the hope that it
+ * will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Giada - Your Hardcore Loopmachine. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * -------------------------------------------------------------------------- */
+
+
+
+#ifndef G_WORKERS_H
+#define G_WORKERS_H
+
+
+namespace giada {
+namespace m {
+namespace workers
+{
+/* Job
+A unit of work: 'index' tells which one out of the set passed to run(). */
+
+typedef void (Job) (int index, void* data);
+
+/* init
+Starts the pool. 'threads' is the number of threads that render together, the
+caller of run() included: 1 means no workers at all. */
+
+void init(int threads);
+void close();
+
+/* count
+Returns the number of threads that share the work, the caller included. */
+
+int count();
+
+/* getIndex
+Returns the index of the calling thread in the pool: 0 for the thread that 
+calls run() (i.e. the audio thread), 1..count()-1 for workers. Useful for 
+picking per-thread scratch data. */
+
+int getIndex();
+
+/* run
+Runs 'job' 'jobs' times across the pool and returns when all of them are done.
+Audio thread only: the caller takes part in the work, idle threads grab the next
+pending job, so that slow jobs don't hold the others back. */
+
+void run(int jobs, Job* job, void* data);
+}}}; // giada::m::workers::
+
+
+#endif
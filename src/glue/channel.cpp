@@ -56,8 +56,12 @@
 #include "../core/channel.h"
 #include "../core/sampleChannel.h"
 #include "../core/midiChannel.h"
+#include "../core/recorder.h"
 #include "../core/plugin.h"
 #include "../core/waveManager.h"
+#include "../core/peakBuilder.h"
+#include "../core/command.h"
+#include "../core/midiDispatcher.h"
 #include "main.h"
 #include "channel.h"
 
@@ -66,13 +70,76 @@ extern gdMainWindow* G_MainWin;
 
 
 using std::string;
+using namespace giada::m::command;
 
 
 namespace giada {
 namespace c     {
 namespace channel 
 {
-int loadChannel(SampleChannel* ch, const string& fname)
+namespace
+{
+/* reloadChannel_
+Loads the current sample again with a different storage, keeping begin and end
+points. */
+
+int reloadChannel_(SampleChannel* ch, m::waveManager::Storage storage)
+{
+	int begin  = ch->getBegin();
+	int end    = ch->getEnd();
+	int result = loadChannel(ch, ch->wave->getPath(), storage);
+	if (result != G_RES_OK)
+		return result;
+
+	ch->setBegin(begin);
+	ch->setEnd(end);
+	return result;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* refreshEditorCb_
+Refreshes the sample editor, if open, once the changes pushed so far have 
+reached the channel. GUI thread only. */
+
+void refreshEditorCb_(void* /*data*/)
+{
+	gdSampleEditor* gdEditor = static_cast<gdSampleEditor*>(gu_getSubwindow(G_MainWin, WID_SAMPLE_EDITOR));
+	if (gdEditor == nullptr)
+		return;
+	flush();
+	gdEditor->volumeTool->refresh();
+	gdEditor->boostTool->refresh();
+	gdEditor->panTool->refresh();
+	gdEditor->pitchTool->refresh();
+}
+
+
+/* refreshEditor_
+From MIDI (gui == false) nothing waits for the audio thread: the GUI thread 
+is woken up to refresh the editor on its own. */
+
+void refreshEditor_(bool gui)
+{
+	if (gui) {
+		Fl::lock();
+		refreshEditorCb_(nullptr);
+		Fl::unlock();
+	}
+	else
+		Fl::awake(refreshEditorCb_, nullptr);
+}
+}; // {anonymous}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+
+int loadChannel(SampleChannel* ch, const string& fname, m::waveManager::Storage storage)
 {
 	using namespace giada::m;
 
@@ -88,21 +155,32 @@ int loadChannel(SampleChannel* ch, const string& fname)
 	conf::samplePath = gu_dirname(fname);
 
 	Wave* wave = nullptr;
-	int result = waveManager::create(fname, &wave); 
+	int result = waveManager::create(fname, &wave, storage, conf::samplerate); 
 	if (result != G_RES_OK)
 		return result;
 
-	if (wave->getRate() != conf::samplerate) {
-		gu_log("[loadChannel] input rate (%d) != system rate (%d), conversion needed\n",
-			wave->getRate(), conf::samplerate);
-		result = waveManager::resample(wave, conf::rsmpQuality, conf::samplerate); 
-		if (result != G_RES_OK) {
-			delete wave;
-			return result;
-		}
+	/* The audio thread swaps waves at the beginning of a block, then the old one
+	is freed: a streamed wave keeps a file open and the disk thread busy until 
+	deleted. The name is set from here too, so that pushWave() finds a buffer 
+	already large enough for it. */
+
+	Wave*  old  = ch->wave;
+	string name = ch->name;
+	ch->name = wave->getBasename();
+
+	Command c = make(CommandType::PUSH_WAVE, ch);
+	c.wave = wave;
+	if (!push(c)) {
+		ch->name = name;
+		delete wave;
+		return G_RES_ERR_PROCESSING;
 	}
+	if (flush())
+		delete old;
+	else
+		gu_log("[loadChannel] swap not confirmed, old wave leaked\n");
 
-	ch->pushWave(wave);
+	peakBuilder::request(*wave);
 
 	G_MainWin->keyboard->updateChannel(ch->guiChannel);
 
@@ -113,6 +191,29 @@ int loadChannel(SampleChannel* ch, const string& fname)
 /* -------------------------------------------------------------------------- */
 
 
+int loadChannelInMemory(SampleChannel* ch)
+{
+	if (ch->wave == nullptr || ch->wave->isDirect() || ch->wave->isChunked())
+		return G_RES_OK;
+	return reloadChannel_(ch, m::waveManager::Storage::FLOAT);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int setNativeStorage(SampleChannel* ch, bool native)
+{
+	if (ch->wave == nullptr || ch->wave->isNative() == native)
+		return G_RES_OK;
+	return reloadChannel_(ch, native ? m::waveManager::Storage::NATIVE : 
+		m::waveManager::Storage::FLOAT);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 Channel* addChannel(int column, ChannelType type, int size)
 {
 	Channel* ch    = m::mh::addChannel(type);
@@ -132,6 +233,13 @@ void deleteChannel(Channel* ch)
 	if (!gdConfirmWin("Warning", "Delete channel: are you sure?"))
 		return;
 	recorder::clearChan(ch->index);
+
+	/* Out of the mixer first: commands still pending for the channel are 
+	discarded from now on. Then wait for those that might still refer to its
+	plug-ins. */
+
+	mh::deleteChannel(ch);
+	flush();
 	ch->hasActions = false;
 #ifdef WITH_VST
 	pluginHost::freeStack(pluginHost::CHANNEL, &mixer::mutex, ch);
@@ -139,7 +247,6 @@ void deleteChannel(Channel* ch)
 	Fl::lock();
 	G_MainWin->keyboard->deleteChannel(ch->guiChannel);
 	Fl::unlock();
-	mh::deleteChannel(ch);
 	gu_closeAllSubwindows();
 }
 
@@ -159,6 +266,7 @@ void freeChannel(Channel* ch)
 
 	G_MainWin->keyboard->freeChannel(ch->guiChannel);
 	m::recorder::clearChan(ch->index);
+	flush();
 	ch->empty();
 
 	/* delete any related subwindow */
@@ -204,6 +312,7 @@ int cloneChannel(Channel* src)
 
 	ch->guiChannel = gch;
 	ch->copy(src, &mixer::mutex);
+	midiDispatcher::invalidate();  // Learned messages copied from 'src'
 
 	G_MainWin->keyboard->updateChannel(ch->guiChannel);
 	return true;
@@ -215,18 +324,12 @@ int cloneChannel(Channel* src)
 
 void setVolume(Channel* ch, float v, bool gui, bool editor)
 {
-	ch->volume = v;
+	push(make(CommandType::SET_VOLUME, ch, 0, v));
 
 	/* Changing channel volume? Update wave editor (if it's shown). */
 
-	if (!editor) {
-		gdSampleEditor* gdEditor = static_cast<gdSampleEditor*>(gu_getSubwindow(G_MainWin, WID_SAMPLE_EDITOR));
-		if (gdEditor) {
-			Fl::lock();
-			gdEditor->volumeTool->refresh();
-			Fl::unlock();
-		}
-	}
+	if (!editor)
+		refreshEditor_(gui);
 
 	if (!gui) {
 		Fl::lock();
@@ -239,15 +342,20 @@ void setVolume(Channel* ch, float v, bool gui, bool editor)
 /* -------------------------------------------------------------------------- */
 
 
-void setPitch(SampleChannel* ch, float val)
+void setPitch(SampleChannel* ch, float val, bool gui)
 {
-	ch->setPitch(val);
-	gdSampleEditor* gdEditor = static_cast<gdSampleEditor*>(gu_getSubwindow(G_MainWin, WID_SAMPLE_EDITOR));
-	if (gdEditor) {
-		Fl::lock();
-		gdEditor->pitchTool->refresh();
-		Fl::unlock();
-	}
+	push(make(CommandType::SET_PITCH, ch, 0, val));
+	refreshEditor_(gui);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void setInterpolation(SampleChannel* ch, Interpolation i)
+{
+	push(make(CommandType::SET_INTERPOLATION, ch, static_cast<int>(i)));
+	flush();
 }
 
 
@@ -256,13 +364,8 @@ void setPitch(SampleChannel* ch, float val)
 
 void setPanning(SampleChannel* ch, float val)
 {
-	ch->setPan(val);
-	gdSampleEditor* gdEditor = static_cast<gdSampleEditor*>(gu_getSubwindow(G_MainWin, WID_SAMPLE_EDITOR));
-	if (gdEditor) {
-		Fl::lock();
-		gdEditor->panTool->refresh();
-		Fl::unlock();
-	}
+	push(make(CommandType::SET_PAN, ch, 0, val));
+	refreshEditor_(/*gui=*/true);
 }
 
 
@@ -271,10 +374,13 @@ void setPanning(SampleChannel* ch, float val)
 
 void toggleMute(Channel* ch, bool gui)
 {
-	ch->setMute(!ch->mute);
+	/* Flipped by the audio thread: the channel state might not be up to date
+	yet, if other toggles are pending. The button keeps track on its own. */
+
+	push(make(CommandType::TOGGLE_MUTE, ch));
 	if (!gui) {
 		Fl::lock();
-		ch->guiChannel->mute->value(ch->mute);
+		ch->guiChannel->mute->value(!ch->guiChannel->mute->value());
 		Fl::unlock();
 	}
 }
@@ -285,10 +391,10 @@ void toggleMute(Channel* ch, bool gui)
 
 void toggleSolo(Channel* ch, bool gui)
 {
-	ch->setSolo(!ch->solo);
+	push(make(CommandType::TOGGLE_SOLO, ch));
 	if (!gui) {
 		Fl::lock();
-		ch->guiChannel->solo->value(ch->solo);
+		ch->guiChannel->solo->value(!ch->guiChannel->solo->value());
 		Fl::unlock();
 	}
 }
@@ -299,7 +405,7 @@ void toggleSolo(Channel* ch, bool gui)
 
 void kill(Channel* ch)
 {
-	ch->kill(0); // on frame 0: it's a user-generated event
+	push(make(CommandType::KILL, ch)); // on frame 0: it's a user-generated event
 }
 
 
@@ -308,13 +414,8 @@ void kill(Channel* ch)
 
 void setBoost(SampleChannel* ch, float val)
 {
-	ch->setBoost(val);
-	gdSampleEditor *gdEditor = static_cast<gdSampleEditor*>(gu_getSubwindow(G_MainWin, WID_SAMPLE_EDITOR));
-	if (gdEditor) {
-		Fl::lock();
-		gdEditor->boostTool->refresh();
-		Fl::unlock();
-	}
+	push(make(CommandType::SET_BOOST, ch, 0, val));
+	refreshEditor_(/*gui=*/true);
 }
 
 
@@ -31,6 +31,7 @@
 
 #include <string>
 #include "../core/types.h"
+#include "../core/waveManager.h"
 
 
 class Channel;
@@ -48,9 +49,23 @@ Adds an empty new channel to the stack. Returns the new channel. */
 Channel* addChannel(int column, ChannelType type, int size);
 
 /* loadChannel
-Fills an existing channel with a wave. */
+Fills an existing channel with a wave, stored as in 'storage' (see 
+waveManager::create). */
 
-int loadChannel(SampleChannel* ch, const std::string& fname);
+int loadChannel(SampleChannel* ch, const std::string& fname, 
+	m::waveManager::Storage storage=m::waveManager::Storage::AUTO);
+
+/* loadChannelInMemory
+Reloads a streamed or native sample in memory as float, keeping begin and end 
+points. Editing works on the whole data. Does nothing for other samples. */
+
+int loadChannelInMemory(SampleChannel* ch);
+
+/* setNativeStorage
+Reloads the sample in its native format (see NativeBuffer) or as float, keeping
+begin and end points. */
+
+int setNativeStorage(SampleChannel* ch, bool native);
 
 /* deleteChannel
 Removes a channel from Mixer. */
@@ -78,7 +93,8 @@ void toggleMute(Channel* ch, bool gui=true);
 void toggleSolo(Channel* ch, bool gui=true);
 void setVolume(Channel* ch, float v, bool gui=true, bool editor=false);
 void setName(Channel* ch, const std::string& name);
-void setPitch(SampleChannel* ch, float val);
+void setPitch(SampleChannel* ch, float val, bool gui=true);
+void setInterpolation(SampleChannel* ch, Interpolation i);
 void setPanning(SampleChannel* ch, float val);
 void setBoost(SampleChannel* ch, float val);
 
@@ -45,6 +45,7 @@
 #include "../core/clock.h"
 #include "../core/sampleChannel.h"
 #include "../core/midiChannel.h"
+#include "../core/command.h"
 #include "main.h"
 #include "channel.h"
 #include "transport.h"
@@ -60,18 +61,18 @@ namespace io
 {
 void keyPress(Channel* ch, bool ctrl, bool shift, int velocity)
 {
-	/* Everything occurs on frame 0 here: they are all user-generated events. */
+	using namespace giada::m;
+
+	/* Everything occurs on frame 0 here: they are all user-generated events. 
+	The audio thread takes care of them at the beginning of the next block. */
+
 	if (ctrl)
 		c::channel::toggleMute(ch);
 	else
-	if (shift) {
-		if (ch->recordKill())
-			ch->kill(0);
-	}
-	else {
-		if (ch->recordStart(m::clock::canQuantize()))
-			ch->start(0, m::clock::canQuantize(), 0);
-	}
+	if (shift)
+		command::push(command::make(command::CommandType::KILL, ch, /*rec=*/1));
+	else
+		command::push(command::make(command::CommandType::KEY_PRESS, ch, /*velocity=*/0));
 }
 
 
@@ -80,10 +81,10 @@ void keyPress(Channel* ch, bool ctrl, bool shift, int velocity)
 
 void keyRelease(Channel* ch, bool ctrl, bool shift)
 {
-	if (!ctrl && !shift) {
-		ch->recordStop();
-		ch->stop();
-	}
+	using namespace giada::m;
+
+	if (!ctrl && !shift)
+		command::push(command::make(command::CommandType::KEY_RELEASE, ch));
 }
 
 
@@ -124,10 +125,7 @@ void startActionRec(bool gui)
 
 void stopActionRec(bool gui)
 {
-	/* Stop the recorder and sort newly recorder actions. */
-
 	m::recorder::active = false;
-	m::recorder::sortActions();
 
 	for (Channel* ch : m::mixer::channels)
 	{
@@ -70,9 +70,7 @@ void setBpm_(float f, string s)
 		s = G_MAX_BPM_STR;		
 	}
 
-	float vPre = clock::getBpm();
-	clock::setBpm(f);
-	recorder::updateBpm(vPre, f, clock::getQuanto());
+	clock::setBpm(f);  // recorded actions follow, see recorder::setFramesInBeat()
 	mixer::allocVirtualInput(clock::getFramesInLoop());
 
 	gu_refreshActionEditor();
@@ -143,7 +141,6 @@ void glue_setBeats(int beats, int bars, bool expand)
 	/* Temp vars to store old data (they are necessary) */
 
 	int oldBeats = clock::getBeats();
-	unsigned oldTotalFrames = clock::getFramesInLoop();
 
 	clock::setBeats(beats);
 	clock::setBars(bars);
@@ -154,7 +151,7 @@ void glue_setBeats(int beats, int bars, bool expand)
 	place. */
 
 	if (expand && clock::getBeats() > oldBeats)
-		recorder::expand(oldTotalFrames, clock::getFramesInLoop());
+		recorder::expand(oldBeats, clock::getBeats());
 
 	G_MainWin->mainTimer->setMeter(clock::getBeats(), clock::getBars());
 	gu_refreshActionEditor();  // in case the action editor is open
@@ -35,6 +35,7 @@
 #include "../core/channel.h"
 #include "../core/const.h"
 #include "../core/conf.h"
+#include "../core/command.h"
 #include "../utils/gui.h"
 #include "../gui/dialogs/gd_mainWindow.h"
 #include "../gui/dialogs/pluginWindow.h"
@@ -58,10 +59,10 @@ namespace plugin
 namespace
 {
 /* getPluginWindow
-Returns the plugInWindow (GUI-less one) with the parameter list. It might be 
-nullptr if there is no plug-in window shown on screen. */
+Returns the plugInWindow (GUI-less one) with the parameter list of plug-in 'id'.
+It might be nullptr if there is no plug-in window shown on screen. */
 
-gdPluginWindow* getPluginWindow(const Plugin* p)
+gdPluginWindow* getPluginWindow(int id)
 {
 	/* Get the parent window first: the plug-in list. Then, if it exists, get
 	the child window - the actual pluginWindow. */
@@ -69,7 +70,61 @@ gdPluginWindow* getPluginWindow(const Plugin* p)
 	gdPluginList* parent = static_cast<gdPluginList*>(gu_getSubwindow(G_MainWin, WID_FX_LIST));
 	if (parent == nullptr)
 		return nullptr;
-	return static_cast<gdPluginWindow*>(gu_getSubwindow(parent, p->getId() + 1));
+	return static_cast<gdPluginWindow*>(gu_getSubwindow(parent, id + 1));
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* updateWindow_
+Shows the new value of parameter 'index' in the plug-in window, once the 
+command that sets it went through. No need to do it if the plug-in has an 
+editor: the plug-in's editor takes care of it on its own. Conversely, update 
+the specific parameter for UI-less plug-ins. GUI thread only. */
+
+void updateWindow_(Plugin* p, int index, bool gui)
+{
+	if (p->hasEditor())
+		return;
+
+	gdPluginWindow* child = getPluginWindow(p->getId());
+	if (child == nullptr) 
+		return;
+
+	command::flush();
+	child->updateParameter(index, !gui);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* Automation_
+A parameter change coming from MIDI, on its way to the GUI thread. See 
+automateParameter(). */
+
+struct Automation_
+{
+	Channel* ch;
+	int      plugin;  // Plugin::getId()
+	int      index;
+};
+
+
+/* -------------------------------------------------------------------------- */
+
+/* updateWindowCb_
+Fl::awake() callback, run by the GUI thread: the plug-in is looked up again 
+there, in case it was freed in the meantime. */
+
+void updateWindowCb_(void* data)
+{
+	Automation_* a = static_cast<Automation_*>(data);
+	for (Plugin* p : a->ch->plugins)
+		if (p->getId() == a->plugin) {
+			updateWindow_(p, a->index, /*gui=*/false);
+			break;
+		}
+	delete a;
 }
 } // {anonymous}
 
@@ -120,7 +175,7 @@ void setProgram(Plugin* p, int index)
 	if (p->hasEditor())
 		return;
 
-	gdPluginWindow* child = getPluginWindow(p);
+	gdPluginWindow* child = getPluginWindow(p->getId());
 	if (child == nullptr) 
 		return;
 	
@@ -133,22 +188,31 @@ void setProgram(Plugin* p, int index)
 
 void setParameter(Plugin* p, int index, float value, bool gui)
 {
-	p->setParameter(index, value);
+	command::Command c = command::make(command::CommandType::SET_PLUGIN_PARAM, 
+		nullptr, index, value);
+	c.plugin = p->getId();
+	command::push(c);
+	updateWindow_(p, index, gui);
+}
 
-	/* No need to update plug-in editor if it has one: the plug-in's editor takes
-	care of it on its own. Conversely, update the specific parameter for UI-less 
-	plug-ins. */
 
-	if (p->hasEditor())
-		return;
+/* -------------------------------------------------------------------------- */
 
-	gdPluginWindow* child = getPluginWindow(p);
-	if (child == nullptr) 
-		return;
 
-	Fl::lock();
-	child->updateParameter(index, !gui);
-	Fl::unlock();
+void automateParameter(Channel* ch, int pluginId, int index, float value, 
+	command::Time time)
+{
+	command::Command c = command::makeTimed(command::CommandType::SET_PLUGIN_PARAM, 
+		ch, time, index);
+	c.plugin = pluginId;
+	c.fValue = value;
+	command::push(c);
+
+	/* Not on the GUI thread: the window is refreshed over there. */
+
+	Automation_* a = new Automation_{ ch, pluginId, index };
+	if (Fl::awake(updateWindowCb_, a) != 0)
+		delete a;
 }
 
 
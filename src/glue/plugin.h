@@ -35,6 +35,9 @@
 #ifdef WITH_VST
 
 
+#include "../core/command.h"
+
+
 class Plugin;
 class Channel;
 
@@ -47,6 +50,15 @@ Plugin* addPlugin(Channel* ch, int index, int stackType);
 void swapPlugins(Channel* ch, int indexP1, int indexP2, int stackType);
 void freePlugin(Channel* ch, int index, int stackType);
 void setParameter(Plugin* p, int index, float value, bool gui=true); 
+
+/* automateParameter
+Like setParameter(), for changes coming from MIDI learn on channel 'ch' at 
+'time': they land on the matching frame of the block and get recorded as 
+G_ACTION_PLUGIN actions if the recorder is on. The plug-in is passed by id 
+and never touched here, so that it can be called by the MIDI thread. */
+
+void automateParameter(Channel* ch, int pluginId, int index, float value, 
+	m::command::Time time);
 void setProgram(Plugin* p, int index);
 
 /* setPluginPathCb
@@ -166,8 +166,7 @@ void recordMidiAction(int chan, int note, int velocity, int frame_a, int frame_b
 
 void deleteMidiAction(MidiChannel* ch, m::recorder::action a1, m::recorder::action a2)
 {
-	m::recorder::deleteAction(ch->index, a1.frame, G_ACTION_MIDI, true, 
-		&m::mixer::mutex, a1.iValue, 0.0);
+	m::recorder::deleteAction(ch->index, a1.frame, G_ACTION_MIDI, true, a1.iValue, 0.0);
 	
 	/* If action 1 is not orphaned, send a note-off first in case we are deleting 
 	it in a middle of a key_on/key_off sequence. Conversely, orphaned actions
@@ -175,8 +174,7 @@ void deleteMidiAction(MidiChannel* ch, m::recorder::action a1, m::recorder::acti
 	
 	if (a2.frame != -1) {
 		ch->sendMidi(a2.iValue);
-		m::recorder::deleteAction(ch->index, a2.frame, G_ACTION_MIDI, true, 
-			&m::mixer::mutex, a2.iValue, 0.0);
+		m::recorder::deleteAction(ch->index, a2.frame, G_ACTION_MIDI, true, a2.iValue, 0.0);
 	}
 
 	ch->hasActions = m::recorder::hasActions(ch->index);
@@ -201,15 +199,13 @@ void recordSampleAction(SampleChannel* ch, int type, int frame_a, int frame_b)
 /* -------------------------------------------------------------------------- */
 
 
-void recordEnvelopeAction(Channel* ch, int type, int frame, float fValue)
+void recordEnvelopeAction(Channel* ch, int type, int frame, float fValue, 
+	uint32_t iValue)
 {
 	namespace mr = m::recorder;
 
-	if (!mr::hasActions(ch->index, type)) {  // First action ever? Add actions at boundaries.
-		mr::rec(ch->index, type, 0, 0, 1.0);	
-		mr::rec(ch->index, type, m::clock::getFramesInLoop() - 1, 0, 1.0);	
-	}
-	mr::rec(ch->index, type, frame, 0, fValue);
+	mr::recEnvelope(ch->index, type, frame, m::clock::getFramesInLoop() - 1, 
+		iValue, fValue, 1.0f);
 
 	updateChannel(ch->guiChannel, /*refreshActionEditor=*/false);
 }
@@ -226,9 +222,9 @@ void deleteEnvelopeAction(Channel* ch, m::recorder::action a, bool moved)
 	selected action only. */
 
 	if (!moved && (a.frame == 0 || a.frame == m::clock::getFramesInLoop() - 1))
-		mr::clearAction(ch->index, a.type);
+		m::recorder::clearAction(ch->index, a.type, a.iValue);
 	else
-		mr::deleteAction(ch->index, a.frame, a.type, false, &m::mixer::mutex);
+		m::recorder::deleteAction(ch->index, a.frame, a.type, a.iValue != 0, a.iValue, a.fValue);
 
 	updateChannel(ch->guiChannel, /*refreshActionEditor=*/false);
 }
@@ -245,11 +241,11 @@ void deleteSampleAction(SampleChannel* ch, m::recorder::action a1,
 	/* if SINGLE_PRESS delete both the keypress and the keyrelease pair. */
 
 	if (ch->mode == ChannelMode::SINGLE_PRESS) {
-		mr::deleteAction(ch->index, a1.frame, G_ACTION_KEYPRESS, false, &m::mixer::mutex);
-		mr::deleteAction(ch->index, a2.frame, G_ACTION_KEYREL, false, &m::mixer::mutex);
+		m::recorder::deleteAction(ch->index, a1.frame, G_ACTION_KEYPRESS, false);
+		m::recorder::deleteAction(ch->index, a2.frame, G_ACTION_KEYREL, false);
 	}
 	else
-		mr::deleteAction(ch->index, a1.frame, a1.type, false, &m::mixer::mutex);
+		m::recorder::deleteAction(ch->index, a1.frame, a1.type, false);
 
   updateChannel(ch->guiChannel, /*refreshActionEditor=*/false);
 }
@@ -264,7 +260,6 @@ vector<m::recorder::Composite> getSampleActions(const SampleChannel* ch)
 
 	vector<mr::Composite> out;
 
-	mr::sortActions();
 	mr::forEachAction([&](const mr::action* a1)
 	{
 		/* Exclude:
@@ -287,10 +282,9 @@ vector<m::recorder::Composite> getSampleActions(const SampleChannel* ch)
 		fetch the corresponding G_ACTION_KEYREL. */
 
 		if (ch->mode == ChannelMode::SINGLE_PRESS && a1->type == G_ACTION_KEYPRESS) {
-			m::recorder::action* a2 = nullptr;
-			mr::getNextAction(ch->index, G_ACTION_KEYREL, a1->frame, &a2);
-			if (a2 != nullptr)
-				cmp.a2 = *a2;
+			mr::action a2;
+			if (mr::getNextAction(ch->index, G_ACTION_KEYREL, a1->frame, &a2) == 1)
+				cmp.a2 = a2;
 		}
 
 		out.push_back(cmp);
@@ -303,23 +297,24 @@ vector<m::recorder::Composite> getSampleActions(const SampleChannel* ch)
 /* -------------------------------------------------------------------------- */
 
 
-vector<m::recorder::action> getEnvelopeActions(const Channel* ch, int type)
+vector<m::recorder::action> getEnvelopeActions(const Channel* ch, int type,
+	uint32_t iValue)
 {
 	namespace mr = m::recorder;
 
 	vector<mr::action> out;
 
-	mr::sortActions();
 	mr::forEachAction([&](const mr::action* a)
 	{
 		/* Exclude:
 		- actions beyond clock::getFramesInLoop();
 		- actions that don't belong to channel ch;
-		- actions with wrong type. */
+		- actions with wrong type or iValue. */
 
 		if (a->frame > m::clock::getFramesInLoop() || 
 			  a->chan != ch->index                   || 
-			  a->type != type)
+			  a->type != type                        ||
+			  a->iValue != iValue)
 			return;
 
 		out.push_back(*a);
@@ -341,8 +336,7 @@ void setVelocity(const Channel* ch, m::recorder::action a, int value)
 	m::MidiEvent event = m::MidiEvent(a.iValue);
 	event.setVelocity(value);
 
-	m::recorder::deleteAction(ch->index, a.frame, G_ACTION_MIDI, true, 
-		&m::mixer::mutex, a.iValue, 0.0);
+	m::recorder::deleteAction(ch->index, a.frame, G_ACTION_MIDI, true, a.iValue, 0.0);
 	m::recorder::rec(ch->index, G_ACTION_MIDI, a.frame, event.getRaw());
 }
 
@@ -352,57 +346,51 @@ void setVelocity(const Channel* ch, m::recorder::action a, int value)
 
 vector<m::recorder::Composite> getMidiActions(int chan)
 {
-	vector<m::recorder::Composite> out;
-
-	m::recorder::sortActions();
-
-	for (unsigned i=0; i<m::recorder::frames.size(); i++) {
-
-		if (m::recorder::frames.at(i) > m::clock::getFramesInLoop())
-			continue;
-
-		for (unsigned j=0; j<m::recorder::global.at(i).size(); j++) {
+	namespace mr = m::recorder;
 
-			m::recorder::action* a1 = m::recorder::global.at(i).at(j);
-			m::recorder::action* a2 = nullptr;
+	vector<mr::Composite> out;
 
-			m::MidiEvent a1midi(a1->iValue);
+	mr::forEachAction([&](const mr::action* a1)
+	{
+		m::MidiEvent a1midi(a1->iValue);
 
-			/* Skip action if:
-				- does not belong to this channel
-				- is not a MIDI action (we only want MIDI things here)
-				- is not a MIDI Note On type. We don't want any other kind of action here */
+		/* Skip action if:
+			- is beyond clock::getFramesInLoop()
+			- does not belong to this channel
+			- is not a MIDI action (we only want MIDI things here)
+			- is not a MIDI Note On type. We don't want any other kind of action here */
 
-			if (a1->chan != chan || a1->type != G_ACTION_MIDI || 
-				  a1midi.getStatus() != m::MidiEvent::NOTE_ON)
-				continue;
+		if (a1->frame > m::clock::getFramesInLoop() || 
+			  a1->chan != chan || a1->type != G_ACTION_MIDI || 
+			  a1midi.getStatus() != m::MidiEvent::NOTE_ON)
+			return;
 
-			/* Prepare the composite action. Action 1 exists for sure, so fill it up
-			right away. */
+		/* Prepare the composite action. Action 1 exists for sure, so fill it up
+		right away. */
 
-			m::recorder::Composite cmp; 
-			cmp.a1 = *a1;
+		mr::Composite cmp; 
+		cmp.a1 = *a1;
 
-			/* Search for the next action. Must have: same channel, G_ACTION_MIDI,
-			greater than a1->frame and with MIDI properties of note_off (0x80), same
-			note of a1 and random velocity: we don't care about it (and so we mask it
-			with 0x0000FF00). */
+		/* Search for the next action. Must have: same channel, G_ACTION_MIDI,
+		greater than a1->frame and with MIDI properties of note_off (0x80), same
+		note of a1 and random velocity: we don't care about it (and so we mask it
+		with 0x0000FF00). */
 
-			m::recorder::getNextAction(chan, G_ACTION_MIDI, a1->frame, &a2, 
-				m::MidiEvent(m::MidiEvent::NOTE_OFF, a1midi.getNote(), 0x0).getRaw(), 
-				0x0000FF00);
+		mr::action a2;
+		int res = mr::getNextAction(chan, G_ACTION_MIDI, a1->frame, &a2, 
+			m::MidiEvent(m::MidiEvent::NOTE_OFF, a1midi.getNote(), 0x0).getRaw(), 
+			0x0000FF00);
 
-			/* If action 2 has been found, add it to the composite duo. Otherwise
-			set the action 2 frame to -1: it should be intended as "orphaned". */
+		/* If action 2 has been found, add it to the composite duo. Otherwise
+		set the action 2 frame to -1: it should be intended as "orphaned". */
 
-			if (a2 != nullptr)
-				cmp.a2 = *a2;
-			else
-				cmp.a2.frame = -1;
+		if (res == 1)
+			cmp.a2 = a2;
+		else
+			cmp.a2.frame = -1;
 
-			out.push_back(cmp);
-		}
-	}
+		out.push_back(cmp);
+	});
 
 	return out;
 }
@@ -60,7 +60,12 @@ size. This function is designed for the Piano Roll (not for live recording). */
 
 void recordMidiAction(int chan, int note, int velocity, int frame_a, int frame_b=0);
 
-void recordEnvelopeAction(Channel* ch, int type, int frame, float fValue);
+/* recordEnvelopeAction
+Adds a point to the envelope of type 'type' and, if not zero, iValue 'iValue'
+(e.g. a plug-in parameter). */
+
+void recordEnvelopeAction(Channel* ch, int type, int frame, float fValue, 
+	uint32_t iValue=0);
 
 void recordSampleAction(SampleChannel* ch, int type, int frame_a, int frame_b=0);
 
@@ -72,7 +77,8 @@ editor as pairs of NoteOn+NoteOff. */
 
 std::vector<m::recorder::Composite> getMidiActions(int channel);
 
-std::vector<m::recorder::action> getEnvelopeActions(const Channel* ch, int type);
+std::vector<m::recorder::action> getEnvelopeActions(const Channel* ch, int type,
+	uint32_t iValue=0);
 
 /* getSampleActions
 Returns a list of Composite actions, ready to be displayed in a Sample Action
@@ -26,6 +26,8 @@
 
 
 #include <cassert>
+#include <memory>
+#include <vector>
 #include <FL/Fl.H>
 #include "../gui/dialogs/gd_mainWindow.h"
 #include "../gui/dialogs/sampleEditor.h"
@@ -41,9 +43,13 @@
 #include "../gui/elems/sampleEditor/waveform.h"
 #include "../gui/elems/mainWindow/keyboard/channel.h"
 #include "../core/sampleChannel.h"
+#include "../core/command.h"
 #include "../core/waveFx.h"
 #include "../core/wave.h"
+#include "../core/waveEditor.h"
+#include "../core/rope.h"
 #include "../core/waveManager.h"
+#include "../core/peakBuilder.h"
 #include "../core/const.h"
 #include "../utils/gui.h"
 #include "../utils/log.h"
@@ -64,6 +70,168 @@ namespace
 	A Wave used during cut/copy/paste operations. */
 
 	Wave* m_waveBuffer = nullptr;
+
+
+/* -------------------------------------------------------------------------- */
+
+/* Version_
+A state of the sample being edited, for undo and redo. Data is shared with the
+other versions, so keeping many of them costs little (see Rope). */
+
+struct Version_
+{
+	std::shared_ptr<const m::Rope> rope;
+	int begin;
+	int end;
+	int shift;
+};
+
+const unsigned HISTORY_SIZE = 64;
+
+std::vector<Version_>          m_undo;
+std::vector<Version_>          m_redo;
+std::shared_ptr<const m::Rope> m_current;  // data the history leads to
+
+/* m_retired
+Waves replaced while the audio thread didn't confirm it in time: it might still
+be reading them. Freed on the next confirmed swap. */
+
+std::vector<Wave*> m_retired;
+
+
+/* -------------------------------------------------------------------------- */
+
+
+Version_ getVersion_(const SampleChannel* ch)
+{
+	const Wave* w = ch->wave;
+	std::shared_ptr<const m::Rope> rope = w->isChunked() ? w->getRope() : 
+		std::make_shared<m::Rope>(w->getBuffer());
+	return { rope, ch->getBegin(), ch->getEnd(), ch->shift };
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* isHistoryValid_
+The history is void if the wave has been replaced by other means in the 
+meantime, e.g. reloaded. */
+
+bool isHistoryValid_(const SampleChannel* ch)
+{
+	return ch->wave != nullptr && ch->wave->getRope() == m_current;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* swap_
+Hands 'wave' over to the audio thread, which puts it in place of the current 
+one at the beginning of a block: playback never waits. */
+
+bool swap_(SampleChannel* ch, Wave* wave)
+{
+	namespace mc = m::command;
+
+	mc::Command c = mc::make(mc::CommandType::SET_WAVE, ch);
+	c.wave = wave;
+
+	Wave* old = ch->wave;
+	if (!mc::push(c)) {
+		delete wave;
+		return false;
+	}
+	m_retired.push_back(old);
+	if (!mc::flush()) {
+		gu_log("[sampleEditor::swap_] swap not confirmed, old wave kept for now\n");
+		return true;
+	}
+	for (Wave* w : m_retired)  // the audio thread has let go of them
+		delete w;
+	m_retired.clear();
+	return true;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* edit_
+Runs 'op' in background on a copy of the wave of channel 'ch', showing progress
+in the editor, then swaps the result in. The previous version goes to the undo
+history. Returns false if the operation has failed or has been cancelled. */
+
+bool edit_(SampleChannel* ch, m::waveEditor::Op op)
+{
+	Version_ prev = getVersion_(ch);
+
+	if (!m::waveEditor::start(*ch->wave, op))
+		return false;
+
+	/* Keep the GUI alive meanwhile. The main window is off limits, so that the
+	channel can't go away. */
+
+	gdSampleEditor* gdEditor = static_cast<gdSampleEditor*>(gu_getSubwindow(G_MainWin, 
+		WID_SAMPLE_EDITOR));
+	gdEditor->setBusy(true);
+	G_MainWin->deactivate();
+	while (m::waveEditor::isBusy()) {
+		Fl::wait(0.02);
+		gdEditor->setProgress(m::waveEditor::getProgress());
+	}
+	G_MainWin->activate();
+	gdEditor->setBusy(false);
+
+	Wave* wave = m::waveEditor::finish();
+	if (wave == nullptr || !swap_(ch, wave))
+		return false;
+
+	if (prev.rope != m_current)
+		clearHistory();
+	m_undo.push_back(prev);
+	if (m_undo.size() > HISTORY_SIZE)
+		m_undo.erase(m_undo.begin());
+	m_redo.clear();
+	m_current = ch->wave->getRope();
+	gdEditor->updateHistory();
+	return true;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* restore_
+Puts back version 'v' of the sample. */
+
+bool restore_(SampleChannel* ch, const Version_& v)
+{
+	Wave* wave = new Wave(*ch->wave);
+	wave->setLogical(ch->wave->isLogical());
+	wave->setEdited(true);
+	wave->setRope(v.rope);
+	if (!swap_(ch, wave))
+		return false;
+	m_current = v.rope;
+	m::peakBuilder::request(*ch->wave);
+
+	ch->shift = v.shift;
+	ch->setEnd(v.end);  // so that begin is not clamped to the current end
+	setBeginEnd(ch, v.begin, v.end);
+	return true;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void refreshEditor_()
+{
+	gdSampleEditor* gdEditor = static_cast<gdSampleEditor*>(gu_getSubwindow(G_MainWin, 
+		WID_SAMPLE_EDITOR));
+	gdEditor->shiftTool->refresh();
+	gdEditor->waveTools->waveform->refresh();
+	gdEditor->updateInfo();
+	gdEditor->updateHistory();
+}
 }; // {anonymous}
 
 
@@ -102,8 +270,15 @@ void setBeginEnd(SampleChannel* ch, int b, int e)
 void cut(SampleChannel* ch, int a, int b)
 {
 	copy(ch, a, b);
-	if (!m::wfx::cut(*ch->wave, a, b)) {
-		gdAlert("Unable to cut the sample!");
+	bool ok = edit_(ch, [a, b](Wave& w, m::wfx::Task& t)
+	{
+		int res = m::wfx::cut(w, a, b, &t);
+		m::peakBuilder::request(w);
+		return res;
+	});
+	if (!ok) {
+		if (!m::waveEditor::isCancelled())
+			gdAlert("Unable to cut the sample!");
 		return;
 	}
 	setBeginEnd(ch, ch->getBegin(), ch->getEnd());
@@ -135,7 +310,15 @@ void paste(SampleChannel* ch, int a)
 		return;
 	}
 	
-	m::wfx::paste(*m_waveBuffer, *ch->wave, a);
+	const Wave* buffer = m_waveBuffer;
+	bool ok = edit_(ch, [buffer, a](Wave& w, m::wfx::Task& t)
+	{
+		int res = m::wfx::paste(*buffer, w, a, &t);
+		m::peakBuilder::request(w);
+		return res;
+	});
+	if (!ok)
+		return;
 
 	/* Shift begin/end points to keep the previous position. */
 
@@ -157,7 +340,14 @@ void paste(SampleChannel* ch, int a)
 
 void silence(SampleChannel* ch, int a, int b)
 {
-	m::wfx::silence(*ch->wave, a, b);
+	bool ok = edit_(ch, [a, b](Wave& w, m::wfx::Task& t)
+	{
+		m::wfx::silence(w, a, b, &t);
+		m::peakBuilder::update(w, a, b);
+		return G_RES_OK;
+	});
+	if (!ok)
+		return;
 	gdSampleEditor* gdEditor = getSampleEditorWindow();
 	gdEditor->waveTools->waveform->refresh();
 }
@@ -168,7 +358,14 @@ void silence(SampleChannel* ch, int a, int b)
 
 void fade(SampleChannel* ch, int a, int b, int type)
 {
-	m::wfx::fade(*ch->wave, a, b, type);
+	bool ok = edit_(ch, [a, b, type](Wave& w, m::wfx::Task& t)
+	{
+		m::wfx::fade(w, a, b, type, &t);
+		m::peakBuilder::update(w, a, b + 1);
+		return G_RES_OK;
+	});
+	if (!ok)
+		return;
 	gdSampleEditor* gdEditor = getSampleEditorWindow();
 	gdEditor->waveTools->waveform->refresh();
 }
@@ -179,7 +376,14 @@ void fade(SampleChannel* ch, int a, int b, int type)
 
 void smoothEdges(SampleChannel* ch, int a, int b)
 {
-	m::wfx::smooth(*ch->wave, a, b);
+	bool ok = edit_(ch, [a, b](Wave& w, m::wfx::Task& t)
+	{
+		m::wfx::smooth(w, a, b, &t);
+		m::peakBuilder::update(w, a, b + 1);
+		return G_RES_OK;
+	});
+	if (!ok)
+		return;
 	gdSampleEditor* gdEditor = getSampleEditorWindow();
 	gdEditor->waveTools->waveform->refresh();
 }
@@ -190,7 +394,14 @@ void smoothEdges(SampleChannel* ch, int a, int b)
 
 void reverse(SampleChannel* ch, int a, int b)
 {
-	m::wfx::reverse(*ch->wave, a, b);
+	bool ok = edit_(ch, [a, b](Wave& w, m::wfx::Task& t)
+	{
+		m::wfx::reverse(w, a, b, &t);
+		m::peakBuilder::update(w, a, b);
+		return G_RES_OK;
+	});
+	if (!ok)
+		return;
 	gdSampleEditor* gdEditor = getSampleEditorWindow();
 	gdEditor->waveTools->waveform->refresh();
 }
@@ -201,7 +412,14 @@ void reverse(SampleChannel* ch, int a, int b)
 
 void normalizeHard(SampleChannel* ch, int a, int b)
 {
-	m::wfx::normalizeHard(*ch->wave, a, b);
+	bool ok = edit_(ch, [a, b](Wave& w, m::wfx::Task& t)
+	{
+		m::wfx::normalizeHard(w, a, b, &t);
+		m::peakBuilder::update(w, a, b);
+		return G_RES_OK;
+	});
+	if (!ok)
+		return;
 	gdSampleEditor* gdEditor = getSampleEditorWindow();
 	gdEditor->waveTools->waveform->refresh();
 }
@@ -212,8 +430,15 @@ void normalizeHard(SampleChannel* ch, int a, int b)
 
 void trim(SampleChannel* ch, int a, int b)
 {
-	if (!m::wfx::trim(*ch->wave, a, b)) {
-		gdAlert("Unable to trim the sample!");
+	bool ok = edit_(ch, [a, b](Wave& w, m::wfx::Task& t)
+	{
+		int res = m::wfx::trim(w, a, b, &t);
+		m::peakBuilder::request(w);
+		return res;
+	});
+	if (!ok) {
+		if (!m::waveEditor::isCancelled())
+			gdAlert("Unable to trim the sample!");
 		return;
 	}
 	setBeginEnd(ch, ch->getBegin(), ch->getEnd());
@@ -287,9 +512,72 @@ bool isWaveBufferFull()
 /* -------------------------------------------------------------------------- */
 
 
+bool canUndo(const SampleChannel* ch)
+{
+	return !m_undo.empty() && isHistoryValid_(ch);
+}
+
+
+bool canRedo(const SampleChannel* ch)
+{
+	return !m_redo.empty() && isHistoryValid_(ch);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void undo(SampleChannel* ch)
+{
+	if (!canUndo(ch))
+		return;
+	Version_ curr = getVersion_(ch);
+	if (!restore_(ch, m_undo.back()))
+		return;
+	m_undo.pop_back();
+	m_redo.push_back(curr);
+	refreshEditor_();
+}
+
+
+void redo(SampleChannel* ch)
+{
+	if (!canRedo(ch))
+		return;
+	Version_ curr = getVersion_(ch);
+	if (!restore_(ch, m_redo.back()))
+		return;
+	m_redo.pop_back();
+	m_undo.push_back(curr);
+	refreshEditor_();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void clearHistory()
+{
+	m_undo.clear();
+	m_redo.clear();
+	m_current.reset();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 void shift(SampleChannel* ch, int offset)
 {
-	m::wfx::shift(*ch->wave, offset - ch->shift);
+	int delta = offset - ch->shift;
+	bool ok = edit_(ch, [delta](Wave& w, m::wfx::Task& t)
+	{
+		m::wfx::shift(w, delta, &t);
+		m::peakBuilder::request(w);
+		return G_RES_OK;
+	});
+	if (!ok)
+		return;
 	ch->shift = offset;
 	gdSampleEditor* gdEditor = getSampleEditorWindow();
 	gdEditor->shiftTool->refresh();
@@ -64,6 +64,20 @@ void shift(SampleChannel* ch, int offset);
 
 bool isWaveBufferFull();
 
+/* undo, redo
+Move back and forth in the history of edits made in the sample editor. Old 
+versions share most of their data with the current one. */
+
+void undo(SampleChannel* ch);
+void redo(SampleChannel* ch);
+bool canUndo(const SampleChannel* ch);
+bool canRedo(const SampleChannel* ch);
+
+/* clearHistory
+Forgets all edits, e.g. when the editor is closed. */
+
+void clearHistory();
+
 /* setPlayHead
 Changes playhead's position. Used in preview. */
 
@@ -25,6 +25,7 @@
  * -------------------------------------------------------------------------- */
 
 
+#include <FL/Fl.H>
 #include "../core/mixer.h"
 #include "../core/mixerHandler.h"
 #include "../core/channel.h"
@@ -35,6 +36,8 @@
 #include "../core/sampleChannel.h"
 #include "../core/midiChannel.h"
 #include "../core/waveManager.h"
+#include "../core/patchLoader.h"
+#include "../core/peakBuilder.h"
 #include "../core/clock.h"
 #include "../core/wave.h"
 #include "../utils/gui.h"
@@ -231,10 +234,134 @@ void glue_savePatch(void* data)
 /* -------------------------------------------------------------------------- */
 
 
+/* PatchLoad__
+A patch being loaded: what is left to do once the samples are ready. Samples 
+are loaded in background, the GUI thread polls for them. */
+
+static struct PatchLoad__
+{
+	bool             active;
+	gdBrowserLoad*   browser;
+	string           fullPath;
+	vector<Channel*> channels;
+	vector<int>      indexes;   // channel index in patch
+	float            progress;
+} patchLoad__ = { false, nullptr, "", {}, {}, 0.0f };
+
+
+/* -------------------------------------------------------------------------- */
+
+/* glue_getLoadBrowser__
+Returns the browser the patch is being loaded from, or nullptr if the user 
+closed it in the meantime. */
+
+static gdBrowserLoad* glue_getLoadBrowser__()
+{
+	if (gu_getSubwindow(G_MainWin, WID_FILE_BROWSER) != patchLoad__.browser)
+		return nullptr;
+	return patchLoad__.browser;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* glue_finishLoadPatch__
+Second half of glue_loadPatch(), once all samples are loaded: hands waves and 
+channels over to Mixer. */
+
+static void glue_finishLoadPatch__()
+{
+	using namespace giada::m;
+
+	patchLoader::finish();
+
+	for (unsigned i=0; i<patchLoad__.channels.size(); i++) {
+		Channel* ch = patchLoad__.channels.at(i);
+		if (ch->type != ChannelType::SAMPLE)
+			continue;
+		Wave* w = nullptr;
+		int res = patchLoader::getWave(patchLoad__.indexes.at(i), &w);
+		static_cast<SampleChannel*>(ch)->readPatchWave(patchLoad__.indexes.at(i), w, res);
+		if (w != nullptr)
+			peakBuilder::request(*w);
+	}
+	patchLoader::clear();
+
+	/* All set: hand channels over to Mixer. */
+
+	mh::addChannels(patchLoad__.channels);
+
+	/* Prepare Mixer. */
+
+	mh::updateSoloCount();
+	mh::readPatch();
+
+	/* Save patchPath by taking the last dir of the broswer, in order to reuse it 
+	the next time. */
+
+	conf::patchPath = gu_dirname(patchLoad__.fullPath);
+
+	/* Refresh GUI. */
+
+	G_MainWin->activate();
+	gu_updateControls();
+	gu_updateMainWinLabel(patch::name);
+
+	gdBrowserLoad* browser = glue_getLoadBrowser__();
+	if (browser != nullptr)
+		browser->setStatusBar(0.1f);
+
+	patchLoad__.active = false;
+	patchLoad__.channels.clear();
+	patchLoad__.indexes.clear();
+
+	gu_log("[glue] patch loaded successfully\n");
+
+#ifdef WITH_VST
+
+	if (pluginHost::hasMissingPlugins())
+		gdAlert("Some plugins were not loaded successfully.\nCheck the plugin browser to know more.");
+
+#endif
+
+	if (browser != nullptr)
+		browser->do_callback();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+/* glue_pollLoadPatch__
+Timeout callback: moves the progress bar on while samples load, then finishes
+the job. Samples take 0.4 of the progress bar. */
+
+static void glue_pollLoadPatch__(void* /*data*/)
+{
+	using namespace giada::m;
+
+	float p = patchLoader::getProgress();
+	gdBrowserLoad* browser = glue_getLoadBrowser__();
+	if (browser != nullptr)
+		browser->setStatusBar((p - patchLoad__.progress) * 0.4f);
+	patchLoad__.progress = p;
+
+	if (p < 1.0f)
+		Fl::repeat_timeout(G_GUI_LOAD_RATE, glue_pollLoadPatch__);
+	else
+		glue_finishLoadPatch__();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 void glue_loadPatch(void* data)
 {
 	using namespace giada::m;
 
+	if (patchLoad__.active)
+		return;
+
 	gdBrowserLoad* browser = (gdBrowserLoad*) data;
 	string fullPath        = browser->getSelectedItem();
 	bool isProject         = gu_isProject(browser->getSelectedItem());
@@ -273,56 +400,52 @@ void glue_loadPatch(void* data)
 
 	browser->setStatusBar(0.1f);
 
-	/* Add common stuff, columns and channels. Also increment the progress bar by 
-	0.8 / total_channels steps.  */
+	/* Samples are loaded on background threads from now on. Meanwhile add 
+	columns and channels, and read everything else, plugins included: they must 
+	be instantiated on this thread. Channels are not visible to Mixer yet. The
+	main window stays disabled until glue_finishLoadPatch__() is done with 
+	them. */
+
+	G_MainWin->deactivate();
 
-	float steps = 0.8 / patch::channels.size();
+	patchLoad__.active   = true;
+	patchLoad__.browser  = browser;
+	patchLoad__.fullPath = fullPath;
+	patchLoad__.progress = 0.0f;
+
+	patchLoader::start(basePath);
+
+	/* Actions are saved in frames, at the tempo and samplerate of the patch: 
+	read them back into musical time with the same beat length. mh::readPatch()
+	in glue_finishLoadPatch__() switches to the current samplerate, actions 
+	follow. */
+
+	recorder::setFramesInBeat(clock::getFramesInBeat(patch::samplerate, patch::bpm, 
+		patch::beats));
+
+	/* Channels and samples take 0.4 of the progress bar each. */
+
+	float steps = 0.4 / patch::channels.size();
 	
 	for (const patch::column_t& col : patch::columns) {
 		G_MainWin->keyboard->addColumn(col.width);
 		unsigned k = 0;
 		for (const patch::channel_t& pch : patch::channels) {
 			if (pch.column == col.index) {
-				Channel* ch = c::channel::addChannel(pch.column, static_cast<ChannelType>(pch.type), pch.size);
+				Channel* ch = mh::createChannel(static_cast<ChannelType>(pch.type));
+				ch->guiChannel = G_MainWin->keyboard->addChannel(pch.column, ch, pch.size);
 				ch->readPatch(basePath, k);
+				patchLoad__.channels.push_back(ch);
+				patchLoad__.indexes.push_back(k);
+				browser->setStatusBar(steps);
 			}
-			browser->setStatusBar(steps);
 			k++;
 		}
 	}
 
-	/* Prepare Mixer. */
-
-	mh::updateSoloCount();
-	mh::readPatch();
-
-	/* Let recorder recompute the actions' positions if the current 
-	samplerate != patch samplerate. */
-
-	recorder::updateSamplerate(conf::samplerate, patch::samplerate);
-
-	/* Save patchPath by taking the last dir of the broswer, in order to reuse it 
-	the next time. */
-
-	conf::patchPath = gu_dirname(fullPath);
-
-	/* Refresh GUI. */
-
-	gu_updateControls();
-	gu_updateMainWinLabel(patch::name);
-
-	browser->setStatusBar(0.1f);
-
-	gu_log("[glue] patch loaded successfully\n");
-
-#ifdef WITH_VST
-
-	if (pluginHost::hasMissingPlugins())
-		gdAlert("Some plugins were not loaded successfully.\nCheck the plugin browser to know more.");
-
-#endif
+	/* Wait for samples without blocking the GUI: see glue_pollLoadPatch__(). */
 
-	browser->do_callback();
+	Fl::add_timeout(G_GUI_LOAD_RATE, glue_pollLoadPatch__);
 }
 
 
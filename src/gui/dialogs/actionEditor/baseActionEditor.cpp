@@ -35,9 +35,13 @@
 #include "../../../core/const.h"
 #include "../../../core/clock.h"
 #include "../../../core/channel.h"
+#include "../../../core/pluginHost.h"
+#include "../../../core/plugin.h"
 #include "../../elems/actionEditor/gridTool.h"
+#include "../../elems/actionEditor/envelopeEditor.h"
 #include "../../elems/basics/scroll.h"
 #include "../../elems/basics/choice.h"
+#include "../../elems/basics/resizerBar.h"
 #include "baseActionEditor.h"
 
 
@@ -196,6 +200,58 @@ void gdBaseActionEditor::prepareWindow()
 }
 
 
+/* -------------------------------------------------------------------------- */
+
+#ifdef WITH_VST
+
+void gdBaseActionEditor::cb_setPluginParam(Fl_Widget* w, void* p) { ((gdBaseActionEditor*)p)->setPluginParam(); }
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void gdBaseActionEditor::addPluginLane(Pixel y)
+{
+	namespace mp = m::pluginHost;
+
+	pluginLane = nullptr;
+
+	mp::forEachPlugin(mp::CHANNEL, ch, [&] (const Plugin* p)
+	{
+		for (int k=0; k<p->getNumParameters(); k++) {
+			string item = p->getName() + ": " + p->getParameterName(k);
+			pluginParam->add(gu_replace(item, "/", "\\/").c_str());
+			pluginParams.push_back(mp::makeParamKey(p->getId(), k));
+		}
+	});
+
+	if (pluginParams.empty()) {
+		pluginParam->deactivate();
+		return;
+	}
+
+	pluginParam->value(0);
+	pluginParam->callback(cb_setPluginParam, (void*)this);
+
+	pluginLane = new geEnvelopeEditor(viewport->x(), y, G_ACTION_PLUGIN, 
+		pluginParam->text(), ch, pluginParams.at(0));
+	viewport->add(pluginLane);
+	viewport->add(new geResizerBar(pluginLane->x(), pluginLane->y()+pluginLane->h(), 
+		viewport->w(), RESIZER_BAR_H, MIN_WIDGET_H));
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void gdBaseActionEditor::setPluginParam()
+{
+	pluginLane->setIValue(pluginParams.at(pluginParam->value()), pluginParam->text());
+}
+
+#endif
+
+
 /* -------------------------------------------------------------------------- */
 
 
@@ -29,6 +29,8 @@
 #define GD_BASE_ACTION_EDITOR_H
 
 
+#include <cstdint>
+#include <vector>
 #include "../../../core/types.h"
 #include "../window.h"
 
@@ -43,6 +45,7 @@ namespace giada {
 namespace v
 {
 class geGridTool;
+class geEnvelopeEditor;
 
 
 class gdBaseActionEditor : public gdWindow
@@ -71,6 +74,27 @@ protected:
 
 	void prepareWindow();
 
+#ifdef WITH_VST
+
+	/* addPluginLane
+	Adds the plug-in automation lane to the viewport at 'y', for the parameter
+	picked in 'pluginParam'. Nothing to add if the channel has no plug-ins. */
+
+	void addPluginLane(Pixel y);
+
+	static void cb_setPluginParam(Fl_Widget* w, void* p);
+	void setPluginParam();
+
+	geChoice*         pluginParam;
+	geEnvelopeEditor* pluginLane;
+
+	/* pluginParams
+	iValue of the G_ACTION_PLUGIN actions of each item in 'pluginParam'. */
+
+	std::vector<uint32_t> pluginParams;
+
+#endif
+
 public:
 
 	virtual ~gdBaseActionEditor();
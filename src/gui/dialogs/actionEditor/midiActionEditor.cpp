@@ -32,10 +32,12 @@
 #include "../../elems/basics/button.h"
 #include "../../elems/basics/resizerBar.h"
 #include "../../elems/basics/box.h"
+#include "../../elems/basics/choice.h"
 #include "../../elems/actionEditor/noteEditor.h"
 #include "../../elems/actionEditor/velocityEditor.h"
 #include "../../elems/actionEditor/pianoRoll.h"
 #include "../../elems/actionEditor/gridTool.h"
+#include "../../elems/actionEditor/envelopeEditor.h"
 #include "midiActionEditor.h"
 
 
@@ -56,7 +58,12 @@ gdMidiActionEditor::gdMidiActionEditor(MidiChannel* ch)
 
 		gridTool = new geGridTool(8, 8);
 
-		geBox *b1  = new geBox(gridTool->x()+gridTool->w()+4, 8, 300, 20);    // padding actionType - zoomButtons
+		Pixel px   = gridTool->x()+gridTool->w()+4;
+#ifdef WITH_VST
+		pluginParam = new geChoice(px, 8, 160, 20);
+		px += pluginParam->w()+4;
+#endif
+		geBox *b1  = new geBox(px, 8, 300, 20);    // padding actionType - zoomButtons
 		zoomInBtn  = new geButton(w()-8-40-4, 8, 20, 20, "", zoomInOff_xpm, zoomInOn_xpm);
 		zoomOutBtn = new geButton(w()-8-20,   8, 20, 20, "", zoomOutOff_xpm, zoomOutOn_xpm);
 	
@@ -78,6 +85,10 @@ gdMidiActionEditor::gdMidiActionEditor(MidiChannel* ch)
 	viewport->add(ve);
 	viewport->add(new geResizerBar(ve->x(), ve->y()+ve->h(), viewport->w(), RESIZER_BAR_H, MIN_WIDGET_H));
 
+#ifdef WITH_VST
+	addPluginLane(ve->y()+ve->h()+RESIZER_BAR_H);
+#endif
+
 	end();
 	prepareWindow();
 }
@@ -91,5 +102,9 @@ void gdMidiActionEditor::rebuild()
 	computeWidth();
 	ne->rebuild();
 	ve->rebuild();
+#ifdef WITH_VST
+	if (pluginLane != nullptr)
+		pluginLane->rebuild();
+#endif
 }
 }} // giada::v::
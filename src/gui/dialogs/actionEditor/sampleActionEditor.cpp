@@ -68,7 +68,12 @@ gdSampleActionEditor::gdSampleActionEditor(SampleChannel* ch)
 		if (!canChangeActionType())
 			actionType->deactivate();
 
-		geBox* b1  = new geBox(gridTool->x()+gridTool->w()+4, 8, 300, 20);    // padding actionType - zoomButtons
+		Pixel px   = gridTool->x()+gridTool->w()+4;
+#ifdef WITH_VST
+		pluginParam = new geChoice(px, 8, 160, 20);
+		px += pluginParam->w()+4;
+#endif
+		geBox* b1  = new geBox(px, 8, 300, 20);    // padding actionType - zoomButtons
 		zoomInBtn  = new geButton(w()-8-40-4, 8, 20, 20, "", zoomInOff_xpm, zoomInOn_xpm);
 		zoomOutBtn = new geButton(w()-8-20,   8, 20, 20, "", zoomOutOff_xpm, zoomOutOn_xpm);
 
@@ -90,6 +95,10 @@ gdSampleActionEditor::gdSampleActionEditor(SampleChannel* ch)
 	viewport->add(vc);
 	viewport->add(new geResizerBar(vc->x(), vc->y()+vc->h(), viewport->w(), RESIZER_BAR_H, MIN_WIDGET_H));
 
+#ifdef WITH_VST
+	addPluginLane(vc->y()+vc->h()+RESIZER_BAR_H);
+#endif
+
 	end();
 	prepareWindow();
 }
@@ -114,5 +123,9 @@ void gdSampleActionEditor::rebuild()
 	computeWidth();
 	ac->rebuild();
 	vc->rebuild();	
+#ifdef WITH_VST
+	if (pluginLane != nullptr)
+		pluginLane->rebuild();
+#endif
 }
 }} // giada::v::
@@ -68,6 +68,7 @@ void gdMidiInputBase::stopMidiLearn(geMidiLearner* learner)
 void gdMidiInputBase::cb_learn(uint32_t* param, uint32_t msg, geMidiLearner* l)
 {
 	*param = msg;
+	midiDispatcher::invalidate();
 	stopMidiLearn(l);
 	gu_log("[gdMidiGrabber] MIDI learn done - message=0x%X\n", msg);
 }
@@ -38,6 +38,7 @@
 #include "../../core/sampleChannel.h"
 #include "../../core/mixer.h"
 #include "../../core/wave.h"
+#include "../../core/waveEditor.h"
 #include "../../utils/gui.h"
 #include "../../utils/string.h"
 #include "../elems/basics/button.h"
@@ -46,6 +47,7 @@
 #include "../elems/basics/dial.h"
 #include "../elems/basics/box.h"
 #include "../elems/basics/check.h"
+#include "../elems/basics/progress.h"
 #include "../elems/sampleEditor/waveform.h"
 #include "../elems/sampleEditor/waveTools.h"
 #include "../elems/sampleEditor/volumeTool.h"
@@ -74,7 +76,7 @@ gdSampleEditor::gdSampleEditor(SampleChannel* ch)
   waveTools = new geWaveTools(G_GUI_OUTER_MARGIN, upperBar->y()+upperBar->h()+G_GUI_OUTER_MARGIN, 
     w()-16, h()-128, ch);
   
-  Fl_Group* bottomBar = createBottomBar(G_GUI_OUTER_MARGIN, waveTools->y()+waveTools->h()+G_GUI_OUTER_MARGIN, 
+  bottomBar = createBottomBar(G_GUI_OUTER_MARGIN, waveTools->y()+waveTools->h()+G_GUI_OUTER_MARGIN, 
   	h()-waveTools->h()-upperBar->h()-32);
 
   add(upperBar);
@@ -109,6 +111,7 @@ gdSampleEditor::~gdSampleEditor()
   m::conf::sampleEditorGridVal = atoi(grid->text());
   m::conf::sampleEditorGridOn  = snap->value();
   c::sampleEditor::setPreview(ch, PreviewMode::NONE);
+  c::sampleEditor::clearHistory();
 }
 
 
@@ -123,12 +126,22 @@ Fl_Group* gdSampleEditor::createUpperBar()
   g->begin();
     grid    = new geChoice(g->x(), g->y(), 50, G_GUI_UNIT);
     snap    = new geCheck(grid->x()+grid->w()+4, g->y()+3, 12, 12, "Snap");
-    sep1    = new geBox(snap->x()+snap->w()+4, g->y(), 506, G_GUI_UNIT);
-    zoomOut = new geButton(sep1->x()+sep1->w()+4, g->y(), G_GUI_UNIT, G_GUI_UNIT, "", zoomOutOff_xpm, zoomOutOn_xpm);
+    sep1    = new geBox(snap->x()+snap->w()+4, g->y(), 398, G_GUI_UNIT);
+    undo    = new geButton(sep1->x()+sep1->w()+4, g->y(), 50, G_GUI_UNIT, "Undo");
+    redo    = new geButton(undo->x()+undo->w()+4, g->y(), 50, G_GUI_UNIT, "Redo");
+    zoomOut = new geButton(redo->x()+redo->w()+4, g->y(), G_GUI_UNIT, G_GUI_UNIT, "", zoomOutOff_xpm, zoomOutOn_xpm);
     zoomIn  = new geButton(zoomOut->x()+zoomOut->w()+4, g->y(), G_GUI_UNIT, G_GUI_UNIT, "", zoomInOff_xpm, zoomInOn_xpm);
+    progress = new geProgress(sep1->x(), g->y(), sep1->w()-74, G_GUI_UNIT);
+    cancel   = new geButton(progress->x()+progress->w()+4, g->y(), 70, G_GUI_UNIT, "Cancel");
   g->end();
   g->resizable(sep1);
 
+  progress->minimum(0.0f);
+  progress->maximum(1.0f);
+  progress->hide();
+  cancel->hide();
+  cancel->callback(cb_cancel, (void*)this);
+
   grid->add("(off)");
   grid->add("2");
   grid->add("3");
@@ -149,6 +162,12 @@ Fl_Group* gdSampleEditor::createUpperBar()
 
   /* TODO - redraw grid if != (off) */
 
+  undo->shortcut(FL_CTRL + 'z');
+  undo->callback(cb_undo, (void*)this);
+  redo->shortcut(FL_CTRL + FL_SHIFT + 'z');
+  redo->callback(cb_redo, (void*)this);
+  updateHistory();
+
   zoomOut->callback(cb_zoomOut, (void*)this);
   zoomIn->callback(cb_zoomIn, (void*)this);
 
@@ -261,6 +280,9 @@ void gdSampleEditor::cb_changeGrid   (Fl_Widget* w, void* p) { ((gdSampleEditor*
 void gdSampleEditor::cb_enableSnap   (Fl_Widget* w, void* p) { ((gdSampleEditor*)p)->cb_enableSnap(); }
 void gdSampleEditor::cb_togglePreview(Fl_Widget* w, void* p) { ((gdSampleEditor*)p)->cb_togglePreview(); }
 void gdSampleEditor::cb_rewindPreview(Fl_Widget* w, void* p) { ((gdSampleEditor*)p)->cb_rewindPreview(); }
+void gdSampleEditor::cb_cancel       (Fl_Widget* w, void* p) { ((gdSampleEditor*)p)->cb_cancel(); }
+void gdSampleEditor::cb_undo         (Fl_Widget* w, void* p) { ((gdSampleEditor*)p)->cb_undo(); }
+void gdSampleEditor::cb_redo         (Fl_Widget* w, void* p) { ((gdSampleEditor*)p)->cb_redo(); }
 
 
 /* -------------------------------------------------------------------------- */
@@ -303,7 +325,7 @@ void gdSampleEditor::cb_reload()
   if (!gdConfirmWin("Warning", "Reload sample: are you sure?"))
     return;
 
-  if (channel::loadChannel(ch, ch->wave->getPath()) != G_RES_OK)
+  if (channel::loadChannel(ch, ch->wave->getPath(), m::waveManager::Storage::FLOAT) != G_RES_OK)
     return;
 
   channel::setBoost(ch, G_DEFAULT_BOOST);
@@ -317,6 +339,7 @@ void gdSampleEditor::cb_reload()
   waveTools->updateWaveform();
 
   sampleEditor::setBeginEnd(ch, 0, ch->wave->getSize());
+  updateHistory();
 
   redraw();
 }
@@ -345,6 +368,70 @@ void gdSampleEditor::cb_zoomOut()
 /* -------------------------------------------------------------------------- */
 
 
+void gdSampleEditor::cb_cancel()
+{
+  m::waveEditor::cancel();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void gdSampleEditor::cb_undo()
+{
+  c::sampleEditor::undo(ch);
+}
+
+
+void gdSampleEditor::cb_redo()
+{
+  c::sampleEditor::redo(ch);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void gdSampleEditor::setBusy(bool v)
+{
+  if (v) {
+    progress->value(0.0f);
+    progress->show();
+    cancel->show();
+    waveTools->deactivate();
+    bottomBar->deactivate();
+    undo->deactivate();
+    redo->deactivate();
+    callback(cb_cancel, (void*)this);
+  }
+  else {
+    progress->hide();
+    cancel->hide();
+    waveTools->activate();
+    bottomBar->activate();
+    callback(cb_closeChild);
+    updateHistory();
+  }
+  redraw();
+}
+
+
+void gdSampleEditor::updateHistory()
+{
+  if (c::sampleEditor::canUndo(ch)) undo->activate(); else undo->deactivate();
+  if (c::sampleEditor::canRedo(ch)) redo->activate(); else redo->deactivate();
+}
+
+
+void gdSampleEditor::setProgress(float v)
+{
+  progress->value(v);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 void gdSampleEditor::cb_changeGrid()
 {
   waveTools->waveform->setGridLevel(atoi(grid->text()));
@@ -46,6 +46,7 @@ class geChoice;
 class geCheck;
 class geBox;
 class geButton;
+class geProgress;
 
 
 class gdSampleEditor : public gdWindow
@@ -68,6 +69,9 @@ private:
 	static void cb_enableSnap(Fl_Widget* w, void* p);
 	static void cb_togglePreview(Fl_Widget* w, void* p);
 	static void cb_rewindPreview(Fl_Widget* w, void* p);
+	static void cb_cancel    (Fl_Widget* w, void* p);
+	static void cb_undo      (Fl_Widget* w, void* p);
+	static void cb_redo      (Fl_Widget* w, void* p);
 	void cb_reload();
 	void cb_zoomIn();
 	void cb_zoomOut();
@@ -75,6 +79,11 @@ private:
 	void cb_enableSnap();
 	void cb_togglePreview();
 	void cb_rewindPreview();
+	void cb_cancel();
+	void cb_undo();
+	void cb_redo();
+
+	Fl_Group* bottomBar;
 
 public:
 
@@ -83,11 +92,28 @@ public:
 
 	void updateInfo();
 
+	/* setBusy
+	Shows progress and a cancel button while an operation runs in background 
+	(see glue::sampleEditor), with the rest of the editor disabled. Closing the
+	window cancels the operation. */
+
+	void setBusy(bool v);
+	void setProgress(float v);
+
+	/* updateHistory
+	Enables undo and redo buttons according to the edit history. */
+
+	void updateHistory();
+
 	geChoice* grid;
 	geCheck*  snap;
 	geBox*    sep1;
+	geButton* undo;
+	geButton* redo;
 	geButton* zoomIn;
 	geButton* zoomOut;
+	geProgress* progress;
+	geButton*   cancel;
 	
 	geWaveTools* waveTools;
 
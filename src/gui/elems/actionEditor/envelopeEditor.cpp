@@ -45,9 +45,10 @@ namespace giada {
 namespace v
 {
 geEnvelopeEditor::geEnvelopeEditor(Pixel x, Pixel y, int actionType, const char* l, 
-	SampleChannel* ch)
+	Channel* ch, uint32_t iValue)
 :	geBaseActionEditor(x, y, 200, m::conf::envelopeEditorH, ch),	
-  m_actionType      (actionType)
+  m_actionType      (actionType),
+  m_iValue          (iValue)
 {
 	copy_label(l);
 	rebuild();
@@ -57,6 +58,17 @@ geEnvelopeEditor::geEnvelopeEditor(Pixel x, Pixel y, int actionType, const char*
 /* -------------------------------------------------------------------------- */
 
 
+void geEnvelopeEditor::setIValue(uint32_t iValue, const char* l)
+{
+	m_iValue = iValue;
+	copy_label(l);
+	rebuild();
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 geEnvelopeEditor::~geEnvelopeEditor()
 {
 	m::conf::envelopeEditorH = h();
@@ -122,7 +134,7 @@ void geEnvelopeEditor::rebuild()
 	clear();
 	size(m_base->fullWidth, h());
 
-	vector<mr::action> actions = cr::getEnvelopeActions(m_ch, m_actionType);
+	vector<mr::action> actions = cr::getEnvelopeActions(m_ch, m_actionType, m_iValue);
 
 	for (mr::action a : actions) {
 		gu_log("[geEnvelopeEditor::rebuild] Action %d\n", a.frame);
@@ -178,7 +190,7 @@ void geEnvelopeEditor::onAddAction()
 {
 	Frame f = m_base->pixelToFrame(Fl::event_x() - x());
 	float v = yToValue(Fl::event_y() - y());
-	c::recorder::recordEnvelopeAction(m_ch, m_actionType, f, v);
+	c::recorder::recordEnvelopeAction(m_ch, m_actionType, f, v, m_iValue);
 	rebuild();
 }
 
@@ -227,7 +239,7 @@ void geEnvelopeEditor::onRefreshAction()
 	Frame f = m_base->pixelToFrame((m_action->x() - x()) + geEnvelopePoint::SIDE / 2);
 	float v = yToValue(m_action->y() - y());
 	c::recorder::deleteEnvelopeAction(m_ch, m_action->a1, /*moved=*/true);
-	c::recorder::recordEnvelopeAction(m_ch, m_actionType, f, v);
+	c::recorder::recordEnvelopeAction(m_ch, m_actionType, f, v, m_iValue);
 	rebuild();
 }
 }} // giada::v::
\ No newline at end of file
@@ -29,12 +29,10 @@
 #define GE_ENVELOPE_EDITOR_H
 
 
+#include <cstdint>
 #include "baseActionEditor.h"
 
 
-class SampleChannel;
-
-
 namespace giada {
 namespace v
 {
@@ -50,6 +48,12 @@ private:
 	
 	int m_actionType;
 
+	/* m_iValue
+	Which envelope among those of the same type, e.g. a plug-in parameter. 0 if
+	there is only one. */
+
+	uint32_t m_iValue;
+
 	void onAddAction()     override;
 	void onDeleteAction()  override;
 	void onMoveAction()    override;
@@ -65,12 +69,18 @@ private:
 
 public:
 
-	geEnvelopeEditor(Pixel x, Pixel y, int actionType, const char* l, SampleChannel* ch);
+	geEnvelopeEditor(Pixel x, Pixel y, int actionType, const char* l, Channel* ch,
+		uint32_t iValue=0);
 	~geEnvelopeEditor();
 
 	void draw() override;
 
 	void rebuild() override;
+
+	/* setIValue
+	Switches to another envelope of the same type, labelled 'l'. */
+
+	void setIValue(uint32_t iValue, const char* l);
 };
 }} // giada::v::
 
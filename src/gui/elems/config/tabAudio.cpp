@@ -55,12 +55,15 @@ geTabAudio::geTabAudio(int X, int Y, int W, int H)
 	devOutInfo  = new geButton(x()+344, y()+65, 20,  20, "?");
 	channelsOut = new geChoice(x()+114, y()+93, 55,  20, "Output channels");
 	limitOutput = new geCheck (x()+177, y()+97, 55,  20, "Limit output");
+	nativeSamples = new geCheck(x()+269, y()+97, 55, 20, "Native format");
 	sounddevIn  = new geChoice(x()+114, y()+121, 222, 20, "Input device");
 	devInInfo   = new geButton(x()+344, y()+121, 20,  20, "?");
 	channelsIn  = new geChoice(x()+114, y()+149, 55,  20, "Input channels");
 	delayComp   = new geInput (x()+309, y()+149, 55,  20, "Rec delay comp.");
 	rsmpQuality = new geChoice(x()+114, y()+177, 250, 20, "Resampling");
-                new geBox(x(), rsmpQuality->y()+rsmpQuality->h()+8, w(), 92,
+	renderThreads = new geInput(x()+114, y()+205, 55, 20, "Render threads");
+	streamThreshold = new geInput(x()+309, y()+205, 55, 20, "Stream above (MB)");
+                new geBox(x(), renderThreads->y()+renderThreads->h()+8, w(), 64,
 										"Restart Giada for the changes to take effect.");
 	end();
 
@@ -194,7 +197,16 @@ geTabAudio::geTabAudio(int X, int Y, int W, int H)
 	delayComp->type(FL_INT_INPUT);
 	delayComp->maximum_size(5);
 
+	renderThreads->value(gu_iToString(conf::renderThreads).c_str());
+	renderThreads->type(FL_INT_INPUT);
+	renderThreads->maximum_size(2);
+
+	streamThreshold->value(gu_iToString(conf::streamThreshold).c_str());
+	streamThreshold->type(FL_INT_INPUT);
+	streamThreshold->maximum_size(5);
+
 	limitOutput->value(conf::limitOutput);
+	nativeSamples->value(conf::nativeSamples);
 }
 
 
@@ -489,6 +501,7 @@ void geTabAudio::save()
 	conf::channelsOut    = channelsOut->value();
 	conf::channelsIn     = channelsIn->value();
 	conf::limitOutput    = limitOutput->value();
+	conf::nativeSamples  = nativeSamples->value();
 	conf::rsmpQuality    = rsmpQuality->value();
 
 	/* if sounddevOut is disabled (because of system change e.g. alsa ->
@@ -508,5 +521,7 @@ void geTabAudio::save()
 	if (i)
 		conf::samplerate = atoi(i->label());
 
-	conf::delayComp = atoi(delayComp->value());
+	conf::delayComp       = atoi(delayComp->value());
+	conf::renderThreads   = atoi(renderThreads->value());
+	conf::streamThreshold = atoi(streamThreshold->value());
 }
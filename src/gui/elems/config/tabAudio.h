@@ -72,8 +72,11 @@ public:
 	geButton  *devOutInfo;
 	geChoice *channelsOut;
 	geCheck  *limitOutput;
+	geCheck  *nativeSamples;
 	geChoice *buffersize;
 	geInput  *delayComp;
+	geInput  *renderThreads;
+	geInput  *streamThreshold;
 
 	geTabAudio(int x, int y, int w, int h);
 
@@ -57,6 +57,8 @@ geTabBehaviors::geTabBehaviors(int X, int Y, int W, int H)
 
 	treatRecsAsLoops = new geCheck(x(), y()+155, 280, 20, "Treat one shot channels with actions as loops");
   inputMonitorDefaultOn = new geCheck(x(), y()+180, 280, 20, "New sample channels have input monitor on by default");
+  peakFiles = new geCheck(x(), y()+205, 280, 20, "Save waveform peak files next to samples");
+  pitchCache = new geCheck(x(), y()+230, 280, 20, "Pre-render pitched channels (faster, more memory)");
 
   end();
 
@@ -67,6 +69,8 @@ geTabBehaviors::geTabBehaviors(int X, int Y, int W, int H)
 	conf::chansStopOnSeqHalt == 1 ? chansStopOnSeqHalt_1->value(1) : chansStopOnSeqHalt_0->value(1);
 	treatRecsAsLoops->value(conf::treatRecsAsLoops);
 	inputMonitorDefaultOn->value(conf::inputMonitorDefaultOn);
+	peakFiles->value(conf::peakFiles);
+	pitchCache->value(conf::pitchCache);
 
 	recsStopOnChanHalt_1->callback(cb_radio_mutex, (void*)this);
 	recsStopOnChanHalt_0->callback(cb_radio_mutex, (void*)this);
@@ -99,4 +103,6 @@ void geTabBehaviors::save()
 	conf::chansStopOnSeqHalt = chansStopOnSeqHalt_1->value() == 1 ? 1 : 0;
 	conf::treatRecsAsLoops = treatRecsAsLoops->value() == 1 ? 1 : 0;
 	conf::inputMonitorDefaultOn = inputMonitorDefaultOn->value() == 1 ? 1 : 0;
+	conf::peakFiles = peakFiles->value() == 1;
+	conf::pitchCache = pitchCache->value() == 1;
 }
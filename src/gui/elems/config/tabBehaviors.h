@@ -51,6 +51,8 @@ public:
 	geRadio *chansStopOnSeqHalt_0;
 	geCheck *treatRecsAsLoops;
 	geCheck *inputMonitorDefaultOn;
+	geCheck *peakFiles;
+	geCheck *pitchCache;
 
 	geTabBehaviors(int x, int y, int w, int h);
 
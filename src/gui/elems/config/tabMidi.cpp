@@ -26,6 +26,8 @@
 
 
 #include <string>
+#include <vector>
+#include <FL/Fl_Check_Browser.H>
 #include "../../../core/const.h"
 #ifdef G_OS_MAC
 	#include <RtMidi.h>
@@ -37,12 +39,14 @@
 #include "../../../core/kernelMidi.h"
 #include "../../../utils/gui.h"
 #include "../basics/box.h"
+#include "../basics/boxtypes.h"
 #include "../basics/choice.h"
 #include "../basics/check.h"
 #include "tabMidi.h"
 
 
 using std::string;
+using std::vector;
 using namespace giada::m;
 
 
@@ -52,15 +56,24 @@ geTabMidi::geTabMidi(int X, int Y, int W, int H)
 	begin();
 	system	  = new geChoice(x()+w()-250, y()+9, 250, 20, "System");
 	portOut	  = new geChoice(x()+w()-250, system->y()+system->h()+8, 250, 20, "Output port");
-	portIn	  = new geChoice(x()+w()-250, portOut->y()+portOut->h()+8, 250, 20, "Input port");
-	midiMap	  = new geChoice(x()+w()-250, portIn->y()+portIn->h()+8, 250, 20, "Output Midi Map");
+	portsIn	  = new Fl_Check_Browser(x()+w()-250, portOut->y()+portOut->h()+8, 250, 56, "Input ports");
+	midiMap	  = new geChoice(x()+w()-250, portsIn->y()+portsIn->h()+8, 250, 20, "Output Midi Map");
 	sync	    = new geChoice(x()+w()-250, midiMap->y()+midiMap->h()+8, 250, 20, "Sync");
-	new geBox(x(), sync->y()+sync->h()+8, w(), h()-150, "Restart Giada for the changes to take effect.");
+	new geBox(x(), sync->y()+sync->h()+8, w(), h()-186, "Restart Giada for the changes to take effect.");
 	end();
 
 	labelsize(G_GUI_FONT_SIZE_BASE);
 	selection_color(G_COLOR_GREY_4);
 
+	portsIn->box(G_CUSTOM_BORDER_BOX);
+	portsIn->textsize(G_GUI_FONT_SIZE_BASE);
+	portsIn->textcolor(G_COLOR_LIGHT_2);
+	portsIn->selection_color(G_COLOR_GREY_4);
+	portsIn->color(G_COLOR_GREY_2);
+	portsIn->labelsize(G_GUI_FONT_SIZE_BASE);
+	portsIn->labelcolor(G_COLOR_LIGHT_1);
+	portsIn->align(FL_ALIGN_LEFT);
+
 	system->callback(cb_changeSystem, (void*)this);
 
 	fetchSystems();
@@ -109,19 +122,19 @@ void geTabMidi::fetchOutPorts()
 void geTabMidi::fetchInPorts()
 {
 	if (kernelMidi::countInPorts() == 0) {
-		portIn->add("-- no ports found --");
-		portIn->value(0);
-		portIn->deactivate();
+		portsIn->add("-- no ports found --");
+		portsIn->deactivate();
+		return;
 	}
-	else {
-
-		portIn->add("(disabled)");
 
-		for (unsigned i=0; i<kernelMidi::countInPorts(); i++)
-			portIn->add(gu_removeFltkChars(kernelMidi::getInPortName(i)).c_str());
+	/* One item per port, checked if open. Item i+1 is port i (Fl_Check_Browser
+	counts from 1). */
 
-		portIn->value(conf::midiPortIn+1);    // +1 because midiPortIn=-1 is '(disabled)'
-	}
+	for (unsigned i=0; i<kernelMidi::countInPorts(); i++)
+		portsIn->add(gu_removeFltkChars(kernelMidi::getInPortName(i)).c_str());
+	for (const conf::MidiPortIn& p : conf::midiPortsIn)
+		if (p.port < (int) kernelMidi::countInPorts())
+			portsIn->checked(p.port + 1, 1);
 }
 
 
@@ -168,7 +181,22 @@ void geTabMidi::save()
 		conf::midiSystem = RtMidi::MACOSX_CORE;
 
 	conf::midiPortOut = portOut->value()-1;   // -1 because midiPortOut=-1 is '(disabled)'
-	conf::midiPortIn  = portIn->value()-1;    // -1 because midiPortIn=-1 is '(disabled)'
+
+	/* Keep filter and namespace of ports that stay open. No ports if the list
+	is inactive, i.e. no ports found or MIDI system changed. */
+
+	vector<conf::MidiPortIn> ports;
+	for (unsigned i=0; portsIn->active() && i<kernelMidi::countInPorts(); i++) {
+		if (!portsIn->checked(i + 1))
+			continue;
+		conf::MidiPortIn port = { (int) i, -1, 0 };
+		for (const conf::MidiPortIn& p : conf::midiPortsIn)
+			if (p.port == (int) i)
+				port = p;
+		ports.push_back(port);
+	}
+	conf::midiPortsIn = ports;
+	conf::midiPortIn  = ports.empty() ? -1 : ports.at(0).port;
 	conf::midiMapPath = midimap::maps.size() == 0 ? "" : midiMap->text(midiMap->value());
 
 	if      (sync->value() == 0)
@@ -232,9 +260,9 @@ void geTabMidi::cb_changeSystem()
 		portOut->clear();
 		fetchOutPorts();
 		portOut->activate();
-		portIn->clear();
+		portsIn->clear();
 		fetchInPorts();
-		portIn->activate();
+		portsIn->activate();
 		sync->activate();
 	}
 	else {
@@ -242,10 +270,9 @@ void geTabMidi::cb_changeSystem()
 		portOut->clear();
 		portOut->add("-- restart to fetch device(s) --");
 		portOut->value(0);
-		portIn->deactivate();
-		portIn->clear();
-		portIn->add("-- restart to fetch device(s) --");
-		portIn->value(0);
+		portsIn->deactivate();
+		portsIn->clear();
+		portsIn->add("-- restart to fetch device(s) --");
 		sync->deactivate();
 	}
 
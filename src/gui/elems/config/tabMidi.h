@@ -32,6 +32,7 @@
 #include <FL/Fl_Group.H>
 
 
+class Fl_Check_Browser;
 class geChoice;
 class geCheck;
 
@@ -54,7 +55,7 @@ public:
 
 	geChoice* system;
 	geChoice* portOut;
-	geChoice* portIn;
+	Fl_Check_Browser* portsIn;
 	geChoice* midiMap;
 	geChoice* sync;
 
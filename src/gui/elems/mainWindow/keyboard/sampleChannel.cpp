@@ -36,6 +36,7 @@
 #include "../../../../glue/recorder.h"
 #include "../../../../glue/storage.h"
 #include "../../../../utils/gui.h"
+#include "../../../../utils/string.h"
 #include "../../../dialogs/gd_mainWindow.h"
 #include "../../../dialogs/gd_keyGrabber.h"
 #include "../../../dialogs/sampleEditor.h"
@@ -69,6 +70,7 @@ namespace
 enum class Menu
 {
 	INPUT_MONITOR = 0,
+	NATIVE_STORAGE,
 	LOAD_SAMPLE,
 	EXPORT_SAMPLE,
 	SETUP_KEYBOARD_INPUT,
@@ -97,6 +99,22 @@ enum class Menu
 /* -------------------------------------------------------------------------- */
 
 
+/* getStorageLabel_
+Menu label for the native storage toggle, with the memory currently used by the
+sample. */
+
+std::string getStorageLabel_(const SampleChannel* ch)
+{
+	if (ch->wave == nullptr)
+		return "Native format";
+	return gu_format("Native format (%.1f MB)", 
+		ch->wave->getMemory() / (1024.0f * 1024.0f));
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 void menuCallback(Fl_Widget* w, void* v)
 {
 	using namespace giada;
@@ -111,6 +129,11 @@ void menuCallback(Fl_Widget* w, void* v)
 			c::channel::toggleInputMonitor(gch->ch);
 			break;
 		}
+		case Menu::NATIVE_STORAGE: {
+			if (c::channel::setNativeStorage(ch, !ch->wave->isNative()) != G_RES_OK)
+				gdAlert("Unable to reload this sample.");
+			break;
+		}
 		case Menu::LOAD_SAMPLE: {
 			gdWindow *w = new gdBrowserLoad(m::conf::browserX, m::conf::browserY,
 				m::conf::browserW, m::conf::browserH, "Browse sample",
@@ -138,6 +161,12 @@ void menuCallback(Fl_Widget* w, void* v)
 			break;
 		}
 		case Menu::EDIT_SAMPLE: {
+			/* The editor needs the whole sample in memory. */
+			int res = c::channel::loadChannelInMemory(ch);
+			if (res != G_RES_OK) {
+				G_MainWin->keyboard->printChannelMessage(res);
+				break;
+			}
 			gu_openSubWindow(G_MainWin, new gdSampleEditor(ch), WID_SAMPLE_EDITOR);
 			break;
 		}
@@ -300,9 +329,14 @@ void geSampleChannel::cb_openMenu()
 	if (m::mixer::recording || m::recorder::active)
 		return;
 
+	SampleChannel* sch = static_cast<SampleChannel*>(ch);
+	std::string storageLabel = getStorageLabel_(sch);
+
 	Fl_Menu_Item rclick_menu[] = {
 		{"Input monitor",            0, menuCallback, (void*) Menu::INPUT_MONITOR,
-			FL_MENU_TOGGLE | FL_MENU_DIVIDER | (static_cast<SampleChannel*>(ch)->inputMonitor ? FL_MENU_VALUE : 0)},
+			FL_MENU_TOGGLE | (sch->inputMonitor ? FL_MENU_VALUE : 0)},
+		{storageLabel.c_str(),       0, menuCallback, (void*) Menu::NATIVE_STORAGE,
+			FL_MENU_TOGGLE | FL_MENU_DIVIDER | (sch->wave != nullptr && sch->wave->isNative() ? FL_MENU_VALUE : 0)},
 		{"Load new sample...",       0, menuCallback, (void*) Menu::LOAD_SAMPLE},
 		{"Export sample to file...", 0, menuCallback, (void*) Menu::EXPORT_SAMPLE},
 		{"Setup keyboard input...",  0, menuCallback, (void*) Menu::SETUP_KEYBOARD_INPUT},
@@ -331,6 +365,7 @@ void geSampleChannel::cb_openMenu()
 	if (ch->status == ChannelStatus::EMPTY || 
 		  ch->status == ChannelStatus::MISSING) 
 	{
+		rclick_menu[(int) Menu::NATIVE_STORAGE].deactivate();
 		rclick_menu[(int) Menu::EXPORT_SAMPLE].deactivate();
 		rclick_menu[(int) Menu::EDIT_SAMPLE].deactivate();
 		rclick_menu[(int) Menu::FREE_CHANNEL].deactivate();
@@ -175,8 +175,12 @@ void geMainIO::setMasterFxInFull(bool v)
 
 void geMainIO::refresh()
 {
-	outMeter->mixerPeak = mixer::peakOut;
-	inMeter->mixerPeak  = mixer::peakIn;
+	dsp::Meter out = mixer::getOutMeter();
+	dsp::Meter in  = mixer::getInMeter();
+	outMeter->mixerPeak = out.peak;
+	outMeter->mixerRms  = out.rms;
+	inMeter->mixerPeak  = in.peak;
+	inMeter->mixerRms   = in.rms;
 	outMeter->redraw();
 	inMeter->redraw();
 }
@@ -73,6 +73,8 @@ void geMidiLearner::updateValue()
 		tmp = "0x" + gu_iToString(*param, true); // true: hex mode
 		tmp.pop_back();  // Remove last two digits, useless in MIDI messages
 		tmp.pop_back();  // Remove last two digits, useless in MIDI messages
+		if ((*param & 0xFF) != 0)  // Learn namespace of the input port
+			tmp += "/" + gu_iToString(*param & 0xFF);
 	}
 	else
 		tmp = "(not set)";
@@ -95,6 +97,7 @@ void geMidiLearner::cb_value()
 {
 	if (Fl::event_button() == FL_RIGHT_MOUSE) {
 		*param = 0x0;
+		midiDispatcher::invalidate();
 		updateValue();
 	}
 	/// TODO - elif (LEFT_MOUSE) : insert values by hand
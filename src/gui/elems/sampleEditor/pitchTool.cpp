@@ -38,6 +38,7 @@
 #include "../basics/input.h"
 #include "../basics/box.h"
 #include "../basics/button.h"
+#include "../basics/choice.h"
 #include "pitchTool.h"
 
 
@@ -57,6 +58,7 @@ gePitchTool::gePitchTool(int x, int y, SampleChannel* ch)
     pitchHalf   = new geButton(pitchToSong->x()+pitchToSong->w()+4, y, 20, 20, "", divideOff_xpm, divideOn_xpm);
     pitchDouble = new geButton(pitchHalf->x()+pitchHalf->w()+4, y, 20, 20, "", multiplyOff_xpm, multiplyOn_xpm);
     pitchReset  = new geButton(pitchDouble->x()+pitchDouble->w()+4, y, 70, 20, "Reset");
+    interpolation = new geChoice(pitchReset->x()+pitchReset->w()+4, y, 120, 20);
   end();
 
   dial->range(0.01f, 4.0f);
@@ -73,6 +75,16 @@ gePitchTool::gePitchTool(int x, int y, SampleChannel* ch)
   pitchDouble->callback(cb_setPitchDouble, (void*)this);
   pitchReset->callback(cb_resetPitch, (void*)this);
 
+  /* Same order as giada::Interpolation. */
+
+  interpolation->add("Resampler: global");
+  interpolation->add("Resampler: linear");
+  interpolation->add("Resampler: cubic");
+  interpolation->add("Resampler: sinc 8");
+  interpolation->add("Resampler: sinc 16");
+  interpolation->add("Resampler: sinc 32");
+  interpolation->callback(cb_setInterpolation, (void*)this);
+
   refresh();
 }
 
@@ -84,6 +96,7 @@ void gePitchTool::refresh()
 {
   dial->value(ch->getPitch());
   input->value(gu_fToString(ch->getPitch(), 4).c_str()); // 4 digits
+  interpolation->value(static_cast<int>(ch->interpolation));
 }
 
 
@@ -97,6 +110,7 @@ void gePitchTool::cb_setPitchHalf  (Fl_Widget* w, void* p) { ((gePitchTool*)p)->
 void gePitchTool::cb_setPitchDouble(Fl_Widget* w, void* p) { ((gePitchTool*)p)->__cb_setPitchDouble(); }
 void gePitchTool::cb_resetPitch    (Fl_Widget* w, void* p) { ((gePitchTool*)p)->__cb_resetPitch(); }
 void gePitchTool::cb_setPitchNum   (Fl_Widget* w, void* p) { ((gePitchTool*)p)->__cb_setPitchNum(); }
+void gePitchTool::cb_setInterpolation(Fl_Widget* w, void* p) { ((gePitchTool*)p)->__cb_setInterpolation(); }
 
 
 /* -------------------------------------------------------------------------- */
@@ -162,3 +176,12 @@ void gePitchTool::__cb_resetPitch()
 {
   c::channel::setPitch(ch, G_DEFAULT_PITCH);
 }
+
+
+/* -------------------------------------------------------------------------- */
+
+
+void gePitchTool::__cb_setInterpolation()
+{
+  c::channel::setInterpolation(ch, static_cast<Interpolation>(interpolation->value()));
+}
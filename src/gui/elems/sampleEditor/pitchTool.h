@@ -37,6 +37,7 @@ class geDial;
 class geInput;
 class geButton;
 class geBox;
+class geChoice;
 
 
 class gePitchTool : public Fl_Group
@@ -53,6 +54,7 @@ private:
   geButton *pitchHalf;
   geButton *pitchDouble;
   geButton *pitchReset;
+  geChoice *interpolation;
 
   static void cb_setPitch      (Fl_Widget *w, void *p);
   static void cb_setPitchToBar (Fl_Widget *w, void *p);
@@ -61,6 +63,7 @@ private:
   static void cb_setPitchDouble(Fl_Widget *w, void *p);
   static void cb_resetPitch    (Fl_Widget *w, void *p);
   static void cb_setPitchNum   (Fl_Widget *w, void *p);
+  static void cb_setInterpolation(Fl_Widget *w, void *p);
   inline void __cb_setPitch();
   inline void __cb_setPitchToBar();
   inline void __cb_setPitchToSong();
@@ -68,6 +71,7 @@ private:
   inline void __cb_setPitchDouble();
   inline void __cb_resetPitch();
   inline void __cb_setPitchNum();
+  inline void __cb_setInterpolation();
 
 public:
 
@@ -144,6 +144,9 @@ void geWaveTools::updateWaveform()
 
 void geWaveTools::redrawWaveformAsync()
 {
+	if (waveform->hasNewPeaks())
+		waveform->refresh();
+	else
 	if (ch->isPreview())
 		waveform->redraw();
 }
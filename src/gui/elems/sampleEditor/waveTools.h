@@ -60,7 +60,8 @@ public:
 	/* redrawWaveformAsync
 	Redraws the waveform, called by the video thread. This is meant to be called
 	repeatedly when you need to update the play head inside the waveform. The
-	method is smart enough to skip painting if the channel is stopped. */
+	method is smart enough to skip painting if the channel is stopped. It also
+	refreshes the picture as soon as peaks are ready. */
 
 	void redrawWaveformAsync();
 };
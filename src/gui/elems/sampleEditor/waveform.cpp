@@ -25,6 +25,7 @@
  * -------------------------------------------------------------------------- */
 
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <FL/fl_draw.H>
@@ -34,6 +35,9 @@
 #include "../../../core/const.h"
 #include "../../../core/mixer.h"
 #include "../../../core/waveFx.h"
+#include "../../../core/peaks.h"
+#include "../../../core/rope.h"
+#include "../../../core/peakBuilder.h"
 #include "../../../core/sampleChannel.h"
 #include "../../../glue/channel.h"
 #include "../../../glue/sampleEditor.h"
@@ -66,6 +70,11 @@ geWaveform::geWaveform(int x, int y, int w, int h, SampleChannel* ch, const char
 	m_data.inf  = nullptr;
 	m_data.size = 0;
 
+	m_cache.surface = nullptr;
+	m_cache.valid   = false;
+	m_cache.w       = 0;
+	m_cache.h       = 0;
+
 	m_grid.snap  = conf::sampleEditorGridOn;
 	m_grid.level = conf::sampleEditorGridVal;
 
@@ -79,6 +88,8 @@ geWaveform::geWaveform(int x, int y, int w, int h, SampleChannel* ch, const char
 geWaveform::~geWaveform()
 {
 	freeData();
+	if (m_cache.surface != nullptr)
+		fl_delete_offscreen(m_cache.surface);
 }
 
 
@@ -103,7 +114,7 @@ void geWaveform::freeData()
 
 int geWaveform::alloc(int datasize, bool force)
 {
-	Wave* wave = m_ch->wave;
+	const Wave* wave = m_ch->wave;
 
 	m_ratio = wave->getSize() / (float) datasize;
 
@@ -130,16 +141,33 @@ int geWaveform::alloc(int datasize, bool force)
 
 	gu_log("[geWaveform::alloc] %d pixels, %f m_ratio\n", m_data.size, m_ratio);
 
+	/* Peaks are built in background: until then there's only the zero line. 
+	refresh() is called again when they are ready (see hasNewPeaks). */
+
+	m_peaks = wave->getPeaks();
+	if (m_peaks == nullptr)
+		peakBuilder::request(*wave);
+
+	/* Levels are stored relative to the top of the widget, so that they can be
+	drawn anywhere (see drawCache). */
+
 	int offset = h() / 2;
-	int zero   = y() + offset; // center, zero amplitude (-inf dB)
+	int zero   = offset; // center, zero amplitude (-inf dB)
 
 	/* Frid frequency: store a grid point every 'gridFreq' frame (if grid is
 	enabled). TODO - this will cause round off errors, since gridFreq is integer. */
 
 	int gridFreq = m_grid.level != 0 ? wave->getSize() / m_grid.level : 0;
+	if (gridFreq != 0)
+		for (int k=gridFreq; k<wave->getSize(); k+=gridFreq)
+			m_grid.points.push_back(k);
 
-	/* Resampling the waveform, hardcore way. Many thanks to 
-	http://fourier.eng.hmc.edu/e161/lectures/resize/node3.html */
+	/* Scan the original waveform only when a pixel is smaller than a peak bin,
+	i.e. at the highest zoom levels. Otherwise peaks tell the levels of each 
+	pixel in a few steps, whatever the zoom. */
+
+	bool direct = m_ratio < Peaks::BIN_FRAMES && (wave->isDirect() || wave->isChunked());
+	std::shared_ptr<const Rope> rope = wave->getRope();
 
 	for (int i=0; i<m_data.size; i++) {
 		
@@ -151,28 +179,29 @@ int geWaveform::alloc(int datasize, bool force)
 		float peaksup = 0.0f;
 		float peakinf = 0.0f;
 
-		for (int k=pc; k<pn; k++) { // TODO - int until we switch to uint32_t for Wave size...
-
-			if (k >= wave->getSize())
-				continue;
-
-			/* Compute average of stereo signal. */
-
-			float avg = 0.0f;
-			float* frame = wave->getFrame(k);
-			for (int j=0; j<wave->getChannels(); j++)
-				avg += frame[j];
-			avg /= wave->getChannels();
-			
-			/* Find peaks (greater and lower). */
+		if (direct) {
+			for (int k=pc; k<pn && k<wave->getSize(); k++) {
 
-			if      (avg > peaksup)  peaksup = avg;
-			else if (avg <= peakinf) peakinf = avg;
+				/* Compute average of stereo signal. */
 
-			/* Fill up grid vector. */
+				float avg = 0.0f;
+				int span;
+				const float* frame = rope != nullptr ? rope->getSpan(k, &span) : wave->getFrame(k);
+				for (int j=0; j<wave->getChannels(); j++)
+					avg += frame[j];
+				avg /= wave->getChannels();
+				
+				/* Find peaks (greater and lower). */
 
-			if (gridFreq != 0 && (int) k % gridFreq == 0 && k != 0)
-				m_grid.points.push_back(k);
+				if      (avg > peaksup)  peaksup = avg;
+				else if (avg <= peakinf) peakinf = avg;
+			}
+		}
+		else
+		if (m_peaks != nullptr) {
+			Peak p  = m_peaks->get(pc, pn);
+			peaksup = std::max(p.max, 0.0f);
+			peakinf = std::min(p.min, 0.0f);
 		}
 
 		m_data.sup[i] = zero - (peaksup * m_ch->getBoost() * offset);
@@ -180,10 +209,11 @@ int geWaveform::alloc(int datasize, bool force)
 
 		// avoid window overflow
 
-		if (m_data.sup[i] < y())       m_data.sup[i] = y();
-		if (m_data.inf[i] > y()+h()-1) m_data.inf[i] = y()+h()-1;
+		if (m_data.sup[i] < 0)     m_data.sup[i] = 0;
+		if (m_data.inf[i] > h()-1) m_data.inf[i] = h()-1;
 	}
 
+	m_cache.valid = false;
 	recalcPoints();
 	return 1;
 }
@@ -202,13 +232,13 @@ void geWaveform::recalcPoints()
 /* -------------------------------------------------------------------------- */
 
 
-void geWaveform::drawSelection()
+void geWaveform::drawSelection(int ox, int oy)
 {
 	if (!isSelected()) 
 		return;
 
-	int a = frameToPixel(m_selection.a) + x();
-	int b = frameToPixel(m_selection.b) + x();
+	int a = frameToPixel(m_selection.a) + ox;
+	int b = frameToPixel(m_selection.b) + ox;
 
 	if (a < 0)
 		a = 0;
@@ -216,25 +246,25 @@ void geWaveform::drawSelection()
 		b = w() + BORDER;
 
 	if (a < b)
-		fl_rectf(a, y(), b-a, h(), G_COLOR_GREY_4);
+		fl_rectf(a, oy, b-a, h(), G_COLOR_GREY_4);
 	else
-		fl_rectf(b, y(), a-b, h(), G_COLOR_GREY_4);
+		fl_rectf(b, oy, a-b, h(), G_COLOR_GREY_4);
 }
 
 
 /* -------------------------------------------------------------------------- */
 
 
-void geWaveform::drawWaveform(int from, int to)
+void geWaveform::drawWaveform(int from, int to, int ox, int oy)
 {
-	int zero = y() + (h() / 2); // zero amplitude (-inf dB)
+	int zero = oy + (h() / 2); // zero amplitude (-inf dB)
 
 	fl_color(G_COLOR_BLACK);
 	for (int i=from; i<to; i++) {
 		if (i >= m_data.size)
 			break;
-		fl_line(i+x(), zero, i+x(), m_data.sup[i]);
-		fl_line(i+x(), zero, i+x(), m_data.inf[i]);
+		fl_line(i+ox, zero, i+ox, m_data.sup[i] + oy);
+		fl_line(i+ox, zero, i+ox, m_data.inf[i] + oy);
 	}
 }
 
@@ -242,7 +272,7 @@ void geWaveform::drawWaveform(int from, int to)
 /* -------------------------------------------------------------------------- */
 
 
-void geWaveform::drawGrid(int from, int to)
+void geWaveform::drawGrid(int from, int to, int ox, int oy)
 {
 	fl_color(G_COLOR_GREY_3);
 	fl_line_style(FL_DASH, 1, nullptr);
@@ -250,7 +280,7 @@ void geWaveform::drawGrid(int from, int to)
 	for (int pf : m_grid.points) {
 		int pp = frameToPixel(pf);
 		if (pp > from && pp < to)
-			fl_line(pp+x(), y(), pp+x(), y()+h());
+			fl_line(pp+ox, oy, pp+ox, oy+h());
 	}
 
 	fl_line_style(FL_SOLID, 0, nullptr);
@@ -311,13 +341,46 @@ void geWaveform::drawPlayHead()
 /* -------------------------------------------------------------------------- */
 
 
+void geWaveform::drawCache(int left, int width, int from, int to)
+{
+	if (m_cache.surface == nullptr || m_cache.w != width || m_cache.h != h()) {
+		if (m_cache.surface != nullptr)
+			fl_delete_offscreen(m_cache.surface);
+		m_cache.surface = fl_create_offscreen(width, h());
+		m_cache.w       = width;
+		m_cache.h       = h();
+	}
+
+	/* Warning: coordinates in the surface start from 0, whatever the position of
+	the widget. 'ox' is where the widget starts in there. */
+
+	int ox = x() - left;
+
+	fl_begin_offscreen(m_cache.surface);
+	fl_rectf(0, 0, width, h(), G_COLOR_GREY_2);  // blank canvas
+	drawSelection(ox, 0);
+	drawWaveform(from, to, ox, 0);
+	drawGrid(from, to, ox, 0);
+	fl_end_offscreen();
+
+	m_cache.valid = true;
+	m_cache.left  = left;
+	m_cache.x     = x();
+	m_cache.from  = from;
+	m_cache.to    = to;
+	m_cache.selA  = m_selection.a;
+	m_cache.selB  = m_selection.b;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 void geWaveform::draw()
 {
 	assert(m_data.sup != nullptr);
 	assert(m_data.inf != nullptr);
 
-	fl_rectf(x(), y(), w(), h(), G_COLOR_GREY_2);  // blank canvas
-
 	/* Draw things from 'from' (offset driven by the scrollbar) to 'to' (width of 
 	parent window). We don't draw the entire waveform, only the visibile part. */
 
@@ -326,9 +389,23 @@ void geWaveform::draw()
 	if (x() + w() < parent()->w())
 		to = x() + w() - BORDER;
 
-	drawSelection();
-	drawWaveform(from, to);
-	drawGrid(from, to);
+	/* The static part of the picture (visible area only) comes from the cache,
+	drawn again only if something has changed. Moving the play head, which 
+	happens many times per second during preview, just copies it back. */
+
+	int left  = std::max(x(), parent()->x());
+	int width = std::min(x() + w(), parent()->x() + parent()->w()) - left;
+	if (width <= 0)
+		return;
+
+	if (!m_cache.valid     || m_cache.left != left || m_cache.x != x() || 
+	    m_cache.w != width || m_cache.h != h()     || 
+	    m_cache.from != from || m_cache.to != to   || 
+	    m_cache.selA != m_selection.a || m_cache.selB != m_selection.b)
+		drawCache(left, width, from, to);
+
+	fl_copy_offscreen(left, y(), width, h(), m_cache.surface, 0, 0);
+
 	drawPlayHead();
 
 	fl_rect(x(), y(), w(), h(), G_COLOR_GREY_4);   // border box
@@ -680,6 +757,15 @@ void geWaveform::refresh()
 /* -------------------------------------------------------------------------- */
 
 
+bool geWaveform::hasNewPeaks() const
+{
+	return m_ch->wave->getPeaks() != m_peaks;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 bool geWaveform::smaller()
 {
 	return w() < parent()->w();
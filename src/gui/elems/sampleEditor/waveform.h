@@ -29,11 +29,18 @@
 #define GE_WAVEFORM_H
 
 
+#include <memory>
 #include <vector>
 #include <FL/Fl_Widget.H>
+#include <FL/fl_draw.H>
 
 
 class SampleChannel;
+namespace giada {
+namespace m
+{
+class Peaks;
+}}
 
 
 class geWaveform : public Fl_Widget
@@ -71,6 +78,30 @@ private:
 		std::vector<int> points;
 	} m_grid;
 
+	/* cache
+	Offscreen picture of the static part of the visible area: background, 
+	selection, waveform and grid. The other fields tell what it shows: it's drawn
+	again when any of them changes, or when alloc() sets 'valid' to false. */
+
+	struct
+	{
+		Fl_Offscreen surface;
+		bool valid;
+		int left;   // screen position of the visible area
+		int x;      // widget position, i.e. scrolling
+		int w;
+		int h;
+		int from;
+		int to;
+		int selA;
+		int selB;
+	} m_cache;
+
+	/* m_peaks
+	Waveform overview the picture comes from. Nullptr while being built. */
+
+	std::shared_ptr<const giada::m::Peaks> m_peaks;
+
 	SampleChannel* m_ch;
 	int m_chanStart;
 	bool m_chanStartLit;
@@ -122,14 +153,21 @@ private:
 	int snap(int pos);
 
 	/* draw*
-	Drawing functions. */
+	Drawing functions. Those with 'ox' and 'oy' draw as if the widget was at 
+	that position. */
 
-	void drawSelection();
-	void drawWaveform(int from, int to);
-	void drawGrid(int from, int to);
+	void drawSelection(int ox, int oy);
+	void drawWaveform(int from, int to, int ox, int oy);
+	void drawGrid(int from, int to, int ox, int oy);
 	void drawStartEndPoints();
 	void drawPlayHead();
 
+	/* drawCache
+	Draws the static part of the picture into m_cache, for the 'width' pixels 
+	wide visible area starting at 'left' on screen. */
+
+	void drawCache(int left, int width, int from, int to);
+
 	void selectAll();
 
 public:
@@ -169,6 +207,12 @@ public:
 
 	void refresh();
 
+	/* hasNewPeaks
+	Tells whether the wave has got new peaks since the last alloc(), e.g. built in
+	background. */
+
+	bool hasNewPeaks() const;
+
 	/* setGridLevel
 	 * set a new frequency level for the grid. 0 means disabled. */
 
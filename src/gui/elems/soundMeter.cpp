@@ -26,6 +26,7 @@
 
 
 #include <cmath>
+#include <algorithm>
 #include <FL/fl_draw.H>
 #include "../../core/const.h"
 #include "../../core/kernelAudio.h"
@@ -39,6 +40,7 @@ geSoundMeter::geSoundMeter(int x, int y, int w, int h, const char *L)
   : Fl_Box    (x, y, w, h, L),
     clip      (false),
     mixerPeak (0.0f),
+    mixerRms  (0.0f),
     peak      (0.0f),
     dbLevel   (0.0f),
     dbLevelOld(0.0f)
@@ -74,14 +76,22 @@ void geSoundMeter::draw()
 
   dbLevelOld = dbLevel;
 
-  /* graphical part */
-
-  float px_level = 0.0f;
-  if (dbLevel < 0.0f)
-    px_level = ((w()/G_MIN_DB_SCALE) * dbLevel) + w();
-  else
-    px_level = w();
+  /* graphical part: peak bar, with the RMS level drawn inside it */
 
   fl_rectf(x()+1, y()+1, w()-2, h()-2, G_COLOR_GREY_2);
-  fl_rectf(x()+1, y()+1, (int) px_level, h()-2, clip || !kernelAudio::getStatus() ? G_COLOR_RED_ALERT : G_COLOR_GREY_4);
+  fl_rectf(x()+1, y()+1, toPixels(dbLevel), h()-2, clip || !kernelAudio::getStatus() ? G_COLOR_RED_ALERT : G_COLOR_GREY_4);
+  if (mixerRms > 0.0f && !clip)
+    fl_rectf(x()+1, y()+1, toPixels(20 * log10(mixerRms)), h()-2, G_COLOR_LIGHT_1);
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+int geSoundMeter::toPixels(float db) const
+{
+  if (db >= 0.0f)
+    return w() - 2;
+  float px = ((w()/G_MIN_DB_SCALE) * db) + w();
+  return px > 0.0f ? std::min((int) px, w() - 2) : 0;
 }
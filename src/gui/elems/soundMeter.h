@@ -42,12 +42,18 @@ public:
 
   bool clip;
 	float mixerPeak;	// peak from mixer
+	float mixerRms;   // RMS from mixer
 
 private:
 
 	float peak;
 	float dbLevel;
 	float dbLevelOld;
+
+	/* toPixels
+	Converts a dB level to the meter width. */
+
+	int toPixels(float db) const;
 };
 
 
@@ -90,6 +90,11 @@ void* videoThreadCb(void* arg)
 
 	if (m::kernelAudio::getStatus())
 		while (!G_quit)	{
+			m::recorder::update();
+			Fl::lock();  // channels don't come and go meanwhile
+			m::mh::updateEnvelopes();
+			m::mixer::mergePendingInput();
+			Fl::unlock();
 			gu_refreshUI();
 			u::time::sleep(G_GUI_REFRESH_RATE);
 		}
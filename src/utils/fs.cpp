@@ -187,6 +187,20 @@ string gu_getCurrentPath()
 /* -------------------------------------------------------------------------- */
 
 
+bool gu_getFileStamp(const string& path, int64_t& size, int64_t& mtime)
+{
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0)
+		return false;
+	size  = st.st_size;
+	mtime = st.st_mtime;
+	return true;
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
 string gu_getExt(const string& file)
 {
 	// TODO - use std functions
@@ -32,6 +32,11 @@
 
 
 #include <string>
+#ifdef __APPLE__  // our Clang still doesn't know about cstdint (c++11 stuff)
+	#include <stdint.h>
+#else
+	#include <cstdint>
+#endif
 
 
 bool gu_fileExists(const std::string& path);
@@ -48,6 +53,12 @@ bool gu_mkdir(const std::string& path);
 std::string gu_getCurrentPath();
 std::string gu_getHomePath();
 
+/* gu_getFileStamp
+Reads size (in bytes) and last modification time of a file. Returns false if 
+the file can't be accessed. */
+
+bool gu_getFileStamp(const std::string& path, int64_t& size, int64_t& mtime);
+
 /* gu_basename
 /path/to/file.txt -> file.txt */
 
@@ -37,6 +37,8 @@
 #include "../core/clock.h"
 #include "../core/pluginHost.h"
 #include "../core/channel.h"
+#include "../core/sampleChannel.h"
+#include "../core/pitchCache.h"
 #include "../core/conf.h"
 #include "../core/graphics.h"
 #include "../gui/dialogs/gd_warnings.h"
@@ -91,6 +93,17 @@ void gu_refreshUI()
 	if (se != nullptr)
 		se->waveTools->redrawWaveformAsync();
 
+	/* Render waves of channels playing at a fixed pitch. Waves don't change 
+	while the GUI lock is held. */
+
+	for (Channel* ch : mixer::channels) {
+		if (ch->type != ChannelType::SAMPLE)
+			continue;
+		SampleChannel* sch = static_cast<SampleChannel*>(ch);
+		if (sch->wave != nullptr)
+			pitchCache::update(sch->pitchSlot, *sch->wave);
+	}
+
 	/* redraw GUI */
 
 	Fl::unlock();
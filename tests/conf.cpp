@@ -25,6 +25,11 @@ TEST_CASE("conf")
     conf::delayComp = 9;
     conf::limitOutput = true;
     conf::rsmpQuality = 10;
+    conf::renderThreads = 4;
+    conf::streamThreshold = 128;
+    conf::waveCacheSize = 512;
+    conf::nativeSamples = true;
+    conf::peakFiles = true;
     conf::midiSystem = 11;
     conf::midiPortOut = 12;
     conf::midiPortIn = 13;
@@ -100,6 +105,11 @@ TEST_CASE("conf")
     REQUIRE(conf::delayComp == 9);
     REQUIRE(conf::limitOutput == true);
     REQUIRE(conf::rsmpQuality == 0); // sanitized
+    REQUIRE(conf::renderThreads == 4);
+    REQUIRE(conf::streamThreshold == 128);
+    REQUIRE(conf::waveCacheSize == 512);
+    REQUIRE(conf::nativeSamples == true);
+    REQUIRE(conf::peakFiles == true);
     REQUIRE(conf::midiSystem == 11);
     REQUIRE(conf::midiPortOut == 12);
     REQUIRE(conf::midiPortIn == 13);
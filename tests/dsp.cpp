@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+#include "../src/core/audioBuffer.h"
+#include "../src/core/dsp.h"
+#include <catch.hpp>
+
+
+using namespace giada::m;
+
+
+namespace
+{
+void fill(AudioBuffer& b, int seed)
+{
+	std::srand(seed);
+	for (int i=0; i<b.countSamples(); i++)
+		b[0][i] = (std::rand() / (float) RAND_MAX) * 4.0f - 2.0f;
+}
+
+
+/* run
+Runs all kernels on copies of the same data. */
+
+struct Result
+{
+	AudioBuffer add, ramp, scaled, clipped, finalized, faded, reversed;
+	AudioBuffer coefs, convolved;
+	float peak;
+	dsp::Meter measured;
+	dsp::Meter final;
+};
+
+const int TAPS = 13;  // odd on purpose: leftovers
+
+void run(Result& r, const AudioBuffer& src, int frames, int channels)
+{
+	const float gains[4] = { 0.7f, 0.3f, 0.5f, 0.9f };
+
+	for (AudioBuffer* b : { &r.add, &r.ramp, &r.scaled, &r.clipped, &r.finalized, 
+		&r.faded, &r.reversed }) {
+		b->alloc(frames, channels);
+		fill(*b, 42);
+	}
+	dsp::add(r.add, src, gains);
+	dsp::addRamp(r.ramp, src, gains, 0.9f, -0.003f);
+	dsp::scale(r.scaled, 0.5f);
+	dsp::clip(r.clipped, 1.0f);
+	r.peak     = dsp::peak(src);
+	r.measured = dsp::measure(src);
+	r.final    = dsp::finalize(r.finalized, &src, 0.8f, 1.0f);
+	dsp::fade(r.faded[0], 10, frames - 3, channels, 1.2f, -0.002f);
+	dsp::reverse(r.reversed[0], frames, channels);
+
+	r.coefs.alloc(TAPS, 1);
+	r.convolved.alloc(1, channels);
+	fill(r.coefs, 7);
+	dsp::convolve(r.convolved[0], src[0], r.coefs[0], TAPS, channels);
+}
+}; // {anonymous}
+
+
+TEST_CASE("dsp")
+{
+	static const int FRAMES = 1023;  // odd on purpose: leftovers
+
+	SECTION("test scalar kernels")
+	{
+		AudioBuffer src, dest;
+		src.alloc(FRAMES, 2);
+		dest.alloc(FRAMES, 2);
+		fill(src, 1);
+		fill(dest, 42);
+
+		REQUIRE(dsp::setIsa(dsp::Isa::SCALAR) == true);
+		Result r;
+		run(r, src, FRAMES, 2);
+
+		REQUIRE(r.add[0][0] == Approx(dest[0][0] + src[0][0] * 0.7f));
+		REQUIRE(r.add[0][1] == Approx(dest[0][1] + src[0][1] * 0.3f));
+		REQUIRE(r.ramp[0][0] == Approx(dest[0][0] + src[0][0] * 0.7f * 0.9f));
+		REQUIRE(r.scaled[5][0] == Approx(dest[5][0] * 0.5f));
+		for (int i=0; i<r.clipped.countSamples(); i++)
+			REQUIRE(std::abs(r.clipped[0][i]) <= 1.0f);
+
+		/* The ramp hits zero at frame 300 and stays there. */
+		REQUIRE(r.ramp[FRAMES - 1][0] == Approx(dest[FRAMES - 1][0]));
+
+		/* finalize: (dest + src) * gain, clamped. Meters describe the result. */
+		float sum  = 0.0f;
+		float peak = 0.0f;
+		for (int i=0; i<dest.countSamples(); i++) {
+			float s = std::min(std::max((dest[0][i] + src[0][i]) * 0.8f, -1.0f), 1.0f);
+			REQUIRE(r.finalized[0][i] == Approx(s));
+			sum += s * s;
+			peak = std::max(peak, std::abs(s));
+		}
+		REQUIRE(r.final.peak == Approx(peak));
+		REQUIRE(r.final.rms  == Approx(std::sqrt(sum / dest.countSamples())));
+		REQUIRE(r.measured.peak == r.peak);
+
+		/* No limit and no mix: plain gain. */
+		AudioBuffer loud;
+		loud.alloc(FRAMES, 2);
+		fill(loud, 42);
+		dsp::Meter m = dsp::finalize(loud, nullptr, 2.0f, 0.0f);
+		REQUIRE(loud[3][1] == Approx(dest[3][1] * 2.0f));
+		REQUIRE(m.peak > 1.0f);
+
+		/* fade: frames outside [10, FRAMES-3) untouched, ramp clamped to 1. */
+		REQUIRE(r.faded[9][0] == dest[9][0]);
+		REQUIRE(r.faded[10][1] == dest[10][1]);
+		REQUIRE(r.faded[500][0] == Approx(dest[500][0] * (1.2f - 500 * 0.002f)));
+		REQUIRE(r.faded[FRAMES - 1][1] == dest[FRAMES - 1][1]);
+
+		/* reverse: frames swapped, channels in place. */
+		for (int i=0; i<FRAMES; i++) {
+			REQUIRE(r.reversed[i][0] == dest[FRAMES - 1 - i][0]);
+			REQUIRE(r.reversed[i][1] == dest[FRAMES - 1 - i][1]);
+		}
+
+		/* convolve: one weighted sum per channel. */
+		for (int j=0; j<2; j++) {
+			float sum = 0.0f;
+			for (int i=0; i<TAPS; i++)
+				sum += src[i][j] * r.coefs[i][0];
+			REQUIRE(r.convolved[0][j] == Approx(sum));
+		}
+	}
+
+	SECTION("test SIMD kernels match scalar ones")
+	{
+		for (int channels : { 1, 2, 3, 4 }) {
+			AudioBuffer src;
+			src.alloc(FRAMES, channels);
+			fill(src, channels);
+
+			REQUIRE(dsp::setIsa(dsp::Isa::SCALAR) == true);
+			Result expected;
+			run(expected, src, FRAMES, channels);
+
+			for (dsp::Isa isa : { dsp::Isa::SSE2, dsp::Isa::AVX2 }) {
+				if (!dsp::setIsa(isa))
+					continue;
+				Result r;
+				run(r, src, FRAMES, channels);
+				for (int i=0; i<src.countSamples(); i++) {
+					REQUIRE(r.add[0][i]     == Approx(expected.add[0][i]));
+					REQUIRE(r.ramp[0][i]    == Approx(expected.ramp[0][i]));
+					REQUIRE(r.scaled[0][i]  == Approx(expected.scaled[0][i]));
+					REQUIRE(r.clipped[0][i] == expected.clipped[0][i]);
+					REQUIRE(r.finalized[0][i] == Approx(expected.finalized[0][i]));
+					REQUIRE(r.faded[0][i]    == Approx(expected.faded[0][i]));
+					REQUIRE(r.reversed[0][i] == expected.reversed[0][i]);
+				}
+				for (int j=0; j<channels; j++)
+					REQUIRE(r.convolved[0][j] == Approx(expected.convolved[0][j]));
+				REQUIRE(r.peak == expected.peak);
+				REQUIRE(r.measured.peak == expected.measured.peak);
+				REQUIRE(r.measured.rms  == Approx(expected.measured.rms));
+				REQUIRE(r.final.peak    == Approx(expected.final.peak));
+				REQUIRE(r.final.rms     == Approx(expected.final.rms));
+			}
+		}
+	}
+
+	SECTION("test decoding")
+	{
+		std::vector<int16_t> pcm16(FRAMES * 2);
+		std::vector<unsigned char> pcm24(FRAMES * 3);
+		std::vector<float> pcm32(FRAMES);
+		for (int i=0; i<FRAMES * 2; i++)
+			pcm16[i] = (i * 37) % 65536 - 32768;
+		for (int i=0; i<FRAMES; i++) {
+			int32_t v = (i * 8191) % 16777216 - 8388608;
+			pcm24[i*3]     = v & 0xFF;
+			pcm24[i*3 + 1] = (v >> 8) & 0xFF;
+			pcm24[i*3 + 2] = (v >> 16) & 0xFF;
+			pcm32[i] = i / (float) FRAMES;
+		}
+
+		for (dsp::Isa isa : { dsp::Isa::SCALAR, dsp::Isa::SSE2, dsp::Isa::AVX2 }) {
+			if (!dsp::setIsa(isa))
+				continue;
+
+			AudioBuffer stereo, mono, mono24, monoFloat;
+			for (AudioBuffer* b : { &stereo, &mono, &mono24, &monoFloat })
+				b->alloc(FRAMES + 1, 2);
+
+			dsp::decode(stereo, 1, pcm16.data(), dsp::Format::INT16, 2, FRAMES);
+			dsp::decode(mono, 1, pcm16.data(), dsp::Format::INT16, 1, FRAMES);
+			dsp::decode(mono24, 1, pcm24.data(), dsp::Format::INT24, 1, FRAMES);
+			dsp::decode(monoFloat, 1, pcm32.data(), dsp::Format::FLOAT32, 1, FRAMES);
+
+			/* Frame 0 is the offset: left untouched. */
+			REQUIRE(stereo[0][0] == 0.0f);
+			REQUIRE(mono[0][1] == 0.0f);
+
+			for (int i=0; i<FRAMES; i++) {
+				REQUIRE(stereo[i + 1][0] == pcm16[i*2] / 32768.0f);
+				REQUIRE(stereo[i + 1][1] == pcm16[i*2 + 1] / 32768.0f);
+				REQUIRE(mono[i + 1][0] == pcm16[i] / 32768.0f);
+				REQUIRE(mono[i + 1][1] == mono[i + 1][0]);
+				int32_t v = (i * 8191) % 16777216 - 8388608;
+				REQUIRE(mono24[i + 1][0] == Approx(v / 8388608.0f));
+				REQUIRE(mono24[i + 1][1] == mono24[i + 1][0]);
+				REQUIRE(monoFloat[i + 1][0] == pcm32[i]);
+				REQUIRE(monoFloat[i + 1][1] == pcm32[i]);
+			}
+		}
+	}
+
+	dsp::init();
+}
+
+
+/* Run with: giada_tests "[bench]" */
+
+TEST_CASE("dsp benchmark", "[.bench]")
+{
+	static const int FRAMES = 1024;
+	static const int BLOCKS = 20000;
+
+	const float gains[2] = { 0.7f, 0.3f };
+
+	AudioBuffer src, dest;
+	src.alloc(FRAMES, 2);
+	dest.alloc(FRAMES, 2);
+	fill(src, 1);
+
+	for (dsp::Isa isa : { dsp::Isa::SCALAR, dsp::Isa::SSE2, dsp::Isa::AVX2 }) {
+		if (!dsp::setIsa(isa))
+			continue;
+		dest.clear();
+		auto t0 = std::chrono::steady_clock::now();
+		for (int i=0; i<BLOCKS; i++) {
+			dsp::addRamp(dest, src, gains, 0.0f, 0.0001f);
+			dsp::clip(dest, 1.0f);
+		}
+		float peak = dsp::peak(dest);
+		auto t1 = std::chrono::steady_clock::now();
+		std::printf("[dsp benchmark] %-6s %8.1f ns/block (peak=%f)\n", 
+			dsp::getIsaName(isa), 
+			std::chrono::duration<double, std::nano>(t1 - t0).count() / BLOCKS, peak);
+
+		/* Master output: separate passes vs the fused one. */
+
+		t0 = std::chrono::steady_clock::now();
+		for (int i=0; i<BLOCKS; i++) {
+			dsp::add(dest, src, gains);
+			dsp::scale(dest, 0.5f);
+			dsp::clip(dest, 1.0f);
+			peak = dsp::peak(dest);
+		}
+		t1 = std::chrono::steady_clock::now();
+		for (int i=0; i<BLOCKS; i++)
+			peak = dsp::finalize(dest, &src, 0.5f, 1.0f).peak;
+		auto t2 = std::chrono::steady_clock::now();
+		std::printf("[dsp benchmark] %-6s %8.1f ns/block multi-pass, %8.1f ns/block fused (peak=%f)\n", 
+			dsp::getIsaName(isa), 
+			std::chrono::duration<double, std::nano>(t1 - t0).count() / BLOCKS,
+			std::chrono::duration<double, std::nano>(t2 - t1).count() / BLOCKS, peak);
+	}
+	dsp::init();
+}
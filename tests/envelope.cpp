@@ -0,0 +1,95 @@
+#include "../src/core/recorder.h"
+#include "../src/core/envelope.h"
+#include "../src/core/const.h"
+#include <catch.hpp>
+
+
+using namespace giada::m;
+
+
+TEST_CASE("Envelope")
+{
+	recorder::init();
+	recorder::setFramesInBeat(1000);
+
+	/* A ramp up and down, as the envelope editor draws it: breakpoints on the
+	first and last frame of the loop. */
+
+	recorder::rec(0, G_ACTION_VOLUME, 0,    0, 0.0f);
+	recorder::rec(0, G_ACTION_VOLUME, 1000, 0, 1.0f);
+	recorder::rec(0, G_ACTION_VOLUME, 3999, 0, 0.5f);
+	recorder::rec(1, G_ACTION_VOLUME, 500,  0, 0.3f);  // another channel
+	recorder::rec(0, G_ACTION_KEYPRESS, 200);
+
+	Envelope env(G_ACTION_VOLUME);
+	REQUIRE(env.isEmpty());
+	env.compile(0);
+	REQUIRE(env.isEmpty());  // not picked up yet
+	env.prepare();
+
+	SECTION("test ramps")
+	{
+		Envelope::Ramp r = env.getRamp(0, 256);
+		REQUIRE(r.frames == 256);
+		REQUIRE(r.start == Approx(0.0f));
+		REQUIRE(r.step == Approx(0.001f));
+
+		/* Stops on the next breakpoint. */
+
+		r = env.getRamp(900, 256);
+		REQUIRE(r.frames == 100);
+		REQUIRE(r.start == Approx(0.9f));
+
+		r = env.getRamp(1000, 256);
+		REQUIRE(r.start == Approx(1.0f));
+		REQUIRE(r.step < 0.0f);
+
+		/* Holds after the last one. */
+
+		r = env.getRamp(3999, 256);
+		REQUIRE(r.frames == 256);
+		REQUIRE(r.start == Approx(0.5f));
+		REQUIRE(r.step == 0.0f);
+
+		/* Backwards, e.g. the sequencer looped. */
+
+		REQUIRE(env.getValue(500) == Approx(0.5f));
+		REQUIRE(env.getValue(2000) == Approx(1.0f - 0.5f * 1000 / 2999));
+		REQUIRE(env.getValue(100) == Approx(0.1f));
+	}
+
+	SECTION("test other channel")
+	{
+		env.compile(1);
+		env.prepare();
+		REQUIRE(env.getValue(0) == Approx(0.3f));  // holds before the first one
+		REQUIRE(env.getRamp(0, 1000).frames == 500);
+	}
+
+	SECTION("test rebuild")
+	{
+		recorder::deleteAction(0, 1000, G_ACTION_VOLUME, false);
+		REQUIRE(env.getValue(1000) == Approx(1.0f));  // not rebuilt yet
+		env.compile(0);
+		env.prepare();
+		REQUIRE(env.getValue(1000) == Approx(0.5f * 1000 / 3999));
+
+		/* Breakpoints follow the tempo. */
+
+		recorder::setFramesInBeat(2000);
+		env.compile(0);
+		env.prepare();
+		REQUIRE(env.getRamp(0, 10000).frames == 7998);  // twice 3999
+	}
+
+	SECTION("test parameter")
+	{
+		recorder::rec(0, G_ACTION_MIDI, 0, 0x2, 0.7f);
+		recorder::rec(0, G_ACTION_MIDI, 0, 0x3, 0.2f);
+
+		Envelope param(G_ACTION_MIDI, 0x3);
+		param.compile(0);
+		param.prepare();
+		REQUIRE(param.getValue(0) == Approx(0.2f));
+	}
+}
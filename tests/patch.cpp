@@ -85,6 +85,7 @@ TEST_CASE("patch")
 		channel1.boost             = 0;
 		channel1.recActive         = 0;
 		channel1.pitch             = 1.2f;
+		channel1.interpolation     = 4;
 		channel1.midiInReadActions = 0;
 		channel1.midiInPitch       = 0;
 		channel1.midiOut           = 0;
@@ -173,6 +174,7 @@ TEST_CASE("patch")
 		REQUIRE(channel0.boost == 1.0f);
 		REQUIRE(channel0.recActive == 0);
 		REQUIRE(channel0.pitch == Approx(1.2f));
+		REQUIRE(channel0.interpolation == 4);
 		REQUIRE(channel0.midiInReadActions == 0);
 		REQUIRE(channel0.midiInPitch == 0);
 		REQUIRE(channel0.midiOut == 0);
@@ -0,0 +1,63 @@
+#include <memory>
+#include "../src/core/patchLoader.h"
+#include "../src/core/patch.h"
+#include "../src/core/wave.h"
+#include "../src/core/const.h"
+#include "../src/core/types.h"
+#include <catch.hpp>
+
+
+using namespace giada;
+using namespace giada::m;
+
+
+TEST_CASE("patchLoader")
+{
+  auto makeChannel = [] (ChannelType type, const std::string& path) {
+    patch::channel_t pch = patch::channel_t();
+    pch.type       = static_cast<int>(type);
+    pch.samplePath = path;
+    return pch;
+  };
+
+  patch::channels.clear();
+  patch::channels.push_back(makeChannel(ChannelType::SAMPLE, "test.wav"));
+  patch::channels.push_back(makeChannel(ChannelType::MIDI, ""));
+  patch::channels.push_back(makeChannel(ChannelType::SAMPLE, "test.wav"));
+  patch::channels.push_back(makeChannel(ChannelType::SAMPLE, "missing.wav"));
+
+  patchLoader::start("tests/resources/");
+  patchLoader::finish();
+
+  REQUIRE(patchLoader::getProgress() == 1.0f);
+
+  SECTION("test results")
+  {
+    Wave* w0;
+    Wave* w1;
+    Wave* w2;
+    Wave* w3;
+    REQUIRE(patchLoader::getWave(0, &w0) == G_RES_OK);
+    REQUIRE(patchLoader::getWave(1, &w1) == G_RES_ERR_NO_DATA);
+    REQUIRE(patchLoader::getWave(2, &w2) == G_RES_OK);
+    REQUIRE(patchLoader::getWave(3, &w3) == G_RES_ERR_IO);
+    
+    std::unique_ptr<Wave> wave0(w0);
+    std::unique_ptr<Wave> wave2(w2);
+
+    REQUIRE(w0 != w2);
+    REQUIRE(w1 == nullptr);
+    REQUIRE(w3 == nullptr);
+    REQUIRE(wave0->getSize() == wave2->getSize());
+    REQUIRE(wave0->isLogical() == wave2->isLogical());
+
+    /* The same sample is read once and shared. */
+
+    const Wave* c0 = wave0.get();
+    const Wave* c2 = wave2.get();
+    REQUIRE(c0->getFrame(0) == c2->getFrame(0));
+  }
+
+  patchLoader::clear();
+  patch::channels.clear();
+}
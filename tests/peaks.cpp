@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../src/core/peaks.h"
+#include "../src/core/peakBuilder.h"
+#include "../src/core/waveManager.h"
+#include "../src/core/wave.h"
+#include "../src/core/const.h"
+#include <catch.hpp>
+
+
+using namespace giada::m;
+
+
+namespace
+{
+/* scan
+Levels of frames [a, b) the slow way. */
+
+Peak scan(const std::vector<float>& data, int channels, int a, int b)
+{
+  Peak p = { 0.0f, 0.0f, 0.0f };
+  for (int i=a; i<b; i++) {
+    float avg = 0.0f;
+    for (int j=0; j<channels; j++)
+      avg += data[i * channels + j];
+    avg /= channels;
+    p.min  = i == a ? avg : std::min(p.min, avg);
+    p.max  = i == a ? avg : std::max(p.max, avg);
+    p.rms += avg * avg;
+  }
+  p.rms = std::sqrt(p.rms / (b - a));
+  return p;
+}
+}; // {anonymous}
+
+
+TEST_CASE("peaks")
+{
+  static const int FRAMES   = 100000;  // not a multiple of BIN_FRAMES
+  static const int CHANNELS = 2;
+
+  std::vector<float> data(FRAMES * CHANNELS);
+  for (int i=0; i<FRAMES; i++) {
+    data[i * CHANNELS]     = std::sin(i * 0.001f) * 0.8f;
+    data[i * CHANNELS + 1] = std::sin(i * 0.0007f) * 0.5f;
+  }
+
+  Peaks peaks(FRAMES);
+  peaks.write(data.data(), CHANNELS, 0, FRAMES);
+
+  SECTION("test levels")
+  {
+    REQUIRE(peaks.countFrames() == FRAMES);
+    REQUIRE(peaks.countLevels() > 1);
+
+    /* Ranges aligned to bins give exact values, at any level. */
+
+    for (int span : { Peaks::BIN_FRAMES, Peaks::BIN_FRAMES * Peaks::FACTOR * 4, FRAMES }) {
+      for (int a=0; a<FRAMES; a+=span) {
+        int  b = std::min(a + span, FRAMES);
+        Peak p = peaks.get(a, b);
+        Peak e = scan(data, CHANNELS, a, b);
+        REQUIRE(p.min == Approx(e.min));
+        REQUIRE(p.max == Approx(e.max));
+        REQUIRE(p.rms == Approx(e.rms));
+      }
+    }
+
+    Peak empty = peaks.get(FRAMES, FRAMES + 10);
+    REQUIRE(empty.max == 0.0f);
+  }
+
+  SECTION("test update")
+  {
+    int a = Peaks::BIN_FRAMES * 10;
+    int b = Peaks::BIN_FRAMES * 20;
+    for (int i=a; i<b; i++)
+      data[i * CHANNELS] = data[i * CHANNELS + 1] = 1.0f;
+    peaks.write(&data[a * CHANNELS], CHANNELS, a, b - a);
+
+    REQUIRE(peaks.get(a, b).max == 1.0f);
+    REQUIRE(peaks.get(0, FRAMES).max == 1.0f);
+    REQUIRE(peaks.get(0, Peaks::BIN_FRAMES * 8).max < 1.0f);
+  }
+
+  SECTION("test load/save")
+  {
+    static const std::string PATH = "./test.peaks";
+
+    REQUIRE(peaks.save(PATH, 1234, 5678) == true);
+
+    Peaks loaded(FRAMES);
+    REQUIRE(loaded.load(PATH, 1234, 9999) == false);  // source has changed
+    REQUIRE(loaded.load(PATH, 1234, 5678) == true);
+    for (int a=0; a<FRAMES; a+=1000) {
+      REQUIRE(loaded.get(a, FRAMES).min == peaks.get(a, FRAMES).min);
+      REQUIRE(loaded.get(a, FRAMES).rms == peaks.get(a, FRAMES).rms);
+    }
+
+    Peaks other(FRAMES / 2);
+    REQUIRE(other.load(PATH, 1234, 5678) == false);  // different size
+
+    std::remove(PATH.c_str());
+  }
+
+  SECTION("test builder")
+  {
+    peakBuilder::init();
+
+    Wave* w;
+    REQUIRE(waveManager::create("tests/resources/test.wav", &w, 
+      waveManager::Storage::FLOAT) == G_RES_OK);
+    std::unique_ptr<Wave> wave(w);
+
+    REQUIRE(wave->getPeaks() == nullptr);
+    peakBuilder::request(*wave);
+    while (peakBuilder::isBusy())
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    std::shared_ptr<const Peaks> built = wave->getPeaks();
+    REQUIRE(built != nullptr);
+    REQUIRE(built->countFrames() == wave->getSize());
+
+    /* In-place edits update peaks right away. */
+
+    const Wave& cw = *wave;
+    float old = built->get(0, cw.getSize()).max;
+    for (int i=0; i<Peaks::BIN_FRAMES; i++)
+      for (int j=0; j<wave->getChannels(); j++)
+        wave->getFrame(i)[j] = 1.0f;
+    peakBuilder::update(*wave, 0, Peaks::BIN_FRAMES);
+    REQUIRE(wave->getPeaks() != built);
+    REQUIRE(wave->getPeaks()->get(0, cw.getSize()).max == 1.0f);
+    REQUIRE(built->get(0, cw.getSize()).max == old);  // old ones never change
+
+    /* New data drops them. */
+
+    AudioBuffer empty;
+    empty.alloc(16, G_MAX_IO_CHANS);
+    wave->moveData(empty);
+    REQUIRE(wave->getPeaks() == nullptr);
+
+    peakBuilder::close();
+  }
+}
@@ -0,0 +1,108 @@
+#include <memory>
+#include <samplerate.h>
+#include "../src/core/const.h"
+#include "../src/core/conf.h"
+#include "../src/core/audioBuffer.h"
+#include "../src/core/wave.h"
+#include "../src/core/pitchCache.h"
+#include "../src/utils/time.h"
+#include <catch.hpp>
+
+
+using namespace giada;
+using namespace giada::m;
+
+
+TEST_CASE("pitchCache")
+{
+	static const int FRAMES = 44100;
+	static const int BLOCK  = 1024;
+
+	conf::samplerate  = 44100;
+	conf::rsmpQuality = SRC_LINEAR;
+	conf::pitchCache  = true;
+
+	pitchCache::init();
+
+	Wave wave;
+	wave.alloc(FRAMES, G_MAX_IO_CHANS, conf::samplerate, 32, "path/to/sample.wav");
+	for (int i=0; i<FRAMES; i++)
+		wave[i][0] = wave[i][1] = 0.5f;
+
+	std::shared_ptr<pitchCache::Slot> slot = std::make_shared<pitchCache::Slot>();
+
+	/* play
+	Runs the audio side for 'frames' frames at 'pitch', then the GUI one, and
+	waits for the render thread. */
+
+	auto play = [&](const Wave& w, float pitch, int frames)
+	{
+		bool ready = false;
+		for (int i=0; i<frames; i+=BLOCK)
+			ready = slot->prepare(w, pitch, BLOCK);
+		pitchCache::update(slot, w);
+		while (pitchCache::isBusy())
+			u::time::sleep(1);
+		return ready;
+	};
+
+	int settle = pitchCache::SETTLE_TIME * conf::samplerate + BLOCK;
+
+	SECTION("test render")
+	{
+		REQUIRE(play(wave, 0.5f, settle) == false);  // asked for, not ready yet
+		REQUIRE(slot->prepare(wave, 0.5f, BLOCK) == true);
+
+		AudioBuffer dest;
+		dest.alloc(BLOCK, G_MAX_IO_CHANS);
+
+		/* Twice as many frames out as frames in. Consecutive reads carry on from
+		each other. */
+
+		REQUIRE(slot->read(dest, 1000, FRAMES, 0) == BLOCK / 2);
+		REQUIRE(dest[BLOCK - 1][0] == Approx(0.5f));
+		REQUIRE(slot->read(dest, 1000 + BLOCK / 2, FRAMES, 0) == BLOCK / 2);
+
+		/* Up to 'end' only. */
+
+		REQUIRE(slot->read(dest, 1000, 1100, 0) == 100);
+
+		SECTION("test pitch change")
+		{
+			REQUIRE(slot->prepare(wave, 0.6f, BLOCK) == false);
+			REQUIRE(slot->prepare(wave, 0.5f, BLOCK) == true);  // still there
+		}
+
+		SECTION("test data change")
+		{
+			Wave other(wave);
+			other[0][0] = 0.0f;  // copy on write: new data
+			REQUIRE(slot->prepare(other, 0.5f, BLOCK) == false);
+		}
+
+		SECTION("test disable")
+		{
+			conf::pitchCache = false;
+			REQUIRE(slot->prepare(wave, 0.5f, BLOCK) == false);
+			conf::pitchCache = true;
+		}
+	}
+
+	SECTION("test not settled")
+	{
+		/* The pitch keeps moving: nothing to render. */
+
+		for (int i=0; i<settle; i+=BLOCK)
+			REQUIRE(play(wave, 0.5f + (i % 2) * 0.1f, BLOCK) == false);
+		REQUIRE(slot->prepare(wave, 0.6f, BLOCK) == false);
+	}
+
+	SECTION("test no pitch")
+	{
+		REQUIRE(play(wave, 1.0f, settle) == false);
+		REQUIRE(slot->prepare(wave, 1.0f, BLOCK) == false);
+	}
+
+	slot.reset();
+	pitchCache::close();
+}
@@ -0,0 +1,67 @@
+#include <thread>
+#include "../src/core/queue.h"
+#include <catch.hpp>
+
+
+TEST_CASE("Queue")
+{
+	using namespace giada::m;
+
+	static const int QUEUE_SIZE = 8;
+
+	Queue<int, QUEUE_SIZE> queue;
+	int item;
+
+	SECTION("test empty")
+	{
+		REQUIRE(queue.isEmpty() == true);
+		REQUIRE(queue.pop(item) == false);
+	}
+
+	SECTION("test FIFO order")
+	{
+		for (int i=0; i<5; i++)
+			REQUIRE(queue.push(i) == true);
+		REQUIRE(queue.isEmpty() == false);
+
+		for (int i=0; i<5; i++) {
+			REQUIRE(queue.pop(item) == true);
+			REQUIRE(item == i);
+		}
+		REQUIRE(queue.isEmpty() == true);
+	}
+
+	SECTION("test full")
+	{
+		for (int i=0; i<QUEUE_SIZE - 1; i++)
+			REQUIRE(queue.push(i) == true);
+		REQUIRE(queue.push(42) == false);
+
+		REQUIRE(queue.pop(item) == true);
+		REQUIRE(item == 0);
+		REQUIRE(queue.push(42) == true);  // wraps around
+	}
+
+	SECTION("test producer/consumer")
+	{
+		static const int ITEMS = 100000;
+
+		std::thread producer([&queue]()
+		{
+			for (int i=0; i<ITEMS; i++)
+				while (!queue.push(i))
+					std::this_thread::yield();
+		});
+
+		bool ordered = true;
+		for (int i=0; i<ITEMS; i++) {
+			while (!queue.pop(item))
+				std::this_thread::yield();
+			ordered &= item == i;
+		}
+		producer.join();
+
+		REQUIRE(ordered == true);
+		REQUIRE(queue.isEmpty() == true);
+	}
+}
@@ -4,33 +4,88 @@
 
 
 using std::string;
+using std::vector;
 using namespace giada::m;
 
 
+namespace
+{
+/* getActions
+Returns a copy of the whole timeline, sorted by frame. */
+
+vector<recorder::action> getActions()
+{
+	vector<recorder::action> out;
+	recorder::forEachAction([&](const recorder::action* a) { out.push_back(*a); });
+	return out;
+}
+
+
+/* getFrames
+Returns the list of frames that contain at least one action. */
+
+vector<int> getFrames()
+{
+	vector<int> out;
+	for (const recorder::action& a : getActions())
+		if (out.empty() || out.back() != a.frame)
+			out.push_back(a.frame);
+	return out;
+}
+
+
+/* getActionsInRange
+Looks actions up as the audio thread does, on the timeline published so far. */
+
+recorder::ActionRange getActionsInRange(int a, int b)
+{
+	recorder::update();
+	recorder::beginBlock();
+	recorder::ActionRange r = recorder::getActionsInRange(a, b);
+	recorder::endBlock();
+	return r;
+}
+
+
+/* getAction
+Returns the j-th action recorded on the i-th non-empty frame. */
+
+recorder::action getAction(size_t i, size_t j)
+{
+	int frame = getFrames().at(i);
+	return *(getActionsInRange(frame, frame + 1).begin() + j);
+}
+
+
+size_t countActionsOnFrame(int frame)
+{
+	recorder::ActionRange r = getActionsInRange(frame, frame + 1);
+	return r.end() - r.begin();
+}
+} // {anonymous}
+
+
 TEST_CASE("recorder")
 {
 	/* Each SECTION the TEST_CASE is executed from the start. The following
 	code is exectuted before each SECTION. */
 
-	pthread_mutex_t mutex;
-	pthread_mutex_init(&mutex, nullptr);
-
 	recorder::init();
-	REQUIRE(recorder::frames.size() == 0);
-	REQUIRE(recorder::global.size() == 0);
+	recorder::setFramesInBeat(22050);  // 120 bpm at 44100 Hz
+	REQUIRE(getFrames().size() == 0);
 
 	SECTION("Test record single action")
 	{
 		recorder::rec(0, G_ACTION_KEYPRESS, 50, 1, 0.5f);
 
-		REQUIRE(recorder::frames.size() == 1);
-		REQUIRE(recorder::frames.at(0) == 50);
-		REQUIRE(recorder::global.at(0).size() == 1);  // 1 action on frame #0
-		REQUIRE(recorder::global.at(0).at(0)->chan == 0);
-		REQUIRE(recorder::global.at(0).at(0)->type == G_ACTION_KEYPRESS);
-		REQUIRE(recorder::global.at(0).at(0)->frame == 50);
-		REQUIRE(recorder::global.at(0).at(0)->iValue == 1);
-		REQUIRE(recorder::global.at(0).at(0)->fValue == 0.5f);
+		REQUIRE(getFrames().size() == 1);
+		REQUIRE(getFrames().at(0) == 50);
+		REQUIRE(countActionsOnFrame(getFrames().at(0)) == 1);  // 1 action on frame #0
+		REQUIRE(getAction(0, 0).chan == 0);
+		REQUIRE(getAction(0, 0).type == G_ACTION_KEYPRESS);
+		REQUIRE(getAction(0, 0).frame == 50);
+		REQUIRE(getAction(0, 0).iValue == 1);
+		REQUIRE(getAction(0, 0).fValue == 0.5f);
 	}
 
 	SECTION("Test record, two actions on same frame")
@@ -38,35 +93,35 @@ TEST_CASE("recorder")
 		recorder::rec(0, G_ACTION_KEYPRESS, 50, 6, 0.3f);
 		recorder::rec(0, G_ACTION_KEYREL,   50, 1, 0.5f);
 
-		REQUIRE(recorder::frames.size() == 1);    // same frame, frames.size must stay 1
-		REQUIRE(recorder::frames.at(0) == 50);
-		REQUIRE(recorder::global.at(0).size() == 2);  // 2 actions on frame #0
+		REQUIRE(getFrames().size() == 1);    // same frame, must stay 1
+		REQUIRE(getFrames().at(0) == 50);
+		REQUIRE(countActionsOnFrame(getFrames().at(0)) == 2);  // 2 actions on frame #0
 
-		REQUIRE(recorder::global.at(0).at(0)->chan == 0);
-		REQUIRE(recorder::global.at(0).at(0)->type == G_ACTION_KEYPRESS);
-		REQUIRE(recorder::global.at(0).at(0)->frame == 50);
-		REQUIRE(recorder::global.at(0).at(0)->iValue == 6);
-		REQUIRE(recorder::global.at(0).at(0)->fValue == 0.3f);
+		REQUIRE(getAction(0, 0).chan == 0);
+		REQUIRE(getAction(0, 0).type == G_ACTION_KEYPRESS);
+		REQUIRE(getAction(0, 0).frame == 50);
+		REQUIRE(getAction(0, 0).iValue == 6);
+		REQUIRE(getAction(0, 0).fValue == 0.3f);
 
-		REQUIRE(recorder::global.at(0).at(1)->chan == 0);
-		REQUIRE(recorder::global.at(0).at(1)->type == G_ACTION_KEYREL);
-		REQUIRE(recorder::global.at(0).at(1)->frame == 50);
-		REQUIRE(recorder::global.at(0).at(1)->iValue == 1);
-		REQUIRE(recorder::global.at(0).at(1)->fValue == 0.5f);
+		REQUIRE(getAction(0, 1).chan == 0);
+		REQUIRE(getAction(0, 1).type == G_ACTION_KEYREL);
+		REQUIRE(getAction(0, 1).frame == 50);
+		REQUIRE(getAction(0, 1).iValue == 1);
+		REQUIRE(getAction(0, 1).fValue == 0.5f);
 
 		SECTION("Test record, another action on a different frame")
 		{
 			recorder::rec(0, G_ACTION_KEYPRESS, 70, 1, 0.5f);
 
-			REQUIRE(recorder::frames.size() == 2);
-			REQUIRE(recorder::frames.at(1) == 70);
-			REQUIRE(recorder::global.at(0).size() == 2);  // 2 actions on frame #0
-			REQUIRE(recorder::global.at(1).size() == 1);  // 1 actions on frame #1
-			REQUIRE(recorder::global.at(1).at(0)->chan == 0);
-			REQUIRE(recorder::global.at(1).at(0)->type == G_ACTION_KEYPRESS);
-			REQUIRE(recorder::global.at(1).at(0)->frame == 70);
-			REQUIRE(recorder::global.at(1).at(0)->iValue == 1);
-			REQUIRE(recorder::global.at(1).at(0)->fValue == 0.5f);
+			REQUIRE(getFrames().size() == 2);
+			REQUIRE(getFrames().at(1) == 70);
+			REQUIRE(countActionsOnFrame(getFrames().at(0)) == 2);  // 2 actions on frame #0
+			REQUIRE(countActionsOnFrame(getFrames().at(1)) == 1);  // 1 actions on frame #1
+			REQUIRE(getAction(1, 0).chan == 0);
+			REQUIRE(getAction(1, 0).type == G_ACTION_KEYPRESS);
+			REQUIRE(getAction(1, 0).frame == 70);
+			REQUIRE(getAction(1, 0).iValue == 1);
+			REQUIRE(getAction(1, 0).fValue == 0.5f);
 		}
 	}
 
@@ -80,24 +135,22 @@ TEST_CASE("recorder")
 		recorder::rec(2, G_ACTION_KEYREL,   120, 1, 0.5f);
 
 		/* Give me action on chan 1, type G_ACTION_KEYREL, frame 70. */
-		recorder::action *action = nullptr;
+		recorder::action action;
 		REQUIRE(recorder::getAction(1, G_ACTION_KEYREL, 70, &action) == 1);
 
-		REQUIRE(action != nullptr);
-		REQUIRE(action->chan == 1);
-		REQUIRE(action->type == G_ACTION_KEYREL);
-		REQUIRE(action->frame == 70);
-		REQUIRE(action->iValue == 1);
-		REQUIRE(action->fValue == 0.5f);
+		REQUIRE(action.chan == 1);
+		REQUIRE(action.type == G_ACTION_KEYREL);
+		REQUIRE(action.frame == 70);
+		REQUIRE(action.iValue == 1);
+		REQUIRE(action.fValue == 0.5f);
 
 		/* Give me *next* action on chan 0, type G_ACTION_KEYREL, starting from frame 20.
 		Must be action #2 */
 
 		REQUIRE(recorder::getNextAction(0, G_ACTION_KEYREL, 20, &action) == 1);
-		REQUIRE(action != nullptr);
-		REQUIRE(action->chan == 0);
-		REQUIRE(action->type == G_ACTION_KEYREL);
-		REQUIRE(action->frame == 70);
+		REQUIRE(action.chan == 0);
+		REQUIRE(action.type == G_ACTION_KEYREL);
+		REQUIRE(action.frame == 70);
 
 		/* Give me *next* action on chan 2, type G_ACTION_KEYPRESS, starting from
 		frame 200. You are requesting frame outside boundaries. */
@@ -121,11 +174,49 @@ TEST_CASE("recorder")
 		recorder::rec(1, G_ACTION_MIDI, 1050, 0x903D3F00, 0.0f);
 		recorder::rec(1, G_ACTION_MIDI, 2000, 0x803D3F00, 0.0f);
 
-		recorder::action* result = nullptr;
-		recorder::getNextAction(0, G_ACTION_MIDI, 100, &result, 0x803CFF00, 0x0000FF00);
+		recorder::action result;
+		REQUIRE(recorder::getNextAction(0, G_ACTION_MIDI, 100, &result, 0x803CFF00, 0x0000FF00) == 1);
+		REQUIRE(result.frame == 1000);
+	}
+
+	SECTION("Test retrieval by range")
+	{
+		recorder::rec(0, G_ACTION_KEYPRESS, 0,   1, 0.5f);
+		recorder::rec(1, G_ACTION_KEYPRESS, 0,   1, 0.5f);
+		recorder::rec(0, G_ACTION_KEYREL,   100, 1, 0.5f);
+		recorder::rec(1, G_ACTION_KEYREL,   150, 1, 0.5f);
+		recorder::rec(0, G_ACTION_KILL,     300, 1, 0.5f);
+
+		/* Ascending lookups, as done by the audio thread. */
+
+		recorder::ActionRange r = getActionsInRange(0, 128);
+		REQUIRE(r.end() - r.begin() == 3);
+		REQUIRE(r.begin()->frame == 0);
+		REQUIRE((r.end() - 1)->frame == 100);
+
+		r = getActionsInRange(128, 256);
+		REQUIRE(r.end() - r.begin() == 1);
+		REQUIRE(r.begin()->frame == 150);
+
+		REQUIRE(getActionsInRange(256, 300).empty());
+		REQUIRE(countActionsOnFrame(300) == 1);
+		REQUIRE(getActionsInRange(301, 1024).empty());
 
-		REQUIRE(result != nullptr);
-		REQUIRE(result->frame == 1000);
+		/* Sequencer looped: the cursor must rewind. */
+
+		REQUIRE(countActionsOnFrame(0) == 2);
+		REQUIRE(countActionsOnFrame(150) == 1);
+
+		SECTION("Test retrieval by range after changes")
+		{
+			recorder::rec(0, G_ACTION_KEYPRESS, 120, 1, 0.5f);
+			recorder::deleteAction(1, 150, G_ACTION_KEYREL, false);
+
+			r = getActionsInRange(100, 200);
+			REQUIRE(r.end() - r.begin() == 2);
+			REQUIRE(r.begin()->frame == 100);
+			REQUIRE((r.begin() + 1)->frame == 120);
+		}
 	}
 
 	SECTION("Test deletion, single action")
@@ -136,18 +227,16 @@ TEST_CASE("recorder")
 		recorder::rec(1, G_ACTION_KEYREL,   80, 1, 0.5f);
 
 		/* Delete action #0, don't check values. */
-		recorder::deleteAction(0, 50, G_ACTION_KEYPRESS, false, &mutex);
+		recorder::deleteAction(0, 50, G_ACTION_KEYPRESS, false);
 
-		REQUIRE(recorder::frames.size() == 3);
-		REQUIRE(recorder::global.size() == 3);
+		REQUIRE(getFrames().size() == 3);
 
 		SECTION("Test deletion checked")
 		{
 			/* Delete action #1, check values. */
-			recorder::deleteAction(1, 70, G_ACTION_KEYPRESS, true, &mutex, 6, 0.3f);
+			recorder::deleteAction(1, 70, G_ACTION_KEYPRESS, true, 6, 0.3f);
 
-			REQUIRE(recorder::frames.size() == 2);
-			REQUIRE(recorder::global.size() == 2);
+			REQUIRE(getFrames().size() == 2);
 		}
 	}
 
@@ -163,24 +252,23 @@ TEST_CASE("recorder")
 		/* Delete any action on channel 0 of types KEYPRESS | KEYREL between
 		frames 0 and 200. */
 
-		recorder::deleteActions(0, 0, 200, G_ACTION_KEYPRESS | G_ACTION_KEYREL, &mutex);
+		recorder::deleteActions(0, 0, 200, G_ACTION_KEYPRESS | G_ACTION_KEYREL);
 
-		REQUIRE(recorder::frames.size() == 2);
-		REQUIRE(recorder::global.size() == 2);
-		REQUIRE(recorder::global.at(0).size() == 1);
-		REQUIRE(recorder::global.at(1).size() == 1);
+		REQUIRE(getFrames().size() == 2);
+		REQUIRE(countActionsOnFrame(getFrames().at(0)) == 1);
+		REQUIRE(countActionsOnFrame(getFrames().at(1)) == 1);
 
-		REQUIRE(recorder::global.at(0).at(0)->chan == 1);
-		REQUIRE(recorder::global.at(0).at(0)->type == G_ACTION_KEYPRESS);
-		REQUIRE(recorder::global.at(0).at(0)->frame == 100);
-		REQUIRE(recorder::global.at(0).at(0)->iValue == 6);
-		REQUIRE(recorder::global.at(0).at(0)->fValue == 0.3f);
+		REQUIRE(getAction(0, 0).chan == 1);
+		REQUIRE(getAction(0, 0).type == G_ACTION_KEYPRESS);
+		REQUIRE(getAction(0, 0).frame == 100);
+		REQUIRE(getAction(0, 0).iValue == 6);
+		REQUIRE(getAction(0, 0).fValue == 0.3f);
 
-		REQUIRE(recorder::global.at(1).at(0)->chan == 1);
-		REQUIRE(recorder::global.at(1).at(0)->type == G_ACTION_KEYREL);
-		REQUIRE(recorder::global.at(1).at(0)->frame == 120);
-		REQUIRE(recorder::global.at(1).at(0)->iValue == 1);
-		REQUIRE(recorder::global.at(1).at(0)->fValue == 0.5f);
+		REQUIRE(getAction(1, 0).chan == 1);
+		REQUIRE(getAction(1, 0).type == G_ACTION_KEYREL);
+		REQUIRE(getAction(1, 0).frame == 120);
+		REQUIRE(getAction(1, 0).iValue == 1);
+		REQUIRE(getAction(1, 0).fValue == 0.5f);
 	}
 
 	SECTION("Test action presence")
@@ -189,12 +277,46 @@ TEST_CASE("recorder")
 		recorder::rec(1, G_ACTION_KEYPRESS, 100, 6, 0.3f);
 		recorder::rec(1, G_ACTION_KEYREL,   120, 1, 0.5f);
 
-		recorder::deleteAction(0, 80, G_ACTION_KEYREL, false, &mutex);
+		recorder::deleteAction(0, 80, G_ACTION_KEYREL, false);
 
 		REQUIRE(recorder::hasActions(0) == false);
 		REQUIRE(recorder::hasActions(1) == true);
 	}
 
+	SECTION("Test envelope")
+	{
+		/* The first point brings the boundaries along, the others don't. */
+
+		recorder::recEnvelope(0, G_ACTION_VOLUME, 100, 999, 0, 0.5f, 1.0f);
+		REQUIRE(getFrames().size() == 3);
+		REQUIRE(getAction(0, 0).fValue == 1.0f);
+		REQUIRE(getAction(1, 0).fValue == 0.5f);
+		REQUIRE(getAction(2, 0).frame == 999);
+
+		recorder::recEnvelope(0, G_ACTION_VOLUME, 200, 999, 0, 0.2f, 1.0f);
+		REQUIRE(getFrames().size() == 4);
+	}
+
+	SECTION("Test edits from the audio thread")
+	{
+		/* Applied on the next update(), in order. */
+
+		recorder::beginBlock();
+		recorder::rec(0, G_ACTION_KEYPRESS, 50, 1, 0.5f);
+		recorder::startOverdub(0, G_ACTION_KEYPRESS | G_ACTION_KEYREL, 100, 16);
+		recorder::stopOverdub(300, 500);
+		recorder::endBlock();
+
+		REQUIRE(getFrames().size() == 0);
+
+		recorder::update();
+
+		REQUIRE(getFrames().size() == 3);
+		REQUIRE(getAction(1, 0).type == G_ACTION_KEYPRESS);
+		REQUIRE(getAction(2, 0).frame == 300);
+		REQUIRE(getAction(2, 0).type == G_ACTION_KEYREL);
+	}
+
 	SECTION("Test clear actions by channel")
 	{
 		recorder::rec(0, G_ACTION_KEYREL,   80, 1, 0.5f);
@@ -205,9 +327,8 @@ TEST_CASE("recorder")
 
 		REQUIRE(recorder::hasActions(0) == true);
 		REQUIRE(recorder::hasActions(1) == false);
-		REQUIRE(recorder::frames.size() == 1);
-		REQUIRE(recorder::global.size() == 1);
-		REQUIRE(recorder::global.at(0).size() == 1);
+		REQUIRE(getFrames().size() == 1);
+		REQUIRE(countActionsOnFrame(getFrames().at(0)) == 1);
 	}
 
 	SECTION("Test clear actions by type")
@@ -222,9 +343,8 @@ TEST_CASE("recorder")
 
 		REQUIRE(recorder::hasActions(0) == true);
 		REQUIRE(recorder::hasActions(1) == false);
-		REQUIRE(recorder::frames.size() == 1);
-		REQUIRE(recorder::global.size() == 1);
-		REQUIRE(recorder::global.at(0).size() == 1);
+		REQUIRE(getFrames().size() == 1);
+		REQUIRE(countActionsOnFrame(getFrames().at(0)) == 1);
 	}
 
 	SECTION("Test clear all")
@@ -236,81 +356,82 @@ TEST_CASE("recorder")
 		recorder::rec(2, G_ACTION_KILL, 120, 1, 0.5f);
 
 		recorder::clearAll();
-		REQUIRE(recorder::frames.size() == 0);
-		REQUIRE(recorder::global.size() == 0);
-	}
-
-	SECTION("Test optimization")
-	{
-		recorder::rec(0, G_ACTION_KEYPRESS, 20, 1, 0.5f);
-		recorder::rec(0, G_ACTION_KEYREL,   80, 1, 0.5f);
-		recorder::rec(1, G_ACTION_KEYPRESS, 20, 1, 0.5f);
-		recorder::rec(1, G_ACTION_KEYREL,   80, 1, 0.5f);
-
-		/* Fake frame 80 without actions.*/
-		recorder::global.at(1).clear();
-
-		recorder::optimize();
-
-		REQUIRE(recorder::frames.size() == 1);
-		REQUIRE(recorder::global.size() == 1);
-		REQUIRE(recorder::global.at(0).size() == 2);
+		REQUIRE(getFrames().size() == 0);
 	}
 
-	SECTION("Test BPM update")
+	SECTION("Test tempo change")
 	{
 		recorder::rec(0, G_ACTION_KEYPRESS,  0, 1, 0.5f);
 		recorder::rec(0, G_ACTION_KEYREL,   80, 1, 0.5f);
 
-		recorder::updateBpm(60.0f, 120.0f, 44100);  // scaling up
+		recorder::setFramesInBeat(11025);  // twice as fast
 
-		REQUIRE(recorder::frames.at(0) == 0);
-		REQUIRE(recorder::frames.at(1) == 40);
+		REQUIRE(getFrames().at(0) == 0);
+		REQUIRE(getFrames().at(1) == 40);
+		REQUIRE(countActionsOnFrame(40) == 1);
 
-		recorder::updateBpm(120.0f, 60.0f, 44100);  // scaling down
+		recorder::setFramesInBeat(22050);  // back
 
-		REQUIRE(recorder::frames.at(0) == 0);
-		REQUIRE(recorder::frames.at(1) == 80);
+		REQUIRE(getFrames().at(0) == 0);
+		REQUIRE(getFrames().at(1) == 80);
+		REQUIRE(countActionsOnFrame(80) == 1);
 	}
 
-	SECTION("Test samplerate update")
+	SECTION("Test samplerate change")
 	{
 		recorder::rec(0, G_ACTION_KEYPRESS,   0, 1, 0.5f);
 		recorder::rec(0, G_ACTION_KEYREL,    80, 1, 0.5f);
 		recorder::rec(0, G_ACTION_KEYPRESS, 120, 1, 0.5f);
 		recorder::rec(0, G_ACTION_KEYREL,   150, 1, 0.5f);
 
-		recorder::updateSamplerate(44100, 22050); // scaling down
+		recorder::setFramesInBeat(44100);  // same tempo at 88200 Hz
+
+		REQUIRE(getFrames().at(0) == 0);
+		REQUIRE(getFrames().at(1) == 160);
+		REQUIRE(getFrames().at(2) == 240);
+		REQUIRE(getFrames().at(3) == 300);
+
+		recorder::setFramesInBeat(22050);
+
+		REQUIRE(getFrames().at(0) == 0);
+		REQUIRE(getFrames().at(1) == 80);
+		REQUIRE(getFrames().at(2) == 120);
+		REQUIRE(getFrames().at(3) == 150);
+	}
+
+	SECTION("Test no drift")
+	{
+		/* Actions never move, no matter how many tempo changes. Frames recorded
+		at an odd tempo come back exactly. */
 
-		REQUIRE(recorder::frames.at(0) == 0);
-		REQUIRE(recorder::frames.at(1) == 160);
-		REQUIRE(recorder::frames.at(2) == 240);
-		REQUIRE(recorder::frames.at(3) == 300);
+		recorder::setFramesInBeat(17001);
+		recorder::rec(0, G_ACTION_KEYPRESS, 12345, 1, 0.5f);
+		recorder::rec(0, G_ACTION_KEYREL,   16999, 1, 0.5f);
 
-		recorder::updateSamplerate(22050, 44100); // scaling up
+		for (int i=0; i<100; i++)
+			recorder::setFramesInBeat(i % 2 == 0 ? 22050 : 9973);
+		recorder::setFramesInBeat(17001);
 
-		REQUIRE(recorder::frames.at(0) == 0);
-		REQUIRE(recorder::frames.at(1) == 80);
-		REQUIRE(recorder::frames.at(2) == 120);
-		REQUIRE(recorder::frames.at(3) == 150);
+		REQUIRE(getFrames().at(0) == 12345);
+		REQUIRE(getFrames().at(1) == 16999);
 	}
 
 	SECTION("Test expand")
 	{
+		recorder::setFramesInBeat(100);
 		recorder::rec(0, G_ACTION_KEYPRESS,   0, 1, 0.5f);
 		recorder::rec(0, G_ACTION_KEYREL,    80, 1, 0.5f);
 		recorder::rec(0, G_ACTION_KILL,     200, 1, 0.5f);
 
-		recorder::expand(300, 600);
+		recorder::expand(3, 6);
 
-		REQUIRE(recorder::frames.size() == 6);
-		REQUIRE(recorder::global.size() == 6);
-		REQUIRE(recorder::frames.at(0) == 0);
-		REQUIRE(recorder::frames.at(1) == 80);
-		REQUIRE(recorder::frames.at(2) == 200);
-		REQUIRE(recorder::frames.at(3) == 300);
-		REQUIRE(recorder::frames.at(4) == 380);
-		REQUIRE(recorder::frames.at(5) == 500);
+		REQUIRE(getFrames().size() == 6);
+		REQUIRE(getFrames().at(0) == 0);
+		REQUIRE(getFrames().at(1) == 80);
+		REQUIRE(getFrames().at(2) == 200);
+		REQUIRE(getFrames().at(3) == 300);
+		REQUIRE(getFrames().at(4) == 380);
+		REQUIRE(getFrames().at(5) == 500);
 	}
 
 	SECTION("Test shrink")
@@ -321,10 +442,9 @@ TEST_CASE("recorder")
 
 		recorder::shrink(100);
 
-		REQUIRE(recorder::frames.size() == 2);
-		REQUIRE(recorder::global.size() == 2);
-		REQUIRE(recorder::frames.at(0) == 0);
-		REQUIRE(recorder::frames.at(1) == 80);
+		REQUIRE(getFrames().size() == 2);
+		REQUIRE(getFrames().at(0) == 0);
+		REQUIRE(getFrames().at(1) == 80);
 	}
 	
 	SECTION("Test overdub, full overwrite")
@@ -337,16 +457,15 @@ TEST_CASE("recorder")
 		/* Should delete all actions in between and keep the first one, plus a
 		new last action on frame 500. */
 		recorder::startOverdub(0, G_ACTION_KEYPRESS | G_ACTION_KEYREL, 0, 1024);
-		recorder::stopOverdub(500, 500, &mutex);
-
-		REQUIRE(recorder::frames.size() == 2);
-		REQUIRE(recorder::global.size() == 2);
-		REQUIRE(recorder::frames.at(0) == 0);
-		REQUIRE(recorder::frames.at(1) == 500);
-		REQUIRE(recorder::global.at(0).at(0)->frame == 0);
-		REQUIRE(recorder::global.at(0).at(0)->type == G_ACTION_KEYPRESS);
-		REQUIRE(recorder::global.at(1).at(0)->frame == 500);
-		REQUIRE(recorder::global.at(1).at(0)->type == G_ACTION_KEYREL);
+		recorder::stopOverdub(500, 500);
+
+		REQUIRE(getFrames().size() == 2);
+		REQUIRE(getFrames().at(0) == 0);
+		REQUIRE(getFrames().at(1) == 500);
+		REQUIRE(getAction(0, 0).frame == 0);
+		REQUIRE(getAction(0, 0).type == G_ACTION_KEYPRESS);
+		REQUIRE(getAction(1, 0).frame == 500);
+		REQUIRE(getAction(1, 0).type == G_ACTION_KEYREL);
 	}
 
 	SECTION("Test overdub, left overlap")
@@ -360,17 +479,16 @@ TEST_CASE("recorder")
 		Overdub:     |#######|-----
 		Result:      |#######|----- */
 		recorder::startOverdub(0, G_ACTION_KEYPRESS | G_ACTION_KEYREL, 0, 16);
-		recorder::stopOverdub(300, 500, &mutex);
+		recorder::stopOverdub(300, 500);
 
-		REQUIRE(recorder::frames.size() == 2);
-		REQUIRE(recorder::global.size() == 2);
-		REQUIRE(recorder::frames.at(0) == 0);
-		REQUIRE(recorder::frames.at(1) == 300);
+		REQUIRE(getFrames().size() == 2);
+		REQUIRE(getFrames().at(0) == 0);
+		REQUIRE(getFrames().at(1) == 300);
 
-		REQUIRE(recorder::global.at(0).at(0)->frame == 0);
-		REQUIRE(recorder::global.at(0).at(0)->type == G_ACTION_KEYPRESS);
-		REQUIRE(recorder::global.at(1).at(0)->frame == 300);
-		REQUIRE(recorder::global.at(1).at(0)->type == G_ACTION_KEYREL);
+		REQUIRE(getAction(0, 0).frame == 0);
+		REQUIRE(getAction(0, 0).type == G_ACTION_KEYPRESS);
+		REQUIRE(getAction(1, 0).frame == 300);
+		REQUIRE(getAction(1, 0).type == G_ACTION_KEYREL);
 	}
 
 	SECTION("Test overdub, right overlap")
@@ -384,24 +502,23 @@ TEST_CASE("recorder")
 		Overdub:     -----|#######|--
 		Result:      |###||#######|-- */
 		recorder::startOverdub(0, G_ACTION_KEYPRESS | G_ACTION_KEYREL, 100, 16);
-		recorder::stopOverdub(500, 500, &mutex);
-
-		REQUIRE(recorder::frames.size() == 4);
-		REQUIRE(recorder::global.size() == 4);
-		REQUIRE(recorder::frames.at(0) == 0);
-		REQUIRE(recorder::frames.at(1) == 84); // 100 - bufferSize (16)
-		REQUIRE(recorder::frames.at(2) == 100);
-		REQUIRE(recorder::frames.at(3) == 500);
-
-		REQUIRE(recorder::global.at(0).at(0)->frame == 0);
-		REQUIRE(recorder::global.at(0).at(0)->type == G_ACTION_KEYPRESS);
-		REQUIRE(recorder::global.at(1).at(0)->frame == 84);
-		REQUIRE(recorder::global.at(1).at(0)->type == G_ACTION_KEYREL);
-
-		REQUIRE(recorder::global.at(2).at(0)->frame == 100);
-		REQUIRE(recorder::global.at(2).at(0)->type == G_ACTION_KEYPRESS);
-		REQUIRE(recorder::global.at(3).at(0)->frame == 500);
-		REQUIRE(recorder::global.at(3).at(0)->type == G_ACTION_KEYREL);
+		recorder::stopOverdub(500, 500);
+
+		REQUIRE(getFrames().size() == 4);
+		REQUIRE(getFrames().at(0) == 0);
+		REQUIRE(getFrames().at(1) == 84); // 100 - bufferSize (16)
+		REQUIRE(getFrames().at(2) == 100);
+		REQUIRE(getFrames().at(3) == 500);
+
+		REQUIRE(getAction(0, 0).frame == 0);
+		REQUIRE(getAction(0, 0).type == G_ACTION_KEYPRESS);
+		REQUIRE(getAction(1, 0).frame == 84);
+		REQUIRE(getAction(1, 0).type == G_ACTION_KEYREL);
+
+		REQUIRE(getAction(2, 0).frame == 100);
+		REQUIRE(getAction(2, 0).type == G_ACTION_KEYPRESS);
+		REQUIRE(getAction(3, 0).frame == 500);
+		REQUIRE(getAction(3, 0).type == G_ACTION_KEYREL);
 	}
 
 	SECTION("Test overdub, hole diggin'")
@@ -416,24 +533,23 @@ TEST_CASE("recorder")
 		Overdub:     ---|#######|---
 		Result:      |#||#######|--- */
 		recorder::startOverdub(0, G_ACTION_KEYPRESS | G_ACTION_KEYREL, 100, 16);
-		recorder::stopOverdub(300, 500, &mutex);
-
-		REQUIRE(recorder::frames.size() == 4);
-		REQUIRE(recorder::global.size() == 4);
-		REQUIRE(recorder::frames.at(0) == 0);
-		REQUIRE(recorder::frames.at(1) == 84); // 100 - bufferSize (16)
-		REQUIRE(recorder::frames.at(2) == 100);
-		REQUIRE(recorder::frames.at(3) == 300);
-
-		REQUIRE(recorder::global.at(0).at(0)->frame == 0);
-		REQUIRE(recorder::global.at(0).at(0)->type == G_ACTION_KEYPRESS);
-		REQUIRE(recorder::global.at(1).at(0)->frame == 84);
-		REQUIRE(recorder::global.at(1).at(0)->type == G_ACTION_KEYREL);
-
-		REQUIRE(recorder::global.at(2).at(0)->frame == 100);
-		REQUIRE(recorder::global.at(2).at(0)->type == G_ACTION_KEYPRESS);
-		REQUIRE(recorder::global.at(3).at(0)->frame == 300);
-		REQUIRE(recorder::global.at(3).at(0)->type == G_ACTION_KEYREL);
+		recorder::stopOverdub(300, 500);
+
+		REQUIRE(getFrames().size() == 4);
+		REQUIRE(getFrames().at(0) == 0);
+		REQUIRE(getFrames().at(1) == 84); // 100 - bufferSize (16)
+		REQUIRE(getFrames().at(2) == 100);
+		REQUIRE(getFrames().at(3) == 300);
+
+		REQUIRE(getAction(0, 0).frame == 0);
+		REQUIRE(getAction(0, 0).type == G_ACTION_KEYPRESS);
+		REQUIRE(getAction(1, 0).frame == 84);
+		REQUIRE(getAction(1, 0).type == G_ACTION_KEYREL);
+
+		REQUIRE(getAction(2, 0).frame == 100);
+		REQUIRE(getAction(2, 0).type == G_ACTION_KEYPRESS);
+		REQUIRE(getAction(3, 0).frame == 300);
+		REQUIRE(getAction(3, 0).type == G_ACTION_KEYREL);
 	}
 
 	SECTION("Test overdub, cover all")
@@ -447,17 +563,16 @@ TEST_CASE("recorder")
 
 		/* Overdub all existing actions. Expected result: a single composite one. */
 		recorder::startOverdub(0, G_ACTION_KEYPRESS | G_ACTION_KEYREL, 0, 16);
-		recorder::stopOverdub(500, 500, &mutex);
+		recorder::stopOverdub(500, 500);
 
-		REQUIRE(recorder::frames.size() == 2);
-		REQUIRE(recorder::global.size() == 2);
-		REQUIRE(recorder::frames.at(0) == 0);
-		REQUIRE(recorder::frames.at(1) == 500);
+		REQUIRE(getFrames().size() == 2);
+		REQUIRE(getFrames().at(0) == 0);
+		REQUIRE(getFrames().at(1) == 500);
 
-		REQUIRE(recorder::global.at(0).at(0)->frame == 0);
-		REQUIRE(recorder::global.at(0).at(0)->type == G_ACTION_KEYPRESS);
-		REQUIRE(recorder::global.at(1).at(0)->frame == 500);
-		REQUIRE(recorder::global.at(1).at(0)->type == G_ACTION_KEYREL);
+		REQUIRE(getAction(0, 0).frame == 0);
+		REQUIRE(getAction(0, 0).type == G_ACTION_KEYPRESS);
+		REQUIRE(getAction(1, 0).frame == 500);
+		REQUIRE(getAction(1, 0).type == G_ACTION_KEYREL);
 	}
 
 	SECTION("Test overdub, null loop")
@@ -467,16 +582,16 @@ TEST_CASE("recorder")
 
 		/* A null loop is a loop that begins and ends on the very same frame. */
 		recorder::startOverdub(0, G_ACTION_KEYPRESS | G_ACTION_KEYREL, 300, 16);
-		recorder::stopOverdub(300, 700, &mutex);
+		recorder::stopOverdub(300, 700);
 
-		REQUIRE(recorder::frames.size() == 2);
-		REQUIRE(recorder::frames.at(0) == 0);
-		REQUIRE(recorder::frames.at(1) == 284);  // 300 - bufferSize (16)
+		REQUIRE(getFrames().size() == 2);
+		REQUIRE(getFrames().at(0) == 0);
+		REQUIRE(getFrames().at(1) == 284);  // 300 - bufferSize (16)
 
-		REQUIRE(recorder::global.at(0).at(0)->frame == 0);
-		REQUIRE(recorder::global.at(0).at(0)->type == G_ACTION_KEYPRESS);
-		REQUIRE(recorder::global.at(1).at(0)->frame == 284);
-		REQUIRE(recorder::global.at(1).at(0)->type == G_ACTION_KEYREL);
+		REQUIRE(getAction(0, 0).frame == 0);
+		REQUIRE(getAction(0, 0).type == G_ACTION_KEYPRESS);
+		REQUIRE(getAction(1, 0).frame == 284);
+		REQUIRE(getAction(1, 0).type == G_ACTION_KEYREL);
 	}
 
 	SECTION("Test overdub, ring loop")
@@ -491,12 +606,12 @@ TEST_CASE("recorder")
 		recorder::rec(0, G_ACTION_KEYREL, 300, 1, 0.5f);
 
 		recorder::startOverdub(0, G_ACTION_KEYPRESS | G_ACTION_KEYREL, 400, 16);
-		recorder::stopOverdub(250, 700, &mutex);
+		recorder::stopOverdub(250, 700);
 
-		REQUIRE(recorder::frames.size() == 4);
-		REQUIRE(recorder::frames.at(0) == 200);
-		REQUIRE(recorder::frames.at(1) == 300);
-		REQUIRE(recorder::frames.at(2) == 400);
-		REQUIRE(recorder::frames.at(3) == 700);
+		REQUIRE(getFrames().size() == 4);
+		REQUIRE(getFrames().at(0) == 200);
+		REQUIRE(getFrames().at(1) == 300);
+		REQUIRE(getFrames().at(2) == 400);
+		REQUIRE(getFrames().at(3) == 700);
 	}
 }
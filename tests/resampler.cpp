@@ -0,0 +1,257 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <vector>
+#include <samplerate.h>
+#include "../src/core/dsp.h"
+#include "../src/core/resampler.h"
+#include <catch.hpp>
+
+
+using namespace giada;
+using namespace giada::m;
+
+
+namespace
+{
+const float PI = 3.14159265f;
+
+const Interpolation ALL[] = { Interpolation::LINEAR, Interpolation::HERMITE,
+	Interpolation::SINC_8, Interpolation::SINC_16, Interpolation::SINC_32 };
+
+const char* getName(Interpolation i)
+{
+	switch (i) {
+		case Interpolation::LINEAR:  return "linear";
+		case Interpolation::HERMITE: return "hermite";
+		case Interpolation::SINC_8:  return "sinc 8";
+		case Interpolation::SINC_16: return "sinc 16";
+		case Interpolation::SINC_32: return "sinc 32";
+		default:                     return "?";
+	}
+}
+
+
+/* makeSine
+Stereo sine, 'freq' in cycles per frame. */
+
+std::vector<float> makeSine(int frames, float freq)
+{
+	std::vector<float> out(frames * 2);
+	for (int i=0; i<frames; i++)
+		out[i*2] = out[i*2 + 1] = std::sin(2 * PI * freq * i);
+	return out;
+}
+}; // {anonymous}
+
+
+TEST_CASE("Resampler")
+{
+	static const int FRAMES = 4096;
+
+	std::vector<float> out(FRAMES * 2);
+
+	SECTION("test identity")
+	{
+		/* At pitch 1.0 output frames fall exactly on input ones. */
+
+		std::vector<float> in = makeSine(FRAMES, 0.1f);
+		for (Interpolation i : ALL) {
+			Resampler r(2, FRAMES);
+			r.setInterpolation(i);
+			Resampler::Result res = r.process(in.data(), FRAMES, false, out.data(), 
+				1000, 1.0f, 1.0f);
+			REQUIRE(res.generated == 1000);
+			REQUIRE(res.used == 1000);
+			for (int j=0; j<2000; j++)
+				REQUIRE(out[j] == Approx(in[j]).margin(0.0001f));
+		}
+	}
+
+	SECTION("test sine")
+	{
+		/* Half speed: each output frame is halfway or on an input one. Skip the
+		first frames, mixed with the silent history. */
+
+		std::vector<float> in = makeSine(FRAMES, 0.01f);
+		for (Interpolation i : ALL) {
+			Resampler r(2, FRAMES);
+			r.setInterpolation(i);
+			Resampler::Result res = r.process(in.data(), FRAMES, false, out.data(), 
+				1000, 0.5f, 0.5f);
+			REQUIRE(res.generated == 1000);
+			REQUIRE(res.used == 500);
+			for (int j=40; j<1000; j++)
+				REQUIRE(out[j*2] == Approx(std::sin(PI * 0.01f * j)).margin(0.001f));
+		}
+	}
+
+	SECTION("test blocks")
+	{
+		/* Consecutive calls carry on from each other, as one large call would. */
+
+		std::vector<float> in = makeSine(FRAMES, 0.05f);
+		for (Interpolation i : ALL) {
+			Resampler whole(2, FRAMES);
+			Resampler split(2, FRAMES);
+			whole.setInterpolation(i);
+			split.setInterpolation(i);
+
+			std::vector<float> expected(1280 * 2);
+			whole.process(in.data(), FRAMES, false, expected.data(), 1280, 0.7f, 0.7f);
+
+			int pos = 0;
+			for (int b=0; b<10; b++) {
+				Resampler::Result res = split.process(in.data() + pos*2, FRAMES - pos, 
+					false, out.data() + b*128*2, 128, 0.7f, 0.7f);
+				REQUIRE(res.generated == 128);
+				pos += res.used;
+			}
+			for (int j=0; j<1280*2; j++)
+				REQUIRE(out[j] == Approx(expected[j]).margin(0.00001f));
+		}
+	}
+
+	SECTION("test ramp")
+	{
+		/* From 1.0 to 2.0 over 100 frames: 100 + 0.01 * (0 + 1 + ... + 99)
+		input frames. */
+
+		std::vector<float> in = makeSine(FRAMES, 0.01f);
+		Resampler r(2, FRAMES);
+		Resampler::Result res = r.process(in.data(), FRAMES, false, out.data(), 
+			100, 1.0f, 2.0f);
+		REQUIRE(res.generated == 100);
+		REQUIRE(res.used == 149);
+	}
+
+	SECTION("test last")
+	{
+		/* The tail is fully consumed, against silence. */
+
+		std::vector<float> in = makeSine(10, 0.01f);
+		for (Interpolation i : ALL) {
+			Resampler r(2, FRAMES);
+			r.setInterpolation(i);
+			Resampler::Result res = r.process(in.data(), 10, true, out.data(), 
+				64, 1.0f, 1.0f);
+			REQUIRE(res.generated == 10);
+			REQUIRE(res.used == 10);
+		}
+	}
+}
+
+
+/* -------------------------------------------------------------------------- */
+
+
+/* Run with: giada_tests "[bench]" 
+Cost of a block at a fixed pitch, and aliasing: a sine close to Nyquist played
+faster ends up above it, so anything left in the output is aliasing. The 
+lower, the better. */
+
+TEST_CASE("Resampler benchmark", "[.bench]")
+{
+	static const int   FRAMES = 1024;
+	static const int   BLOCKS = 5000;
+	static const float PITCH  = 1.37f;
+	static const int   INPUT  = 1 << 18;
+
+	dsp::init();
+
+	std::vector<float> out(FRAMES * 2);
+	std::vector<float> low   = makeSine(INPUT, 0.1234f);
+	std::vector<float> high  = makeSine(INPUT, 0.45f);
+
+	auto getDb = [](const std::vector<float>& v, int samples)
+	{
+		double sum = 0.0;
+		for (int i=0; i<samples; i++)
+			sum += v[i] * v[i];
+		return 10 * std::log10(sum / samples / 0.5 + 1e-20);  // sine rms = 1/sqrt(2)
+	};
+
+	/* run
+	Plays 'in' through 'process' for 'blocks' blocks, restarting 
+	from the beginning when running out of input. Returns the output of the 
+	last block. */
+
+	auto run = [&](const std::vector<float>& in, int blocks, 
+		std::function<int(const float*, int, float*)> process)
+	{
+		int pos = 0;
+		for (int b=0; b<blocks; b++) {
+			if (pos + FRAMES * 8 > INPUT)
+				pos = 0;
+			pos += process(in.data() + pos*2, INPUT - pos, out.data());
+		}
+	};
+
+	for (Interpolation i : ALL) {
+		Resampler r(2, FRAMES * 8);
+		r.setInterpolation(i);
+		auto process = [&](const float* in, int frames, float* dest) 
+		{ 
+			return r.process(in, frames, false, dest, FRAMES, PITCH, PITCH).used; 
+		};
+
+		auto t0 = std::chrono::steady_clock::now();
+		run(low, BLOCKS, process);
+		auto t1 = std::chrono::steady_clock::now();
+
+		r.reset();
+		auto alias = [&](const float* in, int frames, float* dest) 
+		{ 
+			return r.process(in, frames, false, dest, FRAMES, 1.5f, 1.5f).used; 
+		};
+		run(high, 64, alias);
+
+		std::printf("[resampler benchmark] %-18s %10.1f ns/block, aliasing %7.1f dB\n",
+			getName(i), std::chrono::duration<double, std::nano>(t1 - t0).count() / BLOCKS,
+			getDb(out, FRAMES * 2));
+	}
+
+	for (int converter : { SRC_LINEAR, SRC_SINC_FASTEST, SRC_SINC_MEDIUM_QUALITY }) {
+		int error;
+		SRC_STATE* state = src_new(converter, 2, &error);
+		REQUIRE(state != nullptr);
+
+		auto process = [&](const float* in, int frames, float* dest) 
+		{
+			SRC_DATA data;
+			data.data_in       = in;
+			data.input_frames  = frames;
+			data.data_out      = dest;
+			data.output_frames = FRAMES;
+			data.end_of_input  = false;
+			data.src_ratio     = 1 / PITCH;
+			src_process(state, &data);
+			return static_cast<int>(data.input_frames_used);
+		};
+
+		auto t0 = std::chrono::steady_clock::now();
+		run(low, BLOCKS, process);
+		auto t1 = std::chrono::steady_clock::now();
+
+		src_reset(state);
+		auto alias = [&](const float* in, int frames, float* dest) 
+		{
+			SRC_DATA data;
+			data.data_in       = in;
+			data.input_frames  = frames;
+			data.data_out      = dest;
+			data.output_frames = FRAMES;
+			data.end_of_input  = false;
+			data.src_ratio     = 1 / 1.5f;
+			src_process(state, &data);
+			return static_cast<int>(data.input_frames_used);
+		};
+		run(high, 64, alias);
+
+		std::printf("[resampler benchmark] %-18s %10.1f ns/block, aliasing %7.1f dB\n",
+			src_get_name(converter), std::chrono::duration<double, std::nano>(t1 - t0).count() / BLOCKS,
+			getDb(out, FRAMES * 2));
+		src_delete(state);
+	}
+}
@@ -0,0 +1,123 @@
+#include <memory>
+#include "../src/core/audioBuffer.h"
+#include "../src/core/rope.h"
+#include <catch.hpp>
+
+
+using namespace giada::m;
+
+
+TEST_CASE("Rope")
+{
+	static const int FRAMES = 1000;
+
+	/* Each sample holds its own frame number (negative on the right channel). */
+
+	auto makeBuffer = [](int frames, int from)
+	{
+		std::shared_ptr<AudioBuffer> b = std::make_shared<AudioBuffer>();
+		b->alloc(frames, 2);
+		for (int i=0; i<frames; i++) {
+			(*b)[i][0] = from + i;
+			(*b)[i][1] = -(from + i);
+		}
+		return b;
+	};
+
+	auto at = [](const Rope& r, int f, int c)
+	{
+		int frames;
+		return r.getSpan(f, &frames)[c];
+	};
+
+	std::shared_ptr<AudioBuffer> data = makeBuffer(FRAMES, 0);
+	Rope rope(data);
+
+	SECTION("test creation")
+	{
+		REQUIRE(rope.countFrames() == FRAMES);
+		REQUIRE(rope.countChannels() == 2);
+		REQUIRE(rope.countPieces() == 1);
+		REQUIRE(rope.getMemory() == FRAMES * 2 * sizeof(float));
+
+		Rope empty;
+		REQUIRE(empty.countFrames() == 0);
+		REQUIRE(empty.countPieces() == 0);
+		REQUIRE(empty.getMemory() == 0);
+	}
+
+	SECTION("test slice and concat")
+	{
+		Rope cut = rope.slice(0, 100).concat(rope.slice(300, FRAMES));
+
+		REQUIRE(cut.countFrames() == FRAMES - 200);
+		REQUIRE(cut.countPieces() == 2);
+		REQUIRE(cut.getMemory() == rope.getMemory());  // data is shared
+		REQUIRE(at(cut, 99, 0) == 99.0f);
+		REQUIRE(at(cut, 100, 0) == 300.0f);
+		REQUIRE(at(cut, 100, 1) == -300.0f);
+		REQUIRE(rope.countFrames() == FRAMES);  // original untouched
+
+		SECTION("test merge")
+		{
+			/* Putting the missing range back gives the original single piece. */
+
+			Rope back = cut.slice(0, 100).concat(rope.slice(100, 300))
+				.concat(cut.slice(100, cut.countFrames()));
+			REQUIRE(back.countFrames() == FRAMES);
+			REQUIRE(back.countPieces() == 1);
+		}
+
+		SECTION("test out of bounds")
+		{
+			REQUIRE(rope.slice(-10, 10).countFrames() == 10);
+			REQUIRE(rope.slice(FRAMES - 10, FRAMES * 2).countFrames() == 10);
+			REQUIRE(rope.slice(50, 50).countFrames() == 0);
+		}
+	}
+
+	SECTION("test replace")
+	{
+		Rope r = rope.replace(500, makeBuffer(10, 5000));
+
+		REQUIRE(r.countFrames() == FRAMES);
+		REQUIRE(r.countPieces() == 3);
+		REQUIRE(r.getMemory() == (FRAMES + 10) * 2 * sizeof(float));
+		REQUIRE(at(r, 499, 0) == 499.0f);
+		REQUIRE(at(r, 500, 0) == 5000.0f);
+		REQUIRE(at(r, 509, 1) == -5009.0f);
+		REQUIRE(at(r, 510, 0) == 510.0f);
+		REQUIRE(at(rope, 500, 0) == 500.0f);
+	}
+
+	SECTION("test getSpan")
+	{
+		Rope r = rope.slice(0, 100).concat(rope.slice(300, FRAMES));
+		int frames;
+
+		r.getSpan(0, &frames);
+		REQUIRE(frames == 100);
+		r.getSpan(60, &frames);
+		REQUIRE(frames == 40);
+		r.getSpan(100, &frames);
+		REQUIRE(frames == FRAMES - 300);
+	}
+
+	SECTION("test read")
+	{
+		/* Across pieces, at an offset in the destination buffer. */
+
+		Rope r = rope.slice(0, 100).concat(rope.slice(300, FRAMES));
+
+		AudioBuffer dest;
+		dest.alloc(64, 2);
+		r.read(dest, 80, 40, 10);
+
+		REQUIRE(dest[9][0] == 0.0f);
+		REQUIRE(dest[10][0] == 80.0f);
+		REQUIRE(dest[29][0] == 99.0f);
+		REQUIRE(dest[30][0] == 300.0f);
+		REQUIRE(dest[49][1] == -319.0f);
+		REQUIRE(dest[50][0] == 0.0f);
+	}
+}
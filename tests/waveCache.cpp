@@ -0,0 +1,100 @@
+#include <cstdio>
+#include <memory>
+#include "../src/core/waveCache.h"
+#include "../src/core/waveManager.h"
+#include "../src/core/wave.h"
+#include "../src/core/audioBuffer.h"
+#include "../src/core/const.h"
+#include "../src/utils/fs.h"
+#include <catch.hpp>
+
+
+using namespace giada::m;
+
+
+TEST_CASE("waveCache")
+{
+  static const std::string DIR = "./test-cache";
+  static const int FRAMES = 1024 * 16;  // 128 KB of stereo data
+
+  waveCache::init(DIR, 1);
+
+  AudioBuffer buffer;
+  buffer.alloc(FRAMES, G_MAX_IO_CHANS);
+  for (int i=0; i<FRAMES; i++)
+    for (int j=0; j<G_MAX_IO_CHANS; j++)
+      buffer[i][j] = i * 0.001f + j;
+
+  SECTION("test put/get")
+  {
+    waveCache::put("key", buffer);
+    std::shared_ptr<AudioBuffer> data = waveCache::get("key");
+
+    REQUIRE(data != nullptr);
+    REQUIRE(data->countFrames() == FRAMES);
+    REQUIRE(data->countChannels() == G_MAX_IO_CHANS);
+    REQUIRE((*data)[0] != buffer[0]);
+    bool equal = true;
+    for (int i=0; i<FRAMES; i++)
+      for (int j=0; j<G_MAX_IO_CHANS; j++)
+        equal = equal && (*data)[i][j] == buffer[i][j];
+    REQUIRE(equal);
+
+    REQUIRE(waveCache::get("missing") == nullptr);
+  }
+
+  SECTION("test size limit")
+  {
+    for (int i=0; i<10; i++)
+      waveCache::put("key" + std::to_string(i), buffer);
+    int found = 0;
+    for (int i=0; i<10; i++)
+      found += waveCache::get("key" + std::to_string(i)) != nullptr ? 1 : 0;
+    REQUIRE(found > 0);
+    REQUIRE(found < 10);
+  }
+
+  SECTION("test waveManager")
+  {
+    Wave* w;
+    REQUIRE(waveManager::create("tests/resources/test.wav", &w, waveManager::Storage::FLOAT) == G_RES_OK);
+    std::unique_ptr<Wave> wave(w);
+    const Wave* c = wave.get();
+    std::vector<float> original(c->getFrame(0), c->getFrame(0) + c->getSize() * c->getChannels());
+    wave.reset();
+
+    /* No other wave holds the data now: it comes from the cache. */
+
+    REQUIRE(waveManager::create("tests/resources/test.wav", &w, waveManager::Storage::FLOAT) == G_RES_OK);
+    wave.reset(w);
+    c = wave.get();
+    REQUIRE(c->getSize() * c->getChannels() == static_cast<int>(original.size()));
+    REQUIRE(std::equal(original.begin(), original.end(), c->getFrame(0)));
+    REQUIRE(c->isLogical() == false);
+
+    /* Writing doesn't touch cached data. */
+
+    (*wave)[0][0] = original[0] + 1.0f;
+    Wave* w2;
+    REQUIRE(waveManager::create("tests/resources/test.wav", &w2, waveManager::Storage::FLOAT) == G_RES_OK);
+    std::unique_ptr<Wave> wave2(w2);
+    REQUIRE((*static_cast<const Wave*>(w2))[0][0] == original[0]);
+  }
+
+  SECTION("test rate conversion")
+  {
+    Wave* w;
+    REQUIRE(waveManager::create("tests/resources/test.wav", &w, waveManager::Storage::FLOAT, G_DEFAULT_SAMPLERATE * 2) == G_RES_OK);
+    std::unique_ptr<Wave> wave(w);
+    int size = wave->getSize();
+    REQUIRE(wave->getRate() == G_DEFAULT_SAMPLERATE * 2);
+    wave.reset();
+
+    REQUIRE(waveManager::create("tests/resources/test.wav", &w, waveManager::Storage::FLOAT, G_DEFAULT_SAMPLERATE * 2) == G_RES_OK);
+    wave.reset(w);
+    REQUIRE(wave->getRate() == G_DEFAULT_SAMPLERATE * 2);
+    REQUIRE(wave->getSize() == size);
+  }
+
+  waveCache::init("", 0);
+}
@@ -0,0 +1,58 @@
+#include <memory>
+#include "../src/core/const.h"
+#include "../src/core/rope.h"
+#include "../src/core/wave.h"
+#include "../src/core/waveFx.h"
+#include "../src/core/waveEditor.h"
+#include <catch.hpp>
+
+
+using namespace giada::m;
+
+
+TEST_CASE("waveEditor")
+{
+	Wave wave;
+	wave.alloc(wfx::CHUNK_FRAMES * 2, 2, 44100, 32, "path/to/sample.wav");
+	for (int i=0; i<wave.getSize(); i++)
+		wave[i][0] = wave[i][1] = 0.5f;
+
+	SECTION("test edit")
+	{
+		REQUIRE(waveEditor::start(wave, [](Wave& w, wfx::Task& t)
+		{
+			wfx::silence(w, 0, w.getSize(), &t);
+			return G_RES_OK;
+		}) == true);
+
+		std::unique_ptr<Wave> edited(waveEditor::finish());
+		REQUIRE(edited != nullptr);
+		REQUIRE(waveEditor::isBusy() == false);
+		REQUIRE(waveEditor::getProgress() == 1.0f);
+		REQUIRE(edited->isEdited() == true);
+		REQUIRE(edited->getSize() == wave.getSize());
+		REQUIRE(edited->isChunked() == true);
+		int frames;
+		REQUIRE(edited->getRope()->getSpan(100, &frames)[1] == 0.0f);
+		REQUIRE(wave[100][1] == 0.5f);  // original untouched
+	}
+
+	SECTION("test failure and cancel")
+	{
+		REQUIRE(waveEditor::start(wave, [](Wave& w, wfx::Task& t)
+		{
+			return G_RES_ERR;
+		}) == true);
+		REQUIRE(waveEditor::finish() == nullptr);
+		REQUIRE(waveEditor::isCancelled() == false);
+
+		REQUIRE(waveEditor::start(wave, [](Wave& w, wfx::Task& t)
+		{
+			while (!t.cancelled);
+			return G_RES_OK;
+		}) == true);
+		waveEditor::cancel();
+		REQUIRE(waveEditor::finish() == nullptr);
+		REQUIRE(waveEditor::isCancelled() == true);
+	}
+}
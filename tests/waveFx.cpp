@@ -1,5 +1,6 @@
 #include <memory>
 #include "../src/core/const.h"
+#include "../src/core/rope.h"
 #include "../src/core/wave.h"
 #include "../src/core/waveFx.h"
 #include <catch.hpp>
@@ -135,4 +136,104 @@ TEST_CASE("waveFx")
 			REQUIRE(waveMono.getFrame(b)[0] == 0.0f);		
 		}
 	}
+
+	SECTION("test chunked operations")
+	{
+		/* Several chunks, plus a leftover, so that the work is split across 
+		threads. Each sample holds its own position. */
+
+		const int FRAMES = wfx::CHUNK_FRAMES * 3 + 123;
+
+		Wave big;
+		big.alloc(FRAMES, 2, SAMPLE_RATE, BIT_DEPTH, "path/to/big.wav");
+		for (int i=0; i<FRAMES; i++) {
+			big[i][0] = i / (float) FRAMES;
+			big[i][1] = -i / (float) FRAMES;
+		}
+
+		SECTION("test reverse")
+		{
+			int a = 100;
+			int b = FRAMES - 7;
+			wfx::reverse(big, a, b);
+			for (int i=0; i<FRAMES; i++) {
+				int k = i >= a && i < b ? a + b - 1 - i : i;
+				REQUIRE(big[i][0] == k / (float) FRAMES);
+				REQUIRE(big[i][1] == -k / (float) FRAMES);
+			}
+		}
+
+		/* Pointer edits turn the wave into a chunked one: read it through its 
+		Rope. */
+
+		auto at = [&big](int f, int c)
+		{
+			int frames;
+			return big.getRope()->getSpan(f, &frames)[c];
+		};
+
+		SECTION("test shift")
+		{
+			wfx::shift(big, 1000);
+			REQUIRE(big.isChunked() == true);
+			REQUIRE(big.getSize() == FRAMES);
+			REQUIRE(at(0, 0) == (FRAMES - 1000) / (float) FRAMES);
+			REQUIRE(at(1000, 0) == 0.0f);
+
+			wfx::shift(big, -1000);
+			for (int i=0; i<FRAMES; i+=97)
+				REQUIRE(at(i, 0) == i / (float) FRAMES);
+		}
+
+		SECTION("test cut")
+		{
+			int a = wfx::CHUNK_FRAMES - 10;
+			int b = wfx::CHUNK_FRAMES * 2 + 10;
+			REQUIRE(wfx::cut(big, a, b) == G_RES_OK);
+			REQUIRE(big.getSize() == FRAMES - (b - a));
+			REQUIRE(at(a - 1, 0) == (a - 1) / (float) FRAMES);
+			REQUIRE(at(a, 0) == b / (float) FRAMES);
+			REQUIRE(at(big.getSize() - 1, 1) == -(FRAMES - 1) / (float) FRAMES);
+			REQUIRE(big.getRope()->getMemory() == FRAMES * 2 * sizeof(float));  // no copies
+		}
+
+		SECTION("test edit chunked")
+		{
+			/* Only the edited range is copied, the rest stays shared with the 
+			previous version. */
+
+			wfx::shift(big, 0);
+			std::shared_ptr<const Rope> prev = big.getRope();
+			wfx::silence(big, 10, 20);
+			REQUIRE(big.getRope() != prev);
+			REQUIRE(big.getRope()->getMemory() == (FRAMES + 10) * 2 * sizeof(float));
+			REQUIRE(at(9, 0) == 9 / (float) FRAMES);
+			REQUIRE(at(10, 0) == 0.0f);
+			REQUIRE(at(20, 1) == -20 / (float) FRAMES);
+			int frames;
+			REQUIRE(prev->getSpan(10, &frames)[0] == 10 / (float) FRAMES);  // untouched
+
+			wfx::reverse(big, 0, FRAMES);
+			REQUIRE(at(0, 0) == (FRAMES - 1) / (float) FRAMES);
+			REQUIRE(at(FRAMES - 1, 0) == 0.0f);
+		}
+
+		SECTION("test normalize")
+		{
+			wfx::Task task;
+			wfx::normalizeHard(big, 0, FRAMES / 2, &task);
+			REQUIRE(task.progress == 1.0f);
+			REQUIRE(big[FRAMES / 2 - 1][0] == Approx(1.0f));
+			REQUIRE(big[FRAMES / 2][0] == FRAMES / 2 / (float) FRAMES);  // untouched
+		}
+
+		SECTION("test cancel")
+		{
+			wfx::Task task;
+			task.cancelled = true;
+			REQUIRE(wfx::trim(big, 10, FRAMES - 10, &task) == G_RES_ERR);
+			REQUIRE(big.getSize() == FRAMES);
+			REQUIRE(task.progress == 0.0f);
+		}
+	}
 }
@@ -1,6 +1,8 @@
 #include <memory>
 #include "../src/core/waveManager.h"
 #include "../src/core/wave.h"
+#include "../src/core/audioBuffer.h"
+#include "../src/core/nativeBuffer.h"
 #include "../src/core/const.h"
 #include <catch.hpp>
 
@@ -60,4 +62,34 @@ TEST_CASE("waveManager")
     REQUIRE(wave->isLogical() == false);
     REQUIRE(wave->isEdited() == false);
   }
+
+  SECTION("test native storage")
+  {
+    Wave* f;
+    REQUIRE(waveManager::create("tests/resources/test.wav", &w, 
+      waveManager::Storage::NATIVE) == G_RES_OK);
+    REQUIRE(waveManager::create("tests/resources/test.wav", &f, 
+      waveManager::Storage::FLOAT) == G_RES_OK);
+    std::unique_ptr<Wave> wave(w);
+    std::unique_ptr<Wave> floatWave(f);
+
+    REQUIRE(wave->isNative() == true);
+    REQUIRE(wave->isDirect() == false);
+    REQUIRE(wave->getSize() == floatWave->getSize());
+    REQUIRE(wave->getChannels() == G_CHANNELS);
+
+    /* 16 bit samples in their original channel count vs. stereo float. */
+
+    std::shared_ptr<const NativeBuffer> native = wave->getNative();
+    REQUIRE(wave->getMemory() == wave->getSize() * native->countChannels() * 2);
+    REQUIRE(wave->getMemory() < floatWave->getMemory());
+
+    /* Reading converts back to the same float values. */
+
+    AudioBuffer buf;
+    buf.alloc(wave->getSize(), G_CHANNELS);
+    wave->read(buf, 0, wave->getSize(), 0);
+    for (int i=0; i<buf.countSamples(); i++)
+      REQUIRE(buf[0][i] == floatWave->getFrame(0)[i]);
+  }
 }
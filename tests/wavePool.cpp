@@ -0,0 +1,67 @@
+#include <memory>
+#include "../src/core/wavePool.h"
+#include "../src/core/waveManager.h"
+#include "../src/core/wave.h"
+#include "../src/core/const.h"
+#include <catch.hpp>
+
+
+using namespace giada::m;
+
+
+TEST_CASE("wavePool")
+{
+  Wave* w1;
+  Wave* w2;
+  REQUIRE(waveManager::create("tests/resources/test.wav", &w1, waveManager::Storage::FLOAT) == G_RES_OK);
+  REQUIRE(waveManager::create("tests/resources/test.wav", &w2, waveManager::Storage::FLOAT) == G_RES_OK);
+  std::unique_ptr<Wave> wave1(w1);
+  std::unique_ptr<Wave> wave2(w2);
+
+  const Wave* c1 = wave1.get();
+  const Wave* c2 = wave2.get();
+
+  SECTION("test sharing")
+  {
+    REQUIRE(wavePool::count() == 1);
+    REQUIRE(c1->getFrame(0) == c2->getFrame(0));
+    REQUIRE(c1->getSize() == c2->getSize());
+    REQUIRE(c1->getChannels() == c2->getChannels());
+  }
+
+  SECTION("test copy on write")
+  {
+    float original = (*c2)[0][0];
+    (*wave1)[0][0] = original + 1.0f;
+
+    REQUIRE(c1->getFrame(0) != c2->getFrame(0));
+    REQUIRE((*c1)[0][0] == original + 1.0f);
+    REQUIRE((*c2)[0][0] == original);
+    REQUIRE(c1->getSize() == c2->getSize());
+  }
+
+  SECTION("test copy")
+  {
+    Wave copy(*c1);
+    const Wave* c3 = &copy;
+    REQUIRE(c3->getFrame(0) == c1->getFrame(0));
+
+    copy[1][0] = 0.5f;
+    REQUIRE(c3->getFrame(0) != c1->getFrame(0));
+    REQUIRE((*c3)[1][0] == 0.5f);
+  }
+
+  SECTION("test release")
+  {
+    wave1.reset();
+    REQUIRE(wavePool::count() == 1);
+    wave2.reset();
+    REQUIRE(wavePool::count() == 0);
+  }
+
+  SECTION("test missing file")
+  {
+    REQUIRE(wavePool::makeKey("tests/resources/missing.wav") == "");
+    REQUIRE(wavePool::get("") == nullptr);
+  }
+}
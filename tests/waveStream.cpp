@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <memory>
+#include "../src/core/waveStream.h"
+#include "../src/core/waveManager.h"
+#include "../src/core/wave.h"
+#include "../src/core/audioBuffer.h"
+#include "../src/core/const.h"
+#include <catch.hpp>
+
+
+using namespace giada::m;
+
+
+TEST_CASE("waveStream")
+{
+  /* Tiny head and ring buffer, so that the test file (mono, ~40k frames) goes 
+  through all code paths. The disk thread is not running: service() is called
+  by hand. */
+
+  static const int HEAD  = 1024;
+  static const int RING  = 4096;
+  static const int BLOCK = 256;
+
+  Wave* w;
+  REQUIRE(waveManager::create("tests/resources/test.wav", &w, waveManager::Storage::FLOAT) == G_RES_OK);
+  std::unique_ptr<Wave> wave(w);
+
+  WaveStream stream("tests/resources/test.wav", HEAD, RING);
+  AudioBuffer out;
+  out.alloc(BLOCK, G_MAX_IO_CHANS);
+
+  auto serve = [&stream] { while (stream.service()); };
+
+  auto matches = [&wave, &out] (int start, int frames) {
+    for (int i=0; i<frames; i++)
+      for (int j=0; j<G_MAX_IO_CHANS; j++)
+        if (out[i][j] != (*wave)[start + i][j])
+          return false;
+    return true;
+  };
+
+  auto isSilent = [&out] (int frames) {
+    for (int i=0; i<frames; i++)
+      for (int j=0; j<G_MAX_IO_CHANS; j++)
+        if (out[i][j] != 0.0f)
+          return false;
+    return true;
+  };
+
+  REQUIRE(stream.isOpen());
+  REQUIRE(stream.getSize() == wave->getSize());
+  REQUIRE(stream.getFileChannels() == 1);
+
+  SECTION("test playback")
+  {
+    for (int f=0; f<stream.getSize(); f+=BLOCK) {
+      int frames = std::min(BLOCK, stream.getSize() - f);
+      serve();
+      stream.read(out, f, frames, 0);
+      REQUIRE(matches(f, frames));
+    }
+
+    /* Rewind: the head is still there, the ring buffer follows. */
+
+    stream.read(out, 0, BLOCK, 0);
+    REQUIRE(matches(0, BLOCK));
+    serve();
+    stream.read(out, HEAD, BLOCK, 0);
+    REQUIRE(matches(HEAD, BLOCK));
+  }
+
+  SECTION("test jump")
+  {
+    serve();
+    stream.read(out, 20000, BLOCK, 0);
+    REQUIRE(isSilent(BLOCK));  // not there yet
+    serve();
+    stream.read(out, 20000, BLOCK, 0);
+    REQUIRE(matches(20000, BLOCK));
+  }
+
+  SECTION("test prefetch")
+  {
+    stream.prefetch(30000);
+    serve();
+    stream.read(out, 30000, BLOCK, 0);
+    REQUIRE(matches(30000, BLOCK));
+    serve();
+    stream.read(out, 30000 + HEAD, BLOCK, 0);
+    REQUIRE(matches(30000 + HEAD, BLOCK));
+  }
+
+  SECTION("test reading past the end")
+  {
+    out.clear();
+    stream.read(out, stream.getSize(), BLOCK, 0);
+    REQUIRE(isSilent(BLOCK));
+  }
+}
@@ -0,0 +1,52 @@
+#include <atomic>
+#include "../src/core/workers.h"
+#include <catch.hpp>
+
+
+namespace
+{
+std::atomic<int> hits[64];
+
+void job(int index, void* data)
+{
+	hits[index]++;
+	static_cast<std::atomic<int>*>(data)->fetch_add(index);
+}
+}
+
+
+TEST_CASE("workers")
+{
+	using namespace giada::m;
+
+	std::atomic<int> sum(0);
+	for (std::atomic<int>& h : hits)
+		h = 0;
+
+	SECTION("test serial")
+	{
+		workers::init(1);
+		REQUIRE(workers::count() == 1);
+		REQUIRE(workers::getIndex() == 0);
+
+		workers::run(10, job, &sum);
+		REQUIRE(sum == 45);
+		for (int i=0; i<10; i++)
+			REQUIRE(hits[i] == 1);
+	}
+
+	SECTION("test parallel, each job runs exactly once")
+	{
+		workers::init(4);
+		REQUIRE(workers::count() == 4);
+
+		for (int k=0; k<1000; k++)
+			workers::run(64, job, &sum);
+		REQUIRE(sum == 2016 * 1000);
+		for (int i=0; i<64; i++)
+			REQUIRE(hits[i] == 1000);
+	}
+
+	workers::close();
+	REQUIRE(workers::count() == 1);
+}